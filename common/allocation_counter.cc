@@ -0,0 +1,42 @@
+#include "common/allocation_counter.h"
+
+#include <atomic>
+#include <cstddef>
+
+// The glibc implementations, which are wrapped by the functions below
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t num, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+namespace {
+std::atomic<int64_t> num_allocations{0};
+}  // namespace
+
+extern "C" void* malloc(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t num, size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(num, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+namespace dairlib {
+
+AllocationCounter::AllocationCounter() { Reset(); }
+
+int64_t AllocationCounter::num_allocations() const {
+  return ::num_allocations.load(std::memory_order_relaxed) - start_;
+}
+
+void AllocationCounter::Reset() {
+  start_ = ::num_allocations.load(std::memory_order_relaxed);
+}
+
+}  // namespace dairlib
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+namespace dairlib {
+
+/// AllocationCounter counts the heap allocations (malloc, calloc and realloc,
+/// and therefore also operator new) made by all threads of the process since
+/// its construction.
+///
+/// It is meant for tests which check that a real-time code path does not
+/// allocate. The counting is implemented by replacing malloc in the test
+/// binary, so this library must only be linked into tests (testonly).
+///
+/// Usage:
+///   AllocationCounter counter;
+///   ... code under test ...
+///   EXPECT_EQ(counter.num_allocations(), 0);
+class AllocationCounter {
+ public:
+  AllocationCounter();
+
+  /// Number of allocations since the construction or the last Reset()
+  int64_t num_allocations() const;
+
+  void Reset();
+
+ private:
+  int64_t start_;
+};
+
+}  // namespace dairlib
@@ -4,4 +4,9 @@ std::vector<double> CopyVectorXdToStdVector(
     const Eigen::VectorXd& eigen_vec) {
   return std::vector<double>(eigen_vec.data(),
                              eigen_vec.data() + eigen_vec.size());
+}
+
+void CopyVectorXdToStdVector(const Eigen::VectorXd& eigen_vec,
+                             std::vector<double>* std_vec) {
+  std_vec->assign(eigen_vec.data(), eigen_vec.data() + eigen_vec.size());
 }
\ No newline at end of file
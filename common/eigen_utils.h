@@ -5,3 +5,8 @@
 /// from an Eigen::VectorXd.
 std::vector<double> CopyVectorXdToStdVector(
     const Eigen::VectorXd& eigen_vec);
+
+/// CopyVectorXdToStdVector copies an Eigen::VectorXd into `std_vec`. The
+/// memory of `std_vec` is reused if its capacity is large enough.
+void CopyVectorXdToStdVector(const Eigen::VectorXd& eigen_vec,
+                             std::vector<double>* std_vec);
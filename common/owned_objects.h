@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+namespace dairlib {
+
+/// Keeps heap-allocated objects of any type alive as long as the holder.
+/// Structs bundling an object with the objects it refers to by pointer (e.g. a
+/// trajectory optimization and its plant, evaluators and modes) derive from
+/// it, so that the owned objects are destroyed after their own members.
+class OwnedObjects {
+ public:
+  /// Keeps `object` alive as long as the holder, and returns a raw pointer to
+  /// it.
+  template <typename T>
+  T* Own(std::unique_ptr<T> object) {
+    T* ptr = object.get();
+    objects_.emplace_back(std::move(object));
+    return ptr;
+  }
+
+ private:
+  std::vector<std::shared_ptr<void>> objects_;
+};
+
+}  // namespace dairlib
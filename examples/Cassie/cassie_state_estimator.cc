@@ -1,14 +1,13 @@
 #include "examples/Cassie/cassie_state_estimator.h"
 
 #include <math.h>
+#include <array>
 #include <chrono>
 #include <fstream>
 #include <utility>
 
 #include "drake/math/orthonormal_basis.h"
-#include "drake/solvers/equality_constrained_qp_solver.h"
-#include "drake/solvers/mathematical_program.h"
-#include "drake/solvers/solve.h"
+#include "drake/multibody/tree/revolute_joint.h"
 
 namespace dairlib {
 namespace systems {
@@ -24,10 +23,13 @@ using Eigen::Vector3d;
 using Eigen::VectorXd;
 
 using drake::AbstractValue;
+using drake::math::RigidTransformd;
+using drake::math::RotationMatrixd;
+using drake::multibody::Body;
 using drake::multibody::JacobianWrtVariable;
+using drake::multibody::Joint;
+using drake::multibody::JointIndex;
 using drake::multibody::MultibodyPlant;
-using drake::solvers::MathematicalProgram;
-using drake::solvers::Solve;
 using drake::systems::Context;
 using drake::systems::DiscreteValues;
 using drake::systems::EventStatus;
@@ -39,6 +41,17 @@ using systems::OutputVector;
 
 static const int SPACE_DIM = 3;
 
+// Joint whose child is `body`
+static const Joint<double>& GetParentJoint(const MultibodyPlant<double>& plant,
+                                           const Body<double>& body) {
+  for (JointIndex i(0); i < plant.num_joints(); ++i) {
+    if (plant.get_joint(i).child_body().index() == body.index()) {
+      return plant.get_joint(i);
+    }
+  }
+  DRAKE_UNREACHABLE();
+}
+
 CassieStateEstimator::CassieStateEstimator(
     const MultibodyPlant<double>& plant,
     const KinematicEvaluatorSet<double>* fourbar_evaluator,
@@ -83,6 +96,65 @@ CassieStateEstimator::CassieStateEstimator(
   actuator_idx_map_ = multibody::makeNameToActuatorsMap(plant);
   position_idx_map_ = multibody::makeNameToPositionsMap(plant);
   velocity_idx_map_ = multibody::makeNameToVelocitiesMap(plant);
+  motor_effort_map_ = multibody::IndexMap(
+      actuator_idx_map_,
+      {"hip_roll_left_motor", "hip_yaw_left_motor", "hip_pitch_left_motor",
+       "knee_left_motor", "toe_left_motor", "hip_roll_right_motor",
+       "hip_yaw_right_motor", "hip_pitch_right_motor", "knee_right_motor",
+       "toe_right_motor"});
+  joint_position_map_ = multibody::IndexMap(
+      position_idx_map_,
+      {"hip_roll_left", "hip_yaw_left", "hip_pitch_left", "knee_left",
+       "toe_left", "knee_joint_left", "ankle_joint_left",
+       "ankle_spring_joint_left", "hip_roll_right", "hip_yaw_right",
+       "hip_pitch_right", "knee_right", "toe_right", "knee_joint_right",
+       "ankle_joint_right", "ankle_spring_joint_right"});
+  joint_velocity_map_ = multibody::IndexMap(
+      velocity_idx_map_,
+      {"hip_roll_leftdot", "hip_yaw_leftdot", "hip_pitch_leftdot",
+       "knee_leftdot", "toe_leftdot", "knee_joint_leftdot",
+       "ankle_joint_leftdot", "ankle_spring_joint_leftdot", "hip_roll_rightdot",
+       "hip_yaw_rightdot", "hip_pitch_rightdot", "knee_rightdot",
+       "toe_rightdot", "knee_joint_rightdot", "ankle_joint_rightdot",
+       "ankle_spring_joint_rightdot"});
+  // Kinematic chains of the fourbar linkages, from the thighs to the heel
+  // springs
+  for (int i = 0; i < 2; i++) {
+    const auto& thigh_frame = rod_on_thighs_[i].second;
+    const auto& heel_spring_frame = rod_on_heel_springs_[i].second;
+    rod_on_thigh_bodies_.push_back(thigh_frame.GetFixedPoseInBodyFrame() *
+                                   rod_on_thighs_[i].first);
+    heel_spring_frame_poses_.push_back(
+        heel_spring_frame.GetFixedPoseInBodyFrame());
+    std::vector<FourbarChainJoint> chain;
+    const Body<double>* body = &heel_spring_frame.body();
+    while (body->index() != thigh_frame.body().index()) {
+      const Joint<double>& joint = GetParentJoint(plant, *body);
+      const auto* revolute_joint =
+          dynamic_cast<const drake::multibody::RevoluteJoint<double>*>(&joint);
+      DRAKE_DEMAND(revolute_joint != nullptr);
+      chain.insert(
+          chain.begin(),
+          FourbarChainJoint{
+              joint.frame_on_parent().GetFixedPoseInBodyFrame(),
+              joint.frame_on_child().GetFixedPoseInBodyFrame().inverse(),
+              revolute_joint->revolute_axis(), joint.position_start()});
+      body = &joint.parent_body();
+    }
+    fourbar_chains_.push_back(chain);
+  }
+
+  left_heel_spring_idx_ = position_idx_map_.at("ankle_spring_joint_left");
+  right_heel_spring_idx_ = position_idx_map_.at("ankle_spring_joint_right");
+  if (is_floating_base_) {
+    floating_base_position_map_ = multibody::IndexMap(
+        position_idx_map_,
+        {"base_qw", "base_qx", "base_qy", "base_qz", "base_x", "base_y",
+         "base_z"});
+    floating_base_velocity_map_ = multibody::IndexMap(
+        velocity_idx_map_,
+        {"base_wx", "base_wy", "base_wz", "base_vx", "base_vy", "base_vz"});
+  }
 
   if (is_floating_base_) {
     // Middle point between the front and the rear contact points
@@ -109,30 +181,27 @@ CassieStateEstimator::CassieStateEstimator(
     fb_state_idx_ = DeclareDiscreteState(init_floating_base_state);
 
     // initialize ekf state mean and covariance
-    inekf::RobotState initial_state;
-    initial_state.setRotation(Matrix3d::Identity());
-    initial_state.setVelocity(Vector3d::Zero());
-    initial_state.setPosition(Vector3d::Zero());
-    initial_state.setGyroscopeBias(Vector3d::Zero());
-    initial_state.setAccelerometerBias(Vector3d::Zero());
-    MatrixXd P = MatrixXd::Identity(15, 15);
+    Eigen::Matrix<double, 15, 15> P =
+        Eigen::Matrix<double, 15, 15>::Identity();
     P.block<3, 3>(0, 0) = 0.0001 * MatrixXd::Identity(3, 3);  // rotation
     P.block<3, 3>(3, 3) = 0.01 * MatrixXd::Identity(3, 3);    // velocity
     P.block<3, 3>(6, 6) = 0.0001 * MatrixXd::Identity(3, 3);  // position
     P.block<3, 3>(9, 9) = 0.0001 * MatrixXd::Identity(3, 3);  // gyro bias
     P.block<3, 3>(12, 12) = 0.01 * MatrixXd::Identity(3, 3);  // accel bias
-    initial_state.setP(P);
     // initialize ekf input noise
     cov_w_ = 0.000289 * Eigen::MatrixXd::Identity(16, 16);
-    inekf::NoiseParams noise_params;
-    noise_params.setGyroscopeNoise(0.002);
-    noise_params.setAccelerometerNoise(0.04);
-    noise_params.setGyroscopeBiasNoise(0.001);
-    noise_params.setAccelerometerBiasNoise(0.001);
-    noise_params.setContactNoise(0.05);
+    ContactInekf<2>::NoiseParams noise_params;
+    noise_params.gyroscope = 0.002;
+    noise_params.accelerometer = 0.04;
+    noise_params.gyroscope_bias = 0.001;
+    noise_params.accelerometer_bias = 0.001;
+    noise_params.contact = 0.05;
+    ekf_ = std::make_unique<ContactInekf<2>>(noise_params, gravity_);
     // 2. estimated EKF state (imu frame)
-    inekf::InEKF value(initial_state, noise_params);
-    ekf_idx_ = DeclareAbstractState(AbstractValue::Make<inekf::InEKF>(value));
+    // The filter is stored as a discrete state, and updated in place
+    ekf_idx_ = DeclareDiscreteState(ContactInekf<2>::MakeState(
+        Matrix3d::Identity(), Vector3d::Zero(), Vector3d::Zero(),
+        Vector3d::Zero(), Vector3d::Zero(), P));
 
     // 3. state for previous imu value
     // Measured accelrometer should point toward positive z when the robot rests
@@ -150,77 +219,15 @@ CassieStateEstimator::CassieStateEstimator(
     filtered_residual_right_idx_ =
         DeclareDiscreteState(VectorXd::Zero(n_v_, 1));
 
-    // Contact Estimation - Quadratic Programing
+    // Contact Estimation - least squares fits of the EoM
     n_b_ = fourbar_evaluator->count_full();
     n_cl_ = left_contact_evaluator->count_full();
     n_cl_active_ = left_contact_evaluator->count_active();
     n_cr_ = right_contact_evaluator->count_full();
     n_cr_active_ = right_contact_evaluator->count_active();
-    // MathematicalProgram
-    quadprog_ = std::make_unique<drake::solvers::MathematicalProgram>();
-    // Add variables to the optimization program
-    ddq_ = quadprog_->NewContinuousVariables(n_v_, "ddq");
-    lambda_b_ = quadprog_->NewContinuousVariables(n_b_, "lambda_b");
-    lambda_cl_ = quadprog_->NewContinuousVariables(n_cl_, "lambda_cl");
-    lambda_cr_ = quadprog_->NewContinuousVariables(n_cr_, "lambda_cr");
-    eps_cl_ = quadprog_->NewContinuousVariables(n_cl_active_, "eps_cl");
-    eps_cr_ = quadprog_->NewContinuousVariables(n_cr_active_, "eps_cr");
-    eps_imu_ = quadprog_->NewContinuousVariables(SPACE_DIM, "eps_imu");
-    // Add equality constraints to the optimization program
-    fourbar_constraint_ =
-        quadprog_
-            ->AddLinearEqualityConstraint(MatrixXd::Zero(n_b_, n_v_),
-                                          VectorXd::Zero(n_b_), ddq_)
-            .evaluator()
-            .get();
-    left_contact_constraint_ =
-        quadprog_
-            ->AddLinearEqualityConstraint(
-                MatrixXd::Zero(n_cl_active_, n_v_ + n_cl_active_),
-                VectorXd::Zero(n_cl_active_), {ddq_, eps_cl_})
-            .evaluator()
-            .get();
-    right_contact_constraint_ =
-        quadprog_
-            ->AddLinearEqualityConstraint(
-                MatrixXd::Zero(n_cr_active_, n_v_ + n_cr_active_),
-                VectorXd::Zero(n_cr_active_), {ddq_, eps_cr_})
-            .evaluator()
-            .get();
-    imu_accel_constraint_ = quadprog_
-                                ->AddLinearEqualityConstraint(
-                                    MatrixXd::Zero(SPACE_DIM, n_v_ + SPACE_DIM),
-                                    VectorXd::Zero(SPACE_DIM), {ddq_, eps_imu_})
-                                .evaluator()
-                                .get();
-    // Add costs to the optimization program
-    int n_lambda = n_b_ + n_cl_ + n_cr_;
-    quadcost_eom_ =
-        quadprog_
-            ->AddQuadraticCost(MatrixXd::Zero(n_v_ + n_lambda, n_v_ + n_lambda),
-                               MatrixXd::Zero(n_v_ + n_lambda, 1),
-                               {ddq_, lambda_b_, lambda_cl_, lambda_cr_})
-            .evaluator()
-            .get();
-    quadcost_eps_cl_ =
-        quadprog_
-            ->AddQuadraticCost(MatrixXd::Zero(n_cl_active_, n_cl_active_),
-                               VectorXd::Zero(n_cl_active_), eps_cl_)
-            .evaluator()
-            .get();
-    quadcost_eps_cr_ =
-        quadprog_
-            ->AddQuadraticCost(MatrixXd::Zero(n_cr_active_, n_cr_active_),
-                               VectorXd::Zero(n_cr_active_), eps_cr_)
-            .evaluator()
-            .get();
-    quadcost_eps_imu_ =
-        quadprog_
-            ->AddQuadraticCost(
-                w_soft_constraint_ * MatrixXd::Identity(SPACE_DIM, SPACE_DIM),
-                VectorXd::Zero(SPACE_DIM), eps_imu_)
-            .evaluator()
-            .get();
+    contact_estimation_solver_ = std::make_unique<ContactEstimationSolver>(
+        n_v_, n_b_, n_cl_, n_cl_active_, n_cr_, n_cr_active_,
+        w_soft_constraint_, eps_cost_);
   }
 }
 
@@ -244,8 +251,12 @@ CassieStateEstimator::CassieStateEstimator(
 ///  spring is fixed to the heel. The heel spring (rotational spring) can
 ///  deflect in only one dimension, meaning it rotates around the spring base
 ///  where the spring is attached to the heel.
-///  Let the ball joint position in the world frame to be r_ball_joint, and the
-///  spring base position to be r_heel_spring_base.
+///  The position of the ball joint in the heel spring frame only depends on
+///  the joints between the thigh and the heel spring (knee, knee spring,
+///  ankle and heel spring), so it is computed from the chain of these joints
+///  (fourbar_chains_), without evaluating the kinematics of the plant.
+///  Let the ball joint position to be r_ball_joint, and the spring base
+///  position to be r_heel_spring_base.
 ///  Let the length of the rod to be rod_length_, and the spring length to be
 ///  spring_length.
 ///  We want to find the intersections of a sphere S_r (with origin r_ball_joint
@@ -273,26 +284,20 @@ void CassieStateEstimator::solveFourbarLinkage(
   double spring_rest_offset =
       atan(rod_on_heel_springs_[0].first(1) / rod_on_heel_springs_[0].first(0));
 
-  plant_.SetPositions(context_.get(), q);
-
   for (int i = 0; i < 2; i++) {
-    // Get thigh pose and heel spring pose
-    auto thigh_pose = rod_on_thighs_[i].second.CalcPoseInWorld(*context_);
-    const Vector3d& thigh_pos = thigh_pose.translation();
-    const auto& thigh_rot_mat = thigh_pose.rotation();
-
-    auto heel_spring_pose =
-        rod_on_heel_springs_[i].second.CalcPoseInWorld(*context_);
-    const Vector3d& r_heel_spring_base = heel_spring_pose.translation();
-    const auto& heel_spring_rot_mat = heel_spring_pose.rotation();
-
-    // Get r_heel_spring_base_to_thigh_ball_joint
-    Vector3d r_ball_joint = thigh_pos + thigh_rot_mat * rod_on_thighs_[i].first;
-    Vector3d r_heel_spring_base_to_thigh_ball_joint =
-        r_ball_joint - r_heel_spring_base;
+    // Get the pose of the heel spring body in the thigh body
+    RigidTransformd X_TH;
+    for (const auto& joint : fourbar_chains_[i]) {
+      X_TH = X_TH * joint.X_PF *
+             RigidTransformd(RotationMatrixd(
+                 Eigen::AngleAxisd(q(joint.position_index), joint.axis))) *
+             joint.X_MC;
+    }
+
+    // Get r_thigh_ball_joint_wrt_heel_spring_base
     Vector3d r_thigh_ball_joint_wrt_heel_spring_base =
-        heel_spring_rot_mat.transpose() *
-        r_heel_spring_base_to_thigh_ball_joint;
+        (X_TH * heel_spring_frame_poses_[i]).inverse() *
+        rod_on_thigh_bodies_[i];
 
     // Get the projected rod length in the xy plane of heel spring base
     double projected_rod_length =
@@ -356,27 +361,19 @@ void CassieStateEstimator::AssignImuValueToOutputVector(
 void CassieStateEstimator::AssignActuationFeedbackToOutputVector(
     const cassie_out_t& cassie_out, OutputVector<double>* output) const {
   // Copy actuators
-  output->SetEffortAtIndex(actuator_idx_map_.at("hip_roll_left_motor"),
-                           cassie_out.leftLeg.hipRollDrive.torque);
-  output->SetEffortAtIndex(actuator_idx_map_.at("hip_yaw_left_motor"),
-                           cassie_out.leftLeg.hipYawDrive.torque);
-  output->SetEffortAtIndex(actuator_idx_map_.at("hip_pitch_left_motor"),
-                           cassie_out.leftLeg.hipPitchDrive.torque);
-  output->SetEffortAtIndex(actuator_idx_map_.at("knee_left_motor"),
-                           cassie_out.leftLeg.kneeDrive.torque);
-  output->SetEffortAtIndex(actuator_idx_map_.at("toe_left_motor"),
-                           cassie_out.leftLeg.footDrive.torque);
-
-  output->SetEffortAtIndex(actuator_idx_map_.at("hip_roll_right_motor"),
-                           cassie_out.rightLeg.hipRollDrive.torque);
-  output->SetEffortAtIndex(actuator_idx_map_.at("hip_yaw_right_motor"),
-                           cassie_out.rightLeg.hipYawDrive.torque);
-  output->SetEffortAtIndex(actuator_idx_map_.at("hip_pitch_right_motor"),
-                           cassie_out.rightLeg.hipPitchDrive.torque);
-  output->SetEffortAtIndex(actuator_idx_map_.at("knee_right_motor"),
-                           cassie_out.rightLeg.kneeDrive.torque);
-  output->SetEffortAtIndex(actuator_idx_map_.at("toe_right_motor"),
-                           cassie_out.rightLeg.footDrive.torque);
+  Eigen::Matrix<double, 10, 1> efforts;
+  efforts << cassie_out.leftLeg.hipRollDrive.torque,
+      cassie_out.leftLeg.hipYawDrive.torque,
+      cassie_out.leftLeg.hipPitchDrive.torque,
+      cassie_out.leftLeg.kneeDrive.torque,
+      cassie_out.leftLeg.footDrive.torque,
+      cassie_out.rightLeg.hipRollDrive.torque,
+      cassie_out.rightLeg.hipYawDrive.torque,
+      cassie_out.rightLeg.hipPitchDrive.torque,
+      cassie_out.rightLeg.kneeDrive.torque,
+      cassie_out.rightLeg.footDrive.torque;
+  auto u = output->GetMutableEfforts();
+  motor_effort_map_.Scatter(efforts, &u);
 }
 
 void CassieStateEstimator::AssignNonFloatingBaseStateToOutputVector(
@@ -384,73 +381,42 @@ void CassieStateEstimator::AssignNonFloatingBaseStateToOutputVector(
   // Copy the robot state excluding floating base
   // TODO(yuming): check what cassie_out.leftLeg.footJoint.position is.
   // Similarly, the other leg and the velocity of these joints.
-  output->SetPositionAtIndex(position_idx_map_.at("hip_roll_left"),
-                             cassie_out.leftLeg.hipRollDrive.position);
-  output->SetPositionAtIndex(position_idx_map_.at("hip_yaw_left"),
-                             cassie_out.leftLeg.hipYawDrive.position);
-  output->SetPositionAtIndex(position_idx_map_.at("hip_pitch_left"),
-                             cassie_out.leftLeg.hipPitchDrive.position);
-  output->SetPositionAtIndex(position_idx_map_.at("knee_left"),
-                             cassie_out.leftLeg.kneeDrive.position);
-  output->SetPositionAtIndex(position_idx_map_.at("toe_left"),
-                             cassie_out.leftLeg.footDrive.position);
-  output->SetPositionAtIndex(position_idx_map_.at("knee_joint_left"),
-                             cassie_out.leftLeg.shinJoint.position);
-  output->SetPositionAtIndex(position_idx_map_.at("ankle_joint_left"),
-                             cassie_out.leftLeg.tarsusJoint.position);
-  output->SetPositionAtIndex(position_idx_map_.at("ankle_spring_joint_left"),
-                             0.0);
-
-  output->SetPositionAtIndex(position_idx_map_.at("hip_roll_right"),
-                             cassie_out.rightLeg.hipRollDrive.position);
-  output->SetPositionAtIndex(position_idx_map_.at("hip_yaw_right"),
-                             cassie_out.rightLeg.hipYawDrive.position);
-  output->SetPositionAtIndex(position_idx_map_.at("hip_pitch_right"),
-                             cassie_out.rightLeg.hipPitchDrive.position);
-  output->SetPositionAtIndex(position_idx_map_.at("knee_right"),
-                             cassie_out.rightLeg.kneeDrive.position);
-  output->SetPositionAtIndex(position_idx_map_.at("toe_right"),
-                             cassie_out.rightLeg.footDrive.position);
-  output->SetPositionAtIndex(position_idx_map_.at("knee_joint_right"),
-                             cassie_out.rightLeg.shinJoint.position);
-  output->SetPositionAtIndex(position_idx_map_.at("ankle_joint_right"),
-                             cassie_out.rightLeg.tarsusJoint.position);
-  output->SetPositionAtIndex(position_idx_map_.at("ankle_spring_joint_right"),
-                             0.0);
-
-  output->SetVelocityAtIndex(velocity_idx_map_.at("hip_roll_leftdot"),
-                             cassie_out.leftLeg.hipRollDrive.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("hip_yaw_leftdot"),
-                             cassie_out.leftLeg.hipYawDrive.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("hip_pitch_leftdot"),
-                             cassie_out.leftLeg.hipPitchDrive.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("knee_leftdot"),
-                             cassie_out.leftLeg.kneeDrive.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("toe_leftdot"),
-                             cassie_out.leftLeg.footDrive.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("knee_joint_leftdot"),
-                             cassie_out.leftLeg.shinJoint.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("ankle_joint_leftdot"),
-                             cassie_out.leftLeg.tarsusJoint.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("ankle_spring_joint_leftdot"),
-                             0.0);
-
-  output->SetVelocityAtIndex(velocity_idx_map_.at("hip_roll_rightdot"),
-                             cassie_out.rightLeg.hipRollDrive.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("hip_yaw_rightdot"),
-                             cassie_out.rightLeg.hipYawDrive.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("hip_pitch_rightdot"),
-                             cassie_out.rightLeg.hipPitchDrive.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("knee_rightdot"),
-                             cassie_out.rightLeg.kneeDrive.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("toe_rightdot"),
-                             cassie_out.rightLeg.footDrive.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("knee_joint_rightdot"),
-                             cassie_out.rightLeg.shinJoint.velocity);
-  output->SetVelocityAtIndex(velocity_idx_map_.at("ankle_joint_rightdot"),
-                             cassie_out.rightLeg.tarsusJoint.velocity);
-  output->SetVelocityAtIndex(
-      velocity_idx_map_.at("ankle_spring_joint_rightdot"), 0.0);
+  // The heel springs (8th and 16th entries) are not measured, and the spring
+  // positions are solved from the fourbar linkage below.
+  Eigen::Matrix<double, 16, 1> joint_positions;
+  joint_positions << cassie_out.leftLeg.hipRollDrive.position,
+      cassie_out.leftLeg.hipYawDrive.position,
+      cassie_out.leftLeg.hipPitchDrive.position,
+      cassie_out.leftLeg.kneeDrive.position,
+      cassie_out.leftLeg.footDrive.position,
+      cassie_out.leftLeg.shinJoint.position,
+      cassie_out.leftLeg.tarsusJoint.position, 0.0,
+      cassie_out.rightLeg.hipRollDrive.position,
+      cassie_out.rightLeg.hipYawDrive.position,
+      cassie_out.rightLeg.hipPitchDrive.position,
+      cassie_out.rightLeg.kneeDrive.position,
+      cassie_out.rightLeg.footDrive.position,
+      cassie_out.rightLeg.shinJoint.position,
+      cassie_out.rightLeg.tarsusJoint.position, 0.0;
+  Eigen::Matrix<double, 16, 1> joint_velocities;
+  joint_velocities << cassie_out.leftLeg.hipRollDrive.velocity,
+      cassie_out.leftLeg.hipYawDrive.velocity,
+      cassie_out.leftLeg.hipPitchDrive.velocity,
+      cassie_out.leftLeg.kneeDrive.velocity,
+      cassie_out.leftLeg.footDrive.velocity,
+      cassie_out.leftLeg.shinJoint.velocity,
+      cassie_out.leftLeg.tarsusJoint.velocity, 0.0,
+      cassie_out.rightLeg.hipRollDrive.velocity,
+      cassie_out.rightLeg.hipYawDrive.velocity,
+      cassie_out.rightLeg.hipPitchDrive.velocity,
+      cassie_out.rightLeg.kneeDrive.velocity,
+      cassie_out.rightLeg.footDrive.velocity,
+      cassie_out.rightLeg.shinJoint.velocity,
+      cassie_out.rightLeg.tarsusJoint.velocity, 0.0;
+  auto q_output = output->GetMutablePositions();
+  auto v_output = output->GetMutableVelocities();
+  joint_position_map_.Scatter(joint_positions, &q_output);
+  joint_velocity_map_.Scatter(joint_velocities, &v_output);
 
   // Solve fourbar linkage for heel spring positions
   double left_heel_spring = 0;
@@ -466,35 +432,24 @@ void CassieStateEstimator::AssignNonFloatingBaseStateToOutputVector(
     q[0] = 1;
   }
   solveFourbarLinkage(q, &left_heel_spring, &right_heel_spring);
-  output->SetPositionAtIndex(position_idx_map_.at("ankle_spring_joint_left"),
-                             left_heel_spring);
-  output->SetPositionAtIndex(position_idx_map_.at("ankle_spring_joint_right"),
-                             right_heel_spring);
+  output->SetPositionAtIndex(left_heel_spring_idx_, left_heel_spring);
+  output->SetPositionAtIndex(right_heel_spring_idx_, right_heel_spring);
 }
 
 void CassieStateEstimator::AssignFloatingBaseStateToOutputVector(
     const VectorXd& est_fb_state, OutputVector<double>* output) const {
-  output->SetPositionAtIndex(position_idx_map_.at("base_qw"), est_fb_state(0));
-  output->SetPositionAtIndex(position_idx_map_.at("base_qx"), est_fb_state(1));
-  output->SetPositionAtIndex(position_idx_map_.at("base_qy"), est_fb_state(2));
-  output->SetPositionAtIndex(position_idx_map_.at("base_qz"), est_fb_state(3));
-  output->SetPositionAtIndex(position_idx_map_.at("base_x"), est_fb_state(4));
-  output->SetPositionAtIndex(position_idx_map_.at("base_y"), est_fb_state(5));
-  output->SetPositionAtIndex(position_idx_map_.at("base_z"), est_fb_state(6));
-
-  output->SetVelocityAtIndex(velocity_idx_map_.at("base_wx"), est_fb_state(7));
-  output->SetVelocityAtIndex(velocity_idx_map_.at("base_wy"), est_fb_state(8));
-  output->SetVelocityAtIndex(velocity_idx_map_.at("base_wz"), est_fb_state(9));
-  output->SetVelocityAtIndex(velocity_idx_map_.at("base_vx"), est_fb_state(10));
-  output->SetVelocityAtIndex(velocity_idx_map_.at("base_vy"), est_fb_state(11));
-  output->SetVelocityAtIndex(velocity_idx_map_.at("base_vz"), est_fb_state(12));
+  auto q_output = output->GetMutablePositions();
+  auto v_output = output->GetMutableVelocities();
+  floating_base_position_map_.Scatter(est_fb_state.head(7), &q_output);
+  floating_base_velocity_map_.Scatter(est_fb_state.segment(7, 6), &v_output);
 }
 
 /// UpdateContactEstimationCosts() updates the optimal costs of the quadratic
 /// programs for contact estimations. There are three QPs in total which assume
 /// double support, left support and right support in order.
 /// The QP's are solved with the state/input feedback of the robot and the imu
-/// linear acceleration.
+/// linear acceleration. They only have equality constraints, and are solved in
+/// closed form by ContactEstimationSolver.
 ///
 /// Input:
 ///  - OutputVector `output` containing the state, input and imu acceleration of
@@ -558,195 +513,41 @@ void CassieStateEstimator::UpdateContactEstimationCosts(
   const auto& R_WB = pelvis_pose.rotation();
   Vector3d imu_accel_wrt_world = R_WB * output.GetIMUAccelerations() + gravity_;
 
-  // Mathematical program - double contact
-  // Equality constraint
-  fourbar_constraint_->UpdateCoefficients(J_b, -1 * JdotV_b);
-
-  MatrixXd IMU_coeff(SPACE_DIM, n_v_ + SPACE_DIM);
-  IMU_coeff << J_imu, MatrixXd::Identity(SPACE_DIM, SPACE_DIM);
-  imu_accel_constraint_->UpdateCoefficients(
-      IMU_coeff, -1 * JdotV_imu + imu_accel_wrt_world);
-
-  MatrixXd CL_coeff(n_cl_active_, n_v_ + n_cl_active_);
-  CL_coeff << J_cl_active, MatrixXd::Identity(n_cl_active_, n_cl_active_);
-  left_contact_constraint_->UpdateCoefficients(CL_coeff, -1 * JdotV_cl_active);
-
-  MatrixXd CR_coeff(n_cr_active_, n_v_ + n_cr_active_);
-  CR_coeff << J_cr_active, MatrixXd::Identity(n_cr_active_, n_cr_active_);
-  right_contact_constraint_->UpdateCoefficients(CR_coeff, -1 * JdotV_cr_active);
-
-  // Cost
-  int A_cols = n_v_ + n_b_ + n_cl_ + n_cr_;
-  MatrixXd A_dyn(n_v_, A_cols);
-  A_dyn << M, -1 * J_b.transpose(), -1 * J_cl.transpose(),
-      -1 * J_cr.transpose();
-  VectorXd b_dyn(n_v_);
-  b_dyn = -C;
-
-  quadcost_eom_->UpdateCoefficients(
-      2 * A_dyn.transpose() * A_dyn +
-          eps_cost_ * MatrixXd::Identity(A_cols, A_cols),
-      -2 * A_dyn.transpose() * b_dyn);
-  quadcost_eps_cl_->UpdateCoefficients(
-      w_soft_constraint_ * MatrixXd::Identity(n_cl_active_, n_cl_active_),
-      VectorXd::Zero(n_cl_active_));
-  quadcost_eps_cr_->UpdateCoefficients(
-      w_soft_constraint_ * MatrixXd::Identity(n_cr_active_, n_cr_active_),
-      VectorXd::Zero(n_cr_active_));
-
-  // Initial guess
-  // EqualityConstrainedQPSolver doesn't depend on the initial guess. There is a
-  // closed form solution.
-
-  // Solve the optimization problem
-  drake::solvers::EqualityConstrainedQPSolver solver;
-  drake::solvers::SolverOptions solver_options;
-  solver_options.SetOption(drake::solvers::EqualityConstrainedQPSolver::id(),
-                           "FeasibilityTol", 1e-6); // default 1e-12
-  drake::solvers::MathematicalProgramResult result_double =
-      solver.Solve(*quadprog_, {}, solver_options);
-
-  if (!result_double.is_success()) {
-    // If the optimization fails, push infinity into the optimal_cost vector
-    optimal_cost->at(0) = std::numeric_limits<double>::infinity();
-
-  } else {
-    // Push the optimal cost to the optimal_cost vector
-    optimal_cost->at(0) =
-        result_double.get_optimal_cost() +
-        b_dyn.transpose() * b_dyn;  // the second term is the cosntant term
-
-    // Residual calculation
-    // TODO(Nanda): Remove the residual calculation after testing on the real
-    // robot
-    VectorXd ddq_val = result_double.GetSolution(ddq_);
-    VectorXd curr_residual = ddq_val * dt;
-    curr_residual -=
-        (output.GetVelocities() -
-         discrete_state->get_vector(previous_velocity_idx_).get_value());
-    VectorXd filtered_residual_double =
-        discrete_state->get_vector(filtered_residual_double_idx_).get_value();
-    filtered_residual_double =
-        filtered_residual_double +
-        alpha_ * (curr_residual - filtered_residual_double);
-    discrete_state->get_mutable_vector(filtered_residual_double_idx_)
-            .get_mutable_value()
-        << filtered_residual_double;
-  }
-
-  // Mathematical program - left contact
-  // Equality constraints
-  left_contact_constraint_->UpdateCoefficients(CL_coeff, -1 * JdotV_cl_active);
-  right_contact_constraint_->UpdateCoefficients(
-      MatrixXd::Zero(n_cr_active_, n_v_ + n_cr_active_),
-      VectorXd::Zero(n_cr_active_));
-  imu_accel_constraint_->UpdateCoefficients(
-      IMU_coeff, -1 * JdotV_imu + imu_accel_wrt_world);
-
-  // Cost
-  A_dyn << M, -1 * J_b.transpose(), -1 * J_cl.transpose(),
-      MatrixXd::Zero(n_v_, n_cr_);
-
-  quadcost_eom_->UpdateCoefficients(
-      2 * A_dyn.transpose() * A_dyn +
-          eps_cost_ * MatrixXd::Identity(A_cols, A_cols),
-      -2 * A_dyn.transpose() * b_dyn);
-  quadcost_eps_cl_->UpdateCoefficients(
-      w_soft_constraint_ * MatrixXd::Identity(n_cl_active_, n_cl_active_),
-      VectorXd::Zero(n_cl_active_));
-  quadcost_eps_cr_->UpdateCoefficients(
-      MatrixXd::Zero(n_cr_active_, n_cr_active_), VectorXd::Zero(n_cr_active_));
-
-  // Initial guess
-  // EqualityConstrainedQPSolver doesn't depend on the initial guess. There is a
-  // closed form solution.
-
-  // Solve the optimization problem
-  drake::solvers::MathematicalProgramResult result_left =
-      solver.Solve(*quadprog_, {}, solver_options);
-
-  if (!result_left.is_success()) {
-    // Push infinity into optimal_cost vector if the optimization fails
-    optimal_cost->at(1) = std::numeric_limits<double>::infinity();
-
-  } else {
-    // Push the optimal cost to the optimal_cost vector
-    optimal_cost->at(1) =
-        result_left.get_optimal_cost() + b_dyn.transpose() * b_dyn;
-
-    // Residual calculation
-    // TODO(Nanda): Remove the residual calculation after testing on the real
-    // robot
-    VectorXd ddq_val = result_left.GetSolution(ddq_);
-    VectorXd curr_residual = ddq_val * dt;
-    curr_residual -=
-        (output.GetVelocities() -
-         discrete_state->get_vector(previous_velocity_idx_).get_value());
-    VectorXd filtered_residual_left =
-        discrete_state->get_vector(filtered_residual_left_idx_).get_value();
-    filtered_residual_left = filtered_residual_left +
-                             alpha_ * (curr_residual - filtered_residual_left);
-    discrete_state->get_mutable_vector(filtered_residual_left_idx_)
-            .get_mutable_value()
-        << filtered_residual_left;
-  }
-
-  // Mathematical program - right contact
-  // Equality constraint
-  left_contact_constraint_->UpdateCoefficients(
-      MatrixXd::Zero(n_cl_active_, n_v_ + n_cl_active_),
-      VectorXd::Zero(n_cl_active_));
-  right_contact_constraint_->UpdateCoefficients(CR_coeff, -1 * JdotV_cr_active);
-  imu_accel_constraint_->UpdateCoefficients(
-      IMU_coeff, -1 * JdotV_imu + imu_accel_wrt_world);
-
-  // Cost
-  A_dyn << M, -1 * J_b.transpose(), MatrixXd::Zero(n_v_, n_cl_),
-      -1 * J_cr.transpose();
-
-  quadcost_eom_->UpdateCoefficients(
-      2 * A_dyn.transpose() * A_dyn +
-          eps_cost_ * MatrixXd::Identity(A_cols, A_cols),
-      -2 * A_dyn.transpose() * b_dyn);
-  quadcost_eps_cl_->UpdateCoefficients(
-      MatrixXd::Zero(n_cl_active_, n_cl_active_), VectorXd::Zero(n_cl_active_));
-  quadcost_eps_cr_->UpdateCoefficients(
-      w_soft_constraint_ * MatrixXd::Identity(n_cr_active_, n_cr_active_),
-      VectorXd::Zero(n_cr_active_));
-
-  // Initial guess
-  // EqualityConstrainedQPSolver doesn't depend on the initial guess. There is a
-  // closed form solution.
-
-  // Solve the optimization problem
-  drake::solvers::MathematicalProgramResult result_right =
-      solver.Solve(*quadprog_, {}, solver_options);
-
-  if (!result_right.is_success()) {
-    // If the optimization fails, push infinity to the optimal_cost vector
-    optimal_cost->at(2) = std::numeric_limits<double>::infinity();
-
-  } else {
-    // Push the optimal cost to optimal_cost vector
-    optimal_cost->at(2) =
-        result_right.get_optimal_cost() + b_dyn.transpose() * b_dyn;
+  // The three problems share the dynamics, fourbar and imu terms, which are
+  // factorized once by the solver. See ContactEstimationSolver.
+  contact_estimation_solver_->Update(
+      M, C, J_b, JdotV_b, J_imu, JdotV_imu, imu_accel_wrt_world, J_cl,
+      J_cl_active, JdotV_cl_active, J_cr, J_cr_active, JdotV_cr_active);
+
+  const std::vector<ContactEstimationSolver::Stance> stances = {
+      ContactEstimationSolver::kDoubleSupport,
+      ContactEstimationSolver::kLeftSupport,
+      ContactEstimationSolver::kRightSupport};
+  const std::vector<int> filtered_residual_indices = {
+      filtered_residual_double_idx_, filtered_residual_left_idx_,
+      filtered_residual_right_idx_};
+  for (int i = 0; i < 3; i++) {
+    const ContactEstimationSolver::Solution solution =
+        contact_estimation_solver_->Solve(stances[i]);
+
+    // If the solve fails, the cost is infinity
+    optimal_cost->at(i) = solution.cost;
+    if (!solution.success) continue;
 
     // Residual calculation
     // TODO(Nanda): Remove the residual calculation after testing on the real
     // robot
-    VectorXd ddq_val = result_right.GetSolution(ddq_);
-    VectorXd curr_residual = ddq_val * dt;
+    VectorXd curr_residual = solution.ddq * dt;
     curr_residual -=
         (output.GetVelocities() -
          discrete_state->get_vector(previous_velocity_idx_).get_value());
-    VectorXd filtered_residual_right =
-        discrete_state->get_vector(filtered_residual_right_idx_).get_value();
-    filtered_residual_right =
-        filtered_residual_right +
-        alpha_ * (curr_residual - filtered_residual_right);
-    discrete_state->get_mutable_vector(filtered_residual_right_idx_)
+    VectorXd filtered_residual =
+        discrete_state->get_vector(filtered_residual_indices[i]).get_value();
+    filtered_residual =
+        filtered_residual + alpha_ * (curr_residual - filtered_residual);
+    discrete_state->get_mutable_vector(filtered_residual_indices[i])
             .get_mutable_value()
-        << filtered_residual_right;
+        << filtered_residual;
   }
 
   // Record previous velocity (used in acceleration residual)
@@ -1037,49 +838,53 @@ EventStatus CassieStateEstimator::Update(
   // This step is done in AssignNonFloatingBaseStateToOutputVector()
 
   // Step 2 - EKF (Propagate step)
-  auto& ekf = state->get_mutable_abstract_state<inekf::InEKF>(ekf_idx_);
-  ekf.Propagate(context.get_discrete_state(prev_imu_idx_).get_value(), dt);
+  ContactInekf<2>::State ekf(state->get_mutable_discrete_state()
+                                 .get_mutable_vector(ekf_idx_)
+                                 .get_mutable_value()
+                                 .data());
+  ekf_->Propagate(context.get_discrete_state(prev_imu_idx_).get_value(), dt,
+                  &ekf);
 
   // Print for debugging
   if (print_info_to_terminal_) {
     cout << "Prediction: " << endl;
     // cout << "Orientation (quaternion) : " << endl;
-    // Quaterniond q_prop = Quaterniond(ekf.getState().getRotation());
+    // Quaterniond q_prop = Quaterniond(ekf.rotation);
     // q_prop.normalize();
     // cout << q_prop.w() << " ";
     // cout << q_prop.vec().transpose() << endl;
     cout << "Velocities: " << endl;
-    cout << ekf.getState().getVelocity().transpose() << endl;
+    cout << ekf.velocity.transpose() << endl;
     cout << "Positions: " << endl;
-    cout << ekf.getState().getPosition().transpose() << endl;
-    // cout << "X: " << endl;
-    // cout << ekf.getState().getX() << endl;
+    cout << ekf.position.transpose() << endl;
+    // cout << "Contact positions: " << endl;
+    // cout << ekf.contact_positions << endl;
     // cout << "P: " << endl;
-    // cout << ekf.getState().getP() << endl;
+    // cout << ekf.P << endl;
     if (test_with_ground_truth_state_) {
       cout << "z difference: "
-           << ekf.getState().getPosition()[2] - imu_pos_wrt_world_gt[6] << endl;
+           << ekf.position[2] - imu_pos_wrt_world_gt[6] << endl;
     }
   }
 
   // Estimated floating base state (pelvis)
   VectorXd estimated_fb_state(13);
-  Vector3d r_imu_to_pelvis_global = ekf.getState().getRotation() * (-imu_pos_);
+  Vector3d r_imu_to_pelvis_global = ekf.rotation * (-imu_pos_);
   // Rotational position
-  Quaterniond q(ekf.getState().getRotation());
+  Quaterniond q(ekf.rotation);
   q.normalize();
   estimated_fb_state[0] = q.w();
   estimated_fb_state.segment<3>(1) = q.vec();
   // Translational position
   estimated_fb_state.segment<3>(4) =
-      ekf.getState().getPosition() + r_imu_to_pelvis_global;
+      ekf.position + r_imu_to_pelvis_global;
   // Rotational velocity
   Vector3d omega_global =
-      ekf.getState().getRotation() * imu_measurement.head(3);
+      ekf.rotation * imu_measurement.head(3);
   estimated_fb_state.segment<3>(7) = omega_global;
   // Translational velocity
   estimated_fb_state.tail(3) =
-      ekf.getState().getVelocity() + omega_global.cross(r_imu_to_pelvis_global);
+      ekf.velocity + omega_global.cross(r_imu_to_pelvis_global);
 
   // Estimated robot output
   OutputVector<double> filtered_output(n_q_, n_v_, n_u_);
@@ -1114,7 +919,7 @@ EventStatus CassieStateEstimator::Update(
     right_contact = 1;
 
     if ((*counter_for_testing_) % 5000 == 0) {
-      cout << "pos = " << ekf.getState().getPosition().transpose() << endl;
+      cout << "pos = " << ekf.position.transpose() << endl;
     }
     *counter_for_testing_ = *counter_for_testing_ + 1;
   } else if (hardware_test_mode_ == 1) {
@@ -1122,24 +927,22 @@ EventStatus CassieStateEstimator::Update(
     right_contact = 0;
   }
 
-  std::vector<std::pair<int, bool>> contacts;
-  contacts.push_back(std::pair<int, bool>(0, left_contact));
-  contacts.push_back(std::pair<int, bool>(1, right_contact));
-  ekf.setContacts(contacts);
+  const std::array<bool, 2> contacts = {left_contact != 0,
+                                        right_contact != 0};
 
   // Step 4 - EKF (measurement step)
   plant_.SetPositionsAndVelocities(context_.get(), filtered_output.GetState());
 
-  // rotation part of pose and covariance is unused in EKF
-  Eigen::Matrix4d pose = Eigen::Matrix4d::Identity();
-  Eigen::Matrix<double, 6, 6> covariance = MatrixXd::Identity(6, 6);
+  // Positions of the contact points relative to the imu and their covariance
+  ContactInekf<2>::ContactPositions contact_positions;
+  std::array<Matrix3d, 2> contact_covariances;
 
   if (test_with_ground_truth_state_) {
     // Print for debugging
     if (print_info_to_terminal_) {
       cout << "Rotation differences: " << endl;
       cout << "Rotation matrix from EKF: " << endl;
-      cout << ekf.getState().getRotation() << endl;
+      cout << ekf.rotation << endl;
       cout << "Ground truth rotation: " << endl;
       Quaterniond q_real;
       q_real.w() = output_gt.GetPositions()[0];
@@ -1149,59 +952,55 @@ EventStatus CassieStateEstimator::Update(
     }
   }
 
-  inekf::vectorKinematics measured_kinematics;
   Vector3d toe_pos = Vector3d::Zero();
   MatrixXd J = MatrixXd::Zero(3, n_v_);
   for (int i = 0; i < 2; i++) {
     plant_.CalcPointsPositions(*context_, *toe_frames_[i], rear_contact_disp_,
                                pelvis_frame_, &toe_pos);
-    pose.block<3, 3>(0, 0) = Matrix3d::Identity();
-    pose.block<3, 1>(0, 3) = toe_pos - imu_pos_;
+    contact_positions.col(i) = toe_pos - imu_pos_;
 
     if (print_info_to_terminal_) {
       // Print for debugging
       // cout << "Pose: " << endl;
-      // cout << pose.block<3, 1>(0, 3).transpose() << endl;
+      // cout << contact_positions.col(i).transpose() << endl;
     }
 
     plant_.CalcJacobianTranslationalVelocity(
         *context_, JacobianWrtVariable::kV, *toe_frames_[i], rear_contact_disp_,
         pelvis_frame_, pelvis_frame_, &J);
     MatrixXd J_wrt_joints = J.block(0, 6, 3, 16);
-    covariance.block<3, 3>(3, 3) =
-        J_wrt_joints * cov_w_ * J_wrt_joints.transpose();
-    inekf::Kinematics frame(i, pose, covariance);
-    measured_kinematics.push_back(frame);
+    contact_covariances[i] = J_wrt_joints * cov_w_ * J_wrt_joints.transpose();
 
     if (print_info_to_terminal_) {
-      cout << "covariance.block<3, 3>(3, 3) = \n"
-           << covariance.block<3, 3>(3, 3) << endl;
+      cout << "contact covariance = \n" << contact_covariances[i] << endl;
     }
   }
-  ekf.CorrectKinematics(measured_kinematics);
+  ekf_->CorrectContacts(contacts, contact_positions, contact_covariances,
+                        &ekf);
 
   if (print_info_to_terminal_) {
     // Print for debugging
-    q = Quaterniond(ekf.getState().getRotation()).normalized();
+    q = Quaterniond(ekf.rotation).normalized();
     cout << "Update: " << endl;
     // cout << "Orientation (quaternion) : " << endl;
     // cout << q.w() << " ";
     // cout << q.vec().transpose() << endl;
     cout << "Velocities: " << endl;
-    cout << ekf.getState().getVelocity().transpose() << endl;
+    cout << ekf.velocity.transpose() << endl;
     cout << "Positions: " << endl;
-    cout << ekf.getState().getPosition().transpose() << endl;
-    // cout << "X: " << endl;
-    // cout << ekf.getState().getX() << endl;
-    // cout << "Theta: " << endl;
-    // cout << ekf.getState().getTheta() << endl;
+    cout << ekf.position.transpose() << endl;
+    // cout << "Contact positions: " << endl;
+    // cout << ekf.contact_positions << endl;
+    // cout << "Biases: " << endl;
+    // cout << ekf.gyroscope_bias.transpose() << " "
+    //      << ekf.accelerometer_bias.transpose() << endl;
     // cout << "P: " << endl;
-    // cout << ekf.getState().getP() << endl;
+    // cout << ekf.P << endl;
   }
   if (test_with_ground_truth_state_) {
     if (print_info_to_terminal_) {
       cout << "z difference: "
-           << ekf.getState().getPosition()[2] - imu_pos_wrt_world_gt[6] << endl;
+           << ekf.position[2] - imu_pos_wrt_world_gt[6] << endl;
     }
   }
   if (print_info_to_terminal_) {
@@ -1213,19 +1012,19 @@ EventStatus CassieStateEstimator::Update(
   // We get the angular velocity directly from the IMU without filtering
   // because the magnitude of noise is about 2e-3.
   // Rotational position
-  q = Quaterniond(ekf.getState().getRotation()).normalized();
+  q = Quaterniond(ekf.rotation).normalized();
   estimated_fb_state[0] = q.w();
   estimated_fb_state.segment<3>(1) = q.vec();
   // Translational position
-  r_imu_to_pelvis_global = ekf.getState().getRotation() * (-imu_pos_);
+  r_imu_to_pelvis_global = ekf.rotation * (-imu_pos_);
   estimated_fb_state.segment<3>(4) =
-      ekf.getState().getPosition() + r_imu_to_pelvis_global;
+      ekf.position + r_imu_to_pelvis_global;
   // Rotational velocity
-  omega_global = ekf.getState().getRotation() * imu_measurement.head(3);
+  omega_global = ekf.rotation * imu_measurement.head(3);
   estimated_fb_state.segment<3>(7) = omega_global;
   // Translational velocity
   estimated_fb_state.tail(3) =
-      ekf.getState().getVelocity() + omega_global.cross(r_imu_to_pelvis_global);
+      ekf.velocity + omega_global.cross(r_imu_to_pelvis_global);
   state->get_mutable_discrete_state()
           .get_mutable_vector(fb_state_idx_)
           .get_mutable_value()
@@ -1286,15 +1085,13 @@ void CassieStateEstimator::setInitialPelvisPose(Context<double>* context,
   Matrix3d imu_rot_mat =
       Quaterniond(quat[0], quat[1], quat[2], quat[3]).toRotationMatrix();
   Vector3d imu_position = pelvis_pos + imu_rot_mat * imu_pos_;
-  auto& filter = context->get_mutable_abstract_state<inekf::InEKF>(ekf_idx_);
-  auto state = filter.getState();
-  state.setPosition(imu_position);
-  state.setRotation(imu_rot_mat);
-  filter.setState(state);
+  ContactInekf<2>::State filter(
+      context->get_mutable_discrete_state(ekf_idx_).get_mutable_value().data());
+  filter.position = imu_position;
+  filter.rotation = imu_rot_mat;
   cout << "Set initial IMU position to \n"
-       << filter.getState().getPosition().transpose() << endl;
-  cout << "Set initial IMU rotation to \n"
-       << filter.getState().getRotation() << endl;
+       << filter.position.transpose() << endl;
+  cout << "Set initial IMU rotation to \n" << filter.rotation << endl;
 }
 void CassieStateEstimator::setPreviousImuMeasurement(
     Context<double>* context, const VectorXd& imu_value) const {
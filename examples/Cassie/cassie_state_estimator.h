@@ -6,16 +6,18 @@
 #include <fstream>
 #include <memory>
 
+#include "drake/math/rigid_transform.h"
 #include "drake/multibody/plant/multibody_plant.h"
-#include "drake/solvers/mathematical_program.h"
 #include "drake/systems/framework/leaf_system.h"
-#include "src/InEKF.h"
 
+#include "multibody/index_map.h"
 #include "multibody/multibody_utils.h"
 #include "systems/framework/output_vector.h"
 #include "systems/framework/timestamped_vector.h"
 #include "examples/Cassie/datatypes/cassie_out_t.h"
 #include "examples/Cassie/cassie_utils.h"
+#include "examples/Cassie/contact_estimation_solver.h"
+#include "examples/Cassie/contact_inekf.h"
 #include "multibody/kinematic/kinematic_evaluator_set.h"
 
 namespace dairlib {
@@ -142,6 +144,17 @@ class CassieStateEstimator : public drake::systems::LeafSystem<double> {
   std::map<std::string, int> velocity_idx_map_;
   std::map<std::string, int> actuator_idx_map_;
 
+  // Maps from the motor/joint measurements of cassie_out_t (packed in the
+  // order of the names in the constructor) to the plant coordinates, so that
+  // no name lookup is done at run time
+  multibody::IndexMap motor_effort_map_;
+  multibody::IndexMap joint_position_map_;
+  multibody::IndexMap joint_velocity_map_;
+  multibody::IndexMap floating_base_position_map_;
+  multibody::IndexMap floating_base_velocity_map_;
+  int left_heel_spring_idx_;
+  int right_heel_spring_idx_;
+
   // Body frames
   std::vector<const drake::multibody::Frame<double>*> toe_frames_;
   const drake::multibody::Frame<double>& pelvis_frame_;
@@ -156,7 +169,7 @@ class CassieStateEstimator : public drake::systems::LeafSystem<double> {
   drake::systems::DiscreteStateIndex time_idx_;
   // States related to EKF
   drake::systems::DiscreteStateIndex fb_state_idx_;
-  drake::systems::AbstractStateIndex ekf_idx_;
+  drake::systems::DiscreteStateIndex ekf_idx_;
   drake::systems::DiscreteStateIndex prev_imu_idx_;
   // A state related to contact estimation
   // This state store the previous generalized velocity
@@ -176,6 +189,22 @@ class CassieStateEstimator : public drake::systems::LeafSystem<double> {
       std::pair<const Eigen::Vector3d, const drake::multibody::Frame<double>&>>
       rod_on_heel_springs_;
   double rod_length_;
+  // Revolute joint of the chain from a thigh to its heel spring
+  struct FourbarChainJoint {
+    // Pose of the joint frame in the parent body frame
+    drake::math::RigidTransformd X_PF;
+    // Pose of the child body frame in the joint child frame
+    drake::math::RigidTransformd X_MC;
+    Eigen::Vector3d axis;
+    int position_index;
+  };
+  // Joints from the thigh body to the heel spring body of each leg, so that
+  // solveFourbarLinkage() doesn't evaluate the kinematics of the whole plant
+  std::vector<std::vector<FourbarChainJoint>> fourbar_chains_;
+  // Rod end on each thigh, in the thigh body frame
+  std::vector<Eigen::Vector3d> rod_on_thigh_bodies_;
+  // Pose of each heel spring frame of rod_on_heel_springs_ in its body frame
+  std::vector<drake::math::RigidTransformd> heel_spring_frame_poses_;
   Eigen::Vector3d front_contact_disp_;
   Eigen::Vector3d rear_contact_disp_;
   Eigen::Vector3d mid_contact_disp_;
@@ -183,6 +212,8 @@ class CassieStateEstimator : public drake::systems::LeafSystem<double> {
   Eigen::Vector3d imu_pos_ = Eigen::Vector3d(0.03155, 0, -0.07996);
   Eigen::Vector3d gravity_ = Eigen::Vector3d(0, 0, -9.81);
 
+  // EKF kernel (the state of the filter is stored in ekf_idx_)
+  std::unique_ptr<ContactInekf<2>> ekf_;
   // EKF encoder noise
   Eigen::Matrix<double, 16, 16> cov_w_;
 
@@ -208,31 +239,13 @@ class CassieStateEstimator : public drake::systems::LeafSystem<double> {
                               // residual. 0 < alpha_ < 1. The bigger alpha_ is,
                               // the higher the cut-off frequency is.
   // Contact Estimation - Quadratic Programing
-  // MathematicalProgram
-  std::unique_ptr<drake::solvers::MathematicalProgram> quadprog_;
+  std::unique_ptr<ContactEstimationSolver> contact_estimation_solver_;
   // Variable dimensions
   int n_b_;
   int n_cl_;
   int n_cl_active_;
   int n_cr_;
   int n_cr_active_;
-  // Cost and constraints (Bindings)
-  drake::solvers::LinearEqualityConstraint* fourbar_constraint_;
-  drake::solvers::LinearEqualityConstraint* left_contact_constraint_;
-  drake::solvers::LinearEqualityConstraint* right_contact_constraint_;
-  drake::solvers::LinearEqualityConstraint* imu_accel_constraint_;
-  drake::solvers::QuadraticCost* quadcost_eom_;
-  drake::solvers::QuadraticCost* quadcost_eps_cl_;
-  drake::solvers::QuadraticCost* quadcost_eps_cr_;
-  drake::solvers::QuadraticCost* quadcost_eps_imu_;
-  // Decision variables
-  drake::solvers::VectorXDecisionVariable ddq_;
-  drake::solvers::VectorXDecisionVariable lambda_b_;
-  drake::solvers::VectorXDecisionVariable lambda_cl_;
-  drake::solvers::VectorXDecisionVariable lambda_cr_;
-  drake::solvers::VectorXDecisionVariable eps_cl_;
-  drake::solvers::VectorXDecisionVariable eps_cr_;
-  drake::solvers::VectorXDecisionVariable eps_imu_;
 
   // flag for testing and tuning
   std::unique_ptr<drake::systems::Context<double>> context_gt_;
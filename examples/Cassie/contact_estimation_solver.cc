@@ -0,0 +1,157 @@
+#include "examples/Cassie/contact_estimation_solver.h"
+
+#include <limits>
+
+#include "drake/common/drake_assert.h"
+
+namespace dairlib {
+namespace systems {
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+ContactEstimationSolver::ContactEstimationSolver(
+    int n_v, int n_b, int n_cl, int n_cl_active, int n_cr, int n_cr_active,
+    double w_soft_constraint, double eps_cost, double feasibility_tol)
+    : n_v_(n_v),
+      n_b_(n_b),
+      n_cl_(n_cl),
+      n_cl_active_(n_cl_active),
+      n_cr_(n_cr),
+      n_cr_active_(n_cr_active),
+      w_soft_constraint_(w_soft_constraint),
+      eps_cost_(eps_cost),
+      feasibility_tol_(feasibility_tol) {
+  DRAKE_DEMAND(w_soft_constraint > 0);
+  DRAKE_DEMAND(eps_cost > 0);
+}
+
+void ContactEstimationSolver::Update(
+    const MatrixXd& M, const VectorXd& C, const MatrixXd& J_b,
+    const VectorXd& JdotV_b, const MatrixXd& J_imu, const VectorXd& JdotV_imu,
+    const VectorXd& imu_accel, const MatrixXd& J_cl,
+    const MatrixXd& J_cl_active, const VectorXd& JdotV_cl_active,
+    const MatrixXd& J_cr, const MatrixXd& J_cr_active,
+    const VectorXd& JdotV_cr_active) {
+  DRAKE_DEMAND(M.rows() == n_v_ && J_b.rows() == n_b_);
+  DRAKE_DEMAND(J_cl.rows() == n_cl_ && J_cl_active.rows() == n_cl_active_);
+  DRAKE_DEMAND(J_cr.rows() == n_cr_ && J_cr_active.rows() == n_cr_active_);
+  const int n_y = n_v_ + n_b_;
+  const double w = w_soft_constraint_;
+
+  E_.resize(n_v_, n_y);
+  E_ << M, -J_b.transpose();
+  b_dyn_ = -C;
+  J_b_ = J_b;
+  JdotV_b_ = JdotV_b;
+  J_imu_ = J_imu;
+  r_imu_ = imu_accel - JdotV_imu;
+  J_cl_ = J_cl;
+  J_cr_ = J_cr;
+  J_cl_active_ = J_cl_active;
+  J_cr_active_ = J_cr_active;
+  r_cl_ = -JdotV_cl_active;
+  r_cr_ = -JdotV_cr_active;
+
+  // KKT system of the shared terms, with y = (ddq, λ_b). The imu slack is
+  // eliminated into a quadratic cost on ddq.
+  MatrixXd K = MatrixXd::Zero(n_y + n_b_, n_y + n_b_);
+  K.topLeftCorner(n_y, n_y) = 2 * E_.transpose() * E_;
+  K.topLeftCorner(n_y, n_y).diagonal().array() += eps_cost_;
+  K.topLeftCorner(n_v_, n_v_) += w * J_imu.transpose() * J_imu;
+  K.block(0, n_y, n_v_, n_b_) = J_b.transpose();
+  K.block(n_y, 0, n_b_, n_v_) = J_b;
+  VectorXd g(n_y + n_b_);
+  g.head(n_y) = 2 * E_.transpose() * b_dyn_;
+  g.head(n_v_) += w * J_imu.transpose() * r_imu_;
+  g.tail(n_b_) = -JdotV_b;
+
+  // Border of each foot: its contact forces λ, and the multipliers
+  // μ = w (J_active ddq - r) of its stance constraint, which eliminate the
+  // slack variables.
+  const int n_l = n_cl_ + n_cl_active_;
+  const int n_r = n_cr_ + n_cr_active_;
+  W_ = MatrixXd::Zero(n_y + n_b_, n_l + n_r);
+  W_.block(0, 0, n_y, n_cl_) = -2 * E_.transpose() * J_cl.transpose();
+  W_.block(0, n_cl_, n_v_, n_cl_active_) = J_cl_active.transpose();
+  W_.block(0, n_l, n_y, n_cr_) = -2 * E_.transpose() * J_cr.transpose();
+  W_.block(0, n_l + n_cr_, n_v_, n_cr_active_) = J_cr_active.transpose();
+
+  D_ = MatrixXd::Zero(n_l + n_r, n_l + n_r);
+  D_.block(0, 0, n_cl_, n_cl_) = 2 * J_cl * J_cl.transpose();
+  D_.block(n_l, n_l, n_cr_, n_cr_) = 2 * J_cr * J_cr.transpose();
+  D_.block(0, n_l, n_cl_, n_cr_) = 2 * J_cl * J_cr.transpose();
+  D_.block(n_l, 0, n_cr_, n_cl_) = D_.block(0, n_l, n_cl_, n_cr_).transpose();
+  D_.block(0, 0, n_cl_, n_cl_).diagonal().array() += eps_cost_;
+  D_.block(n_l, n_l, n_cr_, n_cr_).diagonal().array() += eps_cost_;
+  D_.block(n_cl_, n_cl_, n_cl_active_, n_cl_active_).diagonal().array() =
+      -1 / w;
+  D_.block(n_l + n_cr_, n_l + n_cr_, n_cr_active_, n_cr_active_)
+      .diagonal()
+      .array() = -1 / w;
+
+  h_.resize(n_l + n_r);
+  h_ << -2 * J_cl * b_dyn_, r_cl_, -2 * J_cr * b_dyn_, r_cr_;
+
+  // The only factorization of the update
+  Eigen::PartialPivLU<MatrixXd> K_lu(K);
+  K_inv_W_ = K_lu.solve(W_);
+  K_inv_g_ = K_lu.solve(g);
+  factorization_success_ = K_inv_W_.allFinite() && K_inv_g_.allFinite();
+}
+
+ContactEstimationSolver::Solution ContactEstimationSolver::Solve(
+    Stance stance) const {
+  const int n_l = n_cl_ + n_cl_active_;
+  const int n_r = n_cr_ + n_cr_active_;
+  const bool left = (stance != kRightSupport);
+  const bool right = (stance != kLeftSupport);
+  // The borders of the stance feet are contiguous columns of W
+  const int start = left ? 0 : n_l;
+  const int size = (left ? n_l : 0) + (right ? n_r : 0);
+
+  Solution solution;
+  solution.cost = std::numeric_limits<double>::infinity();
+  if (!factorization_success_) return solution;
+
+  // Schur complement of K
+  const auto W = W_.middleCols(start, size);
+  const auto K_inv_W = K_inv_W_.middleCols(start, size);
+  const MatrixXd S =
+      D_.block(start, start, size, size) - W.transpose() * K_inv_W;
+  const VectorXd u = S.partialPivLu().solve(h_.segment(start, size) -
+                                            W.transpose() * K_inv_g_);
+  const VectorXd y = (K_inv_g_ - K_inv_W * u).head(n_v_ + n_b_);
+  solution.ddq = y.head(n_v_);
+  if (!u.allFinite() || !y.allFinite() ||
+      (J_b_ * solution.ddq + JdotV_b_).lpNorm<Eigen::Infinity>() >
+          feasibility_tol_) {
+    return solution;
+  }
+
+  // Cost, with the slack variables recovered from ddq
+  VectorXd eom_residual = E_ * y - b_dyn_;
+  double cost = y.squaredNorm() * eps_cost_ / 2 +
+                (J_imu_ * solution.ddq - r_imu_).squaredNorm() *
+                    w_soft_constraint_ / 2;
+  if (left) {
+    const VectorXd lambda_cl = u.head(n_cl_);
+    eom_residual -= J_cl_.transpose() * lambda_cl;
+    cost += lambda_cl.squaredNorm() * eps_cost_ / 2 +
+            (J_cl_active_ * solution.ddq - r_cl_).squaredNorm() *
+                w_soft_constraint_ / 2;
+  }
+  if (right) {
+    const VectorXd lambda_cr = u.segment(left ? n_l : 0, n_cr_);
+    eom_residual -= J_cr_.transpose() * lambda_cr;
+    cost += lambda_cr.squaredNorm() * eps_cost_ / 2 +
+            (J_cr_active_ * solution.ddq - r_cr_).squaredNorm() *
+                w_soft_constraint_ / 2;
+  }
+  solution.cost = cost + eom_residual.squaredNorm();
+  solution.success = true;
+  return solution;
+}
+
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+namespace dairlib {
+namespace systems {
+
+/// ContactEstimationSolver solves the least squares problems of the contact
+/// estimation of CassieStateEstimator, which fit the equations of motion under
+/// the double, left and right support hypotheses:
+///
+///   min   |M ddq - J_bᵀ λ_b - J_clᵀ λ_cl - J_crᵀ λ_cr + C|²
+///         + eps_cost / 2 |(ddq, λ)|²
+///         + w / 2 (|eps_imu|² + |eps_cl|² + |eps_cr|²)
+///   s.t.  J_b ddq + JdotV_b = 0
+///         J_imu ddq + JdotV_imu + eps_imu = imu_accel
+///         J_cl_active ddq + JdotV_cl + eps_cl = 0    (left foot in stance)
+///         J_cr_active ddq + JdotV_cr + eps_cr = 0    (right foot in stance)
+///
+/// where the forces and slacks of a swing foot are removed from the problem.
+///
+/// Instead of solving three equality constrained QPs, the slack variables are
+/// eliminated, and the KKT system of the terms shared by all hypotheses
+/// (dynamics, fourbar linkage and imu) is factorized once per update. Each foot
+/// then only borders this system with its contact forces and its stance
+/// constraint, so that a hypothesis is solved by a Schur complement of the
+/// size of the forces and constraints of its stance feet.
+class ContactEstimationSolver {
+ public:
+  enum Stance { kDoubleSupport = 0, kLeftSupport = 1, kRightSupport = 2 };
+
+  struct Solution {
+    bool success = false;
+    /// Optimal cost, including the constant term |C|²
+    double cost = 0;
+    Eigen::VectorXd ddq;
+  };
+
+  /// @param n_v number of velocities
+  /// @param n_b number of fourbar linkage constraints
+  /// @param n_cl number of left contact forces
+  /// @param n_cl_active number of active left contact constraints
+  /// @param n_cr number of right contact forces
+  /// @param n_cr_active number of active right contact constraints
+  /// @param w_soft_constraint weight of the slack variables
+  /// @param eps_cost regularization of the accelerations and forces
+  /// @param feasibility_tol tolerance on the fourbar linkage constraints, above
+  /// which a solution is unsuccessful
+  ContactEstimationSolver(int n_v, int n_b, int n_cl, int n_cl_active,
+                          int n_cr, int n_cr_active, double w_soft_constraint,
+                          double eps_cost, double feasibility_tol = 1e-6);
+
+  /// Sets the data of the problems and factorizes the shared KKT system.
+  /// @param M mass matrix
+  /// @param C bias term, including the gravity, force elements and actuation
+  /// @param J_b, JdotV_b fourbar linkage Jacobian and JdotV
+  /// @param J_imu, JdotV_imu translational Jacobian and JdotV of the imu
+  /// @param imu_accel imu acceleration in the world frame
+  /// @param J_cl, J_cr full contact Jacobians (one row per contact force)
+  /// @param J_cl_active, JdotV_cl_active active left contact Jacobian, JdotV
+  /// @param J_cr_active, JdotV_cr_active active right contact Jacobian, JdotV
+  void Update(const Eigen::MatrixXd& M, const Eigen::VectorXd& C,
+              const Eigen::MatrixXd& J_b, const Eigen::VectorXd& JdotV_b,
+              const Eigen::MatrixXd& J_imu, const Eigen::VectorXd& JdotV_imu,
+              const Eigen::VectorXd& imu_accel, const Eigen::MatrixXd& J_cl,
+              const Eigen::MatrixXd& J_cl_active,
+              const Eigen::VectorXd& JdotV_cl_active,
+              const Eigen::MatrixXd& J_cr,
+              const Eigen::MatrixXd& J_cr_active,
+              const Eigen::VectorXd& JdotV_cr_active);
+
+  /// Solves the problem of one of the hypotheses. Update() must be called
+  /// first.
+  Solution Solve(Stance stance) const;
+
+ private:
+  const int n_v_;
+  const int n_b_;
+  const int n_cl_;
+  const int n_cl_active_;
+  const int n_cr_;
+  const int n_cr_active_;
+  const double w_soft_constraint_;
+  const double eps_cost_;
+  const double feasibility_tol_;
+
+  // Problem data
+  Eigen::MatrixXd E_;  // [M, -J_bᵀ], dynamics of (ddq, λ_b)
+  Eigen::VectorXd b_dyn_;
+  Eigen::MatrixXd J_b_;
+  Eigen::VectorXd JdotV_b_;
+  Eigen::MatrixXd J_imu_;
+  Eigen::VectorXd r_imu_;
+  Eigen::MatrixXd J_cl_;
+  Eigen::MatrixXd J_cr_;
+  Eigen::MatrixXd J_cl_active_;
+  Eigen::MatrixXd J_cr_active_;
+  Eigen::VectorXd r_cl_;
+  Eigen::VectorXd r_cr_;
+
+  // Shared KKT system of (ddq, λ_b, fourbar multipliers), bordered by the
+  // forces and stance constraints of both feet:
+  //   [K  W] [y]   [g]
+  //   [Wᵀ D] [u] = [h]
+  Eigen::MatrixXd W_;
+  Eigen::MatrixXd D_;
+  Eigen::VectorXd h_;
+  // Solutions of K X = W and K x = g
+  Eigen::MatrixXd K_inv_W_;
+  Eigen::VectorXd K_inv_g_;
+  bool factorization_success_ = false;
+};
+
+}  // namespace systems
+}  // namespace dairlib
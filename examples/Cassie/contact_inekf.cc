@@ -0,0 +1,345 @@
+#include "examples/Cassie/contact_inekf.h"
+
+#include <cmath>
+
+namespace dairlib {
+namespace systems {
+
+using Eigen::Matrix3d;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+
+namespace {
+
+// Tolerance of the small angle approximations, as in inekf
+const double kTolerance = 1e-10;
+
+Matrix3d Skew(const Vector3d& v) {
+  Matrix3d M;
+  M << 0, -v(2), v(1), v(2), 0, -v(0), -v(1), v(0), 0;
+  return M;
+}
+
+Matrix3d ExpSO3(const Vector3d& w) {
+  const double theta = w.norm();
+  if (theta < kTolerance) return Matrix3d::Identity();
+  const Matrix3d A = Skew(w);
+  return Matrix3d::Identity() + (std::sin(theta) / theta) * A +
+         ((1 - std::cos(theta)) / (theta * theta)) * A * A;
+}
+
+Matrix3d LeftJacobianSO3(const Vector3d& w) {
+  const double theta = w.norm();
+  if (theta < kTolerance) return Matrix3d::Identity();
+  const Matrix3d A = Skew(w);
+  return Matrix3d::Identity() +
+         ((1 - std::cos(theta)) / (theta * theta)) * A +
+         ((theta - std::sin(theta)) / (theta * theta * theta)) * A * A;
+}
+
+}  // namespace
+
+template <int kNumContacts>
+ContactInekf<kNumContacts>::State::State(double* data)
+    : rotation(data),
+      velocity(data + 9),
+      position(data + 12),
+      contact_positions(data + 15),
+      gyroscope_bias(data + 15 + 3 * kNumContacts),
+      accelerometer_bias(data + 18 + 3 * kNumContacts),
+      contact_estimated(data + 21 + 3 * kNumContacts),
+      P(data + 21 + 4 * kNumContacts) {}
+
+template <int kNumContacts>
+ContactInekf<kNumContacts>::ContactInekf(const NoiseParams& noise_params,
+                                         const Vector3d& gravity,
+                                         Implementation implementation)
+    : gravity_(gravity),
+      implementation_(implementation),
+      gyroscope_cov_(noise_params.gyroscope * noise_params.gyroscope),
+      accelerometer_cov_(noise_params.accelerometer *
+                         noise_params.accelerometer),
+      gyroscope_bias_cov_(noise_params.gyroscope_bias *
+                          noise_params.gyroscope_bias),
+      accelerometer_bias_cov_(noise_params.accelerometer_bias *
+                              noise_params.accelerometer_bias),
+      contact_cov_(noise_params.contact * noise_params.contact) {}
+
+template <int kNumContacts>
+VectorXd ContactInekf<kNumContacts>::MakeState(
+    const Matrix3d& rotation, const Vector3d& velocity,
+    const Vector3d& position, const Vector3d& gyroscope_bias,
+    const Vector3d& accelerometer_bias,
+    const Eigen::Matrix<double, 15, 15>& P) {
+  VectorXd data = VectorXd::Zero(kStateSize);
+  State state(data.data());
+  state.rotation = rotation;
+  state.velocity = velocity;
+  state.position = position;
+  state.gyroscope_bias = gyroscope_bias;
+  state.accelerometer_bias = accelerometer_bias;
+  state.P.template topLeftCorner<9, 9>() = P.topLeftCorner<9, 9>();
+  state.P.template block<9, 6>(0, kThetaIndex) = P.topRightCorner<9, 6>();
+  state.P.template block<6, 9>(kThetaIndex, 0) = P.bottomLeftCorner<6, 9>();
+  state.P.template bottomRightCorner<6, 6>() = P.bottomRightCorner<6, 6>();
+  return data;
+}
+
+template <int kNumContacts>
+void ContactInekf<kNumContacts>::Propagate(
+    const Eigen::Matrix<double, 6, 1>& imu, double dt, State* state) const {
+  // Bias corrected imu measurements
+  const Vector3d w = imu.head<3>() - state->gyroscope_bias;
+  const Vector3d a = imu.tail<3>() - state->accelerometer_bias;
+
+  // The error dynamics are linearized at the state before the propagation
+  if (implementation_ == Implementation::kDense) {
+    PropagateCovarianceDense(dt, state);
+  } else {
+    PropagateCovarianceStructured(dt, state);
+  }
+
+  // Propagate the mean (the biases and contact positions are constant)
+  const Matrix3d R = state->rotation;
+  const Vector3d v = state->velocity;
+  state->rotation = R * ExpSO3(w * dt);
+  state->velocity = v + (R * a + gravity_) * dt;
+  state->position += v * dt + 0.5 * (R * a + gravity_) * dt * dt;
+}
+
+template <int kNumContacts>
+void ContactInekf<kNumContacts>::PropagateCovarianceDense(
+    double dt, State* state) const {
+  const Matrix3d R = state->rotation;
+  const Vector3d v = state->velocity;
+  const Vector3d p = state->position;
+
+  // Linearized invariant error dynamics, adjoint and process noise
+  CovarianceMatrix A = CovarianceMatrix::Zero();
+  A.template block<3, 3>(3, 0) = Skew(gravity_);
+  A.template block<3, 3>(6, 3) = Matrix3d::Identity();
+  A.template block<3, 3>(0, kThetaIndex) = -R;
+  A.template block<3, 3>(3, kThetaIndex + 3) = -R;
+  A.template block<3, 3>(3, kThetaIndex) = -Skew(v) * R;
+  A.template block<3, 3>(6, kThetaIndex) = -Skew(p) * R;
+  CovarianceMatrix Adj = CovarianceMatrix::Identity();
+  Adj.template block<3, 3>(0, 0) = R;
+  Adj.template block<3, 3>(3, 3) = R;
+  Adj.template block<3, 3>(6, 6) = R;
+  Adj.template block<3, 3>(3, 0) = Skew(v) * R;
+  Adj.template block<3, 3>(6, 0) = Skew(p) * R;
+  Eigen::Matrix<double, kDimP, 1> Qk;
+  Qk.setZero();
+  Qk.template segment<3>(0).setConstant(gyroscope_cov_);
+  Qk.template segment<3>(3).setConstant(accelerometer_cov_);
+  Qk.template segment<3>(kThetaIndex).setConstant(gyroscope_bias_cov_);
+  Qk.template segment<3>(kThetaIndex + 3).setConstant(accelerometer_bias_cov_);
+  for (int i = 0; i < kNumContacts; i++) {
+    if (!state->contact_estimated(i)) continue;
+    const Matrix3d d_R = Skew(state->contact_positions.col(i)) * R;
+    A.template block<3, 3>(ContactIndex(i), kThetaIndex) = -d_R;
+    Adj.template block<3, 3>(ContactIndex(i), ContactIndex(i)) = R;
+    Adj.template block<3, 3>(ContactIndex(i), 0) = d_R;
+    Qk.template segment<3>(ContactIndex(i)).setConstant(contact_cov_);
+  }
+
+  // First order approximation of the discretization used by inekf
+  const CovarianceMatrix Phi = CovarianceMatrix::Identity() + A * dt;
+  const CovarianceMatrix PhiAdj = Phi * Adj;
+  state->P = Phi * state->P * Phi.transpose() +
+             PhiAdj * Qk.asDiagonal() * PhiAdj.transpose() * dt;
+}
+
+template <int kNumContacts>
+void ContactInekf<kNumContacts>::PropagateCovarianceStructured(
+    double dt, State* state) const {
+  const Matrix3d R = state->rotation;
+  const Matrix3d S_g = Skew(gravity_);
+  const Matrix3d S_v = Skew(state->velocity);
+  const Matrix3d S_p = Skew(state->position);
+  std::array<Matrix3d, kNumContacts> S_d;
+  for (int i = 0; i < kNumContacts; i++) {
+    S_d[i] = Skew(state->contact_positions.col(i));
+  }
+
+  // P_pred = Phi (P + Adj Qk Adjᵀ dt) Phiᵀ, with Phi = I + A dt. Since the
+  // noises are isotropic, the rotations of Adj cancel out in Adj Qk Adjᵀ,
+  // which is q_gyro L Lᵀ, with L = [I; S_v; S_p; S_d], plus the diagonal noise
+  // of the other errors.
+  Eigen::Matrix<double, kThetaIndex, 3> L;
+  L.template topRows<3>().setIdentity();
+  L.template middleRows<3>(3) = S_v;
+  L.template middleRows<3>(6) = S_p;
+  for (int i = 0; i < kNumContacts; i++) {
+    L.template middleRows<3>(ContactIndex(i)) = S_d[i];
+  }
+  CovarianceMatrix M = state->P;
+  M.template topLeftCorner<kThetaIndex, kThetaIndex>() +=
+      (gyroscope_cov_ * dt) * L * L.transpose();
+  auto diagonal = M.diagonal();
+  diagonal.template segment<3>(3).array() += accelerometer_cov_ * dt;
+  for (int i = 0; i < kNumContacts; i++) {
+    if (!state->contact_estimated(i)) continue;
+    diagonal.template segment<3>(ContactIndex(i)).array() += contact_cov_ * dt;
+  }
+  diagonal.template segment<3>(kThetaIndex).array() += gyroscope_bias_cov_ * dt;
+  diagonal.template segment<3>(kThetaIndex + 3).array() +=
+      accelerometer_bias_cov_ * dt;
+
+  // Product by A, block row by block row. The rows of the biases are zero.
+  auto apply_A = [&](const CovarianceMatrix& X) {
+    CovarianceMatrix AX;
+    AX.template bottomRows<6>().setZero();
+    const Eigen::Matrix<double, 3, kDimP> RX_g =
+        R * X.template middleRows<3>(kThetaIndex);
+    AX.template middleRows<3>(0) = -RX_g;
+    AX.template middleRows<3>(3) =
+        S_g * X.template middleRows<3>(0) - S_v * RX_g -
+        R * X.template middleRows<3>(kThetaIndex + 3);
+    AX.template middleRows<3>(6) = X.template middleRows<3>(3) - S_p * RX_g;
+    for (int i = 0; i < kNumContacts; i++) {
+      if (state->contact_estimated(i)) {
+        AX.template middleRows<3>(ContactIndex(i)) = -S_d[i] * RX_g;
+      } else {
+        AX.template middleRows<3>(ContactIndex(i)).setZero();
+      }
+    }
+    return AX;
+  };
+  // Phi M Phiᵀ = M + (A M + M Aᵀ) dt + A M Aᵀ dt²
+  const CovarianceMatrix AM = apply_A(M);
+  const CovarianceMatrix AMAT = apply_A(AM.transpose());
+  state->P = M + (AM + AM.transpose()) * dt + AMAT * (dt * dt);
+}
+
+template <int kNumContacts>
+void ContactInekf<kNumContacts>::CorrectContacts(
+    const std::array<bool, kNumContacts>& in_contact,
+    const ContactPositions& positions,
+    const std::array<Matrix3d, kNumContacts>& covariances,
+    State* state) const {
+  // Stack the measurements of the contact points in contact which are part of
+  // the state
+  std::array<int, kNumContacts> slots;
+  int num_measurements = 0;
+  for (int i = 0; i < kNumContacts; i++) {
+    if (in_contact[i] && state->contact_estimated(i)) {
+      slots[num_measurements++] = i;
+    }
+  }
+  if (num_measurements > 0) {
+    const Matrix3d R = state->rotation;
+    const int n = 3 * num_measurements;
+    MeasurementMatrix N = MeasurementMatrix::Zero(n, n);
+    Eigen::Matrix<double, Eigen::Dynamic, 1, 0, kMaxMeasurements, 1> Z(n);
+    for (int j = 0; j < num_measurements; j++) {
+      const int i = slots[j];
+      N.template block<3, 3>(3 * j, 3 * j) =
+          R * covariances[i] * R.transpose();
+      Z.template segment<3>(3 * j) = R * positions.col(i) + state->position -
+                                     state->contact_positions.col(i);
+    }
+
+    GainMatrix K;
+    if (implementation_ == Implementation::kDense) {
+      CorrectCovarianceDense(slots, num_measurements, N, &K, state);
+    } else {
+      CorrectCovarianceStructured(slots, num_measurements, N, &K, state);
+    }
+
+    // Right-invariant update of the mean
+    const Eigen::Matrix<double, kDimP, 1> delta = K * Z;
+    const Vector3d delta_R = delta.template head<3>();
+    const Matrix3d dR = ExpSO3(delta_R);
+    const Matrix3d J = LeftJacobianSO3(delta_R);
+    state->rotation = dR * R;
+    state->velocity = dR * state->velocity + J * delta.template segment<3>(3);
+    state->position = dR * state->position + J * delta.template segment<3>(6);
+    for (int i = 0; i < kNumContacts; i++) {
+      if (!state->contact_estimated(i)) continue;
+      state->contact_positions.col(i) =
+          dR * state->contact_positions.col(i) +
+          J * delta.template segment<3>(ContactIndex(i));
+    }
+    state->gyroscope_bias += delta.template segment<3>(kThetaIndex);
+    state->accelerometer_bias += delta.template segment<3>(kThetaIndex + 3);
+  }
+
+  // Remove the contact points which lost contact
+  for (int i = 0; i < kNumContacts; i++) {
+    if (in_contact[i] || !state->contact_estimated(i)) continue;
+    state->contact_positions.col(i).setZero();
+    state->P.template middleRows<3>(ContactIndex(i)).setZero();
+    state->P.template middleCols<3>(ContactIndex(i)).setZero();
+    state->contact_estimated(i) = 0;
+  }
+
+  // Add the new contact points, whose error is initialized to the position
+  // error
+  for (int i = 0; i < kNumContacts; i++) {
+    if (!in_contact[i] || state->contact_estimated(i)) continue;
+    const Matrix3d R = state->rotation;
+    state->contact_positions.col(i) = state->position + R * positions.col(i);
+    state->P.template middleRows<3>(ContactIndex(i)) =
+        state->P.template middleRows<3>(6);
+    state->P.template middleCols<3>(ContactIndex(i)) =
+        state->P.template middleCols<3>(6);
+    state->P.template block<3, 3>(ContactIndex(i), ContactIndex(i)) +=
+        R * covariances[i] * R.transpose();
+    state->contact_estimated(i) = 1;
+  }
+}
+
+template <int kNumContacts>
+void ContactInekf<kNumContacts>::CorrectCovarianceDense(
+    const std::array<int, kNumContacts>& slots, int num_measurements,
+    const MeasurementMatrix& N, GainMatrix* K, State* state) const {
+  typedef Eigen::Matrix<double, Eigen::Dynamic, kDimP, 0, kMaxMeasurements,
+                        kDimP>
+      JacobianMatrix;
+  JacobianMatrix H = JacobianMatrix::Zero(3 * num_measurements, kDimP);
+  for (int j = 0; j < num_measurements; j++) {
+    H.template block<3, 3>(3 * j, 6) = -Matrix3d::Identity();
+    H.template block<3, 3>(3 * j, ContactIndex(slots[j])) =
+        Matrix3d::Identity();
+  }
+  const GainMatrix PHT = state->P * H.transpose();
+  const MeasurementMatrix S = H * PHT + N;
+  *K = S.ldlt().solve(PHT.transpose()).transpose();
+
+  // Joseph form
+  const CovarianceMatrix IKH = CovarianceMatrix::Identity() - *K * H;
+  state->P = IKH * state->P * IKH.transpose() + *K * N * K->transpose();
+}
+
+template <int kNumContacts>
+void ContactInekf<kNumContacts>::CorrectCovarianceStructured(
+    const std::array<int, kNumContacts>& slots, int num_measurements,
+    const MeasurementMatrix& N, GainMatrix* K, State* state) const {
+  // Each measurement is the error of a contact position minus the error of the
+  // position, so P Hᵀ and H P Hᵀ are differences of columns and rows
+  GainMatrix PHT(kDimP, 3 * num_measurements);
+  for (int j = 0; j < num_measurements; j++) {
+    PHT.template middleCols<3>(3 * j) =
+        state->P.template middleCols<3>(ContactIndex(slots[j])) -
+        state->P.template middleCols<3>(6);
+  }
+  MeasurementMatrix S = N;
+  for (int j = 0; j < num_measurements; j++) {
+    S.template middleRows<3>(3 * j) +=
+        PHT.template middleRows<3>(ContactIndex(slots[j])) -
+        PHT.template middleRows<3>(6);
+  }
+  *K = S.ldlt().solve(PHT.transpose()).transpose();
+
+  // Joseph form, expanded:
+  // (I - K H) P (I - K H)ᵀ + K N Kᵀ = P - K PHTᵀ - PHT Kᵀ + K S Kᵀ
+  const CovarianceMatrix KPHT = *K * PHT.transpose();
+  const GainMatrix KS = *K * S;
+  state->P += KS * K->transpose() - KPHT - KPHT.transpose();
+}
+
+template class ContactInekf<2>;
+
+}  // namespace systems
+}  // namespace dairlib
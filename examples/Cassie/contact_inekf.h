@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+
+#include <Eigen/Dense>
+
+namespace dairlib {
+namespace systems {
+
+/// ContactInekf is the contact-aided right-invariant extended Kalman filter of
+/// the inekf library (see "Contact-Aided Invariant Extended Kalman Filtering
+/// for Robot State Estimation" by Hartley et al.), specialized to a fixed
+/// number of contact points, so that all its matrices have compile-time sizes.
+///
+/// The state of the filter is not an object, but a flat vector of kStateSize
+/// doubles, e.g. a discrete state of a LeafSystem, which Propagate() and
+/// CorrectContacts() update in place through a State view, without heap
+/// allocations. Each contact point has a fixed slot in the state. The position
+/// estimate of a contact point which is not part of the state (i.e. not in
+/// contact) is zero, and so are its rows and columns of the covariance, which
+/// is equivalent to removing them from the state.
+///
+/// The covariance can be updated by two implementations, selected at
+/// construction, which agree up to round-off errors:
+/// - kDense forms the error dynamics, adjoint and measurement Jacobians as
+///   dense matrices, as inekf does.
+/// - kStructured only multiplies their nonzero blocks.
+///
+/// Instantiated for 2 contact points (one per foot of Cassie).
+template <int kNumContacts>
+class ContactInekf {
+ public:
+  /// Dimension of the covariance. Its rows are the errors of the rotation,
+  /// velocity, position, contact positions, gyroscope bias and accelerometer
+  /// bias, in this order.
+  static constexpr int kDimP = 15 + 3 * kNumContacts;
+  /// Size of the state vector
+  static constexpr int kStateSize =
+      9 + 6 + 3 * kNumContacts + 6 + kNumContacts + kDimP * kDimP;
+
+  typedef Eigen::Matrix<double, kDimP, kDimP> CovarianceMatrix;
+  typedef Eigen::Matrix<double, 3, kNumContacts> ContactPositions;
+
+  /// Mutable view of a state vector. The rotation, velocity and position are
+  /// those of the imu, in the world frame.
+  struct State {
+    explicit State(double* data);
+
+    Eigen::Map<Eigen::Matrix3d> rotation;
+    Eigen::Map<Eigen::Vector3d> velocity;
+    Eigen::Map<Eigen::Vector3d> position;
+    /// Position of each contact point in the world frame
+    Eigen::Map<ContactPositions> contact_positions;
+    Eigen::Map<Eigen::Vector3d> gyroscope_bias;
+    Eigen::Map<Eigen::Vector3d> accelerometer_bias;
+    /// 1 if the contact point is part of the state, 0 otherwise
+    Eigen::Map<Eigen::Matrix<double, kNumContacts, 1>> contact_estimated;
+    Eigen::Map<CovarianceMatrix> P;
+  };
+
+  /// Standard deviations of the noises
+  struct NoiseParams {
+    double gyroscope = 0.01;
+    double accelerometer = 0.1;
+    double gyroscope_bias = 0.00001;
+    double accelerometer_bias = 0.0001;
+    double contact = 0.1;
+  };
+
+  enum class Implementation { kStructured, kDense };
+
+  ContactInekf(const NoiseParams& noise_params, const Eigen::Vector3d& gravity,
+               Implementation implementation = Implementation::kStructured);
+
+  /// State vector without contact points
+  /// @param P the 15x15 covariance of the rotation, velocity, position and
+  /// biases
+  static Eigen::VectorXd MakeState(
+      const Eigen::Matrix3d& rotation, const Eigen::Vector3d& velocity,
+      const Eigen::Vector3d& position, const Eigen::Vector3d& gyroscope_bias,
+      const Eigen::Vector3d& accelerometer_bias,
+      const Eigen::Matrix<double, 15, 15>& P);
+
+  /// Propagates the state with the imu measurement (angular velocity and
+  /// linear acceleration, in the imu frame) over the timestep dt.
+  void Propagate(const Eigen::Matrix<double, 6, 1>& imu, double dt,
+                 State* state) const;
+
+  /// Corrects the state with the kinematics of the contact points, as
+  /// inekf::InEKF::CorrectKinematics(). The contact points in contact which
+  /// are part of the state correct the estimate. Then the points which are not
+  /// in contact anymore are removed from the state, and new contacts are added.
+  /// @param in_contact contact indicators
+  /// @param positions positions of the contact points relative to the imu,
+  /// expressed in the imu frame
+  /// @param covariances covariances of these positions
+  void CorrectContacts(const std::array<bool, kNumContacts>& in_contact,
+                       const ContactPositions& positions,
+                       const std::array<Eigen::Matrix3d, kNumContacts>&
+                           covariances,
+                       State* state) const;
+
+ private:
+  static constexpr int kMaxMeasurements = 3 * kNumContacts;
+  typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0,
+                        kMaxMeasurements, kMaxMeasurements>
+      MeasurementMatrix;
+  typedef Eigen::Matrix<double, kDimP, Eigen::Dynamic, 0, kDimP,
+                        kMaxMeasurements>
+      GainMatrix;
+
+  // Index of the first row of a contact point in the covariance
+  static constexpr int ContactIndex(int i) { return 9 + 3 * i; }
+  static constexpr int kThetaIndex = 9 + 3 * kNumContacts;
+
+  // Covariance propagation, at the state before the propagation of the mean
+  void PropagateCovarianceDense(double dt, State* state) const;
+  void PropagateCovarianceStructured(double dt, State* state) const;
+
+  // Computes the Kalman gain K of the stacked measurements of the contact
+  // points in `slots`, and updates the covariance
+  void CorrectCovarianceDense(const std::array<int, kNumContacts>& slots,
+                              int num_measurements, const MeasurementMatrix& N,
+                              GainMatrix* K, State* state) const;
+  void CorrectCovarianceStructured(const std::array<int, kNumContacts>& slots,
+                                   int num_measurements,
+                                   const MeasurementMatrix& N, GainMatrix* K,
+                                   State* state) const;
+
+  Eigen::Vector3d gravity_;
+  Implementation implementation_;
+  double gyroscope_cov_;
+  double accelerometer_cov_;
+  double gyroscope_bias_cov_;
+  double accelerometer_bias_cov_;
+  double contact_cov_;
+};
+
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,186 @@
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/solvers/osqp_solver.h"
+
+#include "examples/Cassie/cassie_fixed_point_solver.h"
+#include "examples/Cassie/cassie_utils.h"
+#include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "systems/controllers/osc/operational_space_control.h"
+#include "systems/framework/output_vector.h"
+
+namespace dairlib {
+namespace {
+
+using drake::CompareMatrices;
+using drake::multibody::MultibodyPlant;
+using drake::systems::BasicVector;
+using Eigen::Matrix3d;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+using systems::OutputVector;
+using systems::controllers::OperationalSpaceControl;
+using systems::controllers::RotTaskSpaceTrackingData;
+using systems::controllers::TransTaskSpaceTrackingData;
+
+struct QpSolution {
+  VectorXd u;
+  VectorXd dv;
+  VectorXd lambda_c;
+  VectorXd lambda_h;
+};
+
+/// Checks that OperationalSpaceControl::EliminateInputsFromQp() gives the
+/// same solution as the full QP on Cassie in left stance (toe and heel
+/// contacts, loop-closure constraints, swing foot and pelvis tracking).
+/// The costs on u, dv and epsilon make the solution unique.
+class OscEliminateInputsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    addCassieMultibody(&plant_w_spr_, nullptr, true,
+                       "examples/Cassie/urdf/cassie_v2.urdf", true, false);
+    plant_w_spr_.Finalize();
+    addCassieMultibody(&plant_wo_spr_, nullptr, true,
+                       "examples/Cassie/urdf/cassie_fixed_springs.urdf", false,
+                       false);
+    plant_wo_spr_.Finalize();
+
+    // Standing fixed point of the model with springs
+    MultibodyPlant<double> plant_for_solver(0.0);
+    addCassieMultibody(&plant_for_solver, nullptr, true,
+                       "examples/Cassie/urdf/cassie_v2.urdf", true, true);
+    plant_for_solver.Finalize();
+    VectorXd u_init, lambda_init;
+    CassieFixedPointSolver(plant_for_solver, 0.9, 0, 70, true, 0.2, &q_init_,
+                           &u_init, &lambda_init);
+  }
+
+  // Solves the QP at kNumTicks states with a varying velocity
+  std::vector<QpSolution> Solve(bool eliminate_inputs, bool input_limits,
+                                const Vector3d& swing_foot_target,
+                                double swing_foot_gain) {
+    auto context_w_spr = plant_w_spr_.CreateDefaultContext();
+    auto context_wo_spr = plant_wo_spr_.CreateDefaultContext();
+    OperationalSpaceControl osc(plant_w_spr_, plant_wo_spr_,
+                                context_w_spr.get(), context_wo_spr.get(),
+                                true);
+    const int n_v = plant_w_spr_.num_velocities();
+    const int n_u = plant_wo_spr_.num_actuators();
+    const int n_v_wo_spr = plant_wo_spr_.num_velocities();
+    osc.SetInputCost(1e-3 * MatrixXd::Identity(n_u, n_u));
+    osc.SetAccelerationCostForAllJoints(
+        0.1 * MatrixXd::Identity(n_v_wo_spr, n_v_wo_spr));
+    if (!input_limits) {
+      osc.DisableAcutationConstraint();
+    }
+
+    multibody::KinematicEvaluatorSet<double> evaluators(plant_wo_spr_);
+    auto left_loop = LeftLoopClosureEvaluator(plant_wo_spr_);
+    auto right_loop = RightLoopClosureEvaluator(plant_wo_spr_);
+    evaluators.add_evaluator(&left_loop);
+    evaluators.add_evaluator(&right_loop);
+    osc.AddKinematicConstraint(&evaluators);
+
+    osc.SetWeightOfSoftContactConstraint(2000);
+    osc.SetContactFriction(0.4);
+    auto left_toe = LeftToeFront(plant_wo_spr_);
+    auto left_heel = LeftToeRear(plant_wo_spr_);
+    multibody::WorldPointEvaluator<double> left_toe_evaluator(
+        plant_wo_spr_, left_toe.first, left_toe.second, Matrix3d::Identity(),
+        Vector3d::Zero(), {1, 2});
+    multibody::WorldPointEvaluator<double> left_heel_evaluator(
+        plant_wo_spr_, left_heel.first, left_heel.second, Matrix3d::Identity(),
+        Vector3d::Zero(), {0, 1, 2});
+    osc.AddStateAndContactPoint(kLeftStance, &left_toe_evaluator);
+    osc.AddStateAndContactPoint(kLeftStance, &left_heel_evaluator);
+
+    TransTaskSpaceTrackingData swing_foot_traj(
+        "swing_ft_traj", swing_foot_gain * MatrixXd::Identity(3, 3),
+        10 * MatrixXd::Identity(3, 3), 400 * MatrixXd::Identity(3, 3),
+        plant_w_spr_, plant_wo_spr_);
+    swing_foot_traj.AddPointToTrack("toe_right");
+    osc.AddConstTrackingData(&swing_foot_traj, swing_foot_target);
+    RotTaskSpaceTrackingData pelvis_traj(
+        "pelvis_traj", 200 * MatrixXd::Identity(3, 3),
+        80 * MatrixXd::Identity(3, 3), 200 * MatrixXd::Identity(3, 3),
+        plant_w_spr_, plant_wo_spr_);
+    pelvis_traj.AddFrameToTrack("pelvis");
+    osc.AddConstTrackingData(&pelvis_traj, Eigen::Vector4d(1, 0, 0, 0));
+
+    // Tight tolerances, so that the two formulations can be compared
+    drake::solvers::SolverOptions solver_options;
+    const auto id = drake::solvers::OsqpSolver::id();
+    solver_options.SetOption(id, "eps_abs", 1e-9);
+    solver_options.SetOption(id, "eps_rel", 1e-9);
+    solver_options.SetOption(id, "max_iter", 100000);
+    osc.SetOsqpSolverOptions(solver_options);
+    if (eliminate_inputs) {
+      osc.EliminateInputsFromQp();
+    }
+    osc.Build();
+
+    auto context = osc.CreateDefaultContext();
+    osc.get_fsm_input_port().FixValue(
+        context.get(), BasicVector<double>(VectorXd::Constant(1, kLeftStance)));
+    const auto& output_port = osc.get_osc_output_port();
+    auto output = output_port.Allocate();
+    std::vector<QpSolution> solutions;
+    for (int i = 0; i < kNumTicks; i++) {
+      OutputVector<double> robot_output(q_init_,
+                                        (0.1 * (i + 1)) * VectorXd::Ones(n_v),
+                                        VectorXd::Zero(n_u));
+      robot_output.set_timestamp(0.001 * i);
+      osc.get_robot_output_input_port().FixValue(context.get(), robot_output);
+      output_port.Calc(*context, output.get());
+      solutions.push_back(
+          {output->get_value<BasicVector<double>>().get_value().head(n_u),
+           osc.dv_solution(), osc.lambda_c_solution(),
+           osc.lambda_h_solution()});
+    }
+    return solutions;
+  }
+
+  void CompareSolutions(const std::vector<QpSolution>& full,
+                        const std::vector<QpSolution>& eliminated) {
+    ASSERT_EQ(full.size(), eliminated.size());
+    for (unsigned int i = 0; i < full.size(); i++) {
+      EXPECT_TRUE(CompareMatrices(full[i].u, eliminated[i].u, 1e-3));
+      EXPECT_TRUE(CompareMatrices(full[i].dv, eliminated[i].dv, 1e-4));
+      EXPECT_TRUE(
+          CompareMatrices(full[i].lambda_c, eliminated[i].lambda_c, 1e-3));
+      EXPECT_TRUE(
+          CompareMatrices(full[i].lambda_h, eliminated[i].lambda_h, 1e-3));
+    }
+  }
+
+  static constexpr int kLeftStance = 0;
+  static constexpr int kNumTicks = 3;
+  MultibodyPlant<double> plant_w_spr_{0.0};
+  MultibodyPlant<double> plant_wo_spr_{0.0};
+  VectorXd q_init_;
+};
+
+TEST_F(OscEliminateInputsTest, WithoutInputLimits) {
+  const Vector3d target(0, -0.2, 0.1);
+  CompareSolutions(Solve(false, false, target, 100),
+                   Solve(true, false, target, 100));
+}
+
+TEST_F(OscEliminateInputsTest, WithInputLimits) {
+  // A far swing foot target with a high gain saturates some of the inputs, so
+  // that the (dense) input limit rows of the eliminated QP are active
+  const Vector3d target(0.5, -0.6, 0.5);
+  const auto full = Solve(false, true, target, 1e4);
+  const auto eliminated = Solve(true, true, target, 1e4);
+  // Effort limit of the Cassie motors
+  const double u_max = 300;
+  for (const auto& solution : full) {
+    EXPECT_NEAR(solution.u.lpNorm<Eigen::Infinity>(), u_max, 1e-3);
+  }
+  CompareSolutions(full, eliminated);
+}
+
+}  // namespace
+}  // namespace dairlib
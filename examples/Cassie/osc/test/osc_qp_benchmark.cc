@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <gflags/gflags.h>
+
+#include "examples/Cassie/cassie_fixed_point_solver.h"
+#include "examples/Cassie/cassie_utils.h"
+#include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "systems/controllers/osc/operational_space_control.h"
+#include "systems/framework/output_vector.h"
+
+#include "drake/common/text_logging.h"
+
+/// Timing benchmark of the OSC QP with and without the elimination of the
+/// inputs (OperationalSpaceControl::EliminateInputsFromQp()), on the Cassie
+/// walking and jumping controller configurations.
+///
+/// The trajectories are replaced by constant targets, and each configuration
+/// cycles through its finite state machine states with a slowly varying
+/// velocity, so that the contact set and the QP coefficients change over the
+/// run. The two formulations should give the same inputs up to the solver
+/// tolerance (osc_eliminate_inputs_test checks this).
+
+DEFINE_int32(n_ticks, 3000, "Number of control ticks per run");
+DEFINE_int32(ticks_per_state, 100,
+             "Number of ticks before switching to the next fsm state");
+
+namespace dairlib {
+
+using drake::multibody::MultibodyPlant;
+using drake::systems::BasicVector;
+using Eigen::Matrix3d;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+using std::cout;
+using std::endl;
+using std::vector;
+using systems::OutputVector;
+using systems::controllers::ComTrackingData;
+using systems::controllers::JointSpaceTrackingData;
+using systems::controllers::OperationalSpaceControl;
+using systems::controllers::RotTaskSpaceTrackingData;
+using systems::controllers::TransTaskSpaceTrackingData;
+
+typedef std::chrono::steady_clock my_clock;
+
+struct BenchmarkResult {
+  double mean_us = 0;
+  double max_us = 0;
+  // Input of each tick (n_u x n_ticks)
+  MatrixXd u;
+};
+
+/// Runs a built OSC for FLAGS_n_ticks and times the computation of its
+/// output
+BenchmarkResult TimeOsc(const OperationalSpaceControl& osc,
+                        const MultibodyPlant<double>& plant_w_spr,
+                        const VectorXd& x_init, const vector<int>& fsm_states) {
+  int n_q = plant_w_spr.num_positions();
+  int n_v = plant_w_spr.num_velocities();
+  int n_u = plant_w_spr.num_actuators();
+
+  auto context = osc.CreateDefaultContext();
+  const auto& output_port = osc.get_osc_output_port();
+  auto output = output_port.Allocate();
+
+  BenchmarkResult result;
+  result.u.resize(n_u, FLAGS_n_ticks);
+  for (int i = 0; i < FLAGS_n_ticks; i++) {
+    OutputVector<double> robot_output(x_init.head(n_q),
+                                      cos(0.01 * i) * x_init.tail(n_v),
+                                      VectorXd::Zero(n_u));
+    robot_output.set_timestamp(0.001 * i);
+    osc.get_robot_output_input_port().FixValue(context.get(), robot_output);
+    int fsm_state =
+        fsm_states.at((i / FLAGS_ticks_per_state) % fsm_states.size());
+    osc.get_fsm_input_port().FixValue(context.get(),
+                                      BasicVector<double>(VectorXd::Constant(
+                                          1, fsm_state)));
+
+    auto start = my_clock::now();
+    output_port.Calc(*context, output.get());
+    auto stop = my_clock::now();
+
+    double duration_us =
+        std::chrono::duration<double, std::micro>(stop - start).count();
+    result.mean_us += duration_us / FLAGS_n_ticks;
+    result.max_us = std::max(result.max_us, duration_us);
+    result.u.col(i) =
+        output->get_value<BasicVector<double>>().get_value().head(n_u);
+  }
+  return result;
+}
+
+BenchmarkResult RunWalking(const MultibodyPlant<double>& plant_w_spr,
+                           const MultibodyPlant<double>& plant_wo_spr,
+                           const VectorXd& x_init, bool eliminate_inputs) {
+  auto context_w_spr = plant_w_spr.CreateDefaultContext();
+  auto context_wo_spr = plant_wo_spr.CreateDefaultContext();
+  OperationalSpaceControl osc(plant_w_spr, plant_wo_spr, context_w_spr.get(),
+                              context_wo_spr.get(), true);
+  int left_stance_state = 0;
+  int right_stance_state = 1;
+  int double_support_state = 2;
+
+  int n_v = plant_wo_spr.num_velocities();
+  osc.SetAccelerationCostForAllJoints(2 * MatrixXd::Identity(n_v, n_v));
+
+  multibody::KinematicEvaluatorSet<double> evaluators(plant_wo_spr);
+  auto left_loop = LeftLoopClosureEvaluator(plant_wo_spr);
+  auto right_loop = RightLoopClosureEvaluator(plant_wo_spr);
+  evaluators.add_evaluator(&left_loop);
+  evaluators.add_evaluator(&right_loop);
+  osc.AddKinematicConstraint(&evaluators);
+
+  osc.SetWeightOfSoftContactConstraint(2000);
+  osc.SetContactFriction(0.4);
+  auto left_toe = LeftToeFront(plant_wo_spr);
+  auto left_heel = LeftToeRear(plant_wo_spr);
+  auto right_toe = RightToeFront(plant_wo_spr);
+  auto right_heel = RightToeRear(plant_wo_spr);
+  auto left_toe_evaluator = multibody::WorldPointEvaluator(
+      plant_wo_spr, left_toe.first, left_toe.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {1, 2});
+  auto left_heel_evaluator = multibody::WorldPointEvaluator(
+      plant_wo_spr, left_heel.first, left_heel.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {0, 1, 2});
+  auto right_toe_evaluator = multibody::WorldPointEvaluator(
+      plant_wo_spr, right_toe.first, right_toe.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {1, 2});
+  auto right_heel_evaluator = multibody::WorldPointEvaluator(
+      plant_wo_spr, right_heel.first, right_heel.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {0, 1, 2});
+  osc.AddStateAndContactPoint(left_stance_state, &left_toe_evaluator);
+  osc.AddStateAndContactPoint(left_stance_state, &left_heel_evaluator);
+  osc.AddStateAndContactPoint(right_stance_state, &right_toe_evaluator);
+  osc.AddStateAndContactPoint(right_stance_state, &right_heel_evaluator);
+  osc.AddStateAndContactPoint(double_support_state, &left_toe_evaluator);
+  osc.AddStateAndContactPoint(double_support_state, &left_heel_evaluator);
+  osc.AddStateAndContactPoint(double_support_state, &right_toe_evaluator);
+  osc.AddStateAndContactPoint(double_support_state, &right_heel_evaluator);
+
+  TransTaskSpaceTrackingData swing_foot_traj(
+      "swing_ft_traj", 100 * MatrixXd::Identity(3, 3),
+      10 * MatrixXd::Identity(3, 3), 400 * MatrixXd::Identity(3, 3),
+      plant_w_spr, plant_wo_spr);
+  swing_foot_traj.AddStateAndPointToTrack(left_stance_state, "toe_right");
+  swing_foot_traj.AddStateAndPointToTrack(right_stance_state, "toe_left");
+  osc.AddConstTrackingData(&swing_foot_traj, Vector3d(0, 0, 0.1));
+  MatrixXd W_com = Vector3d(2, 2, 2000).asDiagonal();
+  ComTrackingData center_of_mass_traj(
+      "com_traj", 50 * MatrixXd::Identity(3, 3), 10 * MatrixXd::Identity(3, 3),
+      W_com, plant_w_spr, plant_wo_spr);
+  osc.AddConstTrackingData(&center_of_mass_traj, Vector3d(0, 0, 0.89));
+  RotTaskSpaceTrackingData pelvis_traj(
+      "pelvis_traj", Vector3d(200, 200, 50).asDiagonal(),
+      Vector3d(80, 80, 40).asDiagonal(), Vector3d(200, 200, 200).asDiagonal(),
+      plant_w_spr, plant_wo_spr);
+  pelvis_traj.AddFrameToTrack("pelvis");
+  osc.AddConstTrackingData(&pelvis_traj, Eigen::Vector4d(1, 0, 0, 0));
+  JointSpaceTrackingData swing_toe_traj(
+      "swing_toe_traj", 200 * MatrixXd::Ones(1, 1), 20 * MatrixXd::Ones(1, 1),
+      200 * MatrixXd::Ones(1, 1), plant_w_spr, plant_wo_spr);
+  swing_toe_traj.AddStateAndJointToTrack(left_stance_state, "toe_right",
+                                         "toe_rightdot");
+  swing_toe_traj.AddStateAndJointToTrack(right_stance_state, "toe_left",
+                                         "toe_leftdot");
+  osc.AddConstTrackingData(&swing_toe_traj, -1.5 * VectorXd::Ones(1));
+
+  if (eliminate_inputs) {
+    osc.EliminateInputsFromQp();
+  }
+  osc.Build();
+
+  return TimeOsc(osc, plant_w_spr, x_init,
+                 {left_stance_state, double_support_state, right_stance_state,
+                  double_support_state});
+}
+
+BenchmarkResult RunJumping(const MultibodyPlant<double>& plant_w_spr,
+                           const MultibodyPlant<double>& plant_wo_spr,
+                           const VectorXd& x_init, bool eliminate_inputs) {
+  auto context_w_spr = plant_w_spr.CreateDefaultContext();
+  auto context_wo_spr = plant_wo_spr.CreateDefaultContext();
+  OperationalSpaceControl osc(plant_w_spr, plant_wo_spr, context_w_spr.get(),
+                              context_wo_spr.get(), true);
+  // Same states as the jumping finite state machine
+  int balance_state = 0;
+  int crouch_state = 1;
+  int flight_state = 2;
+  int land_state = 3;
+  vector<int> stance_states = {balance_state, crouch_state, land_state};
+
+  int n_v = plant_wo_spr.num_velocities();
+  osc.SetAccelerationCostForAllJoints(1e-6 * MatrixXd::Identity(n_v, n_v));
+  osc.SetWeightOfSoftContactConstraint(20000);
+  osc.SetContactFriction(0.4);
+
+  auto left_toe = LeftToeFront(plant_wo_spr);
+  auto left_heel = LeftToeRear(plant_wo_spr);
+  auto right_toe = RightToeFront(plant_wo_spr);
+  auto right_heel = RightToeRear(plant_wo_spr);
+  auto left_toe_evaluator = multibody::WorldPointEvaluator(
+      plant_wo_spr, left_toe.first, left_toe.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {1, 2});
+  auto left_heel_evaluator = multibody::WorldPointEvaluator(
+      plant_wo_spr, left_heel.first, left_heel.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {0, 1, 2});
+  auto right_toe_evaluator = multibody::WorldPointEvaluator(
+      plant_wo_spr, right_toe.first, right_toe.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {1, 2});
+  auto right_heel_evaluator = multibody::WorldPointEvaluator(
+      plant_wo_spr, right_heel.first, right_heel.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {0, 1, 2});
+  for (int mode : stance_states) {
+    osc.AddStateAndContactPoint(mode, &left_toe_evaluator);
+    osc.AddStateAndContactPoint(mode, &left_heel_evaluator);
+    osc.AddStateAndContactPoint(mode, &right_toe_evaluator);
+    osc.AddStateAndContactPoint(mode, &right_heel_evaluator);
+  }
+
+  multibody::KinematicEvaluatorSet<double> evaluators(plant_wo_spr);
+  auto left_loop = LeftLoopClosureEvaluator(plant_wo_spr);
+  auto right_loop = RightLoopClosureEvaluator(plant_wo_spr);
+  evaluators.add_evaluator(&left_loop);
+  evaluators.add_evaluator(&right_loop);
+  osc.AddKinematicConstraint(&evaluators);
+
+  MatrixXd W_com = Vector3d(2000, 200, 2000).asDiagonal();
+  ComTrackingData com_tracking_data(
+      "com_traj", 64 * MatrixXd::Identity(3, 3), 16 * MatrixXd::Identity(3, 3),
+      W_com, plant_w_spr, plant_wo_spr);
+  for (int mode : stance_states) {
+    com_tracking_data.AddStateToTrack(mode);
+  }
+  osc.AddConstTrackingData(&com_tracking_data, Vector3d(0, 0, 0.8));
+  TransTaskSpaceTrackingData left_foot_tracking_data(
+      "l_foot_traj", 36 * MatrixXd::Identity(3, 3),
+      12 * MatrixXd::Identity(3, 3), 1000 * MatrixXd::Identity(3, 3),
+      plant_w_spr, plant_wo_spr);
+  TransTaskSpaceTrackingData right_foot_tracking_data(
+      "r_foot_traj", 36 * MatrixXd::Identity(3, 3),
+      12 * MatrixXd::Identity(3, 3), 1000 * MatrixXd::Identity(3, 3),
+      plant_w_spr, plant_wo_spr);
+  left_foot_tracking_data.AddStateAndPointToTrack(flight_state, "toe_left");
+  right_foot_tracking_data.AddStateAndPointToTrack(flight_state, "toe_right");
+  RotTaskSpaceTrackingData pelvis_rot_tracking_data(
+      "pelvis_rot_tracking_data", Vector3d(32, 32, 16).asDiagonal(),
+      Vector3d(8, 8, 8).asDiagonal(), Vector3d(20, 20, 10).asDiagonal(),
+      plant_w_spr, plant_wo_spr);
+  for (int mode : stance_states) {
+    pelvis_rot_tracking_data.AddStateAndFrameToTrack(mode, "pelvis");
+  }
+  osc.AddConstTrackingData(&pelvis_rot_tracking_data,
+                           Eigen::Vector4d(1, 0, 0, 0));
+  osc.AddConstTrackingData(&left_foot_tracking_data, Vector3d(0, 0.1, 0.2));
+  osc.AddConstTrackingData(&right_foot_tracking_data, Vector3d(0, -0.1, 0.2));
+
+  if (eliminate_inputs) {
+    osc.EliminateInputsFromQp();
+  }
+  osc.Build();
+
+  return TimeOsc(osc, plant_w_spr, x_init,
+                 {balance_state, crouch_state, flight_state, land_state});
+}
+
+void PrintComparison(const std::string& name, const BenchmarkResult& full,
+                     const BenchmarkResult& eliminated) {
+  cout << "***** " << name << " (" << FLAGS_n_ticks << " ticks) *****" << endl;
+  cout << "full QP:           mean " << full.mean_us << " us, max "
+       << full.max_us << " us" << endl;
+  cout << "inputs eliminated: mean " << eliminated.mean_us << " us, max "
+       << eliminated.max_us << " us" << endl;
+  cout << "max input difference: "
+       << (full.u - eliminated.u).cwiseAbs().maxCoeff() << endl;
+}
+
+int DoMain(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  drake::logging::set_log_level("err");
+
+  MultibodyPlant<double> plant_w_spr(0.0);
+  addCassieMultibody(&plant_w_spr, nullptr, true,
+                     "examples/Cassie/urdf/cassie_v2.urdf", true, false);
+  plant_w_spr.Finalize();
+  MultibodyPlant<double> plant_wo_spr(0.0);
+  addCassieMultibody(&plant_wo_spr, nullptr, true,
+                     "examples/Cassie/urdf/cassie_fixed_springs.urdf", false,
+                     false);
+  plant_wo_spr.Finalize();
+
+  // Standing fixed point of the model with springs, with a nonzero velocity
+  MultibodyPlant<double> plant_for_solver(0.0);
+  addCassieMultibody(&plant_for_solver, nullptr, true,
+                     "examples/Cassie/urdf/cassie_v2.urdf", true, true);
+  plant_for_solver.Finalize();
+  VectorXd q_init, u_init, lambda_init;
+  CassieFixedPointSolver(plant_for_solver, 0.9, 0, 70, true, 0.2, &q_init,
+                         &u_init, &lambda_init);
+  VectorXd x_init(plant_w_spr.num_positions() + plant_w_spr.num_velocities());
+  x_init << q_init, 0.1 * VectorXd::Ones(plant_w_spr.num_velocities());
+
+  PrintComparison("walking",
+                  RunWalking(plant_w_spr, plant_wo_spr, x_init, false),
+                  RunWalking(plant_w_spr, plant_wo_spr, x_init, true));
+  PrintComparison("jumping",
+                  RunJumping(plant_w_spr, plant_wo_spr, x_init, false),
+                  RunJumping(plant_w_spr, plant_wo_spr, x_init, true));
+  return 0;
+}
+
+}  // namespace dairlib
+
+int main(int argc, char* argv[]) { return dairlib::DoMain(argc, argv); }
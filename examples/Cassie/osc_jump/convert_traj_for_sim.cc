@@ -2,6 +2,7 @@
 #include <drake/multibody/parsing/parser.h>
 #include <gflags/gflags.h>
 #include "examples/Cassie/cassie_utils.h"
+#include "multibody/index_map.h"
 #include "multibody/multibody_utils.h"
 #include "lcm/lcm_trajectory.h"
 #include "drake/multibody/plant/multibody_plant.h"
@@ -70,44 +71,13 @@ int DoMain() {
   const std::map<string, int>& vel_map_wo_spr =
       multibody::makeNameToVelocitiesMap(plant_wo_spr);
 
-  // Initialize the mapping from states for the plant without springs to the
-  // plant with springs. Note: this is a tall matrix
-  MatrixXd map_position_from_no_spring_to_spring =
-      MatrixXd::Zero(nq_w_spr, nq_wo_spr);
-  MatrixXd map_velocity_from_no_spring_to_spring =
-      MatrixXd::Zero(nv_w_spr, nv_wo_spr);
-  MatrixXd map_state_from_no_spring_to_spring =
-      MatrixXd::Zero(nx_w_spr, nx_wo_spr);
-
-  for (const auto& pos_pair_wo_spr : pos_map_wo_spr) {
-    bool successfully_added = false;
-    for (const auto& pos_pair_w_spr : pos_map_w_spr) {
-      if (pos_pair_wo_spr.first == pos_pair_w_spr.first) {
-        map_position_from_no_spring_to_spring(pos_pair_w_spr.second,
-                                              pos_pair_wo_spr.second) = 1;
-        successfully_added = true;
-      }
-    }
-    DRAKE_DEMAND(successfully_added);
-  }
-
-  for (const auto& vel_pair_wo_spr : vel_map_wo_spr) {
-    bool successfully_added = false;
-    for (const auto& vel_pair_w_spr : vel_map_w_spr) {
-      if (vel_pair_wo_spr.first == vel_pair_w_spr.first) {
-        map_velocity_from_no_spring_to_spring(vel_pair_w_spr.second,
-                                              vel_pair_wo_spr.second) = 1;
-        successfully_added = true;
-      }
-    }
-    DRAKE_DEMAND(successfully_added);
-  }
-
-  map_state_from_no_spring_to_spring.block(0, 0, nq_w_spr, nq_wo_spr) =
-      map_position_from_no_spring_to_spring;
-  map_state_from_no_spring_to_spring.block(nq_w_spr, nq_wo_spr, nv_w_spr,
-                                           nv_wo_spr) =
-      map_velocity_from_no_spring_to_spring;
+  // Mapping from the states of the plant with springs to the plant without
+  // springs. The trajectory is converted with the transposed map (scatter),
+  // which leaves the spring states at zero.
+  const multibody::IndexMap map_position_from_spring_to_no_spring(
+      pos_map_w_spr, pos_map_wo_spr);
+  const multibody::IndexMap map_velocity_from_spring_to_no_spring(
+      vel_map_w_spr, vel_map_wo_spr);
 
   const LcmTrajectory& loadedTrajs =
       LcmTrajectory(FLAGS_folder_path + FLAGS_trajectory_name);
@@ -124,12 +94,23 @@ int DoMain() {
   xu << traj_mode0.datapoints, traj_mode1.datapoints, traj_mode2.datapoints;
   times << traj_mode0.time_vector, traj_mode1.time_vector,
       traj_mode2.time_vector;
-  MatrixXd x_w_spr(2*nx_w_spr, n_points);
-  x_w_spr.topRows(nx_w_spr) =
-      map_state_from_no_spring_to_spring * xu.topRows(nx_wo_spr);
-  x_w_spr.bottomRows(nx_w_spr) =
-      map_state_from_no_spring_to_spring * xu.topRows(2*nx_wo_spr).bottomRows
-      (nx_wo_spr);
+  // The datapoints are stacked as [x; xdot; u] = [q; v; qdot; vdot; u]
+  MatrixXd x_w_spr = MatrixXd::Zero(2*nx_w_spr, n_points);
+  const int n_blocks = 4;
+  const int rows_wo_spr[n_blocks] = {0, nq_wo_spr, nx_wo_spr,
+                                     nx_wo_spr + nq_wo_spr};
+  const int rows_w_spr[n_blocks] = {0, nq_w_spr, nx_w_spr,
+                                    nx_w_spr + nq_w_spr};
+  for (int i = 0; i < n_blocks; i++) {
+    // Even blocks are positions (or their derivatives), odd are velocities
+    const multibody::IndexMap& index_map =
+        (i % 2 == 0) ? map_position_from_spring_to_no_spring
+                     : map_velocity_from_spring_to_no_spring;
+    auto block_w_spr =
+        x_w_spr.middleRows(rows_w_spr[i], index_map.from_size());
+    index_map.Scatter(
+        xu.middleRows(rows_wo_spr[i], index_map.to_size()), &block_w_spr);
+  }
 
   auto state_traj_w_spr = LcmTrajectory::Trajectory();
   state_traj_w_spr.traj_name = "cassie_jumping_trajectory_x";
@@ -209,6 +209,10 @@ int DoMain(int argc, char* argv[]) {
   auto osc_debug_pub =
       builder.AddSystem(LcmPublisherSystem::Make<dairlib::lcmt_osc_output>(
           "OSC_DEBUG", &lcm, TriggerTypeSet({TriggerType::kForced})));
+  auto osc_timing_pub =
+      builder.AddSystem(LcmPublisherSystem::Make<dairlib::lcmt_osc_timing>(
+          "OSC_TIMING", &lcm, TriggerTypeSet({TriggerType::kPeriodic}),
+          1.0));
 
   LcmSubscriberSystem* contact_results_sub = nullptr;
   if (FLAGS_simulator == "DRAKE") {
@@ -384,6 +388,7 @@ int DoMain(int argc, char* argv[]) {
   builder.Connect(command_sender->get_output_port(0),
                   command_pub->get_input_port());
   builder.Connect(osc->get_osc_debug_port(), osc_debug_pub->get_input_port());
+  builder.Connect(osc->get_osc_timing_port(), osc_timing_pub->get_input_port());
 
   // Run lcm-driven simulation
   // Create the diagram
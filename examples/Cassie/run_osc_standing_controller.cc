@@ -175,6 +175,10 @@ int DoMain(int argc, char* argv[]) {
   auto osc_debug_pub =
       builder.AddSystem(LcmPublisherSystem::Make<dairlib::lcmt_osc_output>(
           "OSC_DEBUG", &lcm_local, TriggerTypeSet({TriggerType::kForced})));
+  auto osc_timing_pub =
+      builder.AddSystem(LcmPublisherSystem::Make<dairlib::lcmt_osc_timing>(
+          "OSC_TIMING", &lcm_local, TriggerTypeSet({TriggerType::kPeriodic}),
+          1.0));
 
   // Create desired center of mass traj
   std::vector<std::pair<const Vector3d, const drake::multibody::Frame<double>&>>
@@ -251,6 +255,7 @@ int DoMain(int argc, char* argv[]) {
   builder.Connect(osc->get_osc_output_port(),
                   command_sender->get_input_port(0));
   builder.Connect(osc->get_osc_debug_port(), osc_debug_pub->get_input_port());
+  builder.Connect(osc->get_osc_timing_port(), osc_timing_pub->get_input_port());
   builder.Connect(com_traj_generator->get_output_port(0),
                   osc->get_tracking_data_input_port("com_traj"));
 
@@ -402,6 +402,12 @@ int DoMain(int argc, char* argv[]) {
         builder.AddSystem(LcmPublisherSystem::Make<dairlib::lcmt_osc_output>(
             "OSC_DEBUG", &lcm_local, TriggerTypeSet({TriggerType::kForced})));
     builder.Connect(osc->get_osc_debug_port(), osc_debug_pub->get_input_port());
+    auto osc_timing_pub =
+        builder.AddSystem(LcmPublisherSystem::Make<dairlib::lcmt_osc_timing>(
+            "OSC_TIMING", &lcm_local, TriggerTypeSet({TriggerType::kPeriodic}),
+            1.0));
+    builder.Connect(osc->get_osc_timing_port(),
+                    osc_timing_pub->get_input_port());
   }
 
   // Create the diagram
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include <gflags/gflags.h>
+
+#include "src/InEKF.h"
+
+#include "examples/Cassie/contact_inekf.h"
+
+/// Timing benchmark of one update (propagation and contact correction) of
+/// ContactInekf, with its dense and structured covariance updates, and of
+/// inekf::InEKF, on the same random imu measurements and contact kinematics.
+/// The support alternates between double, left and right support, so that
+/// contact points are added to and removed from the state over the run.
+
+DEFINE_int32(n_updates, 20000, "Number of filter updates per run");
+DEFINE_int32(updates_per_support, 100,
+             "Number of updates before switching to the next support");
+
+namespace dairlib {
+namespace systems {
+
+using Eigen::Matrix3d;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+using std::cout;
+using std::endl;
+using std::vector;
+
+typedef std::chrono::steady_clock my_clock;
+typedef ContactInekf<2> Inekf;
+
+const Vector3d kGravity(0, 0, -9.81);
+const double kDt = 0.0005;
+
+struct Measurement {
+  Eigen::Matrix<double, 6, 1> imu;
+  std::array<bool, 2> in_contact;
+  Inekf::ContactPositions positions;
+  std::array<Matrix3d, 2> covariances;
+};
+
+struct BenchmarkResult {
+  // Duration of each update
+  vector<double> durations_us;
+  // Position estimate after each update (3 x n_updates)
+  MatrixXd positions;
+};
+
+Eigen::Matrix<double, 15, 15> InitialCovariance() {
+  Eigen::Matrix<double, 15, 15> P = Eigen::Matrix<double, 15, 15>::Identity();
+  P.block<3, 3>(0, 0) *= 0.0001;
+  P.block<3, 3>(3, 3) *= 0.01;
+  P.block<3, 3>(6, 6) *= 0.0001;
+  P.block<3, 3>(9, 9) *= 0.0001;
+  P.block<3, 3>(12, 12) *= 0.01;
+  return P;
+}
+
+vector<Measurement> MakeMeasurements() {
+  std::srand(0);
+  vector<Measurement> measurements(FLAGS_n_updates);
+  for (int k = 0; k < FLAGS_n_updates; k++) {
+    Measurement& m = measurements[k];
+    m.imu << 0.1 * Vector3d::Random(), -kGravity + 0.5 * Vector3d::Random();
+    const int support = (k / FLAGS_updates_per_support) % 3;
+    m.in_contact = {support != 2, support != 1};
+    for (int i = 0; i < 2; i++) {
+      m.positions.col(i) =
+          Vector3d(0, 0.1 - 0.2 * i, -0.9) + 0.01 * Vector3d::Random();
+      const Matrix3d J = 0.1 * Matrix3d::Random();
+      m.covariances[i] = 1e-4 * (J * J.transpose() + Matrix3d::Identity());
+    }
+  }
+  return measurements;
+}
+
+BenchmarkResult TimeInekf(const vector<Measurement>& measurements) {
+  inekf::RobotState initial_state;
+  initial_state.setRotation(Matrix3d::Identity());
+  initial_state.setVelocity(Vector3d::Zero());
+  initial_state.setPosition(Vector3d::Zero());
+  initial_state.setGyroscopeBias(Vector3d::Zero());
+  initial_state.setAccelerometerBias(Vector3d::Zero());
+  initial_state.setP(InitialCovariance());
+  inekf::NoiseParams noise_params;
+  noise_params.setGyroscopeNoise(0.002);
+  noise_params.setAccelerometerNoise(0.04);
+  noise_params.setGyroscopeBiasNoise(0.001);
+  noise_params.setAccelerometerBiasNoise(0.001);
+  noise_params.setContactNoise(0.05);
+  inekf::InEKF ekf(initial_state, noise_params);
+
+  BenchmarkResult result;
+  result.positions.resize(3, measurements.size());
+  for (size_t k = 0; k < measurements.size(); k++) {
+    const Measurement& m = measurements[k];
+    // The kinematics are packed as in CassieStateEstimator, in the timed
+    // section
+    auto start = my_clock::now();
+    inekf::vectorKinematics measured_kinematics;
+    for (int i = 0; i < 2; i++) {
+      Eigen::Matrix4d pose = Eigen::Matrix4d::Identity();
+      pose.block<3, 1>(0, 3) = m.positions.col(i);
+      Eigen::Matrix<double, 6, 6> covariance =
+          Eigen::Matrix<double, 6, 6>::Identity();
+      covariance.block<3, 3>(3, 3) = m.covariances[i];
+      measured_kinematics.push_back(inekf::Kinematics(i, pose, covariance));
+    }
+    ekf.Propagate(m.imu, kDt);
+    ekf.setContacts({std::pair<int, bool>(0, m.in_contact[0]),
+                     std::pair<int, bool>(1, m.in_contact[1])});
+    ekf.CorrectKinematics(measured_kinematics);
+    auto stop = my_clock::now();
+
+    result.durations_us.push_back(
+        std::chrono::duration<double, std::micro>(stop - start).count());
+    result.positions.col(k) = ekf.getState().getPosition();
+  }
+  return result;
+}
+
+BenchmarkResult TimeContactInekf(const vector<Measurement>& measurements,
+                                 Inekf::Implementation implementation) {
+  Inekf::NoiseParams noise_params;
+  noise_params.gyroscope = 0.002;
+  noise_params.accelerometer = 0.04;
+  noise_params.gyroscope_bias = 0.001;
+  noise_params.accelerometer_bias = 0.001;
+  noise_params.contact = 0.05;
+  Inekf ekf(noise_params, kGravity, implementation);
+  VectorXd data = Inekf::MakeState(Matrix3d::Identity(), Vector3d::Zero(),
+                                   Vector3d::Zero(), Vector3d::Zero(),
+                                   Vector3d::Zero(), InitialCovariance());
+  Inekf::State state(data.data());
+
+  BenchmarkResult result;
+  result.positions.resize(3, measurements.size());
+  for (size_t k = 0; k < measurements.size(); k++) {
+    const Measurement& m = measurements[k];
+    auto start = my_clock::now();
+    ekf.Propagate(m.imu, kDt, &state);
+    ekf.CorrectContacts(m.in_contact, m.positions, m.covariances, &state);
+    auto stop = my_clock::now();
+
+    result.durations_us.push_back(
+        std::chrono::duration<double, std::micro>(stop - start).count());
+    result.positions.col(k) = state.position;
+  }
+  return result;
+}
+
+void PrintResult(const std::string& name, BenchmarkResult result,
+                 const BenchmarkResult& reference) {
+  vector<double>& d = result.durations_us;
+  double mean = 0;
+  for (double t : d) mean += t / d.size();
+  std::sort(d.begin(), d.end());
+  auto percentile = [&d](double p) {
+    return d[std::min(d.size() - 1, static_cast<size_t>(p * d.size()))];
+  };
+  cout << name << ": mean " << mean << " us, median " << percentile(0.5)
+       << " us, p99 " << percentile(0.99) << " us, max " << d.back()
+       << " us, max position difference to inekf "
+       << (result.positions - reference.positions).cwiseAbs().maxCoeff()
+       << endl;
+}
+
+int DoMain(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  const vector<Measurement> measurements = MakeMeasurements();
+  const BenchmarkResult inekf_result = TimeInekf(measurements);
+  PrintResult("inekf::InEKF", inekf_result, inekf_result);
+  PrintResult("ContactInekf (dense)",
+              TimeContactInekf(measurements, Inekf::Implementation::kDense),
+              inekf_result);
+  PrintResult(
+      "ContactInekf (structured)",
+      TimeContactInekf(measurements, Inekf::Implementation::kStructured),
+      inekf_result);
+  return 0;
+}
+
+}  // namespace systems
+}  // namespace dairlib
+
+int main(int argc, char* argv[]) {
+  return dairlib::systems::DoMain(argc, argv);
+}
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gflags/gflags.h>
+#include "lcm/lcm-cpp.hpp"
+
+#include "dairlib/lcmt_cassie_out.hpp"
+#include "examples/Cassie/cassie_state_estimator.h"
+#include "examples/Cassie/cassie_utils.h"
+#include "examples/Cassie/networking/udp_lcm_translator.h"
+#include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "multibody/kinematic/world_point_evaluator.h"
+#include "systems/framework/output_vector.h"
+
+/// Replay benchmark of CassieStateEstimator on a recorded log of
+/// lcmt_cassie_out messages.
+///
+/// The estimator is driven directly, without LCM loop or Simulator: for each
+/// message, the unrestricted update that dispatcher_robot_out triggers is
+/// computed and applied to the context, and the output is evaluated. The
+/// benchmark reports the distribution of the duration of these updates, the
+/// throughput of the replay, and the difference between the estimated states
+/// and a reference stored alongside the log (<file>.estimator_reference by
+/// default), which can be written with --write_reference.
+///
+/// The floating base is initialized with the identity orientation at
+/// --pelvis_height, instead of the inverse kinematics of dispatcher_robot_out,
+/// so that the replay is deterministic.
+
+DEFINE_string(file, "", "Log file name");
+DEFINE_string(channel, "CASSIE_OUTPUT", "Channel of the lcmt_cassie_out");
+DEFINE_string(reference, "",
+              "Reference estimated states "
+              "(default <file>.estimator_reference)");
+DEFINE_bool(write_reference, false,
+            "Write the estimated states to the reference file instead of "
+            "comparing them to it");
+DEFINE_int64(max_count, -1, "Max number of messages to replay (-1 for all)");
+DEFINE_double(pelvis_height, 1.0, "Initial height of the pelvis");
+DEFINE_int64(test_mode, -1,
+             "-1: Regular EKF (not testing mode). "
+             "0: both feet always in contact with ground. "
+             "1: both feet never in contact with ground. ");
+
+namespace dairlib {
+
+using drake::systems::CompositeEventCollection;
+using drake::systems::State;
+using Eigen::Matrix3d;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+using std::cout;
+using std::endl;
+using std::vector;
+using systems::OutputVector;
+
+typedef std::chrono::steady_clock my_clock;
+
+// Reads the lcmt_cassie_out messages of the log
+vector<lcmt_cassie_out> ReadMessages(const std::string& file,
+                                     const std::string& channel) {
+  lcm::LogFile log(file, "r");
+  DRAKE_DEMAND(log.good());
+  vector<lcmt_cassie_out> messages;
+  for (const lcm::LogEvent* event = log.readNextEvent(); event != nullptr;
+       event = log.readNextEvent()) {
+    if (event->channel != channel) continue;
+    if (FLAGS_max_count >= 0 &&
+        static_cast<int64_t>(messages.size()) >= FLAGS_max_count) {
+      break;
+    }
+    lcmt_cassie_out message;
+    if (message.decode(event->data, 0, event->datalen) < 0) continue;
+    messages.push_back(message);
+  }
+  return messages;
+}
+
+// Reads the reference, one line per message: the time of the message, then
+// the estimated state
+vector<VectorXd> ReadReference(const std::string& file, int n_x) {
+  std::ifstream in(file);
+  DRAKE_DEMAND(in.good());
+  vector<VectorXd> reference;
+  VectorXd row(1 + n_x);
+  while (true) {
+    for (int i = 0; i < row.size(); i++) in >> row(i);
+    if (!in) break;
+    reference.push_back(row);
+  }
+  return reference;
+}
+
+int DoMain(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  DRAKE_DEMAND(!FLAGS_file.empty());
+  const std::string reference_file = FLAGS_reference.empty()
+                                         ? FLAGS_file + ".estimator_reference"
+                                         : FLAGS_reference;
+
+  // Build the estimator as dispatcher_robot_out
+  drake::multibody::MultibodyPlant<double> plant(0.0);
+  addCassieMultibody(&plant, nullptr, true /*floating base*/,
+                     "examples/Cassie/urdf/cassie_v2.urdf",
+                     true /*spring model*/, false /*loop closure*/);
+  plant.Finalize();
+
+  multibody::KinematicEvaluatorSet<double> fourbar_evaluator(plant);
+  auto left_loop = LeftLoopClosureEvaluator(plant);
+  auto right_loop = RightLoopClosureEvaluator(plant);
+  fourbar_evaluator.add_evaluator(&left_loop);
+  fourbar_evaluator.add_evaluator(&right_loop);
+  multibody::KinematicEvaluatorSet<double> left_contact_evaluator(plant);
+  auto left_toe = LeftToeFront(plant);
+  auto left_heel = LeftToeRear(plant);
+  auto left_toe_evaluator = multibody::WorldPointEvaluator(
+      plant, left_toe.first, left_toe.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {1, 2});
+  auto left_heel_evaluator = multibody::WorldPointEvaluator(
+      plant, left_heel.first, left_heel.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {0, 1, 2});
+  left_contact_evaluator.add_evaluator(&left_toe_evaluator);
+  left_contact_evaluator.add_evaluator(&left_heel_evaluator);
+  multibody::KinematicEvaluatorSet<double> right_contact_evaluator(plant);
+  auto right_toe = RightToeFront(plant);
+  auto right_heel = RightToeRear(plant);
+  auto right_toe_evaluator = multibody::WorldPointEvaluator(
+      plant, right_toe.first, right_toe.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {1, 2});
+  auto right_heel_evaluator = multibody::WorldPointEvaluator(
+      plant, right_heel.first, right_heel.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {0, 1, 2});
+  right_contact_evaluator.add_evaluator(&right_toe_evaluator);
+  right_contact_evaluator.add_evaluator(&right_heel_evaluator);
+
+  systems::CassieStateEstimator estimator(
+      plant, &fourbar_evaluator, &left_contact_evaluator,
+      &right_contact_evaluator, false, false, FLAGS_test_mode);
+
+  const vector<lcmt_cassie_out> messages =
+      ReadMessages(FLAGS_file, FLAGS_channel);
+  DRAKE_DEMAND(!messages.empty());
+  cout << "Replaying " << messages.size() << " messages" << endl;
+
+  // Initialize the context as dispatcher_robot_out
+  auto context = estimator.CreateDefaultContext();
+  std::unique_ptr<State<double>> state = context->CloneState();
+  std::unique_ptr<CompositeEventCollection<double>> events =
+      estimator.AllocateCompositeEventCollection();
+  cassie_out_t cassie_out;
+  cassieOutFromLcm(messages[0], &cassie_out);
+  auto& input_value =
+      estimator.get_input_port(0).FixValue(context.get(), cassie_out);
+  const double t0 = messages[0].utime * 1e-6;
+  context->SetTime(t0);
+  estimator.setPreviousTime(context.get(), t0);
+  estimator.setInitialPelvisPose(context.get(), Eigen::Vector4d(1, 0, 0, 0),
+                                 Vector3d(0, 0, FLAGS_pelvis_height));
+  VectorXd init_prev_imu_value(6);
+  init_prev_imu_value << 0, 0, 0, 0, 0, 9.81;
+  estimator.setPreviousImuMeasurement(context.get(), init_prev_imu_value);
+
+  const int n_x = plant.num_positions() + plant.num_velocities();
+  vector<VectorXd> estimates;
+  vector<double> durations_us;
+  auto replay_start = my_clock::now();
+  for (size_t k = 1; k < messages.size(); k++) {
+    cassieOutFromLcm(messages[k], &cassie_out);
+    input_value.GetMutableData()->set_value(cassie_out);
+    const double time = messages[k].utime * 1e-6;
+    if (time <= context->get_time()) continue;
+
+    auto start = my_clock::now();
+    estimator.set_next_message_time(time);
+    events->Clear();
+    const double update_time =
+        estimator.CalcNextUpdateTime(*context, events.get());
+    context->SetTime(update_time);
+    // The update starts from the current state
+    state->SetFrom(context->get_state());
+    estimator.CalcUnrestrictedUpdate(
+        *context, events->get_unrestricted_update_events(), state.get());
+    context->get_mutable_state().SetFrom(*state);
+    context->SetTime(time);
+    const OutputVector<double>& output =
+        estimator.get_output_port(0).Eval<OutputVector<double>>(*context);
+    auto stop = my_clock::now();
+
+    durations_us.push_back(
+        std::chrono::duration<double, std::micro>(stop - start).count());
+    VectorXd estimate(1 + n_x);
+    estimate << time, output.GetState();
+    estimates.push_back(estimate);
+  }
+  const double replay_duration =
+      std::chrono::duration<double>(my_clock::now() - replay_start).count();
+  DRAKE_DEMAND(!durations_us.empty());
+
+  // Latency and throughput
+  double mean = 0;
+  for (double t : durations_us) mean += t / durations_us.size();
+  std::sort(durations_us.begin(), durations_us.end());
+  auto percentile = [&durations_us](double p) {
+    return durations_us[std::min(durations_us.size() - 1,
+                                 static_cast<size_t>(p * durations_us.size()))];
+  };
+  cout << "Update duration: mean " << mean << " us, median "
+       << percentile(0.5) << " us, p90 " << percentile(0.9) << " us, p99 "
+       << percentile(0.99) << " us, max " << durations_us.back() << " us"
+       << endl;
+  cout << "Throughput: " << estimates.size() / replay_duration
+       << " updates/s (including the conversion of the messages)" << endl;
+
+  if (FLAGS_write_reference) {
+    std::ofstream out(reference_file);
+    out.precision(17);
+    for (const VectorXd& estimate : estimates) {
+      out << estimate.transpose() << "\n";
+    }
+    cout << "Wrote the reference to " << reference_file << endl;
+    return 0;
+  }
+
+  // Drift versus the reference
+  const vector<VectorXd> reference = ReadReference(reference_file, n_x);
+  if (reference.size() != estimates.size()) {
+    cout << "The reference has " << reference.size() << " states, expected "
+         << estimates.size() << endl;
+    return 1;
+  }
+  const int n_q = plant.num_positions();
+  const int n_v = plant.num_velocities();
+  double max_position_error = 0;
+  double max_velocity_error = 0;
+  double max_pelvis_drift = 0;
+  for (size_t k = 0; k < estimates.size(); k++) {
+    DRAKE_DEMAND(reference[k](0) == estimates[k](0));
+    const VectorXd error = estimates[k].tail(n_x) - reference[k].tail(n_x);
+    max_position_error =
+        std::max(max_position_error, error.head(n_q).lpNorm<Eigen::Infinity>());
+    max_velocity_error =
+        std::max(max_velocity_error, error.tail(n_v).lpNorm<Eigen::Infinity>());
+    // Pelvis position (after the quaternion)
+    max_pelvis_drift = std::max(max_pelvis_drift, error.segment<3>(4).norm());
+  }
+  const VectorXd final_error = estimates.back().tail(n_x) -
+                               reference.back().tail(n_x);
+  cout << "Drift versus " << reference_file << ": max position error "
+       << max_position_error << ", max velocity error " << max_velocity_error
+       << ", max pelvis position drift " << max_pelvis_drift
+       << ", final pelvis position drift " << final_error.segment<3>(4).norm()
+       << endl;
+  return 0;
+}
+
+}  // namespace dairlib
+
+int main(int argc, char* argv[]) { return dairlib::DoMain(argc, argv); }
@@ -150,6 +150,46 @@ TEST_F(ContactEstimationTest, solveFourbarLinkageTest) {
   EXPECT_TRUE((calc_right_heel_spring - nlp_right_heel_spring) > -1e-10);
 }
 
+// Checks that the heel spring angles close the fourbar linkages across the
+// range of the knee, for random floating base positions. The ankle is set
+// close to the angle at which the heel springs are at rest.
+TEST_F(ContactEstimationTest, solveFourbarLinkageJointRangeTest) {
+  std::map<std::string, int> positionIndexMap =
+      multibody::makeNameToPositionsMap(plant_);
+  auto context = plant_.CreateDefaultContext();
+  std::srand(0);
+
+  for (double knee = -2.1; knee < -0.85; knee += 0.1) {
+    for (double knee_spring : {-0.05, 0.0, 0.05}) {
+      for (double ankle_offset : {0.2, 0.225, 0.25}) {
+        VectorXd q = VectorXd::Zero(plant_.num_positions());
+        const Eigen::Quaterniond quat = Eigen::Quaterniond::UnitRandom();
+        q.head<4>() << quat.w(), quat.vec();
+        q.segment<3>(4) = Vector3d::Random();
+        for (const std::string side : {"left", "right"}) {
+          q(positionIndexMap.at("hip_roll_" + side)) = 0.1;
+          q(positionIndexMap.at("hip_yaw_" + side)) = -0.2;
+          q(positionIndexMap.at("hip_pitch_" + side)) = knee + 2;
+          q(positionIndexMap.at("knee_" + side)) = knee;
+          q(positionIndexMap.at("knee_joint_" + side)) = knee_spring;
+          q(positionIndexMap.at("ankle_joint_" + side)) =
+              ankle_offset - knee - knee_spring;
+          q(positionIndexMap.at("toe_" + side)) = -1.5;
+        }
+
+        double left_heel_spring, right_heel_spring;
+        estimator_->solveFourbarLinkage(q, &left_heel_spring,
+                                        &right_heel_spring);
+        q(positionIndexMap.at("ankle_spring_joint_left")) = left_heel_spring;
+        q(positionIndexMap.at("ankle_spring_joint_right")) = right_heel_spring;
+        plant_.SetPositions(context.get(), q);
+        EXPECT_TRUE(fourbar_evaluator_->EvalFull(*context).isZero(1e-10))
+            << knee << " " << knee_spring << " " << ankle_offset;
+      }
+    }
+  }
+}
+
 // Double support contact estimation test
 // Checks if the contactEstimation returns the correct contacts for a
 // configuration of the robot in double stance.
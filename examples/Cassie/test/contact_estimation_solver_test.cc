@@ -0,0 +1,137 @@
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+#include "drake/solvers/equality_constrained_qp_solver.h"
+#include "drake/solvers/mathematical_program.h"
+
+#include "examples/Cassie/contact_estimation_solver.h"
+
+namespace dairlib {
+namespace systems {
+namespace {
+
+using drake::solvers::EqualityConstrainedQPSolver;
+using drake::solvers::MathematicalProgram;
+using drake::solvers::MathematicalProgramResult;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+const int n_v = 22;
+const int n_b = 2;
+const int n_c = 6;
+const int n_c_active = 5;
+const double w = 100;
+const double eps = 1e-10;
+
+// Compares ContactEstimationSolver to the equality constrained QPs it
+// replaces, on random data. The contact Jacobians are rank deficient, as for
+// the two contact points of a rigid foot.
+class ContactEstimationSolverTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::srand(0);
+    const MatrixXd A = MatrixXd::Random(n_v, n_v);
+    M_ = A * A.transpose() + MatrixXd::Identity(n_v, n_v);
+    C_ = VectorXd::Random(n_v);
+    J_b_ = MatrixXd::Random(n_b, n_v);
+    JdotV_b_ = VectorXd::Random(n_b);
+    J_imu_ = MatrixXd::Random(3, n_v);
+    JdotV_imu_ = VectorXd::Random(3);
+    imu_accel_ = VectorXd::Random(3);
+    J_cl_ = MatrixXd::Random(n_c, n_c_active) *
+            MatrixXd::Random(n_c_active, n_v);
+    J_cr_ = MatrixXd::Random(n_c, n_c_active) *
+            MatrixXd::Random(n_c_active, n_v);
+    JdotV_cl_ = VectorXd::Random(n_c_active);
+    JdotV_cr_ = VectorXd::Random(n_c_active);
+  }
+
+  // Solves the QP of a hypothesis with EqualityConstrainedQPSolver, and
+  // returns the optimal cost including the constant term
+  double SolveQp(bool left, bool right, VectorXd* ddq) {
+    MathematicalProgram prog;
+    auto ddq_var = prog.NewContinuousVariables(n_v);
+    auto lambda = prog.NewContinuousVariables(n_b + 2 * n_c);
+    auto eps_imu = prog.NewContinuousVariables(3);
+    prog.AddLinearEqualityConstraint(J_b_, -JdotV_b_, ddq_var);
+    MatrixXd A_imu(3, n_v + 3);
+    A_imu << J_imu_, MatrixXd::Identity(3, 3);
+    prog.AddLinearEqualityConstraint(A_imu, imu_accel_ - JdotV_imu_,
+                                     {ddq_var, eps_imu});
+    prog.AddQuadraticCost(w * MatrixXd::Identity(3, 3), VectorXd::Zero(3),
+                          eps_imu);
+
+    MatrixXd A_dyn = MatrixXd::Zero(n_v, n_v + n_b + 2 * n_c);
+    A_dyn.leftCols(n_v + n_b) << M_, -J_b_.transpose();
+    if (left) {
+      A_dyn.middleCols(n_v + n_b, n_c) = -J_cl_.transpose();
+      auto eps_cl = prog.NewContinuousVariables(n_c_active);
+      MatrixXd A_cl(n_c_active, n_v + n_c_active);
+      A_cl << J_cl_.topRows(n_c_active),
+          MatrixXd::Identity(n_c_active, n_c_active);
+      prog.AddLinearEqualityConstraint(A_cl, -JdotV_cl_, {ddq_var, eps_cl});
+      prog.AddQuadraticCost(w * MatrixXd::Identity(n_c_active, n_c_active),
+                            VectorXd::Zero(n_c_active), eps_cl);
+    }
+    if (right) {
+      A_dyn.rightCols(n_c) = -J_cr_.transpose();
+      auto eps_cr = prog.NewContinuousVariables(n_c_active);
+      MatrixXd A_cr(n_c_active, n_v + n_c_active);
+      A_cr << J_cr_.topRows(n_c_active),
+          MatrixXd::Identity(n_c_active, n_c_active);
+      prog.AddLinearEqualityConstraint(A_cr, -JdotV_cr_, {ddq_var, eps_cr});
+      prog.AddQuadraticCost(w * MatrixXd::Identity(n_c_active, n_c_active),
+                            VectorXd::Zero(n_c_active), eps_cr);
+    }
+    const int n_z = A_dyn.cols();
+    prog.AddQuadraticCost(
+        2 * A_dyn.transpose() * A_dyn + eps * MatrixXd::Identity(n_z, n_z),
+        2 * A_dyn.transpose() * C_, {ddq_var, lambda});
+
+    EqualityConstrainedQPSolver solver;
+    drake::solvers::SolverOptions options;
+    options.SetOption(EqualityConstrainedQPSolver::id(), "FeasibilityTol",
+                      1e-6);
+    const MathematicalProgramResult result = solver.Solve(prog, {}, options);
+    EXPECT_TRUE(result.is_success());
+    *ddq = result.GetSolution(ddq_var);
+    return result.get_optimal_cost() + C_.squaredNorm();
+  }
+
+  MatrixXd M_;
+  VectorXd C_;
+  MatrixXd J_b_;
+  VectorXd JdotV_b_;
+  MatrixXd J_imu_;
+  VectorXd JdotV_imu_;
+  VectorXd imu_accel_;
+  MatrixXd J_cl_;
+  MatrixXd J_cr_;
+  VectorXd JdotV_cl_;
+  VectorXd JdotV_cr_;
+};
+
+TEST_F(ContactEstimationSolverTest, MatchesQp) {
+  ContactEstimationSolver solver(n_v, n_b, n_c, n_c_active, n_c, n_c_active,
+                                 w, eps);
+  solver.Update(M_, C_, J_b_, JdotV_b_, J_imu_, JdotV_imu_, imu_accel_, J_cl_,
+                J_cl_.topRows(n_c_active), JdotV_cl_, J_cr_,
+                J_cr_.topRows(n_c_active), JdotV_cr_);
+
+  for (auto stance : {ContactEstimationSolver::kDoubleSupport,
+                      ContactEstimationSolver::kLeftSupport,
+                      ContactEstimationSolver::kRightSupport}) {
+    VectorXd ddq_qp;
+    const double cost_qp =
+        SolveQp(stance != ContactEstimationSolver::kRightSupport,
+                stance != ContactEstimationSolver::kLeftSupport, &ddq_qp);
+    const ContactEstimationSolver::Solution solution = solver.Solve(stance);
+    ASSERT_TRUE(solution.success);
+    EXPECT_NEAR(solution.cost, cost_qp, 1e-6 * cost_qp) << stance;
+    EXPECT_TRUE(solution.ddq.isApprox(ddq_qp, 1e-6)) << stance;
+  }
+}
+
+}  // namespace
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,128 @@
+#include <array>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "src/InEKF.h"
+
+#include "examples/Cassie/contact_inekf.h"
+
+namespace dairlib {
+namespace systems {
+namespace {
+
+using Eigen::Matrix3d;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+
+typedef ContactInekf<2> Inekf;
+
+// Runs ContactInekf and inekf::InEKF side by side on random imu measurements
+// and contact kinematics, with contacts being made and broken, and compares
+// their estimates.
+void CompareWithInekf(Inekf::Implementation implementation) {
+  std::srand(0);
+  const Vector3d gravity(0, 0, -9.81);
+  Eigen::Matrix<double, 15, 15> P = Eigen::Matrix<double, 15, 15>::Identity();
+  P.block<3, 3>(0, 0) *= 0.0001;
+  P.block<3, 3>(3, 3) *= 0.01;
+  P.block<3, 3>(6, 6) *= 0.0001;
+  P.block<3, 3>(9, 9) *= 0.0001;
+  P.block<3, 3>(12, 12) *= 0.01;
+  const Vector3d position(0.1, -0.2, 1);
+
+  inekf::RobotState initial_state;
+  initial_state.setRotation(Matrix3d::Identity());
+  initial_state.setVelocity(Vector3d::Zero());
+  initial_state.setPosition(position);
+  initial_state.setGyroscopeBias(Vector3d::Zero());
+  initial_state.setAccelerometerBias(Vector3d::Zero());
+  initial_state.setP(P);
+  inekf::NoiseParams noise_params;
+  noise_params.setGyroscopeNoise(0.002);
+  noise_params.setAccelerometerNoise(0.04);
+  noise_params.setGyroscopeBiasNoise(0.001);
+  noise_params.setAccelerometerBiasNoise(0.001);
+  noise_params.setContactNoise(0.05);
+  inekf::InEKF reference(initial_state, noise_params);
+
+  Inekf::NoiseParams params;
+  params.gyroscope = 0.002;
+  params.accelerometer = 0.04;
+  params.gyroscope_bias = 0.001;
+  params.accelerometer_bias = 0.001;
+  params.contact = 0.05;
+  Inekf ekf(params, gravity, implementation);
+  VectorXd data = Inekf::MakeState(Matrix3d::Identity(), Vector3d::Zero(),
+                                   position, Vector3d::Zero(),
+                                   Vector3d::Zero(), P);
+  Inekf::State state(data.data());
+
+  const double dt = 0.0005;
+  for (int k = 0; k < 1000; k++) {
+    Eigen::Matrix<double, 6, 1> imu;
+    imu << 0.1 * Vector3d::Random(), -gravity + 0.5 * Vector3d::Random();
+    reference.Propagate(imu, dt);
+    ekf.Propagate(imu, dt, &state);
+
+    // Alternate between double, left and right support
+    const std::array<bool, 2> in_contact = {(k / 100) % 3 != 2,
+                                            (k / 100) % 3 != 1};
+    Inekf::ContactPositions positions;
+    std::array<Matrix3d, 2> covariances;
+    inekf::vectorKinematics measured_kinematics;
+    for (int i = 0; i < 2; i++) {
+      positions.col(i) = Vector3d(0, 0.1 - 0.2 * i, -0.9) +
+                         0.01 * Vector3d::Random();
+      const MatrixXd J = 0.1 * MatrixXd::Random(3, 3);
+      covariances[i] = 1e-4 * (J * J.transpose() + Matrix3d::Identity());
+      Eigen::Matrix4d pose = Eigen::Matrix4d::Identity();
+      pose.block<3, 1>(0, 3) = positions.col(i);
+      Eigen::Matrix<double, 6, 6> covariance =
+          Eigen::Matrix<double, 6, 6>::Identity();
+      covariance.block<3, 3>(3, 3) = covariances[i];
+      measured_kinematics.push_back(inekf::Kinematics(i, pose, covariance));
+    }
+    reference.setContacts({std::pair<int, bool>(0, in_contact[0]),
+                           std::pair<int, bool>(1, in_contact[1])});
+    reference.CorrectKinematics(measured_kinematics);
+    ekf.CorrectContacts(in_contact, positions, covariances, &state);
+
+    const inekf::RobotState& expected = reference.getState();
+    const double tol = 1e-8;
+    ASSERT_TRUE(state.rotation.isApprox(expected.getRotation(), tol)) << k;
+    ASSERT_TRUE(
+        (state.velocity - expected.getVelocity()).isZero(tol)) << k;
+    ASSERT_TRUE(
+        (state.position - expected.getPosition()).isZero(tol)) << k;
+    ASSERT_TRUE(
+        (state.gyroscope_bias - expected.getGyroscopeBias()).isZero(tol))
+        << k;
+    ASSERT_TRUE((state.accelerometer_bias - expected.getAccelerometerBias())
+                    .isZero(tol))
+        << k;
+    // Covariance of the imu state and biases (the order of the contact points
+    // in inekf depends on the order in which they were added)
+    const MatrixXd expected_P = expected.getP();
+    const int n = expected_P.rows();
+    ASSERT_TRUE(state.P.topLeftCorner<9, 9>().isApprox(
+        expected_P.topLeftCorner(9, 9), tol)) << k;
+    ASSERT_TRUE(state.P.bottomRightCorner<6, 6>().isApprox(
+        expected_P.bottomRightCorner(6, 6), tol)) << k;
+    ASSERT_EQ(n, 15 + 3 * static_cast<int>(state.contact_estimated.sum()));
+  }
+}
+
+GTEST_TEST(ContactInekfTest, StructuredMatchesInekf) {
+  CompareWithInekf(Inekf::Implementation::kStructured);
+}
+
+GTEST_TEST(ContactInekfTest, DenseMatchesInekf) {
+  CompareWithInekf(Inekf::Implementation::kDense);
+}
+
+}  // namespace
+}  // namespace systems
+}  // namespace dairlib
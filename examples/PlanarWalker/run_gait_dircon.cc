@@ -16,10 +16,22 @@
 #include "multibody/kinematic/world_point_evaluator.h"
 #include "multibody/multibody_utils.h"
 #include "multibody/visualization_utils.h"
+#include "solvers/program_profiler.h"
 
 DEFINE_double(strideLength, 0.1, "The stride length.");
 DEFINE_double(duration, 1, "The stride duration");
 DEFINE_bool(autodiff, false, "Double or autodiff version");
+DEFINE_int32(num_threads, 1,
+             "Number of threads evaluating the collocation constraints");
+DEFINE_bool(analytic_gradients, false,
+            "Use analytic gradients of the dynamics (double version only)");
+DEFINE_int32(dynamics_cache_mb, 64,
+             "Memory cap of each dynamics cache, in megabytes");
+DEFINE_bool(profile, false,
+            "Print the time spent in each type of constraint after the solve");
+DEFINE_string(profile_csv, "",
+              "If not empty (and --profile is set), file the profile is "
+              "written to");
 
 using drake::AutoDiffXd;
 using drake::multibody::MultibodyPlant;
@@ -38,6 +50,7 @@ namespace {
 using systems::trajectory_optimization::DirconModeSequence;
 using systems::trajectory_optimization::DirconMode;
 using systems::trajectory_optimization::Dircon;
+using systems::trajectory_optimization::DirconEvaluationOptions;
 using systems::trajectory_optimization::KinematicConstraintType;
 
 using std::vector;
@@ -106,7 +119,12 @@ void runDircon(
   auto sequence = DirconModeSequence<T>(plant);
   sequence.AddMode(&mode_left);
   sequence.AddMode(&mode_right);
-  auto trajopt = Dircon<T>(sequence);  
+  DirconEvaluationOptions options;
+  options.num_threads = FLAGS_num_threads;
+  options.analytic_gradients = FLAGS_analytic_gradients;
+  options.dynamics_cache_bytes =
+      static_cast<std::size_t>(FLAGS_dynamics_cache_mb) << 20;
+  auto trajopt = Dircon<T>(sequence, options);
 
   trajopt.AddDurationBounds(duration, duration);
 
@@ -191,12 +209,31 @@ void runDircon(
       dairlib::FindResourceOrThrow("examples/PlanarWalker/PlanarWalker.urdf"),
       visualizer_poses, 0.2, "base");
 
+  std::unique_ptr<solvers::ProgramProfiler> profiler;
+  if (FLAGS_profile) {
+    profiler = std::make_unique<solvers::ProgramProfiler>(trajopt);
+  }
+
   auto start = std::chrono::high_resolution_clock::now();
   const auto result = Solve(trajopt, trajopt.initial_guess());
   auto finish = std::chrono::high_resolution_clock::now();
   std::chrono::duration<double> elapsed = finish - start;
   std::cout << "Solve time:" << elapsed.count() <<std::endl;
   std::cout << "Cost:" << result.get_optimal_cost() <<std::endl;
+  for (int j = 0; j < sequence.num_modes(); j++) {
+    const auto stats = trajopt.GetDynamicsCacheStats(j);
+    std::cout << "Dynamics cache, mode " << j << ": " << stats.hits
+              << " hits, " << stats.misses << " misses (hit rate "
+              << stats.hit_rate() << "), " << stats.evictions
+              << " evictions, " << stats.num_entries << " entries ("
+              << stats.num_bytes / 1024 << " kB)" << std::endl;
+  }
+  if (profiler) {
+    std::cout << profiler->Report(elapsed.count());
+    if (!FLAGS_profile_csv.empty()) {
+      profiler->WriteCsv(FLAGS_profile_csv);
+    }
+  }
 
   // visualizer
   const drake::trajectories::PiecewisePolynomial<double> pp_xtraj =
@@ -0,0 +1,243 @@
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "drake/multibody/parsing/parser.h"
+#include "drake/solvers/snopt_solver.h"
+
+#include "common/find_resource.h"
+#include "systems/trajectory_optimization/dircon/dircon.h"
+#include "systems/trajectory_optimization/multi_start.h"
+#include "systems/trajectory_optimization/trajectory_library.h"
+#include "multibody/kinematic/world_point_evaluator.h"
+#include "multibody/multibody_utils.h"
+
+DEFINE_double(min_stride_length, 0.05, "Shortest stride length of the sweep");
+DEFINE_double(max_stride_length, 0.3, "Longest stride length of the sweep");
+DEFINE_int32(num_strides, 6, "Number of stride lengths of the sweep");
+DEFINE_double(duration, 1, "The stride duration");
+DEFINE_int32(num_workers, 4, "Number of problems solved at a time");
+DEFINE_bool(processes, false,
+            "Solve the problems in forked processes rather than threads");
+DEFINE_string(output_directory, "/tmp",
+              "Directory of the saved gaits, nothing is saved if empty");
+DEFINE_string(warm_start_directory, "",
+              "Directory of previously saved gaits. If not empty, each "
+              "problem is warm started from its nearest saved gaits.");
+
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using drake::trajectories::PiecewisePolynomial;
+using Eigen::Matrix3d;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+
+namespace dairlib {
+namespace {
+
+using multibody::KinematicEvaluatorSet;
+using multibody::WorldPointEvaluator;
+using systems::trajectory_optimization::Dircon;
+using systems::trajectory_optimization::DirconMode;
+using systems::trajectory_optimization::DirconModeSequence;
+using systems::trajectory_optimization::MultiStartDriver;
+using systems::trajectory_optimization::TrajectoryLibrary;
+using std::vector;
+
+/// Builds the two-mode walking problem of run_gait_dircon for one stride
+/// length. The random initial guess is seeded by the index of the problem, and
+/// replaced by the interpolation of the nearest gaits of `library` if it is
+/// not empty.
+std::unique_ptr<MultiStartDriver::Problem> MakeWalkingProblem(
+    const MultibodyPlant<double>& plant, const TrajectoryLibrary& library,
+    double stride_length, int index) {
+  auto problem = std::make_unique<MultiStartDriver::Problem>();
+  problem->task_parameters = VectorXd::Constant(1, stride_length);
+  std::mt19937 generator(index);
+  std::uniform_real_distribution<double> uniform(-1, 1);
+  auto random = [&](int size) {
+    VectorXd v(size);
+    for (int i = 0; i < size; i++) v(i) = uniform(generator);
+    return v;
+  };
+
+  Vector3d pt(0, 0, -.5);
+  auto left_foot_eval =
+      problem->Own(std::make_unique<WorldPointEvaluator<double>>(
+          plant, pt, plant.GetFrameByName("left_lower_leg"),
+          Matrix3d::Identity(), Vector3d::Zero(), std::vector<int>{0, 2}));
+  auto right_foot_eval =
+      problem->Own(std::make_unique<WorldPointEvaluator<double>>(
+          plant, pt, plant.GetFrameByName("right_lower_leg"),
+          Matrix3d::Identity(), Vector3d::Zero(), std::vector<int>{0, 2}));
+  for (auto eval : {left_foot_eval, right_foot_eval}) {
+    eval->set_frictional();
+    eval->set_mu(1);
+  }
+  auto evaluators_left =
+      problem->Own(std::make_unique<KinematicEvaluatorSet<double>>(plant));
+  evaluators_left->add_evaluator(left_foot_eval);
+  auto evaluators_right =
+      problem->Own(std::make_unique<KinematicEvaluatorSet<double>>(plant));
+  evaluators_right->add_evaluator(right_foot_eval);
+
+  const int num_knotpoints = 10;
+  auto mode_left = problem->Own(std::make_unique<DirconMode<double>>(
+      *evaluators_left, num_knotpoints, .1, 3));
+  mode_left->MakeConstraintRelative(0, 0);  // x-coordinate
+  auto mode_right = problem->Own(std::make_unique<DirconMode<double>>(
+      *evaluators_right, num_knotpoints, .1, 3));
+  mode_right->MakeConstraintRelative(0, 0);  // x-coordinate
+  auto sequence =
+      problem->Own(std::make_unique<DirconModeSequence<double>>(plant));
+  sequence->AddMode(mode_left);
+  sequence->AddMode(mode_right);
+
+  auto trajopt_owned = std::make_unique<Dircon<double>>(*sequence);
+  auto& trajopt = *trajopt_owned;
+  trajopt.AddDurationBounds(FLAGS_duration, FLAGS_duration);
+  trajopt.SetSolverOption(drake::solvers::SnoptSolver::id(),
+                          "Major iterations limit", 200);
+
+  // Initial guess, as in run_gait_dircon
+  const int nx = plant.num_positions() + plant.num_velocities();
+  const int nu = plant.num_actuators();
+  const int N = num_knotpoints;
+  vector<double> init_time;
+  vector<MatrixXd> init_x, init_u;
+  for (int i = 0; i < 2 * N - 1; i++) {
+    init_time.push_back(i * .2);
+    init_x.push_back(.1 * random(nx));
+    init_u.push_back(random(nu));
+  }
+  trajopt.drake::systems::trajectory_optimization::MultipleShooting::
+      SetInitialTrajectory(
+          PiecewisePolynomial<double>::ZeroOrderHold(init_time, init_u),
+          PiecewisePolynomial<double>::ZeroOrderHold(init_time, init_x));
+  VectorXd init_l_vec(3);
+  init_l_vec << 0, 0, 20 * 9.81;
+  vector<double> init_time_j;
+  vector<MatrixXd> init_l_j, init_vc_j;
+  for (int i = 0; i < N; i++) {
+    init_time_j.push_back(i * .2);
+    init_l_j.push_back(init_l_vec);
+    init_vc_j.push_back(VectorXd::Zero(3));
+  }
+  const auto init_l_traj =
+      PiecewisePolynomial<double>::ZeroOrderHold(init_time_j, init_l_j);
+  const auto init_vc_traj =
+      PiecewisePolynomial<double>::ZeroOrderHold(init_time_j, init_vc_j);
+  for (int j = 0; j < sequence->num_modes(); j++) {
+    trajopt.SetInitialForceTrajectory(j, init_l_traj, init_l_traj,
+                                      init_vc_traj);
+  }
+
+  // Periodicity and stride length, as in run_gait_dircon
+  auto positions_map = multibody::makeNameToPositionsMap(plant);
+  auto velocities_map = multibody::makeNameToVelocitiesMap(plant);
+  const int nq = plant.num_positions();
+  auto x0 = trajopt.initial_state();
+  auto xf = trajopt.final_state();
+  trajopt.AddLinearConstraint(x0(positions_map["planar_z"]) ==
+                              xf(positions_map["planar_z"]));
+  trajopt.AddLinearConstraint(x0(positions_map["hip_pin"]) +
+                                  x0(positions_map["planar_roty"]) ==
+                              xf(positions_map["planar_roty"]));
+  trajopt.AddLinearConstraint(x0(positions_map["left_knee_pin"]) ==
+                              xf(positions_map["right_knee_pin"]));
+  trajopt.AddLinearConstraint(x0(positions_map["right_knee_pin"]) ==
+                              xf(positions_map["left_knee_pin"]));
+  trajopt.AddLinearConstraint(x0(positions_map["hip_pin"]) ==
+                              -xf(positions_map["hip_pin"]));
+  trajopt.AddLinearConstraint(x0(nq + velocities_map["planar_zdot"]) ==
+                              xf(nq + velocities_map["planar_zdot"]));
+  trajopt.AddLinearConstraint(x0(nq + velocities_map["hip_pindot"]) +
+                                  x0(nq + velocities_map["planar_rotydot"]) ==
+                              xf(nq + velocities_map["planar_rotydot"]));
+  trajopt.AddLinearConstraint(x0(nq + velocities_map["left_knee_pindot"]) ==
+                              xf(nq + velocities_map["right_knee_pindot"]));
+  trajopt.AddLinearConstraint(x0(nq + velocities_map["right_knee_pindot"]) ==
+                              xf(nq + velocities_map["left_knee_pindot"]));
+  trajopt.AddLinearConstraint(x0(nq + velocities_map["hip_pindot"]) ==
+                              -xf(nq + velocities_map["hip_pindot"]));
+
+  auto x = trajopt.state();
+  trajopt.AddConstraintToAllKnotPoints(x(positions_map["left_knee_pin"]) >= 0);
+  trajopt.AddConstraintToAllKnotPoints(x(positions_map["right_knee_pin"]) >=
+                                       0);
+  trajopt.AddLinearConstraint(x0(positions_map["planar_x"]) == 0);
+  trajopt.AddLinearConstraint(xf(positions_map["planar_x"]) == stride_length);
+  for (int i = 0; i < N; i++) {
+    trajopt.AddBoundingBoxConstraint(0, 0, trajopt.force_vars(0, i)(1));
+    trajopt.AddBoundingBoxConstraint(0, 0, trajopt.force_vars(1, i)(1));
+  }
+
+  const double R = 10;  // Cost on input effort
+  auto u = trajopt.input();
+  trajopt.AddRunningCost(u.transpose() * R * u);
+
+  problem->state_names = multibody::createStateNameVectorFromMap(plant);
+  problem->input_names = multibody::createActuatorNameVectorFromMap(plant);
+  if (library.size() > 0) {
+    library.SetInitialGuess(problem->task_parameters, &trajopt);
+  }
+  problem->trajopt = std::move(trajopt_owned);
+  return problem;
+}
+
+int DoMain() {
+  MultibodyPlant<double> plant(0.0);
+  Parser parser(&plant);
+  parser.AddModelFromFile(
+      FindResourceOrThrow("examples/PlanarWalker/PlanarWalker.urdf"));
+  plant.WeldFrames(plant.world_frame(), plant.GetFrameByName("base"),
+                   drake::math::RigidTransform<double>());
+  plant.Finalize();
+
+  const VectorXd stride_lengths = VectorXd::LinSpaced(
+      FLAGS_num_strides, FLAGS_min_stride_length, FLAGS_max_stride_length);
+
+  TrajectoryLibrary library;
+  if (!FLAGS_warm_start_directory.empty()) {
+    const int num_gaits =
+        library.AddDirectory(FLAGS_warm_start_directory, "planar_walker_gait");
+    std::cout << "Warm starting from " << num_gaits << " saved gaits"
+              << std::endl;
+  }
+
+  MultiStartDriver::Options options;
+  options.num_workers = FLAGS_num_workers;
+  options.parallelism = FLAGS_processes
+                            ? MultiStartDriver::Parallelism::kProcesses
+                            : MultiStartDriver::Parallelism::kThreads;
+  options.output_directory = FLAGS_output_directory;
+  options.name = "planar_walker_gait";
+  MultiStartDriver driver(
+      [&](int i) {
+        return MakeWalkingProblem(plant, library, stride_lengths(i), i);
+      },
+      options);
+
+  for (const auto& result : driver.Run(FLAGS_num_strides)) {
+    std::cout << "Stride length " << stride_lengths(result.index) << ": "
+              << result.solution_result << ", cost " << result.cost
+              << ", solve time " << result.solve_time << " s";
+    if (!result.filename.empty()) {
+      std::cout << ", saved to " << result.filename;
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace dairlib
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  return dairlib::DoMain();
+}
@@ -0,0 +1,49 @@
+#include "multibody/index_map.h"
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+using std::map;
+using std::string;
+using std::vector;
+
+namespace dairlib {
+namespace multibody {
+
+IndexMap::IndexMap(const map<string, int>& from_map,
+                   const map<string, int>& to_map)
+    : from_size_(from_map.size()), indices_(to_map.size(), -1) {
+  for (const auto& [name, to_index] : to_map) {
+    auto it = from_map.find(name);
+    DRAKE_DEMAND(it != from_map.end());
+    DRAKE_DEMAND(0 <= to_index && to_index < to_size());
+    indices_[to_index] = it->second;
+  }
+}
+
+IndexMap::IndexMap(const map<string, int>& from_map,
+                   const vector<string>& to_names)
+    : from_size_(from_map.size()) {
+  indices_.reserve(to_names.size());
+  for (const auto& name : to_names) {
+    auto it = from_map.find(name);
+    DRAKE_DEMAND(it != from_map.end());
+    indices_.push_back(it->second);
+  }
+}
+
+VectorXd IndexMap::Gather(const VectorXd& from) const {
+  VectorXd to(to_size());
+  Gather(from, &to);
+  return to;
+}
+
+MatrixXd IndexMap::ToMatrix() const {
+  MatrixXd S = MatrixXd::Zero(to_size(), from_size_);
+  for (int i = 0; i < to_size(); i++) {
+    S(i, indices_[i]) = 1;
+  }
+  return S;
+}
+
+}  // namespace multibody
+}  // namespace dairlib
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "drake/common/drake_assert.h"
+
+namespace dairlib {
+namespace multibody {
+
+/// IndexMap selects the coordinates of a vector by name, e.g. the positions of
+/// the plant without springs out of the positions of the plant with springs.
+/// It is equivalent to multiplying by a 0/1 selection matrix S, i.e.
+///   to = S * from     (Gather)
+///   from = S^T * to   (Scatter, on the selected coordinates only)
+/// but runs in O(n) and does not allocate memory.
+///
+/// The maps are built once from the name to index maps of
+/// makeNameToPositionsMap(), makeNameToVelocitiesMap(), etc.
+class IndexMap {
+ public:
+  IndexMap() = default;
+
+  /// Constructs the map such that to(to_map.at(name)) =
+  /// from(from_map.at(name)) for every name in `to_map`. Every name of
+  /// `to_map` must exist in `from_map`.
+  IndexMap(const std::map<std::string, int>& from_map,
+           const std::map<std::string, int>& to_map);
+
+  /// Constructs the map such that to(i) = from(from_map.at(to_names[i])).
+  /// Every name of `to_names` must exist in `from_map`.
+  IndexMap(const std::map<std::string, int>& from_map,
+           const std::vector<std::string>& to_names);
+
+  /// Sets the rows of `to` to the selected rows of `from`
+  /// (to = S * from). `to` must have to_size() rows.
+  template <typename DerivedFrom, typename DerivedTo>
+  void Gather(const Eigen::MatrixBase<DerivedFrom>& from,
+              Eigen::MatrixBase<DerivedTo>* to) const {
+    DRAKE_ASSERT(from.rows() == from_size_);
+    DRAKE_ASSERT(to->rows() == to_size());
+    for (int i = 0; i < to_size(); i++) {
+      to->row(i) = from.row(indices_[i]);
+    }
+  }
+
+  /// Writes the rows of `to` into the selected rows of `from`. The rows of
+  /// `from` which are not selected are left unchanged, so this is
+  /// from = S^T * to if `from` is zero beforehand.
+  template <typename DerivedTo, typename DerivedFrom>
+  void Scatter(const Eigen::MatrixBase<DerivedTo>& to,
+               Eigen::MatrixBase<DerivedFrom>* from) const {
+    DRAKE_ASSERT(to.rows() == to_size());
+    DRAKE_ASSERT(from->rows() == from_size_);
+    for (int i = 0; i < to_size(); i++) {
+      from->row(indices_[i]) = to.row(i);
+    }
+  }
+
+  /// Allocating version of Gather() for a vector
+  Eigen::VectorXd Gather(const Eigen::VectorXd& from) const;
+
+  /// The equivalent dense selection matrix S (to_size() x from_size())
+  Eigen::MatrixXd ToMatrix() const;
+
+  int from_size() const { return from_size_; }
+  int to_size() const { return indices_.size(); }
+
+  /// The index in `from` of every coordinate of `to`
+  const std::vector<int>& indices() const { return indices_; }
+
+ private:
+  int from_size_ = 0;
+  std::vector<int> indices_;
+};
+
+}  // namespace multibody
+}  // namespace dairlib
@@ -32,8 +32,8 @@ template <typename T>
 VectorX<T> DistanceEvaluator<T>::EvalFull(const Context<T>& context) const {
   // Transform points A and B to world frame
   const drake::multibody::Frame<T>& world = plant().world_frame();
-  static Vector3<T> pt_A_W;
-  static Vector3<T> pt_B_W;
+  Vector3<T> pt_A_W;
+  Vector3<T> pt_B_W;
 
   plant().CalcPointsPositions(context, frame_A_, pt_A_.template cast<T>(),
                               world, &pt_A_W);
@@ -51,12 +51,10 @@ void DistanceEvaluator<T>::EvalFullJacobian(
   /// Jacobian of ||pt_A - pt_B||, evaluated all in world frame, is
   ///   (pt_A - pt_B)^T * (J_A - J_B) / ||pt_A - pt_B||
 
-  // Create static Jacobians and point positions for re-use. Warning: not thread
-  // safe
-  static Matrix3X<T> J_A(3, plant().num_velocities());
-  static Matrix3X<T> J_B(3, plant().num_velocities());
-  static Vector3<T> pt_A_W;;
-  static Vector3<T> pt_B_W;
+  Matrix3X<T> J_A(3, plant().num_velocities());
+  Matrix3X<T> J_B(3, plant().num_velocities());
+  Vector3<T> pt_A_W;
+  Vector3<T> pt_B_W;
 
   const drake::multibody::Frame<T>& world = plant().world_frame();
 
@@ -86,10 +84,10 @@ VectorX<T> DistanceEvaluator<T>::EvalFullJacobianDotTimesV(
   //   - phidot * (pt_A - pt_B)^T (J_A - J_B) *v / phi^2
   const drake::multibody::Frame<T>& world = plant().world_frame();
 
-  static MatrixX<T> J_A(3, plant().num_velocities());
-  static MatrixX<T> J_B(3, plant().num_velocities());
-  static VectorX<T> pt_A_world(3);
-  static VectorX<T> pt_B_world(3);
+  MatrixX<T> J_A(3, plant().num_velocities());
+  MatrixX<T> J_B(3, plant().num_velocities());
+  VectorX<T> pt_A_world(3);
+  VectorX<T> pt_B_world(3);
 
   auto pt_A_cast = pt_A_.template cast<T>();
   auto pt_B_cast = pt_B_.template cast<T>();
@@ -134,6 +132,54 @@ VectorX<T> DistanceEvaluator<T>::EvalFullJacobianDotTimesV(
   return J_dot_times_v;
 }
 
+template <typename T>
+void DistanceEvaluator<T>::EvalFullJacobian(
+    const Context<T>& context, KinematicsCache<T>* cache,
+    drake::EigenPtr<MatrixX<T>> J) const {
+  const auto& pt_A_W = cache->EvalPointPosition(context, frame_A_, pt_A_);
+  const auto& pt_B_W = cache->EvalPointPosition(context, frame_B_, pt_B_);
+  const auto& J_A =
+      cache->EvalJacobianTranslationalVelocity(context, frame_A_, pt_A_);
+  const auto& J_B =
+      cache->EvalJacobianTranslationalVelocity(context, frame_B_, pt_B_);
+  Vector3<T> rel_pos = pt_A_W - pt_B_W;
+  // Two products instead of rel_pos^T * (J_A - J_B), which would allocate a
+  // temporary for J_A - J_B
+  J->noalias() = rel_pos.transpose() * J_A;
+  J->noalias() -= rel_pos.transpose() * J_B;
+  *J /= rel_pos.norm();
+}
+
+template <typename T>
+void DistanceEvaluator<T>::EvalFullJacobianDotTimesV(
+    const Context<T>& context, KinematicsCache<T>* cache,
+    drake::EigenPtr<VectorX<T>> JdotV) const {
+  // See EvalFullJacobianDotTimesV(context) for the derivation
+  const auto& pt_A_W = cache->EvalPointPosition(context, frame_A_, pt_A_);
+  const auto& pt_B_W = cache->EvalPointPosition(context, frame_B_, pt_B_);
+  const auto& J_A =
+      cache->EvalJacobianTranslationalVelocity(context, frame_A_, pt_A_);
+  const auto& J_B =
+      cache->EvalJacobianTranslationalVelocity(context, frame_B_, pt_B_);
+  const auto& J_A_dot_times_v =
+      cache->EvalBiasTranslationalAcceleration(context, frame_A_, pt_A_);
+  const auto& J_B_dot_times_v =
+      cache->EvalBiasTranslationalAcceleration(context, frame_B_, pt_B_);
+
+  Vector3<T> rel_pos = pt_A_W - pt_B_W;
+  const auto v = plant().GetVelocities(context);
+  Vector3<T> J_rel_v;
+  J_rel_v.noalias() = J_A * v;
+  J_rel_v.noalias() -= J_B * v;
+  Vector3<T> J_rel_dot_times_v = J_A_dot_times_v - J_B_dot_times_v;
+  T phi = rel_pos.norm();
+  T phidot = rel_pos.dot(J_rel_v) / phi;
+
+  (*JdotV)(0) = J_rel_v.squaredNorm() / phi +
+                rel_pos.dot(J_rel_dot_times_v) / phi -
+                phidot * rel_pos.dot(J_rel_v) / (phi * phi);
+}
+
 DRAKE_DEFINE_CLASS_TEMPLATE_INSTANTIATIONS_ON_DEFAULT_NONSYMBOLIC_SCALARS(
     class ::dairlib::multibody::DistanceEvaluator)
 
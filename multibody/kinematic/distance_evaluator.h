@@ -38,6 +38,14 @@ class DistanceEvaluator : public KinematicEvaluator<T> {
   drake::VectorX<T> EvalFullJacobianDotTimesV(
       const drake::systems::Context<T>& context) const override;
 
+  void EvalFullJacobian(const drake::systems::Context<T>& context,
+                        KinematicsCache<T>* cache,
+                        drake::EigenPtr<drake::MatrixX<T>> J) const override;
+
+  void EvalFullJacobianDotTimesV(
+      const drake::systems::Context<T>& context, KinematicsCache<T>* cache,
+      drake::EigenPtr<drake::VectorX<T>> JdotV) const override;
+
   using KinematicEvaluator<T>::EvalFullJacobian;
   using KinematicEvaluator<T>::plant;
 
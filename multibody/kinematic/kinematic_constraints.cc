@@ -1,10 +1,16 @@
 #include "multibody/kinematic/kinematic_constraints.h"
 #include "multibody/multibody_utils.h"
 
+#include <utility>
+#include <vector>
+
+#include "drake/math/autodiff_gradient.h"
+
 namespace dairlib {
 namespace multibody {
 
 using Eigen::VectorXd;
+using drake::math::DiscardGradient;
 using drake::multibody::MultibodyPlant;
 using drake::systems::Context;
 using drake::VectorX;
@@ -43,6 +49,46 @@ KinematicPositionConstraint<T>::KinematicPositionConstraint(
   } else {
     context_ = context;
   }
+
+  // Declare the structural nonzeros of the gradient. phi(q) is probed at two
+  // (fixed seed) random configurations: positions that are not on the
+  // kinematic path of an evaluator do not enter its computation, so perturbing
+  // them leaves the corresponding rows bitwise unchanged. See
+  // sparsity_pattern_test for a check against the AutoDiff gradient.
+  const int n_q = plant_.num_positions();
+  const int n_active = evaluators_.count_active();
+  std::vector<std::vector<bool>> depends(n_active,
+                                         std::vector<bool>(n_q, false));
+  auto probe_context = plant_.CreateDefaultContext();
+  for (int sample = 0; sample < 2; sample++) {
+    VectorX<T> q = RandomPositions(plant_, sample).cast<T>();
+    plant_.SetPositions(probe_context.get(), q);
+    const VectorXd phi =
+        DiscardGradient(evaluators_.EvalActive(*probe_context));
+    for (int j = 0; j < n_q; j++) {
+      q(j) += 1e-3;
+      plant_.SetPositions(probe_context.get(), q);
+      const VectorXd phi_j =
+          DiscardGradient(evaluators_.EvalActive(*probe_context));
+      for (int i = 0; i < n_active; i++) {
+        depends[i][j] = depends[i][j] || (phi_j(i) != phi(i));
+      }
+      q(j) -= 1e-3;
+    }
+  }
+
+  std::vector<std::pair<int, int>> nonzeros;
+  for (int i = 0; i < n_active; i++) {
+    for (int j = 0; j < n_q; j++) {
+      if (depends[i][j]) nonzeros.emplace_back(i, j);
+    }
+  }
+  // Each relative offset alpha(i) only enters its own row
+  int i = 0;
+  for (int row : full_constraint_relative_) {
+    nonzeros.emplace_back(row, n_q + i++);
+  }
+  this->SetGradientSparsity(nonzeros);
 }
 
 template <typename T>
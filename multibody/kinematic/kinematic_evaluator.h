@@ -1,5 +1,7 @@
 #pragma once
 
+#include "multibody/kinematic/kinematics_cache.h"
+
 #include "drake/multibody/plant/multibody_plant.h"
 #include "drake/solvers/constraint.h"
 #include "drake/systems/framework/context.h"
@@ -74,6 +76,26 @@ class KinematicEvaluator {
   virtual drake::VectorX<T> EvalFullJacobianDotTimesV(
       const drake::systems::Context<T>& context) const = 0;
 
+  /// Same as EvalFullJacobian(context, J), but reads the kinematics of the
+  /// underlying frames from `cache`, which must be valid for `context`. This
+  /// shares the computation with any other user of the same cache.
+  /// The default implementation does not use the cache.
+  virtual void EvalFullJacobian(const drake::systems::Context<T>& context,
+                                KinematicsCache<T>* cache,
+                                drake::EigenPtr<drake::MatrixX<T>> J) const {
+    EvalFullJacobian(context, J);
+  }
+
+  /// Same as EvalFullJacobianDotTimesV(context), but reads the kinematics of
+  /// the underlying frames from `cache` and writes the result into `JdotV`
+  /// (of size num_full()), so that no memory is allocated.
+  /// The default implementation does not use the cache.
+  virtual void EvalFullJacobianDotTimesV(
+      const drake::systems::Context<T>& context, KinematicsCache<T>* cache,
+      drake::EigenPtr<drake::VectorX<T>> JdotV) const {
+    *JdotV = EvalFullJacobianDotTimesV(context);
+  }
+
   void set_active_inds(std::vector<int> active_inds);
 
   const std::vector<int>& active_inds() const;
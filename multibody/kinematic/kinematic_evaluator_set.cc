@@ -148,6 +148,34 @@ VectorX<T> KinematicEvaluatorSet<T>::EvalFullJacobianDotTimesV(
   return Jdotv;
 }
 
+template <typename T>
+void KinematicEvaluatorSet<T>::EvalFullJacobian(
+    const Context<T>& context, KinematicsCache<T>* cache,
+    drake::EigenPtr<MatrixX<T>> J) const {
+  const int num_velocities = plant_.num_velocities();
+  DRAKE_THROW_UNLESS(J->rows() == count_full());
+  DRAKE_THROW_UNLESS(J->cols() == num_velocities);
+  int ind = 0;
+  for (const auto& e : evaluators_) {
+    auto J_i = J->block(ind, 0, e->num_full(), num_velocities);
+    e->EvalFullJacobian(context, cache, &J_i);
+    ind += e->num_full();
+  }
+}
+
+template <typename T>
+void KinematicEvaluatorSet<T>::EvalFullJacobianDotTimesV(
+    const Context<T>& context, KinematicsCache<T>* cache,
+    drake::EigenPtr<VectorX<T>> JdotV) const {
+  DRAKE_THROW_UNLESS(JdotV->rows() == count_full());
+  int ind = 0;
+  for (const auto& e : evaluators_) {
+    auto JdotV_i = JdotV->segment(ind, e->num_full());
+    e->EvalFullJacobianDotTimesV(context, cache, &JdotV_i);
+    ind += e->num_full();
+  }
+}
+
 template <typename T>
 int KinematicEvaluatorSet<T>::add_evaluator(KinematicEvaluator<T>* e) {
   // Compare plants for equality by reference
@@ -226,7 +254,7 @@ VectorX<T> KinematicEvaluatorSet<T>::CalcMassMatrixTimesVDot(
 template <typename T>
 VectorX<T> KinematicEvaluatorSet<T>::CalcTimeDerivativesWithForce(
     Context<T>* context, const VectorX<T>& lambda) const {
-  static MatrixX<T> J(count_full(), plant_.num_velocities());
+  MatrixX<T> J(count_full(), plant_.num_velocities());
   EvalFullJacobian(*context, &J);
   VectorX<T> J_transpose_lambda = J.transpose() * lambda;
 
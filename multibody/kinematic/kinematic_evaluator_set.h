@@ -71,6 +71,18 @@ class KinematicEvaluatorSet {
   drake::VectorX<T> EvalFullJacobianDotTimesV(
       const drake::systems::Context<T>& context) const;
 
+  /// Evaluates the Jacobian w.r.t. velocity v (not qdot), reading the frame
+  /// kinematics from `cache` (see KinematicEvaluator::EvalFullJacobian)
+  void EvalFullJacobian(const drake::systems::Context<T>& context,
+                        KinematicsCache<T>* cache,
+                        drake::EigenPtr<drake::MatrixX<T>> J) const;
+
+  /// Evaluates Jdot * v into `JdotV`, reading the frame kinematics from
+  /// `cache`
+  void EvalFullJacobianDotTimesV(const drake::systems::Context<T>& context,
+                                 KinematicsCache<T>* cache,
+                                 drake::EigenPtr<drake::VectorX<T>> JdotV) const;
+
   /// Determines the list of evaluators objects contained in the union with
   /// another set Specifically, `index` is in the returned vector if
   /// other.evaluators_.at(index) is an element of other.evaluators, as judged
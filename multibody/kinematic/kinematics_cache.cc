@@ -0,0 +1,174 @@
+#include "multibody/kinematic/kinematics_cache.h"
+
+#include "drake/common/default_scalars.h"
+
+using drake::MatrixX;
+using drake::Vector3;
+using drake::Vector6;
+using drake::multibody::Frame;
+using drake::multibody::JacobianWrtVariable;
+using drake::multibody::MultibodyPlant;
+using drake::systems::Context;
+using Eigen::Vector3d;
+
+namespace dairlib {
+namespace multibody {
+
+template <typename T>
+KinematicsCache<T>::KinematicsCache(const MultibodyPlant<T>& plant)
+    : plant_(plant) {}
+
+template <typename T>
+void KinematicsCache<T>::Clear() {
+  for (auto& entry : entries_) {
+    entry.position_valid = false;
+    entry.J_trans_valid = false;
+    entry.JdotV_trans_valid = false;
+    entry.J_spatial_valid = false;
+    entry.JdotV_spatial_valid = false;
+  }
+  com_position_valid_ = false;
+  com_J_valid_ = false;
+  com_JdotV_valid_ = false;
+}
+
+template <typename T>
+typename KinematicsCache<T>::PointEntry& KinematicsCache<T>::FindOrAddEntry(
+    const Frame<T>& frame_A, const Vector3d& pt_A) {
+  // The number of points is small, so a linear search is cheaper than hashing
+  for (auto& entry : entries_) {
+    if (entry.frame_index == frame_A.index() && entry.pt == pt_A) {
+      return entry;
+    }
+  }
+  entries_.emplace_back();
+  auto& entry = entries_.back();
+  entry.frame_index = frame_A.index();
+  entry.pt = pt_A;
+  entry.J_trans.resize(3, plant_.num_velocities());
+  entry.J_spatial.resize(6, plant_.num_velocities());
+  return entry;
+}
+
+template <typename T>
+const Vector3<T>& KinematicsCache<T>::EvalPointPosition(
+    const Context<T>& context, const Frame<T>& frame_A, const Vector3d& pt_A) {
+  auto& entry = FindOrAddEntry(frame_A, pt_A);
+  if (!entry.position_valid) {
+    plant_.CalcPointsPositions(context, frame_A, pt_A.template cast<T>(),
+                               plant_.world_frame(), &entry.position);
+    entry.position_valid = true;
+  }
+  return entry.position;
+}
+
+template <typename T>
+const MatrixX<T>& KinematicsCache<T>::EvalJacobianTranslationalVelocity(
+    const Context<T>& context, const Frame<T>& frame_A, const Vector3d& pt_A) {
+  auto& entry = FindOrAddEntry(frame_A, pt_A);
+  if (!entry.J_trans_valid) {
+    if (entry.J_spatial_valid) {
+      // The translational rows of the spatial Jacobian at the same point
+      entry.J_trans = entry.J_spatial.bottomRows(3);
+    } else {
+      const auto& world = plant_.world_frame();
+      plant_.CalcJacobianTranslationalVelocity(
+          context, JacobianWrtVariable::kV, frame_A, pt_A.template cast<T>(),
+          world, world, &entry.J_trans);
+    }
+    entry.J_trans_valid = true;
+  }
+  return entry.J_trans;
+}
+
+template <typename T>
+const Vector3<T>& KinematicsCache<T>::EvalBiasTranslationalAcceleration(
+    const Context<T>& context, const Frame<T>& frame_A, const Vector3d& pt_A) {
+  auto& entry = FindOrAddEntry(frame_A, pt_A);
+  if (!entry.JdotV_trans_valid) {
+    if (entry.JdotV_spatial_valid) {
+      entry.JdotV_trans = entry.JdotV_spatial.tail(3);
+    } else {
+      const auto& world = plant_.world_frame();
+      entry.JdotV_trans = plant_.CalcBiasTranslationalAcceleration(
+          context, JacobianWrtVariable::kV, frame_A, pt_A.template cast<T>(),
+          world, world);
+    }
+    entry.JdotV_trans_valid = true;
+  }
+  return entry.JdotV_trans;
+}
+
+template <typename T>
+const MatrixX<T>& KinematicsCache<T>::EvalJacobianSpatialVelocity(
+    const Context<T>& context, const Frame<T>& frame_A, const Vector3d& pt_A) {
+  auto& entry = FindOrAddEntry(frame_A, pt_A);
+  if (!entry.J_spatial_valid) {
+    const auto& world = plant_.world_frame();
+    plant_.CalcJacobianSpatialVelocity(context, JacobianWrtVariable::kV,
+                                       frame_A, pt_A.template cast<T>(), world,
+                                       world, &entry.J_spatial);
+    entry.J_spatial_valid = true;
+  }
+  return entry.J_spatial;
+}
+
+template <typename T>
+const Vector6<T>& KinematicsCache<T>::EvalBiasSpatialAcceleration(
+    const Context<T>& context, const Frame<T>& frame_A, const Vector3d& pt_A) {
+  auto& entry = FindOrAddEntry(frame_A, pt_A);
+  if (!entry.JdotV_spatial_valid) {
+    const auto& world = plant_.world_frame();
+    entry.JdotV_spatial =
+        plant_
+            .CalcBiasSpatialAcceleration(context, JacobianWrtVariable::kV,
+                                         frame_A, pt_A.template cast<T>(),
+                                         world, world)
+            .get_coeffs();
+    entry.JdotV_spatial_valid = true;
+  }
+  return entry.JdotV_spatial;
+}
+
+template <typename T>
+const Vector3<T>& KinematicsCache<T>::EvalCenterOfMassPosition(
+    const Context<T>& context) {
+  if (!com_position_valid_) {
+    com_position_ = plant_.CalcCenterOfMassPosition(context);
+    com_position_valid_ = true;
+  }
+  return com_position_;
+}
+
+template <typename T>
+const MatrixX<T>&
+KinematicsCache<T>::EvalJacobianCenterOfMassTranslationalVelocity(
+    const Context<T>& context) {
+  if (!com_J_valid_) {
+    const auto& world = plant_.world_frame();
+    com_J_.resize(3, plant_.num_velocities());
+    plant_.CalcJacobianCenterOfMassTranslationalVelocity(
+        context, JacobianWrtVariable::kV, world, world, &com_J_);
+    com_J_valid_ = true;
+  }
+  return com_J_;
+}
+
+template <typename T>
+const Vector3<T>&
+KinematicsCache<T>::EvalBiasCenterOfMassTranslationalAcceleration(
+    const Context<T>& context) {
+  if (!com_JdotV_valid_) {
+    const auto& world = plant_.world_frame();
+    com_JdotV_ = plant_.CalcBiasCenterOfMassTranslationalAcceleration(
+        context, JacobianWrtVariable::kV, world, world);
+    com_JdotV_valid_ = true;
+  }
+  return com_JdotV_;
+}
+
+DRAKE_DEFINE_CLASS_TEMPLATE_INSTANTIATIONS_ON_DEFAULT_NONSYMBOLIC_SCALARS(
+    class ::dairlib::multibody::KinematicsCache)
+
+}  // namespace multibody
+}  // namespace dairlib
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <deque>
+
+#include "drake/multibody/plant/multibody_plant.h"
+#include "drake/systems/framework/context.h"
+
+namespace dairlib {
+namespace multibody {
+
+/// KinematicsCache stores the kinematics of points fixed on frames of a
+/// MultibodyPlant, evaluated at one state. Users which need the kinematics of
+/// the same point (e.g. OSC tracking data, contact evaluators and holonomic
+/// constraints sharing a foot point) only pay for one computation per state.
+///
+/// Entries are keyed by (frame, point in the frame). All quantities are
+/// measured and expressed in the world frame, and all Jacobians are w.r.t.
+/// the generalized velocities v.
+///
+/// The cache does not observe the Context: Clear() must be called whenever
+/// the state in the Context changes, and a cache must only be used with one
+/// Context. Entries are only marked as invalid on Clear(), so memory is only
+/// allocated the first time a point is requested.
+template <typename T>
+class KinematicsCache {
+ public:
+  explicit KinematicsCache(const drake::multibody::MultibodyPlant<T>& plant);
+
+  /// Invalidates all entries
+  void Clear();
+
+  /// Position of pt_A (fixed in frame_A) in the world
+  const drake::Vector3<T>& EvalPointPosition(
+      const drake::systems::Context<T>& context,
+      const drake::multibody::Frame<T>& frame_A, const Eigen::Vector3d& pt_A);
+
+  /// Translational velocity Jacobian (3 x nv) of pt_A
+  const drake::MatrixX<T>& EvalJacobianTranslationalVelocity(
+      const drake::systems::Context<T>& context,
+      const drake::multibody::Frame<T>& frame_A, const Eigen::Vector3d& pt_A);
+
+  /// Translational Jdot * v of pt_A
+  const drake::Vector3<T>& EvalBiasTranslationalAcceleration(
+      const drake::systems::Context<T>& context,
+      const drake::multibody::Frame<T>& frame_A, const Eigen::Vector3d& pt_A);
+
+  /// Spatial velocity Jacobian (6 x nv, rotational rows first) of frame_A
+  /// shifted to pt_A
+  const drake::MatrixX<T>& EvalJacobianSpatialVelocity(
+      const drake::systems::Context<T>& context,
+      const drake::multibody::Frame<T>& frame_A, const Eigen::Vector3d& pt_A);
+
+  /// Spatial Jdot * v (rotational part first) of frame_A shifted to pt_A
+  const drake::Vector6<T>& EvalBiasSpatialAcceleration(
+      const drake::systems::Context<T>& context,
+      const drake::multibody::Frame<T>& frame_A, const Eigen::Vector3d& pt_A);
+
+  /// Center of mass position
+  const drake::Vector3<T>& EvalCenterOfMassPosition(
+      const drake::systems::Context<T>& context);
+
+  /// Center of mass translational velocity Jacobian (3 x nv)
+  const drake::MatrixX<T>& EvalJacobianCenterOfMassTranslationalVelocity(
+      const drake::systems::Context<T>& context);
+
+  /// Center of mass translational Jdot * v
+  const drake::Vector3<T>& EvalBiasCenterOfMassTranslationalAcceleration(
+      const drake::systems::Context<T>& context);
+
+  const drake::multibody::MultibodyPlant<T>& plant() const { return plant_; }
+
+ private:
+  struct PointEntry {
+    drake::multibody::FrameIndex frame_index;
+    Eigen::Vector3d pt;
+
+    bool position_valid = false;
+    bool J_trans_valid = false;
+    bool JdotV_trans_valid = false;
+    bool J_spatial_valid = false;
+    bool JdotV_spatial_valid = false;
+
+    drake::Vector3<T> position;
+    drake::MatrixX<T> J_trans;
+    drake::Vector3<T> JdotV_trans;
+    drake::MatrixX<T> J_spatial;
+    drake::Vector6<T> JdotV_spatial;
+  };
+
+  PointEntry& FindOrAddEntry(const drake::multibody::Frame<T>& frame_A,
+                             const Eigen::Vector3d& pt_A);
+
+  const drake::multibody::MultibodyPlant<T>& plant_;
+
+  // std::deque does not invalidate references to its elements on push_back,
+  // so references returned by the Eval methods stay valid.
+  std::deque<PointEntry> entries_;
+
+  bool com_position_valid_ = false;
+  bool com_J_valid_ = false;
+  bool com_JdotV_valid_ = false;
+  drake::Vector3<T> com_position_;
+  drake::MatrixX<T> com_J_;
+  drake::Vector3<T> com_JdotV_;
+};
+
+}  // namespace multibody
+}  // namespace dairlib
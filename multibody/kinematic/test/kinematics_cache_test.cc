@@ -0,0 +1,164 @@
+#include <memory>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/multibody/parsing/parser.h"
+#include "drake/multibody/plant/multibody_plant.h"
+
+#include "common/find_resource.h"
+#include "multibody/kinematic/kinematics_cache.h"
+
+namespace dairlib {
+namespace multibody {
+namespace {
+
+using drake::CompareMatrices;
+using drake::multibody::Frame;
+using drake::multibody::JacobianWrtVariable;
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using drake::systems::Context;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+
+/// Compares the quantities of KinematicsCache with direct MultibodyPlant
+/// calls, on the PlanarWalker
+class KinematicsCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    plant_ = std::make_unique<MultibodyPlant<double>>(0.0);
+    Parser parser(plant_.get());
+    parser.AddModelFromFile(
+        FindResourceOrThrow("examples/PlanarWalker/PlanarWalker.urdf"));
+    plant_->WeldFrames(plant_->world_frame(), plant_->GetFrameByName("base"),
+                       drake::math::RigidTransform<double>());
+    plant_->Finalize();
+    context_ = plant_->CreateDefaultContext();
+    SetState(0.3);
+  }
+
+  void SetState(double offset) {
+    const int n_x = plant_->num_positions() + plant_->num_velocities();
+    plant_->SetPositionsAndVelocities(
+        context_.get(), VectorXd::LinSpaced(n_x, -0.7, 0.8) +
+                            VectorXd::Constant(n_x, offset));
+  }
+
+  // Checks every point quantity of (frame, pt) and the center of mass against
+  // the plant at the current state
+  void ExpectMatchesPlant(KinematicsCache<double>* cache,
+                          const Frame<double>& frame, const Vector3d& pt) {
+    const auto& world = plant_->world_frame();
+    const int n_v = plant_->num_velocities();
+
+    Vector3d position;
+    plant_->CalcPointsPositions(*context_, frame, pt, world, &position);
+    EXPECT_TRUE(CompareMatrices(cache->EvalPointPosition(*context_, frame, pt),
+                                position, 1e-12));
+
+    MatrixXd J_spatial(6, n_v);
+    plant_->CalcJacobianSpatialVelocity(*context_, JacobianWrtVariable::kV,
+                                        frame, pt, world, world, &J_spatial);
+    EXPECT_TRUE(CompareMatrices(
+        cache->EvalJacobianSpatialVelocity(*context_, frame, pt), J_spatial,
+        1e-12));
+    MatrixXd J_trans(3, n_v);
+    plant_->CalcJacobianTranslationalVelocity(
+        *context_, JacobianWrtVariable::kV, frame, pt, world, world, &J_trans);
+    EXPECT_TRUE(CompareMatrices(
+        cache->EvalJacobianTranslationalVelocity(*context_, frame, pt),
+        J_trans, 1e-12));
+
+    const auto JdotV_spatial =
+        plant_
+            ->CalcBiasSpatialAcceleration(*context_, JacobianWrtVariable::kV,
+                                          frame, pt, world, world)
+            .get_coeffs();
+    EXPECT_TRUE(CompareMatrices(
+        cache->EvalBiasSpatialAcceleration(*context_, frame, pt),
+        JdotV_spatial, 1e-12));
+    const MatrixXd JdotV_trans = plant_->CalcBiasTranslationalAcceleration(
+        *context_, JacobianWrtVariable::kV, frame, pt, world, world);
+    EXPECT_TRUE(CompareMatrices(
+        cache->EvalBiasTranslationalAcceleration(*context_, frame, pt),
+        JdotV_trans, 1e-12));
+
+    EXPECT_TRUE(CompareMatrices(cache->EvalCenterOfMassPosition(*context_),
+                                plant_->CalcCenterOfMassPosition(*context_),
+                                1e-12));
+    MatrixXd J_com(3, n_v);
+    plant_->CalcJacobianCenterOfMassTranslationalVelocity(
+        *context_, JacobianWrtVariable::kV, world, world, &J_com);
+    EXPECT_TRUE(CompareMatrices(
+        cache->EvalJacobianCenterOfMassTranslationalVelocity(*context_), J_com,
+        1e-12));
+    EXPECT_TRUE(CompareMatrices(
+        cache->EvalBiasCenterOfMassTranslationalAcceleration(*context_),
+        plant_->CalcBiasCenterOfMassTranslationalAcceleration(
+            *context_, JacobianWrtVariable::kV, world, world),
+        1e-12));
+  }
+
+  std::unique_ptr<MultibodyPlant<double>> plant_;
+  std::unique_ptr<Context<double>> context_;
+};
+
+TEST_F(KinematicsCacheTest, MatchesPlant) {
+  KinematicsCache<double> cache(*plant_);
+  const auto& left = plant_->GetFrameByName("left_lower_leg");
+  const auto& right = plant_->GetFrameByName("right_lower_leg");
+  // The spatial quantities are evaluated first, so that the translational
+  // ones are taken from them. Two points on one frame are separate entries.
+  ExpectMatchesPlant(&cache, left, Vector3d(0, 0, -0.5));
+  ExpectMatchesPlant(&cache, left, Vector3d(0.1, 0, -0.2));
+  ExpectMatchesPlant(&cache, right, Vector3d(0, 0, -0.5));
+
+  // The translational quantities alone
+  KinematicsCache<double> translational_cache(*plant_);
+  const Vector3d pt(0, 0, -0.5);
+  MatrixXd J_trans(3, plant_->num_velocities());
+  plant_->CalcJacobianTranslationalVelocity(
+      *context_, JacobianWrtVariable::kV, left, pt, plant_->world_frame(),
+      plant_->world_frame(), &J_trans);
+  EXPECT_TRUE(CompareMatrices(
+      translational_cache.EvalJacobianTranslationalVelocity(*context_, left,
+                                                            pt),
+      J_trans, 1e-12));
+}
+
+TEST_F(KinematicsCacheTest, CachedUntilCleared) {
+  KinematicsCache<double> cache(*plant_);
+  const auto& frame = plant_->GetFrameByName("left_lower_leg");
+  const Vector3d pt(0, 0, -0.5);
+  const Vector3d position = cache.EvalPointPosition(*context_, frame, pt);
+  const MatrixXd J = cache.EvalJacobianTranslationalVelocity(*context_, frame,
+                                                             pt);
+  const Vector3d com = cache.EvalCenterOfMassPosition(*context_);
+
+  // Repeated evaluations return the stored entries
+  EXPECT_EQ(&cache.EvalPointPosition(*context_, frame, pt),
+            &cache.EvalPointPosition(*context_, frame, pt));
+
+  // The cache does not observe the context: entries are stale until Clear()
+  SetState(-0.4);
+  EXPECT_TRUE(
+      CompareMatrices(cache.EvalPointPosition(*context_, frame, pt), position));
+  EXPECT_TRUE(CompareMatrices(
+      cache.EvalJacobianTranslationalVelocity(*context_, frame, pt), J));
+  EXPECT_TRUE(CompareMatrices(cache.EvalCenterOfMassPosition(*context_), com));
+
+  // After Clear(), every quantity is recomputed at the new state, and the
+  // references returned before stay valid
+  const Vector3d* position_ref = &cache.EvalPointPosition(*context_, frame, pt);
+  cache.Clear();
+  EXPECT_FALSE(
+      CompareMatrices(cache.EvalPointPosition(*context_, frame, pt), position,
+                      1e-6));
+  EXPECT_EQ(&cache.EvalPointPosition(*context_, frame, pt), position_ref);
+  ExpectMatchesPlant(&cache, frame, pt);
+}
+
+}  // namespace
+}  // namespace multibody
+}  // namespace dairlib
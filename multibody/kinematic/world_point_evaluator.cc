@@ -86,6 +86,22 @@ VectorX<T> WorldPointEvaluator<T>::EvalFullJacobianDotTimesV(
   return rotation_ * Jdot_times_V;
 }
 
+template <typename T>
+void WorldPointEvaluator<T>::EvalFullJacobian(
+    const Context<T>& context, KinematicsCache<T>* cache,
+    drake::EigenPtr<MatrixX<T>> J) const {
+  J->noalias() = rotation_ * cache->EvalJacobianTranslationalVelocity(
+                                  context, frame_A_, pt_A_);
+}
+
+template <typename T>
+void WorldPointEvaluator<T>::EvalFullJacobianDotTimesV(
+    const Context<T>& context, KinematicsCache<T>* cache,
+    drake::EigenPtr<VectorX<T>> JdotV) const {
+  JdotV->noalias() = rotation_ * cache->EvalBiasTranslationalAcceleration(
+                                     context, frame_A_, pt_A_);
+}
+
 template <typename T>
 vector<shared_ptr<Constraint>>
 WorldPointEvaluator<T>::CreateConicFrictionConstraints() const {
@@ -61,6 +61,14 @@ class WorldPointEvaluator : public KinematicEvaluator<T> {
   drake::VectorX<T> EvalFullJacobianDotTimesV(
       const drake::systems::Context<T>& context) const override;
 
+  void EvalFullJacobian(const drake::systems::Context<T>& context,
+                        KinematicsCache<T>* cache,
+                        drake::EigenPtr<drake::MatrixX<T>> J) const override;
+
+  void EvalFullJacobianDotTimesV(
+      const drake::systems::Context<T>& context, KinematicsCache<T>* cache,
+      drake::EigenPtr<drake::VectorX<T>> JdotV) const override;
+
   using KinematicEvaluator<T>::EvalFullJacobian;
   using KinematicEvaluator<T>::plant;
 
@@ -1,5 +1,6 @@
 #include "multibody/multibody_utils.h"
 
+#include <random>
 #include <set>
 #include <vector>
 
@@ -386,12 +387,28 @@ bool isQuaternion(const MultibodyPlant<T>& plant) {
   return QuaternionStartIndex(plant) != -1;
 }
 
+template <typename T>
+VectorXd RandomPositions(const MultibodyPlant<T>& plant, unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  VectorXd q(plant.num_positions());
+  for (int i = 0; i < q.size(); i++) {
+    q(i) = distribution(generator);
+  }
+  for (int start : QuaternionStartIndices(plant)) {
+    q.segment(start, 4).normalize();
+  }
+  return q;
+}
+
 template int QuaternionStartIndex(const MultibodyPlant<double>& plant);  // NOLINT
 template int QuaternionStartIndex(const MultibodyPlant<AutoDiffXd>& plant);  // NOLINT
 template std::vector<int> QuaternionStartIndices(const MultibodyPlant<double>& plant);  // NOLINT
 template std::vector<int> QuaternionStartIndices(const MultibodyPlant<AutoDiffXd>& plant);  // NOLINT
 template bool isQuaternion(const MultibodyPlant<double>& plant);  // NOLINT
 template bool isQuaternion(const MultibodyPlant<AutoDiffXd>& plant);  // NOLINT
+template VectorXd RandomPositions(const MultibodyPlant<double>& plant, unsigned int seed);  // NOLINT
+template VectorXd RandomPositions(const MultibodyPlant<AutoDiffXd>& plant, unsigned int seed);  // NOLINT
 template map<string, int> makeNameToPositionsMap<double>(const MultibodyPlant<double>& plant);  // NOLINT
 template map<string, int> makeNameToPositionsMap<AutoDiffXd>(const MultibodyPlant<AutoDiffXd>& plant);  // NOLINT
 template map<string, int> makeNameToVelocitiesMap<double>(const MultibodyPlant<double>& plant);  // NOLINT
@@ -125,5 +125,13 @@ int QuaternionStartIndex(const drake::multibody::MultibodyPlant<T>& plant);
 template <typename T>
 bool isQuaternion(const drake::multibody::MultibodyPlant<T>& plant);
 
+/// Pseudo-random generalized positions, uniform in [-1, 1] with the
+/// quaternions of floating base joints normalized. Used to probe which
+/// entries of configuration dependent quantities are structurally zero.
+/// Deterministic for a given seed.
+template <typename T>
+Eigen::VectorXd RandomPositions(
+    const drake::multibody::MultibodyPlant<T>& plant, unsigned int seed);
+
 }  // namespace multibody
 }  // namespace dairlib
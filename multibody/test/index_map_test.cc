@@ -0,0 +1,88 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "multibody/index_map.h"
+
+namespace dairlib {
+namespace multibody {
+namespace {
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+using std::map;
+using std::string;
+
+class IndexMapTest : public ::testing::Test {
+ protected:
+  // "from" has two extra coordinates (spring_a, spring_b) and a different
+  // ordering than "to"
+  map<string, int> from_map_{{"x", 0},        {"spring_a", 1}, {"y", 2},
+                             {"spring_b", 3}, {"z", 4}};
+  map<string, int> to_map_{{"z", 0}, {"x", 1}, {"y", 2}};
+};
+
+TEST_F(IndexMapTest, GatherMatchesSelectionMatrix) {
+  IndexMap index_map(from_map_, to_map_);
+  EXPECT_EQ(index_map.from_size(), 5);
+  EXPECT_EQ(index_map.to_size(), 3);
+
+  VectorXd from(5);
+  from << 1, 2, 3, 4, 5;
+  VectorXd expected(3);
+  expected << 5, 1, 3;
+
+  VectorXd to(3);
+  index_map.Gather(from, &to);
+  EXPECT_TRUE(to.isApprox(expected));
+  EXPECT_TRUE(index_map.Gather(from).isApprox(expected));
+  EXPECT_TRUE((index_map.ToMatrix() * from).isApprox(expected));
+
+  // Gather into a segment, and gather the rows of a matrix
+  VectorXd x = VectorXd::Zero(6);
+  auto x_head = x.head(3);
+  index_map.Gather(from, &x_head);
+  EXPECT_TRUE(x.head(3).isApprox(expected));
+
+  MatrixXd from_mat(5, 2);
+  from_mat << from, 2 * from;
+  MatrixXd to_mat(3, 2);
+  index_map.Gather(from_mat, &to_mat);
+  EXPECT_TRUE(to_mat.isApprox(index_map.ToMatrix() * from_mat));
+}
+
+TEST_F(IndexMapTest, ScatterMatchesTransposedSelectionMatrix) {
+  IndexMap index_map(from_map_, to_map_);
+
+  VectorXd to(3);
+  to << 5, 1, 3;
+  VectorXd from = VectorXd::Zero(5);
+  index_map.Scatter(to, &from);
+  EXPECT_TRUE(from.isApprox(index_map.ToMatrix().transpose() * to));
+
+  // Unselected coordinates are left unchanged
+  VectorXd from_ones = VectorXd::Ones(5);
+  index_map.Scatter(to, &from_ones);
+  EXPECT_EQ(from_ones(1), 1);
+  EXPECT_EQ(from_ones(3), 1);
+}
+
+TEST_F(IndexMapTest, ConstructFromNames) {
+  IndexMap index_map(from_map_, std::vector<string>{"spring_b", "x"});
+  VectorXd from(5);
+  from << 1, 2, 3, 4, 5;
+  VectorXd expected(2);
+  expected << 4, 1;
+  EXPECT_TRUE(index_map.Gather(from).isApprox(expected));
+}
+
+}  // namespace
+}  // namespace multibody
+}  // namespace dairlib
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
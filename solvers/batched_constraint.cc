@@ -0,0 +1,341 @@
+#include "solvers/batched_constraint.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "drake/math/autodiff.h"
+#include "drake/math/autodiff_gradient.h"
+
+namespace dairlib {
+namespace solvers {
+
+using drake::AutoDiffVecXd;
+using drake::VectorX;
+using drake::solvers::Binding;
+using drake::solvers::Constraint;
+using drake::solvers::VectorXDecisionVariable;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+using std::vector;
+
+namespace {
+
+typedef vector<vector<Binding<Constraint>>> Chunks;
+
+// Union of the variables of all bindings, in order of first appearance
+VectorXDecisionVariable UniqueVariables(const Chunks& chunks) {
+  vector<drake::symbolic::Variable> variables;
+  std::unordered_map<drake::symbolic::Variable::Id, int> indices;
+  for (const auto& chunk : chunks) {
+    for (const auto& binding : chunk) {
+      for (int i = 0; i < binding.variables().size(); i++) {
+        const auto& var = binding.variables()(i);
+        if (indices.emplace(var.get_id(), variables.size()).second) {
+          variables.push_back(var);
+        }
+      }
+    }
+  }
+  VectorXDecisionVariable result(variables.size());
+  for (int i = 0; i < result.size(); i++) {
+    result(i) = variables[i];
+  }
+  return result;
+}
+
+int CountConstraints(const Chunks& chunks) {
+  int count = 0;
+  for (const auto& chunk : chunks) {
+    for (const auto& binding : chunk) {
+      count += binding.evaluator()->num_constraints();
+    }
+  }
+  return count;
+}
+
+VectorXd StackBounds(const Chunks& chunks, bool lower) {
+  VectorXd bounds(CountConstraints(chunks));
+  int row = 0;
+  for (const auto& chunk : chunks) {
+    for (const auto& binding : chunk) {
+      const auto& c = *binding.evaluator();
+      bounds.segment(row, c.num_constraints()) =
+          lower ? c.lower_bound() : c.upper_bound();
+      row += c.num_constraints();
+    }
+  }
+  return bounds;
+}
+
+}  // namespace
+
+// Threads evaluating the chunks 1, ..., num_workers (the calling thread
+// evaluates chunk 0), which wait for work between evaluations
+class BatchedConstraint::WorkerPool {
+ public:
+  explicit WorkerPool(int num_workers) : errors_(num_workers + 1) {
+    for (int k = 1; k <= num_workers; k++) {
+      threads_.emplace_back(&WorkerPool::Loop, this, k);
+    }
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  // Calls work(k) for k = 0, ..., num_workers, and rethrows the first
+  // exception, if any
+  void Run(const std::function<void(int)>& work) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::fill(errors_.begin(), errors_.end(), nullptr);
+      work_ = &work;
+      pending_ = threads_.size();
+      generation_++;
+    }
+    start_.notify_all();
+    try {
+      work(0);
+    } catch (...) {
+      errors_[0] = std::current_exception();
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_.wait(lock, [this]() { return pending_ == 0; });
+      work_ = nullptr;
+    }
+    for (const auto& error : errors_) {
+      if (error) std::rethrow_exception(error);
+    }
+  }
+
+ private:
+  void Loop(int k) {
+    int generation = 0;
+    while (true) {
+      const std::function<void(int)>* work;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_.wait(lock,
+                    [&]() { return stop_ || generation_ != generation; });
+        if (stop_) return;
+        generation = generation_;
+        work = work_;
+      }
+      try {
+        (*work)(k);
+      } catch (...) {
+        errors_[k] = std::current_exception();
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0) done_.notify_one();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const std::function<void(int)>* work_ = nullptr;
+  int generation_ = 0;
+  int pending_ = 0;
+  bool stop_ = false;
+  // One per chunk, each written by the thread of the chunk only
+  vector<std::exception_ptr> errors_;
+  vector<std::thread> threads_;
+};
+
+BatchedConstraint::BatchedConstraint(const Chunks& chunks,
+                                     const std::string& description)
+    : Constraint(CountConstraints(chunks), UniqueVariables(chunks).size(),
+                 StackBounds(chunks, true), StackBounds(chunks, false),
+                 description),
+      variables_(UniqueVariables(chunks)) {
+  std::unordered_map<drake::symbolic::Variable::Id, int> indices;
+  for (int i = 0; i < variables_.size(); i++) {
+    indices[variables_(i).get_id()] = i;
+  }
+
+  int row = 0;
+  for (const auto& chunk : chunks) {
+    if (chunk.empty()) continue;
+    chunks_.emplace_back();
+    for (const auto& binding : chunk) {
+      Element element;
+      element.constraint = binding.evaluator();
+      for (int i = 0; i < binding.variables().size(); i++) {
+        element.var_indices.push_back(
+            indices.at(binding.variables()(i).get_id()));
+      }
+      element.row_start = row;
+      row += element.constraint->num_constraints();
+      chunks_.back().push_back(element);
+    }
+  }
+
+  // Each constraint only depends on its own variables, and contributes its
+  // own sparsity pattern if it declares one (dense otherwise)
+  vector<std::pair<int, int>> nonzeros;
+  for (auto& chunk : chunks_) {
+    for (auto& element : chunk) {
+      const auto& pattern = element.constraint->gradient_sparsity_pattern();
+      if (pattern.has_value()) {
+        element.nonzeros = pattern.value();
+      } else {
+        for (int i = 0; i < element.constraint->num_constraints(); i++) {
+          for (int j = 0; j < static_cast<int>(element.var_indices.size());
+               j++) {
+            element.nonzeros.emplace_back(i, j);
+          }
+        }
+      }
+      for (const auto& [i, j] : element.nonzeros) {
+        nonzeros.emplace_back(element.row_start + i, element.var_indices[j]);
+      }
+    }
+  }
+  // A variable may appear twice in a binding
+  std::sort(nonzeros.begin(), nonzeros.end());
+  nonzeros.erase(std::unique(nonzeros.begin(), nonzeros.end()),
+                 nonzeros.end());
+
+  for (auto& chunk : chunks_) {
+    for (auto& element : chunk) {
+      for (const auto& [i, j] : element.nonzeros) {
+        const std::pair<int, int> nonzero(element.row_start + i,
+                                          element.var_indices[j]);
+        element.batch_nonzero_indices.push_back(
+            std::lower_bound(nonzeros.begin(), nonzeros.end(), nonzero) -
+            nonzeros.begin());
+      }
+    }
+  }
+  row_nonzero_start_.assign(num_constraints() + 1, 0);
+  for (const auto& [i, j] : nonzeros) {
+    row_nonzero_start_[i + 1]++;
+    nonzero_cols_.push_back(j);
+  }
+  for (int i = 0; i < num_constraints(); i++) {
+    row_nonzero_start_[i + 1] += row_nonzero_start_[i];
+  }
+  SetGradientSparsityPattern(nonzeros);
+}
+
+BatchedConstraint::~BatchedConstraint() = default;
+
+std::vector<std::shared_ptr<Constraint>> BatchedConstraint::constraints()
+    const {
+  std::vector<std::shared_ptr<Constraint>> constraints;
+  for (const auto& chunk : chunks_) {
+    for (const auto& element : chunk) {
+      constraints.push_back(element.constraint);
+    }
+  }
+  return constraints;
+}
+
+void BatchedConstraint::EvalChunk(int chunk, const VectorXd& x, VectorXd* y,
+                                  vector<double>* gradient) const {
+  VectorXd x_i, y_i;
+  for (const auto& element : chunks_[chunk]) {
+    const int n_x = element.var_indices.size();
+    const int n_y = element.constraint->num_constraints();
+    x_i.resize(n_x);
+    for (int j = 0; j < n_x; j++) {
+      x_i(j) = x(element.var_indices[j]);
+    }
+
+    if (gradient == nullptr) {
+      element.constraint->Eval(x_i, &y_i);
+    } else {
+      // The gradient w.r.t. the variables of this constraint only
+      AutoDiffVecXd y_i_ad;
+      element.constraint->Eval(drake::math::initializeAutoDiff(x_i), &y_i_ad);
+      y_i = drake::math::autoDiffToValueMatrix(y_i_ad);
+      for (unsigned int k = 0; k < element.nonzeros.size(); k++) {
+        const auto& [i, j] = element.nonzeros[k];
+        const auto& derivatives = y_i_ad(i).derivatives();
+        // += in case a variable appears twice in the binding. Entries with no
+        // derivatives are zero.
+        if (derivatives.size() > 0) {
+          (*gradient)[element.batch_nonzero_indices[k]] += derivatives(j);
+        }
+      }
+    }
+    y->segment(element.row_start, n_y) = y_i;
+  }
+}
+
+void BatchedConstraint::EvalChunks(const VectorXd& x, VectorXd* y,
+                                   vector<double>* gradient) const {
+  y->resize(num_constraints());
+  if (gradient) {
+    gradient->assign(nonzero_cols_.size(), 0);
+  }
+
+  std::lock_guard<std::mutex> lock(eval_mutex_);
+  if (num_chunks() <= 1) {
+    if (num_chunks() == 1) EvalChunk(0, x, y, gradient);
+    return;
+  }
+  if (pool_ == nullptr) {
+    pool_ = std::make_unique<WorkerPool>(num_chunks() - 1);
+  }
+  pool_->Run([&](int k) { EvalChunk(k, x, y, gradient); });
+}
+
+void BatchedConstraint::DoEval(const Eigen::Ref<const VectorXd>& x,
+                               VectorXd* y) const {
+  EvalChunks(x, y, nullptr);
+}
+
+void BatchedConstraint::DoEval(const Eigen::Ref<const AutoDiffVecXd>& x,
+                               AutoDiffVecXd* y) const {
+  const VectorXd x_val = drake::math::autoDiffToValueMatrix(x);
+  const MatrixXd original_grad = drake::math::autoDiffToGradientMatrix(x);
+  VectorXd y_val;
+  vector<double> gradient;
+  EvalChunks(x_val, &y_val, &gradient);
+
+  // As in NonlinearConstraint, skip the product with the (almost always
+  // identity) gradient of x. Only the nonzeros are visited either way.
+  const bool identity = original_grad.cols() == num_vars() &&
+                        original_grad.isIdentity(1e-16);
+  y->resize(num_constraints());
+  for (int i = 0; i < num_constraints(); i++) {
+    (*y)(i).value() = y_val(i);
+    auto& derivatives = (*y)(i).derivatives();
+    derivatives.setZero(identity ? num_vars() : original_grad.cols());
+    for (int k = row_nonzero_start_[i]; k < row_nonzero_start_[i + 1]; k++) {
+      if (identity) {
+        derivatives(nonzero_cols_[k]) = gradient[k];
+      } else {
+        derivatives +=
+            gradient[k] * original_grad.row(nonzero_cols_[k]).transpose();
+      }
+    }
+  }
+}
+
+void BatchedConstraint::DoEval(
+    const Eigen::Ref<const VectorX<drake::symbolic::Variable>>& x,
+    VectorX<drake::symbolic::Expression>* y) const {
+  throw std::logic_error(
+      "BatchedConstraint does not support symbolic evaluation.");
+}
+
+}  // namespace solvers
+}  // namespace dairlib
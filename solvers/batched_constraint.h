@@ -0,0 +1,102 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "drake/solvers/binding.h"
+#include "drake/solvers/constraint.h"
+
+namespace dairlib {
+namespace solvers {
+
+/// Groups several constraints into a single constraint, whose evaluation is
+/// split across threads. This is meant for expensive, independent constraints
+/// such as the collocation constraints of every knot of a trajectory
+/// optimization, which solvers otherwise evaluate one after the other.
+///
+/// The constraints are given in chunks. Each chunk is evaluated on its own
+/// thread, constraints of a chunk in order. Constraints of different chunks
+/// must therefore not share any mutable state (Contexts, caches...), while
+/// constraints of one chunk may. The threads are started at the first
+/// evaluation and kept until the constraint is destroyed; concurrent
+/// evaluations of one BatchedConstraint are serialized.
+///
+/// The variables of the batched constraint are the union of the variables of
+/// all constraints, see variables(). Gradients are evaluated constraint by
+/// constraint (each w.r.t. its own variables only), and only the entries of
+/// the declared sparsity pattern of each constraint are assembled into the
+/// gradient of the batch, whose sparsity pattern is declared accordingly.
+class BatchedConstraint : public drake::solvers::Constraint {
+ public:
+  /// @param chunks the constraints, with their variables, grouped in chunks
+  /// @param description (default blank)
+  explicit BatchedConstraint(
+      const std::vector<
+          std::vector<drake::solvers::Binding<drake::solvers::Constraint>>>&
+          chunks,
+      const std::string& description = "");
+
+  ~BatchedConstraint() override;
+
+  /// Variables to bind the batched constraint to
+  const drake::solvers::VectorXDecisionVariable& variables() const {
+    return variables_;
+  }
+
+  int num_chunks() const { return chunks_.size(); }
+
+  /// The constraints of all chunks, in order
+  std::vector<std::shared_ptr<drake::solvers::Constraint>> constraints() const;
+
+ protected:
+  void DoEval(const Eigen::Ref<const Eigen::VectorXd>& x,
+              Eigen::VectorXd* y) const override;
+
+  void DoEval(const Eigen::Ref<const drake::AutoDiffVecXd>& x,
+              drake::AutoDiffVecXd* y) const override;
+
+  void DoEval(
+      const Eigen::Ref<const drake::VectorX<drake::symbolic::Variable>>&,
+      drake::VectorX<drake::symbolic::Expression>*) const override;
+
+ private:
+  class WorkerPool;
+
+  struct Element {
+    std::shared_ptr<drake::solvers::Constraint> constraint;
+    // Indices of the variables of the constraint in variables_
+    std::vector<int> var_indices;
+    // First row of the constraint in the batch
+    int row_start;
+    // Nonzeros of the gradient of the constraint (w.r.t. its own variables),
+    // and the index of the nonzero of the batch each one is added to
+    std::vector<std::pair<int, int>> nonzeros;
+    std::vector<int> batch_nonzero_indices;
+  };
+
+  // Evaluates the constraints of chunk `chunk`. If gradient is not null, also
+  // adds the gradients to the nonzeros of the batch in the rows of the chunk.
+  void EvalChunk(int chunk, const Eigen::VectorXd& x, Eigen::VectorXd* y,
+                 std::vector<double>* gradient) const;
+
+  // Calls EvalChunk on every chunk, one thread per chunk. gradient (if not
+  // null) is resized to the number of nonzeros of the batch.
+  void EvalChunks(const Eigen::VectorXd& x, Eigen::VectorXd* y,
+                  std::vector<double>* gradient) const;
+
+  std::vector<std::vector<Element>> chunks_;
+  drake::solvers::VectorXDecisionVariable variables_;
+  // First nonzero of each row of the gradient sparsity pattern (which is
+  // sorted by row), and the column of each nonzero
+  std::vector<int> row_nonzero_start_;
+  std::vector<int> nonzero_cols_;
+
+  mutable std::mutex eval_mutex_;
+  mutable std::unique_ptr<WorkerPool> pool_;
+};
+
+}  // namespace solvers
+}  // namespace dairlib
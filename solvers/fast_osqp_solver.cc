@@ -0,0 +1,392 @@
+#include "solvers/fast_osqp_solver.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "drake/solvers/osqp_solver.h"
+
+using drake::solvers::Binding;
+using drake::solvers::MathematicalProgram;
+using drake::solvers::MathematicalProgramResult;
+using drake::solvers::OsqpSolver;
+using drake::solvers::SolutionResult;
+using drake::solvers::SolverOptions;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+using std::vector;
+
+namespace dairlib {
+namespace solvers {
+
+namespace {
+
+template <typename C>
+vector<vector<int>> FindIndices(const MathematicalProgram& prog,
+                                const vector<Binding<C>>& bindings) {
+  vector<vector<int>> indices;
+  for (const auto& binding : bindings) {
+    indices.push_back(prog.FindDecisionVariableIndices(binding.variables()));
+  }
+  return indices;
+}
+
+// Returns the position in the value array of `mat` of the (row, col) entry,
+// which must be part of the sparsity pattern
+int FindValueIndex(const Eigen::SparseMatrix<c_float, Eigen::ColMajor, c_int>&
+                       mat,
+                   c_int row, c_int col) {
+  const c_int* begin = mat.innerIndexPtr() + mat.outerIndexPtr()[col];
+  const c_int* end = mat.innerIndexPtr() + mat.outerIndexPtr()[col + 1];
+  const c_int* it = std::lower_bound(begin, end, row);
+  DRAKE_DEMAND(it != end && *it == row);
+  return it - mat.innerIndexPtr();
+}
+
+// Sets the values of `mat` from `triplets`. The first time (when `indices` is
+// empty), the sparsity pattern is built from the triplets and the position of
+// each triplet in the value array is stored in `indices`. Afterwards, the
+// values are written in place (duplicated entries are summed).
+void SetValuesFromTriplets(
+    const vector<Eigen::Triplet<c_float, c_int>>& triplets,
+    bool sparsity_pattern_set,
+    Eigen::SparseMatrix<c_float, Eigen::ColMajor, c_int>* mat,
+    vector<int>* indices) {
+  if (!sparsity_pattern_set) {
+    mat->setFromTriplets(triplets.begin(), triplets.end());
+    mat->makeCompressed();
+    indices->resize(triplets.size());
+    for (unsigned int k = 0; k < triplets.size(); k++) {
+      (*indices)[k] =
+          FindValueIndex(*mat, triplets[k].row(), triplets[k].col());
+    }
+  } else {
+    DRAKE_DEMAND(triplets.size() == indices->size());
+    Eigen::Map<Eigen::Matrix<c_float, Eigen::Dynamic, 1>>(mat->valuePtr(),
+                                                          mat->nonZeros())
+        .setZero();
+    for (unsigned int k = 0; k < triplets.size(); k++) {
+      mat->valuePtr()[(*indices)[k]] += triplets[k].value();
+    }
+  }
+}
+
+}  // namespace
+
+FastOsqpSolver::FastOsqpSolver(const MathematicalProgram& prog,
+                               const SolverOptions& solver_options)
+    : prog_(prog), solver_options_(solver_options) {
+  // Check the settings here rather than in the first solve
+  OSQPSettings settings;
+  SetSettings(&settings);
+}
+
+FastOsqpSolver::~FastOsqpSolver() { Reset(); }
+
+void FastOsqpSolver::Reset() {
+  if (workspace_ != nullptr) {
+    osqp_cleanup(workspace_);
+    workspace_ = nullptr;
+  }
+}
+
+void FastOsqpSolver::SetUpSparsityPattern() {
+  // Any other binding would be silently left out of the QP
+  const int num_supported_costs =
+      prog_.quadratic_costs().size() + prog_.linear_costs().size();
+  const int num_supported_constraints =
+      prog_.linear_constraints().size() +
+      prog_.linear_equality_constraints().size() +
+      prog_.bounding_box_constraints().size();
+  if (static_cast<int>(prog_.GetAllCosts().size()) != num_supported_costs ||
+      static_cast<int>(prog_.GetAllConstraints().size()) !=
+          num_supported_constraints) {
+    throw std::invalid_argument(
+        "FastOsqpSolver: only quadratic and linear costs, and linear, linear "
+        "equality and bounding box constraints are supported.");
+  }
+
+  n_x_ = prog_.num_vars();
+  quadratic_cost_indices_ = FindIndices(prog_, prog_.quadratic_costs());
+  linear_cost_indices_ = FindIndices(prog_, prog_.linear_costs());
+  linear_constraint_indices_ = FindIndices(prog_, prog_.linear_constraints());
+  linear_equality_constraint_indices_ =
+      FindIndices(prog_, prog_.linear_equality_constraints());
+  bounding_box_constraint_indices_ =
+      FindIndices(prog_, prog_.bounding_box_constraints());
+
+  n_constraint_ = 0;
+  for (const auto& binding : prog_.linear_constraints()) {
+    n_constraint_ += binding.evaluator()->num_constraints();
+  }
+  for (const auto& binding : prog_.linear_equality_constraints()) {
+    n_constraint_ += binding.evaluator()->num_constraints();
+  }
+  for (const auto& binding : prog_.bounding_box_constraints()) {
+    n_constraint_ += binding.evaluator()->num_constraints();
+  }
+
+  q_.resize(n_x_);
+  l_.resize(n_constraint_);
+  u_.resize(n_constraint_);
+  P_.resize(n_x_, n_x_);
+  A_.resize(n_constraint_, n_x_);
+  sparsity_pattern_set_ = false;
+  y_prev_ = VectorXd::Zero(n_constraint_);
+  x_sol_ = VectorXd::Zero(n_x_);
+}
+
+void FastOsqpSolver::UpdateCoefficients() {
+  // Every entry of every binding is added (including zeros), so that the
+  // sparsity pattern does not change between solves.
+  P_triplets_.clear();
+  q_.setZero();
+  for (unsigned int k = 0; k < prog_.quadratic_costs().size(); k++) {
+    const auto& cost = prog_.quadratic_costs()[k].evaluator();
+    const auto& ind = quadratic_cost_indices_[k];
+    for (unsigned int i = 0; i < ind.size(); i++) {
+      for (unsigned int j = 0; j < ind.size(); j++) {
+        // OSQP only reads the upper triangular part of P
+        if (ind[i] <= ind[j]) {
+          P_triplets_.emplace_back(ind[i], ind[j],
+                                   0.5 * (cost->Q()(i, j) + cost->Q()(j, i)));
+        }
+      }
+      q_(ind[i]) += cost->b()(i);
+    }
+  }
+  for (unsigned int k = 0; k < prog_.linear_costs().size(); k++) {
+    const auto& cost = prog_.linear_costs()[k].evaluator();
+    const auto& ind = linear_cost_indices_[k];
+    for (unsigned int i = 0; i < ind.size(); i++) {
+      q_(ind[i]) += cost->a()(i);
+    }
+  }
+  SetValuesFromTriplets(P_triplets_, sparsity_pattern_set_, &P_,
+                        &P_value_indices_);
+
+  A_triplets_.clear();
+  int row = 0;
+  for (unsigned int k = 0; k < prog_.linear_constraints().size(); k++) {
+    const auto& constraint = prog_.linear_constraints()[k].evaluator();
+    const auto& ind = linear_constraint_indices_[k];
+    const MatrixXd& A = constraint->A();
+    for (int i = 0; i < A.rows(); i++) {
+      for (unsigned int j = 0; j < ind.size(); j++) {
+        A_triplets_.emplace_back(row + i, ind[j], A(i, j));
+      }
+      l_(row + i) = constraint->lower_bound()(i);
+      u_(row + i) = constraint->upper_bound()(i);
+    }
+    row += A.rows();
+  }
+  for (unsigned int k = 0; k < prog_.linear_equality_constraints().size();
+       k++) {
+    const auto& constraint = prog_.linear_equality_constraints()[k].evaluator();
+    const auto& ind = linear_equality_constraint_indices_[k];
+    const MatrixXd& A = constraint->A();
+    for (int i = 0; i < A.rows(); i++) {
+      for (unsigned int j = 0; j < ind.size(); j++) {
+        A_triplets_.emplace_back(row + i, ind[j], A(i, j));
+      }
+      l_(row + i) = constraint->lower_bound()(i);
+      u_(row + i) = constraint->upper_bound()(i);
+    }
+    row += A.rows();
+  }
+  for (unsigned int k = 0; k < prog_.bounding_box_constraints().size(); k++) {
+    const auto& constraint = prog_.bounding_box_constraints()[k].evaluator();
+    const auto& ind = bounding_box_constraint_indices_[k];
+    for (unsigned int i = 0; i < ind.size(); i++) {
+      A_triplets_.emplace_back(row + i, ind[i], 1);
+      l_(row + i) = constraint->lower_bound()(i);
+      u_(row + i) = constraint->upper_bound()(i);
+    }
+    row += ind.size();
+  }
+  SetValuesFromTriplets(A_triplets_, sparsity_pattern_set_, &A_,
+                        &A_value_indices_);
+  sparsity_pattern_set_ = true;
+
+  // OSQP does not accept infinite bounds
+  l_ = l_.cwiseMax(-OSQP_INFTY);
+  u_ = u_.cwiseMin(OSQP_INFTY);
+}
+
+void FastOsqpSolver::SetSettings(OSQPSettings* settings) const {
+  osqp_set_default_settings(settings);
+  // Default to the same settings as drake::solvers::OsqpSolver
+  settings->verbose = 0;
+  settings->polish = 1;
+  settings->warm_start = 1;
+
+  std::map<std::string, c_float*> double_settings = {
+      {"rho", &settings->rho},
+      {"sigma", &settings->sigma},
+      {"eps_abs", &settings->eps_abs},
+      {"eps_rel", &settings->eps_rel},
+      {"eps_prim_inf", &settings->eps_prim_inf},
+      {"eps_dual_inf", &settings->eps_dual_inf},
+      {"alpha", &settings->alpha},
+      {"delta", &settings->delta}};
+#ifdef PROFILING
+  // OSQP only has (and enforces) a time limit when built with PROFILING
+  double_settings["time_limit"] = &settings->time_limit;
+#endif
+  const std::map<std::string, c_int*> int_settings = {
+      {"max_iter", &settings->max_iter},
+      {"polish", &settings->polish},
+      {"polish_refine_iter", &settings->polish_refine_iter},
+      {"verbose", &settings->verbose},
+      {"scaling", &settings->scaling},
+      {"adaptive_rho", &settings->adaptive_rho},
+      {"scaled_termination", &settings->scaled_termination},
+      {"check_termination", &settings->check_termination},
+      {"warm_start", &settings->warm_start}};
+
+  for (const auto& [name, value] :
+       solver_options_.GetOptionsDouble(OsqpSolver::id())) {
+    auto it = double_settings.find(name);
+    if (it == double_settings.end()) {
+      throw std::invalid_argument(
+          "FastOsqpSolver: unsupported OSQP setting " + name +
+          (name == "time_limit" ? " (OSQP is not built with PROFILING)" : ""));
+    }
+    *it->second = value;
+  }
+  for (const auto& [name, value] :
+       solver_options_.GetOptionsInt(OsqpSolver::id())) {
+    auto it = int_settings.find(name);
+    if (it == int_settings.end()) {
+      throw std::invalid_argument("FastOsqpSolver: unsupported OSQP setting " +
+                                  name);
+    }
+    *it->second = value;
+  }
+}
+
+void FastOsqpSolver::Solve(const VectorXd& initial_guess) {
+  if (workspace_ == nullptr) {
+    SetUpSparsityPattern();
+  }
+  DRAKE_DEMAND(initial_guess.size() == n_x_);
+  UpdateCoefficients();
+
+  if (workspace_ == nullptr) {
+    OSQPData data;
+    data.n = n_x_;
+    data.m = n_constraint_;
+    data.P = csc_matrix(P_.rows(), P_.cols(), P_.nonZeros(), P_.valuePtr(),
+                        P_.innerIndexPtr(), P_.outerIndexPtr());
+    data.q = q_.data();
+    data.A = csc_matrix(A_.rows(), A_.cols(), A_.nonZeros(), A_.valuePtr(),
+                        A_.innerIndexPtr(), A_.outerIndexPtr());
+    data.l = l_.data();
+    data.u = u_.data();
+
+    OSQPSettings settings;
+    SetSettings(&settings);
+
+    // osqp_setup copies the data, so the csc wrappers can be freed right after
+    const c_int setup_err = osqp_setup(&workspace_, &data, &settings);
+    c_free(data.P);
+    c_free(data.A);
+    if (setup_err != 0) {
+      workspace_ = nullptr;
+      throw std::runtime_error("FastOsqpSolver: osqp_setup failed.");
+    }
+  } else {
+    // Only the coefficients changed; the factorization is updated in place
+    osqp_update_P_A(workspace_, P_.valuePtr(), OSQP_NULL, P_.nonZeros(),
+                    A_.valuePtr(), OSQP_NULL, A_.nonZeros());
+    osqp_update_lin_cost(workspace_, q_.data());
+    osqp_update_bounds(workspace_, l_.data(), u_.data());
+  }
+
+  osqp_warm_start(workspace_, initial_guess.data(), y_prev_.data());
+  osqp_solve(workspace_);
+
+  num_iterations_ = workspace_->info->iter;
+  optimal_cost_ = workspace_->info->obj_val;
+  x_sol_ = Eigen::Map<const VectorXd>(workspace_->solution->x, n_x_);
+  y_prev_ = Eigen::Map<const VectorXd>(workspace_->solution->y, n_constraint_);
+
+  switch (workspace_->info->status_val) {
+    case OSQP_SOLVED:
+    case OSQP_SOLVED_INACCURATE:
+      solution_result_ = SolutionResult::kSolutionFound;
+      break;
+    case OSQP_PRIMAL_INFEASIBLE:
+    case OSQP_PRIMAL_INFEASIBLE_INACCURATE:
+      solution_result_ = SolutionResult::kInfeasibleConstraints;
+      break;
+    case OSQP_DUAL_INFEASIBLE:
+    case OSQP_DUAL_INFEASIBLE_INACCURATE:
+      solution_result_ = SolutionResult::kDualInfeasible;
+      break;
+    case OSQP_MAX_ITER_REACHED:
+    case OSQP_TIME_LIMIT_REACHED:
+      solution_result_ = SolutionResult::kIterationLimit;
+      break;
+    default:
+      solution_result_ = SolutionResult::kUnknownError;
+  }
+  if (solution_result_ != SolutionResult::kSolutionFound) {
+    // Don't warm start the next solve from a failed dual solution
+    y_prev_.setZero();
+  }
+}
+
+const VectorXd& FastOsqpSolver::SolveLeastSquares(double penalty,
+                                                  double regularization) {
+  DRAKE_DEMAND(sparsity_pattern_set_);
+
+  // Hessian of the cost (P only stores the upper triangular part)
+  H_ls_.setZero(n_x_, n_x_);
+  for (int col = 0; col < P_.outerSize(); col++) {
+    for (decltype(P_)::InnerIterator it(P_, col); it; ++it) {
+      H_ls_(it.row(), it.col()) += it.value();
+      if (it.row() != it.col()) {
+        H_ls_(it.col(), it.row()) += it.value();
+      }
+    }
+  }
+  H_ls_.diagonal().array() += regularization;
+  g_ls_ = q_;
+
+  // Penalty on the equality constraints
+  //   0.5*x^T*A^T*W*A*x - (A^T*W*l)^T*x + constant
+  // where W is `penalty` on the equality rows and zero elsewhere
+  A_ls_.setZero(n_constraint_, n_x_);
+  for (int col = 0; col < A_.outerSize(); col++) {
+    for (decltype(A_)::InnerIterator it(A_, col); it; ++it) {
+      A_ls_(it.row(), it.col()) = it.value();
+    }
+  }
+  w_ls_.resize(n_constraint_);
+  for (int i = 0; i < n_constraint_; i++) {
+    w_ls_(i) = (l_(i) == u_(i)) ? penalty : 0;
+  }
+  WA_ls_.noalias() = w_ls_.asDiagonal() * A_ls_;
+  H_ls_.noalias() += A_ls_.transpose() * WA_ls_;
+  g_ls_.noalias() -= WA_ls_.transpose() * l_;
+
+  llt_ls_.compute(H_ls_);
+  x_ls_ = -g_ls_;
+  llt_ls_.solveInPlace(x_ls_);
+  return x_ls_;
+}
+
+void FastOsqpSolver::Solve(const VectorXd& initial_guess,
+                           MathematicalProgramResult* result) {
+  Solve(initial_guess);
+  result->set_decision_variable_index(prog_.decision_variable_index());
+  result->set_solver_id(OsqpSolver::id());
+  result->set_solution_result(solution_result_);
+  result->set_x_val(x_sol_);
+  result->set_optimal_cost(optimal_cost_);
+}
+
+}  // namespace solvers
+}  // namespace dairlib
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <osqp.h>
+
+#include "drake/solvers/mathematical_program.h"
+#include "drake/solvers/mathematical_program_result.h"
+#include "drake/solvers/solver_options.h"
+
+namespace dairlib {
+namespace solvers {
+
+/// FastOsqpSolver solves a quadratic program with OSQP, keeping a single OSQP
+/// workspace alive across calls to Solve().
+///
+/// The intended use case is a QP that is solved repeatedly (e.g. once per
+/// control tick) where only the coefficients of the costs and constraints
+/// change, but not the set of bindings or the variables they act on. Each
+/// binding is treated as a dense block, so the sparsity pattern of the OSQP
+/// problem is fixed at the first call to Solve() and later calls only push
+/// the new coefficient values into the existing workspace (no re-allocation
+/// of the workspace and no re-selection of the solver).
+///
+/// Supported bindings are quadratic and linear costs, linear (equality)
+/// constraints and bounding box constraints; the first Solve() throws if the
+/// program has any other binding. Adding or removing bindings from the
+/// MathematicalProgram after the first Solve() is not supported.
+///
+/// The solver is warm-started with the user-provided primal guess and the
+/// dual solution of the previous solve.
+///
+/// After the first solve, Solve(initial_guess) does not allocate memory as
+/// long as OSQP solution polishing ("polish") is disabled.
+class FastOsqpSolver {
+ public:
+  /// @param prog the MathematicalProgram to be solved. The reference is kept,
+  ///   so `prog` must outlive this object.
+  /// @param solver_options OSQP settings, looked up by the OSQP setting names
+  ///   under drake::solvers::OsqpSolver::id() (e.g. "eps_abs", "max_iter").
+  ///   "time_limit" is only available when OSQP is built with PROFILING.
+  /// @throws std::invalid_argument if a setting is not supported
+  explicit FastOsqpSolver(
+      const drake::solvers::MathematicalProgram& prog,
+      const drake::solvers::SolverOptions& solver_options =
+          drake::solvers::SolverOptions());
+
+  ~FastOsqpSolver();
+
+  FastOsqpSolver(const FastOsqpSolver&) = delete;
+  FastOsqpSolver& operator=(const FastOsqpSolver&) = delete;
+
+  /// Reads the current coefficients from the MathematicalProgram, warm starts
+  /// OSQP from `initial_guess` and solves the QP.
+  /// @param initial_guess primal warm start, ordered as the decision variables
+  ///   of the program
+  /// @param result the solution, with solver id set to OsqpSolver::id()
+  /// @throws std::invalid_argument if the program has unsupported bindings
+  void Solve(const Eigen::VectorXd& initial_guess,
+             drake::solvers::MathematicalProgramResult* result);
+
+  /// Same as above, but only stores the solution in this object (see
+  /// primal_solution() and solution_result()), which avoids the memory
+  /// allocations of filling a MathematicalProgramResult.
+  void Solve(const Eigen::VectorXd& initial_guess);
+
+  /// Solves a regularized least-squares relaxation of the QP of the last
+  /// Solve(): the inequality constraints are dropped, and the equality
+  /// constraints (rows with l == u) are replaced by the penalty
+  ///   0.5 * penalty * |A_eq*x - b_eq|^2.
+  /// This is a single Cholesky solve, so it is much cheaper than Solve() and
+  /// always returns a solution, which makes it a fallback for when the QP
+  /// fails or runs out of time. Must be called after Solve().
+  /// @param penalty weight of the equality constraint violation
+  /// @param regularization added to the diagonal of the Hessian, so that the
+  ///   problem is strictly convex
+  /// @return the solution, ordered as the decision variables of the program
+  const Eigen::VectorXd& SolveLeastSquares(double penalty = 1e6,
+                                           double regularization = 1e-8);
+
+  /// Discards the OSQP workspace. The next call to Solve() sets up the
+  /// workspace from scratch.
+  void Reset();
+
+  /// Number of ADMM iterations taken by the last solve
+  int num_iterations() const { return num_iterations_; }
+
+  /// Primal solution of the last solve
+  const Eigen::VectorXd& primal_solution() const { return x_sol_; }
+
+  /// Status of the last solve
+  drake::solvers::SolutionResult solution_result() const {
+    return solution_result_;
+  }
+
+  /// Optimal cost of the last solve
+  double optimal_cost() const { return optimal_cost_; }
+
+ private:
+  void SetUpSparsityPattern();
+  void UpdateCoefficients();
+  void SetSettings(OSQPSettings* settings) const;
+
+  const drake::solvers::MathematicalProgram& prog_;
+  drake::solvers::SolverOptions solver_options_;
+
+  int n_x_ = 0;
+  int n_constraint_ = 0;
+
+  // Index of each binding's variables in the decision variable vector
+  std::vector<std::vector<int>> quadratic_cost_indices_;
+  std::vector<std::vector<int>> linear_cost_indices_;
+  std::vector<std::vector<int>> linear_constraint_indices_;
+  std::vector<std::vector<int>> linear_equality_constraint_indices_;
+  std::vector<std::vector<int>> bounding_box_constraint_indices_;
+
+  // QP data in OSQP format:
+  //   min 0.5 x^T P x + q^T x, s.t. l <= A x <= u
+  // P is upper triangular.
+  std::vector<Eigen::Triplet<c_float, c_int>> P_triplets_;
+  std::vector<Eigen::Triplet<c_float, c_int>> A_triplets_;
+  Eigen::SparseMatrix<c_float, Eigen::ColMajor, c_int> P_;
+  Eigen::SparseMatrix<c_float, Eigen::ColMajor, c_int> A_;
+  // Position of each triplet in the values of P_ and A_. The triplets are
+  // generated in the same order at every solve, so after the first solve the
+  // values are written in place instead of calling setFromTriplets(), which
+  // allocates.
+  bool sparsity_pattern_set_ = false;
+  std::vector<int> P_value_indices_;
+  std::vector<int> A_value_indices_;
+  Eigen::VectorXd q_;
+  Eigen::VectorXd l_;
+  Eigen::VectorXd u_;
+
+  // Dual solution of the previous solve, used for warm start
+  Eigen::VectorXd y_prev_;
+
+  // Buffers of SolveLeastSquares()
+  Eigen::MatrixXd H_ls_;
+  Eigen::VectorXd g_ls_;
+  Eigen::MatrixXd A_ls_;
+  Eigen::MatrixXd WA_ls_;
+  Eigen::VectorXd w_ls_;
+  Eigen::LLT<Eigen::MatrixXd> llt_ls_;
+  Eigen::VectorXd x_ls_;
+
+  OSQPWorkspace* workspace_ = nullptr;
+  int num_iterations_ = 0;
+  Eigen::VectorXd x_sol_;
+  drake::solvers::SolutionResult solution_result_ =
+      drake::solvers::SolutionResult::kUnknownError;
+  double optimal_cost_ = 0;
+};
+
+}  // namespace solvers
+}  // namespace dairlib
@@ -1,6 +1,9 @@
 #include "solvers/nonlinear_constraint.h"
 
+#include <chrono>
+
 #include "drake/common/default_scalars.h"
+#include "drake/common/drake_assert.h"
 #include "drake/math/autodiff.h"
 #include "drake/math/autodiff_gradient.h"
 
@@ -27,6 +30,97 @@ void NonlinearConstraint<T>::SetConstraintScaling(
   constraint_scaling_ = map;
 }
 
+template <typename T>
+void NonlinearConstraint<T>::SetFiniteDifferenceMethod(
+    FiniteDifferenceMethod method) {
+  finite_difference_method_ = method;
+}
+
+template <typename T>
+void NonlinearConstraint<T>::SetGradientSparsity(
+    const std::vector<std::pair<int, int>>& nonzeros) {
+  this->SetGradientSparsityPattern(nonzeros);
+
+  column_rows_.assign(num_vars(), {});
+  for (const auto& [row, col] : nonzeros) {
+    DRAKE_DEMAND(0 <= row && row < num_constraints());
+    DRAKE_DEMAND(0 <= col && col < num_vars());
+    column_rows_[col].push_back(row);
+  }
+
+  // Greedy coloring: each column joins the first group whose columns share
+  // no row with it. row_used[g][i] is true if a column of group g has a
+  // nonzero in row i.
+  column_groups_.clear();
+  std::vector<std::vector<bool>> row_used;
+  for (int col = 0; col < num_vars(); col++) {
+    int group = 0;
+    for (; group < static_cast<int>(column_groups_.size()); group++) {
+      bool independent = true;
+      for (int row : column_rows_[col]) {
+        if (row_used[group][row]) {
+          independent = false;
+          break;
+        }
+      }
+      if (independent) break;
+    }
+    if (group == static_cast<int>(column_groups_.size())) {
+      column_groups_.emplace_back();
+      row_used.emplace_back(num_constraints(), false);
+    }
+    column_groups_[group].push_back(col);
+    for (int row : column_rows_[col]) {
+      row_used[group][row] = true;
+    }
+  }
+}
+
+template <typename T>
+int NonlinearConstraint<T>::num_column_groups() const {
+  return column_groups_.empty() ? num_vars()
+                                : static_cast<int>(column_groups_.size());
+}
+
+template <typename T>
+void NonlinearConstraint<T>::EnableProfiling(bool enabled) {
+  profiling_enabled_ = enabled;
+  num_evaluations_ = 0;
+  num_gradient_evaluations_ = 0;
+  evaluation_ns_ = 0;
+  gradient_ns_ = 0;
+}
+
+template <typename T>
+EvaluationProfile NonlinearConstraint<T>::profile() const {
+  EvaluationProfile profile;
+  profile.num_evaluations = num_evaluations_;
+  profile.num_gradient_evaluations = num_gradient_evaluations_;
+  profile.evaluation_time = evaluation_ns_ * 1e-9;
+  profile.gradient_time = gradient_ns_ * 1e-9;
+  return profile;
+}
+
+template <typename T>
+int64_t NonlinearConstraint<T>::NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+template <typename T>
+void NonlinearConstraint<T>::RecordEvaluation(int64_t start,
+                                              bool gradient) const {
+  const int64_t elapsed = NowNs() - start;
+  if (gradient) {
+    num_gradient_evaluations_++;
+    gradient_ns_ += elapsed;
+  } else {
+    num_evaluations_++;
+    evaluation_ns_ += elapsed;
+  }
+}
+
 template <typename T>
 template <typename U>
 void NonlinearConstraint<T>::ScaleConstraint(VectorX<U>* y) const {
@@ -38,17 +132,21 @@ void NonlinearConstraint<T>::ScaleConstraint(VectorX<U>* y) const {
 template <>
 void NonlinearConstraint<double>::DoEval(
     const Eigen::Ref<const Eigen::VectorXd>& x, Eigen::VectorXd* y) const {
+  const int64_t start = profiling_enabled_ ? NowNs() : 0;
   EvaluateConstraint(x, y);
   this->ScaleConstraint<double>(y);
+  if (profiling_enabled_) RecordEvaluation(start, false);
 }
 
 template <>
 void NonlinearConstraint<AutoDiffXd>::DoEval(
     const Eigen::Ref<const Eigen::VectorXd>& x, Eigen::VectorXd* y) const {
+  const int64_t start = profiling_enabled_ ? NowNs() : 0;
   AutoDiffVecXd y_t;
   EvaluateConstraint(drake::math::initializeAutoDiff(x), &y_t);
   *y = drake::math::autoDiffToValueMatrix(y_t);
   this->ScaleConstraint<double>(y);
+  if (profiling_enabled_) RecordEvaluation(start, false);
 }
 
 template <typename T>
@@ -62,27 +160,75 @@ void NonlinearConstraint<T>::DoEval(
 template <>
 void NonlinearConstraint<AutoDiffXd>::DoEval(
     const Eigen::Ref<const AutoDiffVecXd>& x, AutoDiffVecXd* y) const {
+  const int64_t start = profiling_enabled_ ? NowNs() : 0;
   EvaluateConstraint(x, y);
   this->ScaleConstraint<AutoDiffXd>(y);
+  if (profiling_enabled_) RecordEvaluation(start, true);
+}
+
+template <>
+void NonlinearConstraint<double>::EvaluateConstraintAndGradient(
+    const Eigen::Ref<const VectorXd>& x, VectorXd* y, MatrixXd* dy) const {
+  VectorXd x_val = x;
+  VectorXd y_plus, y_minus;
+  EvaluateConstraint(x_val, y);
+
+  // Difference quotient of f along the perturbation of the columns `cols`
+  const bool central =
+      finite_difference_method_ == FiniteDifferenceMethod::kCentral;
+  auto difference = [&](const std::vector<int>& cols) -> VectorXd {
+    for (int col : cols) x_val(col) += eps_;
+    EvaluateConstraint(x_val, &y_plus);
+    if (central) {
+      for (int col : cols) x_val(col) -= 2 * eps_;
+      EvaluateConstraint(x_val, &y_minus);
+      for (int col : cols) x_val(col) += eps_;
+      return (y_plus - y_minus) / (2 * eps_);
+    }
+    for (int col : cols) x_val(col) -= eps_;
+    return (y_plus - *y) / eps_;
+  };
+
+  if (column_groups_.empty()) {
+    dy->resize(y->size(), x_val.size());
+    for (int i = 0; i < x_val.size(); i++) {
+      dy->col(i) = difference({i});
+    }
+    return;
+  }
+
+  // Columns of a group have disjoint nonzero rows, so each row of the
+  // difference belongs to (at most) one column of the group
+  dy->setZero(y->size(), x_val.size());
+  for (const auto& group : column_groups_) {
+    const VectorXd dy_group = difference(group);
+    for (int col : group) {
+      for (int row : column_rows_[col]) {
+        (*dy)(row, col) = dy_group(row);
+      }
+    }
+  }
+}
+
+template <>
+void NonlinearConstraint<AutoDiffXd>::EvaluateConstraintAndGradient(
+    const Eigen::Ref<const VectorXd>& x, VectorXd* y, MatrixXd* dy) const {
+  AutoDiffVecXd y_t;
+  EvaluateConstraint(drake::math::initializeAutoDiff(x), &y_t);
+  *y = drake::math::autoDiffToValueMatrix(y_t);
+  *dy = drake::math::autoDiffToGradientMatrix(y_t);
 }
 
 template <>
 void NonlinearConstraint<double>::DoEval(
     const Eigen::Ref<const AutoDiffVecXd>& x, AutoDiffVecXd* y) const {
+  const int64_t start = profiling_enabled_ ? NowNs() : 0;
   MatrixXd original_grad = drake::math::autoDiffToGradientMatrix(x);
 
-  // forward differencing
   VectorXd x_val = drake::math::autoDiffToValueMatrix(x);
-  VectorXd y0, yi;
-  EvaluateConstraint(x_val, &y0);
-
-  MatrixXd dy = MatrixXd(y0.size(), x_val.size());
-  for (int i = 0; i < x_val.size(); i++) {
-    x_val(i) += eps_;
-    EvaluateConstraint(x_val, &yi);
-    x_val(i) -= eps_;
-    dy.col(i) = (yi - y0) / eps_;
-  }
+  VectorXd y0;
+  MatrixXd dy;
+  EvaluateConstraintAndGradient(x_val, &y0, &dy);
 
   // Profiling identified dy * original_grad as a significant runtime event,
   // even though it is almost always the identity matrix.
@@ -94,6 +240,7 @@ void NonlinearConstraint<double>::DoEval(
   }
 
   this->ScaleConstraint<AutoDiffXd>(y);
+  if (profiling_enabled_) RecordEvaluation(start, true);
 }
 
 }  // namespace solvers
@@ -1,13 +1,37 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include "drake/common/symbolic.h"
 #include "drake/solvers/constraint.h"
 
 namespace dairlib {
 namespace solvers {
 
+/// Finite difference scheme of NonlinearConstraint<double>
+enum class FiniteDifferenceMethod {
+  /// (f(x + eps) - f(x)) / eps, one evaluation per perturbation
+  kForward,
+  /// (f(x + eps) - f(x - eps)) / (2 eps), two evaluations per perturbation
+  kCentral,
+};
+
+/// Number and duration of the evaluations of a NonlinearConstraint, see
+/// NonlinearConstraint::EnableProfiling
+struct EvaluationProfile {
+  /// Evaluations of the value only
+  int64_t num_evaluations = 0;
+  /// Evaluations of the value and gradient
+  int64_t num_gradient_evaluations = 0;
+  /// Total wall time of each kind of evaluation, in seconds
+  double evaluation_time = 0;
+  double gradient_time = 0;
+};
+
 /// Abstract class for nonlinear constraints that manages 
 /// manages evaluation of functions and numerical differentiation
 /// 
@@ -38,14 +62,64 @@ class NonlinearConstraint : public drake::solvers::Constraint {
 
   void SetConstraintScaling(const std::unordered_map<int, double>& map);
 
+  /// Sets the finite difference scheme used when T = double (default
+  /// kForward). Central differences are more accurate, and usually need a
+  /// larger eps (e.g. 1e-5), at twice the number of evaluations.
+  void SetFiniteDifferenceMethod(FiniteDifferenceMethod method);
+
+  /// Declares the structural nonzeros (row, column) of the gradient. The
+  /// pattern is forwarded to the solvers (see
+  /// EvaluatorBase::SetGradientSparsityPattern), and, when T = double,
+  /// structurally independent columns (no common nonzero row) are perturbed
+  /// together, with the groups given by a greedy Curtis-Powell-Reid coloring.
+  /// Entries outside the pattern are returned as zero.
+  void SetGradientSparsity(const std::vector<std::pair<int, int>>& nonzeros);
+
+  /// Number of groups of columns perturbed together by the finite
+  /// differences (num_vars() unless a sparsity pattern is set)
+  int num_column_groups() const;
+
+  /// If enabled (default false), counts and times the evaluations of the
+  /// constraint, see profile(). Enabling resets the profile. Evaluations may
+  /// be concurrent (e.g. in a solvers::BatchedConstraint), in which case the
+  /// times are summed over threads.
+  void EnableProfiling(bool enabled);
+
+  EvaluationProfile profile() const;
+
   virtual void EvaluateConstraint(const Eigen::Ref<const drake::VectorX<T>>& x,
                                   drake::VectorX<T>* y) const = 0;
 
+ protected:
+  /// Evaluates the (unscaled) constraint y and its gradient dy/dx. The default
+  /// implementation uses forward differences when T = double, and automatic
+  /// differentiation of EvaluateConstraint when T = AutoDiffXd. Subclasses
+  /// with analytic gradients can override it.
+  virtual void EvaluateConstraintAndGradient(
+      const Eigen::Ref<const Eigen::VectorXd>& x, Eigen::VectorXd* y,
+      Eigen::MatrixXd* dy) const;
+
  private:
   template <typename U>
   void ScaleConstraint(drake::VectorX<U>* y) const;
+  // Adds an evaluation started at `start` (in ns, see NowNs) to the profile
+  void RecordEvaluation(int64_t start, bool gradient) const;
+  static int64_t NowNs();
+
+  bool profiling_enabled_{false};
+  mutable std::atomic<int64_t> num_evaluations_{0};
+  mutable std::atomic<int64_t> num_gradient_evaluations_{0};
+  mutable std::atomic<int64_t> evaluation_ns_{0};
+  mutable std::atomic<int64_t> gradient_ns_{0};
+
   std::unordered_map<int, double> constraint_scaling_;
   double eps_;
+  FiniteDifferenceMethod finite_difference_method_{
+      FiniteDifferenceMethod::kForward};
+  // Columns perturbed together, and the nonzero rows of each column. Both
+  // are empty if no sparsity pattern is set (all columns are dense).
+  std::vector<std::vector<int>> column_groups_;
+  std::vector<std::vector<int>> column_rows_;
 };
 
 }  // namespace solvers
@@ -0,0 +1,190 @@
+#include "solvers/program_profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "drake/common/nice_type_name.h"
+
+#include "solvers/batched_constraint.h"
+
+namespace dairlib {
+namespace solvers {
+
+using drake::AutoDiffXd;
+using drake::solvers::Constraint;
+using drake::solvers::EvaluatorBase;
+using drake::solvers::MathematicalProgram;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Calls f on the evaluator of every constraint and cost of prog. The
+// constraints of a BatchedConstraint are visited instead of the batch.
+void ForEachEvaluator(
+    const MathematicalProgram& prog,
+    const std::function<void(const std::shared_ptr<EvaluatorBase>&, bool)>&
+        f) {
+  std::function<void(const std::shared_ptr<Constraint>&)> visit_constraint =
+      [&](const std::shared_ptr<Constraint>& constraint) {
+        auto batch = std::dynamic_pointer_cast<BatchedConstraint>(constraint);
+        if (batch) {
+          for (const auto& c : batch->constraints()) visit_constraint(c);
+        } else {
+          f(constraint, false);
+        }
+      };
+  for (const auto& binding : prog.GetAllConstraints()) {
+    visit_constraint(binding.evaluator());
+  }
+  for (const auto& binding : prog.GetAllCosts()) {
+    f(binding.evaluator(), true);
+  }
+}
+
+// Calls f on evaluator as a NonlinearConstraint, if it is one. Returns false
+// otherwise.
+template <typename F>
+bool AsNonlinearConstraint(const std::shared_ptr<EvaluatorBase>& evaluator,
+                           F f) {
+  if (auto c = std::dynamic_pointer_cast<NonlinearConstraint<double>>(
+          evaluator)) {
+    f(c.get());
+    return true;
+  }
+  if (auto c = std::dynamic_pointer_cast<NonlinearConstraint<AutoDiffXd>>(
+          evaluator)) {
+    f(c.get());
+    return true;
+  }
+  return false;
+}
+
+void SetProfiling(const MathematicalProgram& prog, bool enabled) {
+  ForEachEvaluator(prog, [enabled](const auto& evaluator, bool) {
+    AsNonlinearConstraint(evaluator,
+                          [enabled](auto c) { c->EnableProfiling(enabled); });
+  });
+}
+
+// Class name without namespaces or template arguments, e.g.
+// "DirconCollocationConstraint"
+string TypeName(const EvaluatorBase& evaluator) {
+  string name = drake::NiceTypeName::Get(evaluator);
+  name = name.substr(0, name.find('<'));
+  const size_t separator = name.rfind("::");
+  return separator == string::npos ? name : name.substr(separator + 2);
+}
+
+double TotalTime(const ProgramProfiler::Entry& entry) {
+  return entry.profile.evaluation_time + entry.profile.gradient_time;
+}
+
+}  // namespace
+
+ProgramProfiler::ProgramProfiler(const MathematicalProgram& prog)
+    : prog_(prog) {
+  SetProfiling(prog_, true);
+}
+
+ProgramProfiler::~ProgramProfiler() { SetProfiling(prog_, false); }
+
+void ProgramProfiler::Reset() { SetProfiling(prog_, true); }
+
+vector<ProgramProfiler::Entry> ProgramProfiler::Summarize() const {
+  std::map<std::pair<bool, string>, Entry> entries;
+  ForEachEvaluator(prog_, [&entries](const auto& evaluator, bool is_cost) {
+    const string type = TypeName(*evaluator);
+    Entry& entry = entries[{is_cost, type}];
+    entry.type = type;
+    entry.is_cost = is_cost;
+    entry.num_bindings++;
+    entry.num_rows += evaluator->num_outputs();
+    entry.profiled |= AsNonlinearConstraint(evaluator, [&entry](auto c) {
+      const EvaluationProfile profile = c->profile();
+      entry.profile.num_evaluations += profile.num_evaluations;
+      entry.profile.num_gradient_evaluations +=
+          profile.num_gradient_evaluations;
+      entry.profile.evaluation_time += profile.evaluation_time;
+      entry.profile.gradient_time += profile.gradient_time;
+    });
+  });
+
+  vector<Entry> summary;
+  for (const auto& type_entry : entries) {
+    summary.push_back(type_entry.second);
+  }
+  std::stable_sort(summary.begin(), summary.end(),
+                   [](const Entry& a, const Entry& b) {
+                     if (a.profiled != b.profiled) return a.profiled;
+                     return TotalTime(a) > TotalTime(b);
+                   });
+  return summary;
+}
+
+string ProgramProfiler::Report(double solve_time) const {
+  const vector<Entry> summary = Summarize();
+  std::ostringstream out;
+  out << std::left << std::setw(36) << "type" << std::right << std::setw(8)
+      << "count" << std::setw(8) << "rows" << std::setw(10) << "evals"
+      << std::setw(10) << "time (s)" << std::setw(10) << "grads"
+      << std::setw(10) << "time (s)";
+  if (solve_time > 0) out << std::setw(8) << "share";
+  out << std::endl;
+
+  double total_time = 0;
+  out << std::fixed;
+  for (const auto& entry : summary) {
+    out << std::left << std::setw(36)
+        << (entry.is_cost ? "cost: " : "") + entry.type << std::right
+        << std::setw(8) << entry.num_bindings << std::setw(8)
+        << entry.num_rows;
+    if (entry.profiled) {
+      out << std::setw(10) << entry.profile.num_evaluations << std::setw(10)
+          << std::setprecision(3) << entry.profile.evaluation_time
+          << std::setw(10) << entry.profile.num_gradient_evaluations
+          << std::setw(10) << entry.profile.gradient_time;
+      if (solve_time > 0) {
+        out << std::setw(7) << std::setprecision(1)
+            << 100 * TotalTime(entry) / solve_time << "%";
+      }
+      total_time += TotalTime(entry);
+    }
+    out << std::endl;
+  }
+  out << std::setprecision(3) << "Time in profiled constraints: "
+      << total_time << " s";
+  if (solve_time > 0) {
+    out << ", solve time: " << solve_time << " s";
+  }
+  out << " (constraints evaluated concurrently add up their times)"
+      << std::endl;
+  return out.str();
+}
+
+void ProgramProfiler::WriteCsv(const string& filename) const {
+  std::ofstream file(filename);
+  if (!file) {
+    throw std::runtime_error("ProgramProfiler: cannot write " + filename);
+  }
+  file << "type,is_cost,profiled,num_bindings,num_rows,num_evaluations,"
+          "evaluation_time,num_gradient_evaluations,gradient_time"
+       << std::endl;
+  for (const auto& entry : Summarize()) {
+    file << entry.type << "," << entry.is_cost << "," << entry.profiled
+         << "," << entry.num_bindings << "," << entry.num_rows << ","
+         << entry.profile.num_evaluations << ","
+         << entry.profile.evaluation_time << ","
+         << entry.profile.num_gradient_evaluations << ","
+         << entry.profile.gradient_time << std::endl;
+  }
+}
+
+}  // namespace solvers
+}  // namespace dairlib
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "drake/solvers/mathematical_program.h"
+
+#include "solvers/nonlinear_constraint.h"
+
+namespace dairlib {
+namespace solvers {
+
+/// Breaks down the time spent by a solver in the constraints of a
+/// MathematicalProgram, by type of constraint (e.g. for Dircon: collocation,
+/// acceleration, kinematic, impact, quaternion constraints).
+///
+/// Creating a ProgramProfiler enables the profiling of every
+/// NonlinearConstraint of the program, including those grouped in a
+/// BatchedConstraint (see NonlinearConstraint::EnableProfiling). After the
+/// solve, Summarize() and Report() aggregate the profiles by the class of the
+/// constraints. Other constraints and costs (linear constraints such as the
+/// friction cones, quadratic costs...) are listed with their number of rows,
+/// but are not timed: the solvers handle most of them without evaluating
+/// them. The time of the solve not spent in the constraints is spent in the
+/// solver itself (linear algebra, line search...) and in these costs.
+class ProgramProfiler {
+ public:
+  /// Profile of one type of constraint or cost
+  struct Entry {
+    /// Class of the constraint or cost, without namespaces or template
+    /// arguments
+    std::string type;
+    bool is_cost = false;
+    /// False if the evaluations of this type are not timed
+    bool profiled = false;
+    int num_bindings = 0;
+    int num_rows = 0;
+    EvaluationProfile profile;
+  };
+
+  /// Enables profiling on the constraints of prog, which must outlive the
+  /// profiler.
+  explicit ProgramProfiler(const drake::solvers::MathematicalProgram& prog);
+
+  /// Disables profiling on the constraints of the program
+  ~ProgramProfiler();
+
+  /// Resets the profiles, e.g. before another solve
+  void Reset();
+
+  /// One entry per type, profiled types first, by decreasing total time
+  std::vector<Entry> Summarize() const;
+
+  /// Table of Summarize(), with the share of solve_time (the wall time of the
+  /// solve) spent in each profiled type, if solve_time is positive
+  std::string Report(double solve_time = 0) const;
+
+  /// Writes Summarize() to a CSV file
+  /// @throws std::exception if the file cannot be written
+  void WriteCsv(const std::string& filename) const;
+
+ private:
+  const drake::solvers::MathematicalProgram& prog_;
+};
+
+}  // namespace solvers
+}  // namespace dairlib
@@ -0,0 +1,176 @@
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/math/autodiff.h"
+#include "drake/math/autodiff_gradient.h"
+#include "drake/solvers/mathematical_program.h"
+#include "solvers/batched_constraint.h"
+
+namespace dairlib {
+namespace solvers {
+namespace {
+
+using drake::CompareMatrices;
+using drake::solvers::Binding;
+using drake::solvers::Constraint;
+using drake::solvers::MathematicalProgram;
+using drake::solvers::QuadraticConstraint;
+using Eigen::Matrix2d;
+using Eigen::MatrixXd;
+using Eigen::Vector2d;
+using Eigen::VectorXd;
+
+class BatchedConstraintTest : public ::testing::Test {};
+
+// y = x^2, which throws for negative x
+class SquareConstraint : public Constraint {
+ public:
+  SquareConstraint() : Constraint(1, 1, VectorXd::Zero(1), VectorXd::Ones(1)) {
+    SetGradientSparsityPattern({{0, 0}});
+  }
+
+ protected:
+  template <typename T>
+  void DoEvalGeneric(const Eigen::Ref<const drake::VectorX<T>>& x,
+                     drake::VectorX<T>* y) const {
+    if (x(0) < 0) throw std::runtime_error("negative");
+    *y = x.cwiseProduct(x);
+  }
+
+  void DoEval(const Eigen::Ref<const VectorXd>& x,
+              VectorXd* y) const override {
+    DoEvalGeneric<double>(x, y);
+  }
+
+  void DoEval(const Eigen::Ref<const drake::AutoDiffVecXd>& x,
+              drake::AutoDiffVecXd* y) const override {
+    DoEvalGeneric<drake::AutoDiffXd>(x, y);
+  }
+
+  void DoEval(
+      const Eigen::Ref<const drake::VectorX<drake::symbolic::Variable>>&,
+      drake::VectorX<drake::symbolic::Expression>*) const override {
+    throw std::logic_error("not supported");
+  }
+};
+
+TEST_F(BatchedConstraintTest, MatchesIndividualConstraints) {
+  MathematicalProgram prog;
+  auto x = prog.NewContinuousVariables(3, "x");
+
+  // Three quadratic constraints on overlapping pairs of variables
+  std::vector<Binding<Constraint>> bindings;
+  for (int i = 0; i < 3; i++) {
+    Matrix2d Q;
+    Q << 2 + i, 1, 1, 3;
+    auto c = std::make_shared<QuadraticConstraint>(
+        Q, Vector2d(i, -1), -1 - i, 1 + i);
+    drake::solvers::VectorXDecisionVariable vars(2);
+    vars << x(i), x((i + 1) % 3);
+    bindings.emplace_back(c, vars);
+  }
+
+  BatchedConstraint batch({{bindings[0]}, {bindings[1], bindings[2]}},
+                          "batch");
+  EXPECT_EQ(batch.num_chunks(), 2);
+  EXPECT_EQ(batch.num_constraints(), 3);
+  ASSERT_EQ(batch.num_vars(), 3);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(batch.variables()(i).equal_to(x(i)));
+  }
+  EXPECT_TRUE(
+      CompareMatrices(batch.lower_bound(), Eigen::Vector3d(-1, -2, -3)));
+  EXPECT_TRUE(CompareMatrices(batch.upper_bound(), Eigen::Vector3d(1, 2, 3)));
+
+  VectorXd x_val(3);
+  x_val << 0.3, -0.7, 1.1;
+
+  // Values and gradients of the individual constraints
+  VectorXd y_expected(3);
+  MatrixXd dy_expected = MatrixXd::Zero(3, 3);
+  for (int i = 0; i < 3; i++) {
+    Vector2d x_i(x_val(i), x_val((i + 1) % 3));
+    drake::AutoDiffVecXd y_i;
+    bindings[i].evaluator()->Eval(drake::math::initializeAutoDiff(x_i), &y_i);
+    MatrixXd dy_i = drake::math::autoDiffToGradientMatrix(y_i);
+    y_expected(i) = y_i(0).value();
+    dy_expected(i, i) = dy_i(0, 0);
+    dy_expected(i, (i + 1) % 3) = dy_i(0, 1);
+  }
+
+  VectorXd y;
+  batch.Eval(x_val, &y);
+  EXPECT_TRUE(CompareMatrices(y, y_expected, 1e-12));
+
+  drake::AutoDiffVecXd y_ad;
+  batch.Eval(drake::math::initializeAutoDiff(x_val), &y_ad);
+  EXPECT_TRUE(CompareMatrices(drake::math::autoDiffToValueMatrix(y_ad),
+                              y_expected, 1e-12));
+  EXPECT_TRUE(CompareMatrices(drake::math::autoDiffToGradientMatrix(y_ad),
+                              dy_expected, 1e-12));
+}
+
+TEST_F(BatchedConstraintTest, SparsityPattern) {
+  MathematicalProgram prog;
+  auto x = prog.NewContinuousVariables(3, "x");
+
+  // Two dense constraints on x(0), x(1) and on x(2), x(2)
+  auto c = std::make_shared<QuadraticConstraint>(Matrix2d::Identity(),
+                                                 Vector2d::Zero(), 0, 1);
+  drake::solvers::VectorXDecisionVariable vars_0(2), vars_1(2);
+  vars_0 << x(0), x(1);
+  vars_1 << x(2), x(2);
+  BatchedConstraint batch({{Binding<Constraint>(c, vars_0)},
+                           {Binding<Constraint>(c, vars_1)}});
+
+  ASSERT_TRUE(batch.gradient_sparsity_pattern().has_value());
+  const std::vector<std::pair<int, int>> expected{{0, 0}, {0, 1}, {1, 2}};
+  EXPECT_EQ(batch.gradient_sparsity_pattern().value(), expected);
+}
+
+TEST_F(BatchedConstraintTest, RepeatedEvaluations) {
+  MathematicalProgram prog;
+  const int n = 6;
+  auto x = prog.NewContinuousVariables(n, "x");
+  auto c = std::make_shared<SquareConstraint>();
+  std::vector<std::vector<Binding<Constraint>>> chunks(n);
+  for (int i = 0; i < n; i++) {
+    chunks[i].emplace_back(c, x.segment<1>(i));
+  }
+  BatchedConstraint batch(chunks);
+  EXPECT_EQ(batch.num_chunks(), n);
+
+  // The worker threads are reused across evaluations
+  for (int k = 0; k < 20; k++) {
+    const VectorXd x_val = VectorXd::LinSpaced(n, 0, 1) * k;
+    VectorXd y;
+    batch.Eval(x_val, &y);
+    EXPECT_TRUE(CompareMatrices(y, x_val.cwiseProduct(x_val), 1e-12));
+
+    // Gradient w.r.t. other variables than x itself
+    const MatrixXd dx = MatrixXd::Ones(n, 2);
+    drake::AutoDiffVecXd y_ad;
+    batch.Eval(drake::math::initializeAutoDiffGivenGradientMatrix(x_val, dx),
+               &y_ad);
+    EXPECT_TRUE(CompareMatrices(drake::math::autoDiffToGradientMatrix(y_ad),
+                                (2 * x_val).asDiagonal() * dx, 1e-12));
+  }
+
+  // Exceptions of the worker threads are rethrown, and the workers are still
+  // usable afterwards
+  VectorXd y;
+  EXPECT_THROW(batch.Eval(-VectorXd::Ones(n), &y), std::runtime_error);
+  VectorXd x_val = VectorXd::Ones(n);
+  x_val(n - 1) = -1;
+  EXPECT_THROW(batch.Eval(x_val, &y), std::runtime_error);
+  batch.Eval(VectorXd::Ones(n), &y);
+  EXPECT_TRUE(CompareMatrices(y, VectorXd::Ones(n)));
+}
+
+}  // namespace
+}  // namespace solvers
+}  // namespace dairlib
@@ -0,0 +1,138 @@
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include <osqp.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/solvers/mathematical_program.h"
+#include "drake/solvers/osqp_solver.h"
+#include "solvers/fast_osqp_solver.h"
+
+namespace dairlib {
+namespace solvers {
+namespace {
+
+using drake::CompareMatrices;
+using drake::solvers::MathematicalProgram;
+using drake::solvers::OsqpSolver;
+using drake::solvers::SolutionResult;
+using drake::solvers::SolverOptions;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+
+// min 0.5*|x|^2 s.t. x0 + x1 == b, 1 <= x2 <= 2
+class FastOsqpSolverTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    x_ = prog_.NewContinuousVariables(3, "x");
+    prog_.AddQuadraticCost(MatrixXd::Identity(3, 3), VectorXd::Zero(3), x_);
+    equality_ = prog_.AddLinearEqualityConstraint(
+                         Eigen::RowVector2d(1, 1), VectorXd::Ones(1),
+                         x_.head<2>())
+                    .evaluator()
+                    .get();
+    prog_.AddBoundingBoxConstraint(1, 2, x_(2));
+
+    options_.SetOption(OsqpSolver::id(), "eps_abs", 1e-8);
+    options_.SetOption(OsqpSolver::id(), "eps_rel", 1e-8);
+  }
+
+  MathematicalProgram prog_;
+  drake::solvers::VectorXDecisionVariable x_;
+  drake::solvers::LinearEqualityConstraint* equality_;
+  SolverOptions options_;
+};
+
+TEST_F(FastOsqpSolverTest, SolvesAndResolvesWithUpdatedCoefficients) {
+  FastOsqpSolver solver(prog_, options_);
+  solver.Solve(VectorXd::Zero(3));
+  EXPECT_EQ(solver.solution_result(), SolutionResult::kSolutionFound);
+  EXPECT_TRUE(CompareMatrices(solver.primal_solution(), Vector3d(0.5, 0.5, 1),
+                              1e-6));
+
+  // Only the coefficients change; the workspace is reused
+  equality_->UpdateCoefficients(Eigen::RowVector2d(1, 1),
+                                2 * VectorXd::Ones(1));
+  drake::solvers::MathematicalProgramResult result;
+  solver.Solve(solver.primal_solution(), &result);
+  EXPECT_TRUE(result.is_success());
+  EXPECT_TRUE(CompareMatrices(result.GetSolution(x_), Vector3d(1, 1, 1), 1e-6));
+}
+
+TEST_F(FastOsqpSolverTest, IterationLimit) {
+  options_.SetOption(OsqpSolver::id(), "eps_abs", 1e-12);
+  options_.SetOption(OsqpSolver::id(), "eps_rel", 1e-12);
+  options_.SetOption(OsqpSolver::id(), "max_iter", 1);
+  FastOsqpSolver solver(prog_, options_);
+  solver.Solve(VectorXd::Zero(3));
+  EXPECT_EQ(solver.solution_result(), SolutionResult::kIterationLimit);
+  EXPECT_EQ(solver.num_iterations(), 1);
+}
+
+TEST_F(FastOsqpSolverTest, Infeasible) {
+  // Contradicts 1 <= x2
+  prog_.AddLinearConstraint(Eigen::RowVectorXd::Ones(1), VectorXd::Zero(1),
+                            VectorXd::Zero(1), x_.tail<1>());
+  FastOsqpSolver solver(prog_, options_);
+  solver.Solve(VectorXd::Zero(3));
+  EXPECT_EQ(solver.solution_result(), SolutionResult::kInfeasibleConstraints);
+}
+
+TEST_F(FastOsqpSolverTest, LeastSquaresAfterFailure) {
+  options_.SetOption(OsqpSolver::id(), "max_iter", 1);
+  FastOsqpSolver solver(prog_, options_);
+  solver.Solve(VectorXd::Zero(3));
+  ASSERT_NE(solver.solution_result(), SolutionResult::kSolutionFound);
+
+  // The equality row is penalized (with an error of order 1/penalty), the
+  // bounds on x2 are dropped
+  const VectorXd& x = solver.SolveLeastSquares(1e6);
+  EXPECT_NEAR(x(0) + x(1), 1, 1e-5);
+  EXPECT_NEAR(x(0), x(1), 1e-8);
+  EXPECT_NEAR(x(2), 0, 1e-8);
+
+  // The least-squares solution uses the current coefficients
+  equality_->UpdateCoefficients(Eigen::RowVector2d(1, -1), VectorXd::Ones(1));
+  solver.Solve(x);
+  const VectorXd& x_updated = solver.SolveLeastSquares(1e6);
+  EXPECT_NEAR(x_updated(0) - x_updated(1), 1, 1e-5);
+}
+
+TEST_F(FastOsqpSolverTest, UnsupportedBindings) {
+  MathematicalProgram with_cost;
+  auto y = with_cost.NewContinuousVariables(2, "y");
+  with_cost.AddQuadraticCost(MatrixXd::Identity(2, 2), VectorXd::Zero(2), y);
+  with_cost.AddCost(y(0) * y(0) * y(1));
+  FastOsqpSolver cost_solver(with_cost, options_);
+  EXPECT_THROW(cost_solver.Solve(VectorXd::Zero(2)), std::invalid_argument);
+
+  MathematicalProgram with_constraint;
+  auto z = with_constraint.NewContinuousVariables(3, "z");
+  with_constraint.AddQuadraticCost(MatrixXd::Identity(3, 3),
+                                   VectorXd::Zero(3), z);
+  with_constraint.AddLorentzConeConstraint(MatrixXd::Identity(3, 3),
+                                          VectorXd::Zero(3), z);
+  FastOsqpSolver constraint_solver(with_constraint, options_);
+  EXPECT_THROW(constraint_solver.Solve(VectorXd::Zero(3)),
+               std::invalid_argument);
+}
+
+TEST_F(FastOsqpSolverTest, Settings) {
+  SolverOptions unknown;
+  unknown.SetOption(OsqpSolver::id(), "not_an_osqp_setting", 1.0);
+  EXPECT_THROW({ FastOsqpSolver solver(prog_, unknown); },
+               std::invalid_argument);
+
+  SolverOptions time_limit;
+  time_limit.SetOption(OsqpSolver::id(), "time_limit", 1e-3);
+#ifdef PROFILING
+  EXPECT_NO_THROW({ FastOsqpSolver solver(prog_, time_limit); });
+#else
+  EXPECT_THROW({ FastOsqpSolver solver(prog_, time_limit); },
+               std::invalid_argument);
+#endif
+}
+
+}  // namespace
+}  // namespace solvers
+}  // namespace dairlib
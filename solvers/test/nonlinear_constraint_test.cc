@@ -0,0 +1,122 @@
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/math/autodiff.h"
+#include "drake/math/autodiff_gradient.h"
+#include "solvers/nonlinear_constraint.h"
+
+namespace dairlib {
+namespace solvers {
+namespace {
+
+using drake::AutoDiffVecXd;
+using drake::CompareMatrices;
+using drake::VectorX;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+/// Banded constraint y_i = sin(x_i) * x_{i+1}, which counts its evaluations
+class BandedConstraint : public NonlinearConstraint<double> {
+ public:
+  explicit BandedConstraint(int n)
+      : NonlinearConstraint<double>(n - 1, n, VectorXd::Zero(n - 1),
+                                    VectorXd::Zero(n - 1), "banded", 1e-6) {}
+
+  void EvaluateConstraint(const Eigen::Ref<const VectorXd>& x,
+                          VectorXd* y) const override {
+    num_evaluations_++;
+    y->resize(x.size() - 1);
+    for (int i = 0; i < y->size(); i++) {
+      (*y)(i) = std::sin(x(i)) * x(i + 1);
+    }
+  }
+
+  MatrixXd ExpectedGradient(const VectorXd& x) const {
+    MatrixXd dy = MatrixXd::Zero(x.size() - 1, x.size());
+    for (int i = 0; i < x.size() - 1; i++) {
+      dy(i, i) = std::cos(x(i)) * x(i + 1);
+      dy(i, i + 1) = std::sin(x(i));
+    }
+    return dy;
+  }
+
+  std::vector<std::pair<int, int>> Nonzeros(int n) const {
+    std::vector<std::pair<int, int>> nonzeros;
+    for (int i = 0; i < n - 1; i++) {
+      nonzeros.emplace_back(i, i);
+      nonzeros.emplace_back(i, i + 1);
+    }
+    return nonzeros;
+  }
+
+  mutable int num_evaluations_ = 0;
+};
+
+MatrixXd EvalGradient(const drake::solvers::Constraint& constraint,
+                      const VectorXd& x) {
+  AutoDiffVecXd y;
+  constraint.Eval(drake::math::initializeAutoDiff(x), &y);
+  return drake::math::autoDiffToGradientMatrix(y);
+}
+
+class NonlinearConstraintTest : public ::testing::Test {
+ protected:
+  const int n_ = 10;
+  const VectorXd x_ = VectorXd::LinSpaced(10, -1, 2);
+};
+
+TEST_F(NonlinearConstraintTest, ForwardDifferences) {
+  BandedConstraint constraint(n_);
+  MatrixXd dy = EvalGradient(constraint, x_);
+  EXPECT_TRUE(CompareMatrices(dy, constraint.ExpectedGradient(x_), 1e-5));
+  EXPECT_EQ(constraint.num_evaluations_, 1 + n_);
+}
+
+TEST_F(NonlinearConstraintTest, CentralDifferences) {
+  BandedConstraint constraint(n_);
+  constraint.SetFiniteDifferenceMethod(FiniteDifferenceMethod::kCentral);
+  MatrixXd dy = EvalGradient(constraint, x_);
+  EXPECT_TRUE(CompareMatrices(dy, constraint.ExpectedGradient(x_), 1e-9));
+  EXPECT_EQ(constraint.num_evaluations_, 1 + 2 * n_);
+}
+
+TEST_F(NonlinearConstraintTest, ColumnGrouping) {
+  BandedConstraint constraint(n_);
+  constraint.SetGradientSparsity(constraint.Nonzeros(n_));
+  constraint.SetFiniteDifferenceMethod(FiniteDifferenceMethod::kCentral);
+
+  // A bidiagonal pattern needs two colors
+  EXPECT_EQ(constraint.num_column_groups(), 2);
+  EXPECT_TRUE(constraint.gradient_sparsity_pattern().has_value());
+
+  MatrixXd dy = EvalGradient(constraint, x_);
+  EXPECT_TRUE(CompareMatrices(dy, constraint.ExpectedGradient(x_), 1e-9));
+  EXPECT_EQ(constraint.num_evaluations_, 1 + 2 * 2);
+}
+
+TEST_F(NonlinearConstraintTest, Profiling) {
+  BandedConstraint constraint(n_);
+  VectorXd y;
+  constraint.Eval(x_, &y);
+  EXPECT_EQ(constraint.profile().num_evaluations, 0);
+
+  constraint.EnableProfiling(true);
+  constraint.Eval(x_, &y);
+  constraint.Eval(x_, &y);
+  EvalGradient(constraint, x_);
+  EXPECT_EQ(constraint.profile().num_evaluations, 2);
+  EXPECT_EQ(constraint.profile().num_gradient_evaluations, 1);
+  EXPECT_GE(constraint.profile().gradient_time, 0);
+
+  // Enabling again resets the profile
+  constraint.EnableProfiling(true);
+  EXPECT_EQ(constraint.profile().num_evaluations, 0);
+  EXPECT_EQ(constraint.profile().num_gradient_evaluations, 0);
+}
+
+}  // namespace
+}  // namespace solvers
+}  // namespace dairlib
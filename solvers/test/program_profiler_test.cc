@@ -0,0 +1,64 @@
+#include <memory>
+#include <gtest/gtest.h>
+
+#include "drake/solvers/mathematical_program.h"
+#include "solvers/batched_constraint.h"
+#include "solvers/program_profiler.h"
+
+namespace dairlib {
+namespace solvers {
+namespace {
+
+using drake::solvers::Binding;
+using drake::solvers::Constraint;
+using drake::solvers::MathematicalProgram;
+using Eigen::VectorXd;
+
+/// y = x^2
+class SquareConstraint : public NonlinearConstraint<double> {
+ public:
+  SquareConstraint()
+      : NonlinearConstraint<double>(1, 1, VectorXd::Zero(1),
+                                    VectorXd::Ones(1)) {}
+
+  void EvaluateConstraint(const Eigen::Ref<const VectorXd>& x,
+                          VectorXd* y) const override {
+    *y = x.cwiseProduct(x);
+  }
+};
+
+TEST(ProgramProfilerTest, Summary) {
+  MathematicalProgram prog;
+  auto x = prog.NewContinuousVariables(3, "x");
+  auto square = std::make_shared<SquareConstraint>();
+  prog.AddConstraint(square, x.segment(0, 1));
+  // Constraints of a batch are profiled individually
+  auto batch = std::make_shared<BatchedConstraint>(
+      std::vector<std::vector<Binding<Constraint>>>{
+          {Binding<Constraint>(std::make_shared<SquareConstraint>(),
+                               x.segment(1, 1))},
+          {Binding<Constraint>(std::make_shared<SquareConstraint>(),
+                               x.segment(2, 1))}});
+  prog.AddConstraint(batch, batch->variables());
+  prog.AddLinearConstraint(x(0) + x(1) <= 1);
+  prog.AddQuadraticCost(x(0) * x(0));
+
+  ProgramProfiler profiler(prog);
+  for (const auto& binding : prog.GetAllConstraints()) {
+    prog.EvalBindingAtInitialGuess(binding);
+  }
+
+  const auto summary = profiler.Summarize();
+  ASSERT_EQ(summary.size(), 3u);
+  EXPECT_EQ(summary[0].type, "SquareConstraint");
+  EXPECT_TRUE(summary[0].profiled);
+  EXPECT_EQ(summary[0].num_bindings, 3);
+  EXPECT_EQ(summary[0].profile.num_evaluations, 3);
+  EXPECT_FALSE(summary[1].profiled);
+  EXPECT_FALSE(summary[2].profiled);
+  EXPECT_FALSE(profiler.Report(1).empty());
+}
+
+}  // namespace
+}  // namespace solvers
+}  // namespace dairlib
@@ -3,6 +3,7 @@
 #include "common/eigen_utils.h"
 #include "multibody/multibody_utils.h"
 #include "drake/common/text_logging.h"
+#include "drake/solvers/osqp_solver.h"
 
 using std::cout;
 using std::endl;
@@ -21,15 +22,12 @@ using drake::multibody::JointActuatorIndex;
 using drake::multibody::JointIndex;
 using drake::multibody::MultibodyPlant;
 using drake::solvers::MathematicalProgram;
-using drake::solvers::MathematicalProgramResult;
 using drake::solvers::SolutionResult;
 using drake::systems::BasicVector;
 using drake::systems::Context;
 using drake::trajectories::ExponentialPlusPiecewisePolynomial;
 using drake::trajectories::PiecewisePolynomial;
 
-using drake::solvers::Solve;
-
 namespace dairlib::systems::controllers {
 
 using multibody::makeNameToVelocitiesMap;
@@ -87,6 +85,9 @@ OperationalSpaceControl::OperationalSpaceControl(
   osc_debug_port_ = this->DeclareAbstractOutputPort(
                             &OperationalSpaceControl::AssignOscLcmOutput)
                         .get_index();
+  osc_timing_port_ = this->DeclareAbstractOutputPort(
+                             &OperationalSpaceControl::AssignOscTimingLcmOutput)
+                         .get_index();
 
   const std::map<string, int>& pos_map_w_spr =
       multibody::makeNameToPositionsMap(plant_w_spr);
@@ -98,32 +99,10 @@ OperationalSpaceControl::OperationalSpaceControl(
       multibody::makeNameToVelocitiesMap(plant_wo_spr);
 
   // Initialize the mapping from spring to no spring
-  map_position_from_spring_to_no_spring_ = MatrixXd::Zero(n_q_, n_q_w_spr);
-  map_velocity_from_spring_to_no_spring_ = MatrixXd::Zero(n_v_, n_v_w_spr);
-
-  for (auto pos_pair_wo_spr : pos_map_wo_spr) {
-    bool successfully_added = false;
-    for (auto pos_pair_w_spr : pos_map_w_spr) {
-      if (pos_pair_wo_spr.first == pos_pair_w_spr.first) {
-        map_position_from_spring_to_no_spring_(pos_pair_wo_spr.second,
-                                               pos_pair_w_spr.second) = 1;
-        successfully_added = true;
-      }
-    }
-    DRAKE_DEMAND(successfully_added);
-  }
-
-  for (auto vel_pair_wo_spr : vel_map_wo_spr) {
-    bool successfully_added = false;
-    for (auto vel_pair_w_spr : vel_map_w_spr) {
-      if (vel_pair_wo_spr.first == vel_pair_w_spr.first) {
-        map_velocity_from_spring_to_no_spring_(vel_pair_wo_spr.second,
-                                               vel_pair_w_spr.second) = 1;
-        successfully_added = true;
-      }
-    }
-    DRAKE_DEMAND(successfully_added);
-  }
+  map_position_from_spring_to_no_spring_ =
+      multibody::IndexMap(pos_map_w_spr, pos_map_wo_spr);
+  map_velocity_from_spring_to_no_spring_ =
+      multibody::IndexMap(vel_map_w_spr, vel_map_wo_spr);
 
   // Get input limits
   VectorXd u_min(n_u_);
@@ -240,7 +219,15 @@ void OperationalSpaceControl::Build() {
   // Checker
   CheckCostSettings();
   CheckConstraintSettings();
+
+  // Kinematics caches
+  kinematics_cache_w_spr_ =
+      std::make_unique<multibody::KinematicsCache<double>>(plant_w_spr_);
+  kinematics_cache_wo_spr_ =
+      std::make_unique<multibody::KinematicsCache<double>>(plant_wo_spr_);
   for (auto tracking_data : *tracking_data_vec_) {
+    tracking_data->SetKinematicsCaches(kinematics_cache_w_spr_.get(),
+                                       kinematics_cache_wo_spr_.get());
     tracking_data->CheckOscTrackingData();
   }
 
@@ -256,6 +243,34 @@ void OperationalSpaceControl::Build() {
     n_c_active_ += evaluator->num_active();
   }
 
+  // Split the rows of the manipulator equation into actuated and unactuated
+  // rows, to eliminate the inputs from the QP
+  actuated_rows_.clear();
+  unactuated_rows_.clear();
+  if (eliminate_inputs_) {
+    MatrixXd B = plant_wo_spr_.MakeActuationMatrix();
+    for (int i = 0; i < n_v_; i++) {
+      if (B.row(i).lpNorm<Eigen::Infinity>() > 0) {
+        actuated_rows_.push_back(i);
+      } else {
+        unactuated_rows_.push_back(i);
+      }
+    }
+    DRAKE_DEMAND(static_cast<int>(actuated_rows_.size()) == n_u_);
+    MatrixXd B_a(n_u_, n_u_);
+    for (int i = 0; i < n_u_; i++) {
+      B_a.row(i) = B.row(actuated_rows_[i]);
+    }
+    Eigen::FullPivLU<MatrixXd> lu(B_a);
+    DRAKE_DEMAND(lu.isInvertible());
+    B_a_inv_ = lu.inverse();
+  }
+  // Size of the inputs and of the dynamics constraint in the QP
+  const int n_u_qp = eliminate_inputs_ ? 0 : n_u_;
+  const int n_dyn = eliminate_inputs_ ? unactuated_rows_.size() : n_v_;
+  // Size of [dv; lambda_c; lambda_h]
+  const int n_z = n_v_ + n_c_ + n_h_;
+
   // Initialize solution
   dv_sol_ = std::make_unique<Eigen::VectorXd>(n_v_);
   u_sol_ = std::make_unique<Eigen::VectorXd>(n_u_);
@@ -270,7 +285,7 @@ void OperationalSpaceControl::Build() {
 
   // Add decision variables
   dv_ = prog_->NewContinuousVariables(n_v_, "dv");
-  u_ = prog_->NewContinuousVariables(n_u_, "u");
+  u_ = prog_->NewContinuousVariables(n_u_qp, "u");
   lambda_c_ = prog_->NewContinuousVariables(n_c_, "lambda_contact");
   lambda_h_ = prog_->NewContinuousVariables(n_h_, "lambda_holonomic");
   epsilon_ = prog_->NewContinuousVariables(n_c_active_, "epsilon");
@@ -278,9 +293,9 @@ void OperationalSpaceControl::Build() {
   // Add constraints
   // 1. Dynamics constraint
   dynamics_constraint_ =
-      prog_->AddLinearEqualityConstraint(
-               MatrixXd::Zero(n_v_, n_v_ + n_c_ + n_h_ + n_u_),
-               VectorXd::Zero(n_v_), {dv_, lambda_c_, lambda_h_, u_})
+      prog_->AddLinearEqualityConstraint(MatrixXd::Zero(n_dyn, n_z + n_u_qp),
+                                         VectorXd::Zero(n_dyn),
+                                         {dv_, lambda_c_, lambda_h_, u_})
            .evaluator()
            .get();
   // 2. Holonomic constraint
@@ -354,15 +369,31 @@ void OperationalSpaceControl::Build() {
   }
   // 5. Input constraint
   if (with_input_constraints_) {
-    prog_->AddLinearConstraint(MatrixXd::Identity(n_u_, n_u_), u_min_, u_max_,
-                               u_);
+    if (eliminate_inputs_) {
+      input_constraint_ =
+          prog_->AddLinearConstraint(MatrixXd::Zero(n_u_, n_z), u_min_, u_max_,
+                                     {dv_, lambda_c_, lambda_h_})
+              .evaluator()
+              .get();
+    } else {
+      prog_->AddLinearConstraint(MatrixXd::Identity(n_u_, n_u_), u_min_,
+                                 u_max_, u_);
+    }
   }
   // No joint position constraint in this implementation
 
   // Add costs
   // 1. input cost
   if (W_input_.size() > 0) {
-    prog_->AddQuadraticCost(W_input_, VectorXd::Zero(n_u_), u_);
+    if (eliminate_inputs_) {
+      input_cost_ = prog_->AddQuadraticCost(MatrixXd::Zero(n_z, n_z),
+                                            VectorXd::Zero(n_z),
+                                            {dv_, lambda_c_, lambda_h_})
+                        .evaluator()
+                        .get();
+    } else {
+      prog_->AddQuadraticCost(W_input_, VectorXd::Zero(n_u_), u_);
+    }
   }
   // 2. acceleration cost
   if (W_joint_accel_.size() > 0) {
@@ -375,12 +406,85 @@ void OperationalSpaceControl::Build() {
         VectorXd::Zero(n_c_active_), epsilon_);
   }
   // 4. Tracking cost
-  for (unsigned int i = 0; i < tracking_data_vec_->size(); i++) {
-    tracking_cost_.push_back(prog_->AddQuadraticCost(MatrixXd::Zero(n_v_, n_v_),
-                                                     VectorXd::Zero(n_v_), dv_)
-                                  .evaluator()
-                                  .get());
+  tracking_cost_ = prog_->AddQuadraticCost(MatrixXd::Zero(n_v_, n_v_),
+                                           VectorXd::Zero(n_v_), dv_)
+                       .evaluator()
+                       .get();
+
+  if (qp_time_budget_ > 0) {
+    solver_options_.SetOption(drake::solvers::OsqpSolver::id(), "time_limit",
+                              qp_time_budget_);
+  }
+  solver_ = std::make_unique<solvers::FastOsqpSolver>(*prog_, solver_options_);
+
+  // Allocate the buffers of the control loop
+  workspace_ = std::make_unique<OscWorkspace>();
+  auto& ws = *workspace_;
+  ws.x_w_spr.resize(plant_w_spr_.num_positions() +
+                    plant_w_spr_.num_velocities());
+  ws.x_wo_spr.resize(n_q_ + n_v_);
+  ws.B = plant_wo_spr_.MakeActuationMatrix();
+  ws.M.resize(n_v_, n_v_);
+  ws.bias.resize(n_v_);
+  ws.grav.resize(n_v_);
+  ws.J_h = MatrixXd::Zero(n_h_, n_v_);
+  ws.JdotV_h = VectorXd::Zero(n_h_);
+  ws.J_c = MatrixXd::Zero(n_c_, n_v_);
+  ws.JdotV_c_i = VectorXd::Zero(kSpaceDim);
+  ws.J_c_active = MatrixXd::Zero(n_c_active_, n_v_);
+  ws.JdotV_c_active = VectorXd::Zero(n_c_active_);
+  ws.A_dyn = MatrixXd::Zero(n_dyn, n_z + n_u_qp);
+  if (!eliminate_inputs_) {
+    ws.A_dyn.block(0, n_z, n_v_, n_u_) = -ws.B;
   }
+  ws.b_dyn.resize(n_dyn);
+  if (eliminate_inputs_) {
+    ws.D = MatrixXd::Zero(n_v_, n_z);
+    ws.D_a = MatrixXd::Zero(n_u_, n_z);
+    ws.bias_a = VectorXd::Zero(n_u_);
+    ws.A_u = MatrixXd::Zero(n_u_, n_z);
+    ws.b_u = VectorXd::Zero(n_u_);
+    ws.WA_u = MatrixXd::Zero(n_u_, n_z);
+    ws.Q_u = MatrixXd::Zero(n_z, n_z);
+    ws.b_Q_u = VectorXd::Zero(n_z);
+    ws.u_lb = VectorXd::Zero(n_u_);
+    ws.u_ub = VectorXd::Zero(n_u_);
+  }
+  ws.b_h.resize(n_h_);
+  if (w_soft_constraint_ <= 0) {
+    ws.A_c = MatrixXd::Zero(n_c_active_, n_v_);
+  } else {
+    ws.A_c = MatrixXd::Zero(n_c_active_, n_v_ + n_c_active_);
+    ws.A_c.block(0, n_v_, n_c_active_, n_c_active_) =
+        MatrixXd::Identity(n_c_active_, n_c_active_);
+  }
+  ws.b_c.resize(n_c_active_);
+  ws.zero_bound = VectorXd::Zero(1);
+  ws.neg_inf_bound =
+      VectorXd::Constant(1, -numeric_limits<double>::infinity());
+  ws.weighted_u.resize(n_u_);
+  ws.weighted_dv.resize(n_v_);
+  for (auto tracking_data : *tracking_data_vec_) {
+    ws.WJ.push_back(MatrixXd::Zero(tracking_data->GetYdotDim(), n_v_));
+    ws.tracking_error.push_back(VectorXd::Zero(tracking_data->GetYdotDim()));
+    ws.weighted_tracking_error.push_back(
+        VectorXd::Zero(tracking_data->GetYdotDim()));
+  }
+  ws.Q_tracking = MatrixXd::Zero(n_v_, n_v_);
+  ws.b_tracking = VectorXd::Zero(n_v_);
+  ws.tracking_active.assign(tracking_data_vec_->size(), false);
+  // The decision variables are stacked in the order they are created above
+  DRAKE_DEMAND(prog_->num_vars() == n_v_ + n_u_qp + n_c_ + n_h_ + n_c_active_);
+  ws.initial_guess = VectorXd::Zero(prog_->num_vars());
+
+  // Timing
+  vector<string> stage_names = {"spring_mapping", "dynamics",
+                                "constraint_jacobians", "cost_assembly",
+                                "solve", "solution_extraction", "total"};
+  for (auto tracking_data : *tracking_data_vec_) {
+    stage_names.push_back("tracking_data:" + tracking_data->GetName());
+  }
+  timing_stats_ = std::make_unique<OscTimingStats>(stage_names);
 }
 
 drake::systems::EventStatus OperationalSpaceControl::DiscreteVariableUpdate(
@@ -404,18 +508,21 @@ drake::systems::EventStatus OperationalSpaceControl::DiscreteVariableUpdate(
   return drake::systems::EventStatus::Succeeded();
 }
 
-VectorXd OperationalSpaceControl::SolveQp(
+const VectorXd& OperationalSpaceControl::SolveQp(
     const VectorXd& x_w_spr, const VectorXd& x_wo_spr,
     const drake::systems::Context<double>& context, double t, int fsm_state,
     double time_since_last_state_switch) const {
+  auto t_stage = OscTimingStats::Clock::now();
+  auto& ws = *workspace_;
+
   // Get active contact indices
-  std::set<int> active_contact_set = {};
+  const std::set<int>* active_contact_set = &no_active_contact_;
   if (single_contact_mode_) {
-    active_contact_set = contact_indices_map_.at(-1);
+    active_contact_set = &contact_indices_map_.at(-1);
   } else {
     auto map_iterator = contact_indices_map_.find(fsm_state);
     if (map_iterator != contact_indices_map_.end()) {
-      active_contact_set = map_iterator->second;
+      active_contact_set = &map_iterator->second;
     } else {
       static const drake::logging::Warn log_once(const_cast<char*>(
           (std::to_string(fsm_state) +
@@ -423,6 +530,9 @@ VectorXd OperationalSpaceControl::SolveQp(
               .c_str()));
     }
   }
+  auto is_active = [active_contact_set](int i) {
+    return active_contact_set->find(i) != active_contact_set->end();
+  };
 
   // Update context
   SetPositionsIfNew<double>(plant_w_spr_,
@@ -437,84 +547,110 @@ VectorXd OperationalSpaceControl::SolveQp(
   SetVelocitiesIfNew<double>(plant_wo_spr_,
                              x_wo_spr.tail(plant_wo_spr_.num_velocities()),
                              context_wo_spr_);
+  kinematics_cache_w_spr_->Clear();
+  kinematics_cache_wo_spr_->Clear();
 
   // Get M, f_cg, B matrices of the manipulator equation
-  MatrixXd B = plant_wo_spr_.MakeActuationMatrix();
-  MatrixXd M(n_v_, n_v_);
-  plant_wo_spr_.CalcMassMatrixViaInverseDynamics(*context_wo_spr_, &M);
-  VectorXd bias(n_v_);
-  plant_wo_spr_.CalcBiasTerm(*context_wo_spr_, &bias);
-  VectorXd grav = plant_wo_spr_.CalcGravityGeneralizedForces(*context_wo_spr_);
-  bias = bias - grav;
+  plant_wo_spr_.CalcMassMatrixViaInverseDynamics(*context_wo_spr_, &ws.M);
+  plant_wo_spr_.CalcBiasTerm(*context_wo_spr_, &ws.bias);
+  ws.grav = plant_wo_spr_.CalcGravityGeneralizedForces(*context_wo_spr_);
+  ws.bias -= ws.grav;
+  t_stage = timing_stats_->Toc(kDynamicsStage, t_stage);
 
   // Get J and JdotV for holonomic constraint
-  MatrixXd J_h(n_h_, n_v_);
-  VectorXd JdotV_h(n_h_);
   if (kinematic_evaluators_ != nullptr) {
-    J_h = kinematic_evaluators_->EvalFullJacobian(*context_wo_spr_);
-    JdotV_h =
-        kinematic_evaluators_->EvalFullJacobianDotTimesV(*context_wo_spr_);
+    kinematic_evaluators_->EvalFullJacobian(
+        *context_wo_spr_, kinematics_cache_wo_spr_.get(), &ws.J_h);
+    kinematic_evaluators_->EvalFullJacobianDotTimesV(
+        *context_wo_spr_, kinematics_cache_wo_spr_.get(), &ws.JdotV_h);
   }
 
   // Get J for external forces in equations of motion
-  MatrixXd J_c = MatrixXd::Zero(n_c_, n_v_);
+  ws.J_c.setZero();
   for (unsigned int i = 0; i < all_contacts_.size(); i++) {
-    if (active_contact_set.find(i) != active_contact_set.end()) {
-      J_c.block(kSpaceDim * i, 0, kSpaceDim, n_v_) =
-          all_contacts_[i]->EvalFullJacobian(*context_wo_spr_);
+    if (is_active(i)) {
+      auto J_c_i = ws.J_c.block(kSpaceDim * i, 0, kSpaceDim, n_v_);
+      all_contacts_[i]->EvalFullJacobian(
+          *context_wo_spr_, kinematics_cache_wo_spr_.get(), &J_c_i);
     }
   }
 
   // Get J and JdotV for contact constraint
-  MatrixXd J_c_active = MatrixXd::Zero(n_c_active_, n_v_);
-  VectorXd JdotV_c_active = VectorXd::Zero(n_c_active_);
+  ws.J_c_active.setZero();
+  ws.JdotV_c_active.setZero();
   int row_idx = 0;
   for (unsigned int i = 0; i < all_contacts_.size(); i++) {
     auto contact_i = all_contacts_[i];
-    if (active_contact_set.find(i) != active_contact_set.end()) {
+    if (is_active(i)) {
       // We don't call EvalActiveJacobian() because it'll repeat the computation
       // of the Jacobian. (J_c_active is just a stack of slices of J_c)
+      // Same for JdotV, which is read from the kinematics cache
+      contact_i->EvalFullJacobianDotTimesV(
+          *context_wo_spr_, kinematics_cache_wo_spr_.get(), &ws.JdotV_c_i);
       for (int j = 0; j < contact_i->num_active(); j++) {
-        J_c_active.row(row_idx + j) =
-            J_c.row(kSpaceDim * i + contact_i->active_inds().at(j));
+        ws.J_c_active.row(row_idx + j) =
+            ws.J_c.row(kSpaceDim * i + contact_i->active_inds().at(j));
+        ws.JdotV_c_active(row_idx + j) =
+            ws.JdotV_c_i(contact_i->active_inds().at(j));
       }
-      JdotV_c_active.segment(row_idx, contact_i->num_active()) =
-          contact_i->EvalActiveJacobianDotTimesV(*context_wo_spr_);
     }
     row_idx += contact_i->num_active();
   }
+  t_stage = timing_stats_->Toc(kConstraintJacobianStage, t_stage);
 
   // Update constraints
   // 1. Dynamics constraint
   ///    M*dv + bias == J_c^T*lambda_c + J_h^T*lambda_h + B*u
   /// -> M*dv - J_c^T*lambda_c - J_h^T*lambda_h - B*u == - bias
   /// -> [M, -J_c^T, -J_h^T, -B]*[dv, lambda_c, lambda_h, u]^T = - bias
-  MatrixXd A_dyn = MatrixXd::Zero(n_v_, n_v_ + n_c_ + n_h_ + n_u_);
-  A_dyn.block(0, 0, n_v_, n_v_) = M;
-  A_dyn.block(0, n_v_, n_v_, n_c_) = -J_c.transpose();
-  A_dyn.block(0, n_v_ + n_c_, n_v_, n_h_) = -J_h.transpose();
-  A_dyn.block(0, n_v_ + n_c_ + n_h_, n_v_, n_u_) = -B;
-  dynamics_constraint_->UpdateCoefficients(A_dyn, -bias);
+  /// (The -B block is constant and set in Build())
+  if (!eliminate_inputs_) {
+    ws.A_dyn.block(0, 0, n_v_, n_v_) = ws.M;
+    ws.A_dyn.block(0, n_v_, n_v_, n_c_) = -ws.J_c.transpose();
+    ws.A_dyn.block(0, n_v_ + n_c_, n_v_, n_h_) = -ws.J_h.transpose();
+    ws.b_dyn = -ws.bias;
+  } else {
+    /// With the inputs eliminated, z = [dv, lambda_c, lambda_h] and
+    ///    D*z + bias == B*u,  D = [M, -J_c^T, -J_h^T]
+    /// The unactuated rows are the dynamics constraint
+    /// -> D_ua*z == -bias_ua
+    /// and the actuated rows give the inputs
+    /// -> u = B_a^{-1}*(D_a*z + bias_a)
+    ws.D.block(0, 0, n_v_, n_v_) = ws.M;
+    ws.D.block(0, n_v_, n_v_, n_c_) = -ws.J_c.transpose();
+    ws.D.block(0, n_v_ + n_c_, n_v_, n_h_) = -ws.J_h.transpose();
+    for (unsigned int i = 0; i < unactuated_rows_.size(); i++) {
+      ws.A_dyn.row(i) = ws.D.row(unactuated_rows_[i]);
+      ws.b_dyn(i) = -ws.bias(unactuated_rows_[i]);
+    }
+    for (int i = 0; i < n_u_; i++) {
+      ws.D_a.row(i) = ws.D.row(actuated_rows_[i]);
+      ws.bias_a(i) = ws.bias(actuated_rows_[i]);
+    }
+    ws.A_u.noalias() = B_a_inv_ * ws.D_a;
+    ws.b_u.noalias() = B_a_inv_ * ws.bias_a;
+  }
+  dynamics_constraint_->UpdateCoefficients(ws.A_dyn, ws.b_dyn);
   // 2. Holonomic constraint
   ///    JdotV_h + J_h*dv == 0
   /// -> J_h*dv == -JdotV_h
-  holonomic_constraint_->UpdateCoefficients(J_h, -JdotV_h);
+  ws.b_h = -ws.JdotV_h;
+  holonomic_constraint_->UpdateCoefficients(ws.J_h, ws.b_h);
   // 3. Contact constraint
   if (!all_contacts_.empty()) {
+    ws.b_c = -ws.JdotV_c_active;
     if (w_soft_constraint_ <= 0) {
       ///    JdotV_c_active + J_c_active*dv == 0
       /// -> J_c_active*dv == -JdotV_c_active
-      contact_constraints_->UpdateCoefficients(J_c_active, -JdotV_c_active);
+      contact_constraints_->UpdateCoefficients(ws.J_c_active, ws.b_c);
     } else {
       // Relaxed version:
       ///    JdotV_c_active + J_c_active*dv == -epsilon
       /// -> J_c_active*dv + I*epsilon == -JdotV_c_active
       /// -> [J_c_active, I]* [dv, epsilon]^T == -JdotV_c_active
-      MatrixXd A_c = MatrixXd::Zero(n_c_active_, n_v_ + n_c_active_);
-      A_c.block(0, 0, n_c_active_, n_v_) = J_c_active;
-      A_c.block(0, n_v_, n_c_active_, n_c_active_) =
-          MatrixXd::Identity(n_c_active_, n_c_active_);
-      contact_constraints_->UpdateCoefficients(A_c, -JdotV_c_active);
+      /// (The identity block is constant and set in Build())
+      ws.A_c.block(0, 0, n_c_active_, n_v_) = ws.J_c_active;
+      contact_constraints_->UpdateCoefficients(ws.A_c, ws.b_c);
     }
   }
   // 4. Friction constraint (approximated firction cone)
@@ -530,43 +666,53 @@ VectorXd OperationalSpaceControl::SolveQp(
   ///     mu_*lambda_c(3*i+2) - lambda_c(3*i+1) >= 0
   ///     mu_*lambda_c(3*i+2) + lambda_c(3*i+1) >= 0
   ///                           lambda_c(3*i+2) >= 0
-  if (!all_contacts_.empty()) {
-    VectorXd inf_vectorxd(1);
-    inf_vectorxd << numeric_limits<double>::infinity();
-    for (unsigned int i = 0; i < all_contacts_.size(); i++) {
-      if (active_contact_set.find(i) != active_contact_set.end()) {
-        // when the contact is active
-        friction_constraints_.at(5 * i)->UpdateLowerBound(VectorXd::Zero(1));
-        friction_constraints_.at(5 * i + 1)->UpdateLowerBound(
-            VectorXd::Zero(1));
-        friction_constraints_.at(5 * i + 2)->UpdateLowerBound(
-            VectorXd::Zero(1));
-        friction_constraints_.at(5 * i + 3)->UpdateLowerBound(
-            VectorXd::Zero(1));
-        friction_constraints_.at(5 * i + 4)->UpdateLowerBound(
-            VectorXd::Zero(1));
-      } else {
-        // when the contact is not active
-        friction_constraints_.at(5 * i)->UpdateLowerBound(-inf_vectorxd);
-        friction_constraints_.at(5 * i + 1)->UpdateLowerBound(-inf_vectorxd);
-        friction_constraints_.at(5 * i + 2)->UpdateLowerBound(-inf_vectorxd);
-        friction_constraints_.at(5 * i + 3)->UpdateLowerBound(-inf_vectorxd);
-        friction_constraints_.at(5 * i + 4)->UpdateLowerBound(-inf_vectorxd);
-      }
+  for (unsigned int i = 0; i < all_contacts_.size(); i++) {
+    // The constraints are disabled when the contact is not active
+    const VectorXd& lower_bound =
+        is_active(i) ? ws.zero_bound : ws.neg_inf_bound;
+    for (int j = 0; j < 5; j++) {
+      friction_constraints_.at(5 * i + j)->UpdateLowerBound(lower_bound);
     }
   }
+  // 5. Input constraint (only changes when the inputs are eliminated)
+  ///    u_min <= A_u*z + b_u <= u_max
+  if (input_constraint_ != nullptr) {
+    ws.u_lb = u_min_ - ws.b_u;
+    ws.u_ub = u_max_ - ws.b_u;
+    input_constraint_->UpdateCoefficients(ws.A_u, ws.u_lb, ws.u_ub);
+  }
 
   // Update costs
+  // 1. Input cost (only changes when the inputs are eliminated)
+  ///    0.5*u^T*W*u = 0.5*z^T*A_u^T*W*A_u*z + (A_u^T*W*b_u)^T*z + constant
+  if (input_cost_ != nullptr) {
+    ws.WA_u.noalias() = W_input_ * ws.A_u;
+    ws.Q_u.noalias() = ws.A_u.transpose() * ws.WA_u;
+    ws.b_Q_u.noalias() = ws.WA_u.transpose() * ws.b_u;
+    input_cost_->UpdateCoefficients(ws.Q_u, ws.b_Q_u);
+  }
   // 4. Tracking cost
+  ws.Q_tracking.setZero();
+  ws.b_tracking.setZero();
   for (unsigned int i = 0; i < tracking_data_vec_->size(); i++) {
     auto tracking_data = tracking_data_vec_->at(i);
+    t_stage = timing_stats_->Toc(kCostAssemblyStage, t_stage);
+
+    // The activity is checked first, so that the desired trajectory and the
+    // kinematics are only evaluated for the active tracking data
+    ws.tracking_active[i] =
+        tracking_data->UpdateTrackingFlag(fsm_state) &&
+        time_since_last_state_switch >= t_s_vec_.at(i) &&
+        time_since_last_state_switch <= t_e_vec_.at(i);
+    if (!ws.tracking_active[i]) {
+      continue;
+    }
 
     // Check whether or not it is a constant trajectory, and update TrackingData
     if (fixed_position_vec_.at(i).size() != 0) {
-      // Create constant trajectory and update
-      tracking_data->Update(
-          x_w_spr, *context_w_spr_, x_wo_spr, *context_wo_spr_,
-          PiecewisePolynomial<double>(fixed_position_vec_.at(i)), t, fsm_state);
+      tracking_data->Update(x_w_spr, *context_w_spr_, x_wo_spr,
+                            *context_wo_spr_, fixed_position_vec_.at(i),
+                            fsm_state);
     } else {
       // Read in traj from input port
       const string& traj_name = tracking_data->GetName();
@@ -580,45 +726,92 @@ VectorXd OperationalSpaceControl::SolveQp(
       tracking_data->Update(x_w_spr, *context_w_spr_, x_wo_spr,
                             *context_wo_spr_, traj, t, fsm_state);
     }
-    // TODO(yangwill): Should only really be updating the trajectory if it's
-    //  active
-    if (tracking_data->IsActive() &&
-        time_since_last_state_switch >= t_s_vec_.at(i) &&
-        time_since_last_state_switch <= t_e_vec_.at(i)) {
-      const VectorXd& ddy_t = tracking_data->GetYddotCommand();
-      const MatrixXd& W = tracking_data->GetWeight();
-      const MatrixXd& J_t = tracking_data->GetJ();
-      const VectorXd& JdotV_t = tracking_data->GetJdotTimesV();
-      // The tracking cost is
-      // 0.5 * (J_*dv + JdotV - y_command)^T * W * (J_*dv + JdotV - y_command).
-      // We ignore the constant term
-      // 0.5 * (JdotV - y_command)^T * W * (JdotV - y_command),
-      // since it doesn't change the result of QP.
-      tracking_cost_.at(i)->UpdateCoefficients(
-          J_t.transpose() * W * J_t, J_t.transpose() * W * (JdotV_t - ddy_t));
-    } else {
-      tracking_cost_.at(i)->UpdateCoefficients(MatrixXd::Zero(n_v_, n_v_),
-                                               VectorXd::Zero(n_v_));
+    t_stage = timing_stats_->Toc(kNumFixedTimingStages + i, t_stage);
+
+    const VectorXd& ddy_t = tracking_data->GetYddotCommand();
+    const MatrixXd& W = tracking_data->GetWeight();
+    const MatrixXd& J_t = tracking_data->GetJ();
+    const VectorXd& JdotV_t = tracking_data->GetJdotTimesV();
+    // The tracking cost is
+    // 0.5 * (J_*dv + JdotV - y_command)^T * W * (J_*dv + JdotV - y_command).
+    // We ignore the constant term
+    // 0.5 * (JdotV - y_command)^T * W * (JdotV - y_command),
+    // since it doesn't change the result of QP.
+    ws.WJ[i].noalias() = W * J_t;
+    ws.tracking_error[i] = JdotV_t - ddy_t;
+    ws.Q_tracking.noalias() += J_t.transpose() * ws.WJ[i];
+    ws.b_tracking.noalias() += ws.WJ[i].transpose() * ws.tracking_error[i];
+  }
+  tracking_cost_->UpdateCoefficients(ws.Q_tracking, ws.b_tracking);
+
+  t_stage = timing_stats_->Toc(kCostAssemblyStage, t_stage);
+
+  // Solve the QP, warm-started from the previous solution. The decision
+  // variables are ordered as [dv, u, lambda_c, lambda_h, epsilon] (u is
+  // empty if the inputs are eliminated).
+  const int n_u_qp = u_.size();
+  const int u_start = n_v_;
+  const int lambda_c_start = u_start + n_u_qp;
+  const int lambda_h_start = lambda_c_start + n_c_;
+  const int epsilon_start = lambda_h_start + n_h_;
+  ws.initial_guess.segment(0, n_v_) = *dv_sol_;
+  ws.initial_guess.segment(u_start, n_u_qp) = u_sol_->head(n_u_qp);
+  ws.initial_guess.segment(lambda_c_start, n_c_) = *lambda_c_sol_;
+  ws.initial_guess.segment(lambda_h_start, n_h_) = *lambda_h_sol_;
+  ws.initial_guess.segment(epsilon_start, n_c_active_) = *epsilon_sol_;
+  const auto t_solve_start = t_stage;
+  solver_->Solve(ws.initial_guess);
+  t_stage = timing_stats_->Toc(kSolveStage, t_stage);
+
+  // Only fall back when the solver did not converge (e.g. it hit OSQP's time
+  // or iteration limit, or the QP is infeasible). A converged solution that
+  // took longer than the budget (OSQP's time limit does not include the
+  // update of the factorization) is still used, and only counted.
+  double solve_time =
+      std::chrono::duration<double>(t_stage - t_solve_start).count();
+  ws.qp_failed = solver_->solution_result() != SolutionResult::kSolutionFound;
+  ws.qp_budget_overrun = qp_time_budget_ > 0 && solve_time > qp_time_budget_;
+  if (ws.qp_budget_overrun) {
+    ws.num_qp_budget_overruns++;
+  }
+  const VectorXd* x_sol = &solver_->primal_solution();
+  if (ws.qp_failed) {
+    ws.num_qp_failures++;
+    if (qp_fallback_ == QpFallback::kLeastSquares) {
+      x_sol = &solver_->SolveLeastSquares();
     }
   }
 
-  // Solve the QP
-  const MathematicalProgramResult result = Solve(*prog_);
-
-  // Extract solutions
-  *dv_sol_ = result.GetSolution(dv_);
-  *u_sol_ = result.GetSolution(u_);
-  *lambda_c_sol_ = result.GetSolution(lambda_c_);
-  *lambda_h_sol_ = result.GetSolution(lambda_h_);
-  *epsilon_sol_ = result.GetSolution(epsilon_);
+  // Extract solutions (unless the previous solution is held)
+  if (!ws.qp_failed || qp_fallback_ != QpFallback::kPreviousInput) {
+    *dv_sol_ = x_sol->segment(0, n_v_);
+    if (eliminate_inputs_) {
+      // [dv, lambda_c, lambda_h] are contiguous since u is empty
+      u_sol_->noalias() = ws.A_u * x_sol->head(n_v_ + n_c_ + n_h_);
+      *u_sol_ += ws.b_u;
+    } else {
+      *u_sol_ = x_sol->segment(u_start, n_u_);
+    }
+    *lambda_c_sol_ = x_sol->segment(lambda_c_start, n_c_);
+    *lambda_h_sol_ = x_sol->segment(lambda_h_start, n_h_);
+    *epsilon_sol_ = x_sol->segment(epsilon_start, n_c_active_);
+    // The least-squares solution ignores the input limits
+    if (ws.qp_failed && qp_fallback_ == QpFallback::kLeastSquares &&
+        with_input_constraints_) {
+      *u_sol_ = u_sol_->cwiseMax(u_min_).cwiseMin(u_max_);
+    }
+  }
 
-  for (auto tracking_data : *tracking_data_vec_) {
-    if (tracking_data->IsActive()) tracking_data->SaveYddotCommandSol(*dv_sol_);
+  for (unsigned int i = 0; i < tracking_data_vec_->size(); i++) {
+    if (ws.tracking_active[i]) {
+      tracking_data_vec_->at(i)->SaveYddotCommandSol(*dv_sol_);
+    }
   }
+  timing_stats_->Toc(kSolutionExtractionStage, t_stage);
 
   // Print QP result
   if (print_tracking_info_) {
-    cout << "\n" << to_string(result.get_solution_result()) << endl;
+    cout << "\n" << to_string(solver_->solution_result()) << endl;
     cout << "fsm_state = " << fsm_state << endl;
     cout << "**********************\n";
     cout << "u_sol = " << u_sol_->transpose() << endl;
@@ -646,8 +839,9 @@ VectorXd OperationalSpaceControl::SolveQp(
            << endl;
     }
     // 4. Tracking cost
-    for (auto tracking_data : *tracking_data_vec_) {
-      if (tracking_data->IsActive()) {
+    for (unsigned int i = 0; i < tracking_data_vec_->size(); i++) {
+      auto tracking_data = tracking_data_vec_->at(i);
+      if (ws.tracking_active[i]) {
         const VectorXd& ddy_t = tracking_data->GetYddotCommand();
         const MatrixXd& W = tracking_data->GetWeight();
         const MatrixXd& J_t = tracking_data->GetJ();
@@ -664,9 +858,9 @@ VectorXd OperationalSpaceControl::SolveQp(
 
     // Target acceleration
     cout << "**********************\n";
-    for (auto tracking_data : *tracking_data_vec_) {
-      if (tracking_data->IsActive()) {
-        tracking_data->PrintFeedbackAndDesiredValues((*dv_sol_));
+    for (unsigned int i = 0; i < tracking_data_vec_->size(); i++) {
+      if (ws.tracking_active[i]) {
+        tracking_data_vec_->at(i)->PrintFeedbackAndDesiredValues((*dv_sol_));
       }
     }
     cout << "**********************\n\n";
@@ -682,85 +876,144 @@ void OperationalSpaceControl::AssignOscLcmOutput(
   auto fsm_output =
       (BasicVector<double>*)this->EvalVectorInput(context, fsm_port_);
 
-  double time_since_last_state_switch =
-      used_with_finite_state_machine_
-          ? state->get_timestamp() -
-                context.get_discrete_state(prev_event_time_idx_).get_value()(0)
-          : state->get_timestamp();
-
   output->utime = state->get_timestamp() * 1e6;
   output->fsm_state = fsm_output->get_value()(0);
-  output->input_cost =
-      (W_input_.size() > 0)
-          ? (0.5 * (*u_sol_).transpose() * W_input_ * (*u_sol_))(0)
-          : 0;
-  output->acceleration_cost =
-      (W_joint_accel_.size() > 0)
-          ? (0.5 * (*dv_sol_).transpose() * W_joint_accel_ * (*dv_sol_))(0)
-          : 0;
+  auto& ws = *workspace_;
+  output->input_cost = 0;
+  if (W_input_.size() > 0) {
+    ws.weighted_u.noalias() = W_input_ * (*u_sol_);
+    output->input_cost = 0.5 * u_sol_->dot(ws.weighted_u);
+  }
+  output->acceleration_cost = 0;
+  if (W_joint_accel_.size() > 0) {
+    ws.weighted_dv.noalias() = W_joint_accel_ * (*dv_sol_);
+    output->acceleration_cost = 0.5 * dv_sol_->dot(ws.weighted_dv);
+  }
+  output->qp_failed = ws.qp_failed;
+  output->num_qp_failures = ws.num_qp_failures;
+  output->qp_budget_overrun = ws.qp_budget_overrun;
+  output->num_qp_budget_overruns = ws.num_qp_budget_overruns;
   output->soft_constraint_cost =
       (w_soft_constraint_ > 0)
-          ? (0.5 * w_soft_constraint_ * (*epsilon_sol_).transpose() *
-             (*epsilon_sol_))(0)
+          ? 0.5 * w_soft_constraint_ * epsilon_sol_->squaredNorm()
           : 0;
 
-  output->tracking_data_names.clear();
-  output->tracking_data.clear();
-  output->tracking_cost.clear();
-
+  // The vectors of the message are resized instead of cleared, so that their
+  // memory is reused from one message to the next
+  unsigned int num_active = 0;
   for (unsigned int i = 0; i < tracking_data_vec_->size(); i++) {
     auto tracking_data = tracking_data_vec_->at(i);
 
-    if (tracking_data->IsActive() &&
-        time_since_last_state_switch >= t_s_vec_.at(i) &&
-        time_since_last_state_switch <= t_e_vec_.at(i)) {
-      output->tracking_data_names.push_back(tracking_data->GetName());
-      lcmt_osc_tracking_data osc_output;
+    // Only the tracking data which were active in the last QP are updated
+    if (ws.tracking_active[i]) {
+      if (output->tracking_data.size() <= num_active) {
+        output->tracking_data_names.emplace_back();
+        output->tracking_data.emplace_back();
+        output->tracking_cost.emplace_back();
+      }
+      output->tracking_data_names[num_active] = tracking_data->GetName();
+      lcmt_osc_tracking_data& osc_output = output->tracking_data[num_active];
       osc_output.y_dim = tracking_data->GetYDim();
       osc_output.ydot_dim = tracking_data->GetYdotDim();
       osc_output.name = tracking_data->GetName();
       // This should always be true
       osc_output.is_active = tracking_data->IsActive();
-      osc_output.y = CopyVectorXdToStdVector(tracking_data->GetY());
-      osc_output.y_des = CopyVectorXdToStdVector(tracking_data->GetYDes());
-      osc_output.error_y = CopyVectorXdToStdVector(tracking_data->GetErrorY());
-      osc_output.ydot = CopyVectorXdToStdVector(tracking_data->GetYdot());
-      osc_output.ydot_des =
-          CopyVectorXdToStdVector(tracking_data->GetYdotDes());
-      osc_output.error_ydot =
-          CopyVectorXdToStdVector(tracking_data->GetErrorYdot());
-      osc_output.yddot_des =
-          CopyVectorXdToStdVector(tracking_data->GetYddotDesConverted());
-      osc_output.yddot_command =
-          CopyVectorXdToStdVector(tracking_data->GetYddotCommand());
-      osc_output.yddot_command_sol =
-          CopyVectorXdToStdVector(tracking_data->GetYddotCommandSol());
-      output->tracking_data.push_back(osc_output);
+      CopyVectorXdToStdVector(tracking_data->GetY(), &osc_output.y);
+      CopyVectorXdToStdVector(tracking_data->GetYDes(), &osc_output.y_des);
+      CopyVectorXdToStdVector(tracking_data->GetErrorY(), &osc_output.error_y);
+      CopyVectorXdToStdVector(tracking_data->GetYdot(), &osc_output.ydot);
+      CopyVectorXdToStdVector(tracking_data->GetYdotDes(),
+                              &osc_output.ydot_des);
+      CopyVectorXdToStdVector(tracking_data->GetErrorYdot(),
+                              &osc_output.error_ydot);
+      CopyVectorXdToStdVector(tracking_data->GetYddotDesConverted(),
+                              &osc_output.yddot_des);
+      CopyVectorXdToStdVector(tracking_data->GetYddotCommand(),
+                              &osc_output.yddot_command);
+      CopyVectorXdToStdVector(tracking_data->GetYddotCommandSol(),
+                              &osc_output.yddot_command_sol);
 
       const VectorXd& ddy_t = tracking_data->GetYddotCommand();
       const MatrixXd& W = tracking_data->GetWeight();
       const MatrixXd& J_t = tracking_data->GetJ();
       const VectorXd& JdotV_t = tracking_data->GetJdotTimesV();
-      output->tracking_cost.push_back(
-          (0.5 * (J_t * (*dv_sol_) + JdotV_t - ddy_t).transpose() * W *
-           (J_t * (*dv_sol_) + JdotV_t - ddy_t))(0));
+      // error = J_t * dv + JdotV_t - ddy_t
+      VectorXd& error = ws.tracking_error[i];
+      error = JdotV_t - ddy_t;
+      error.noalias() += J_t * (*dv_sol_);
+      ws.weighted_tracking_error[i].noalias() = W * error;
+      output->tracking_cost[num_active] =
+          0.5 * error.dot(ws.weighted_tracking_error[i]);
+      num_active++;
     }
   }
+  output->tracking_data_names.resize(num_active);
+  output->tracking_data.resize(num_active);
+  output->tracking_cost.resize(num_active);
 
   output->num_tracking_data = output->tracking_data_names.size();
 }
 
+void OperationalSpaceControl::AssignOscTimingLcmOutput(
+    const Context<double>& context, dairlib::lcmt_osc_timing* output) const {
+  auto state =
+      (OutputVector<double>*)this->EvalVectorInput(context, state_port_);
+
+  output->utime = state->get_timestamp() * 1e6;
+  output->num_samples = timing_stats_->num_samples();
+  output->num_stages = timing_stats_->num_stages();
+  // Resize instead of clearing so that the storage of the message is reused
+  output->stage_names.resize(timing_stats_->num_stages());
+  output->last_us.resize(timing_stats_->num_stages());
+  output->p50_us.resize(timing_stats_->num_stages());
+  output->p99_us.resize(timing_stats_->num_stages());
+  output->max_us.resize(timing_stats_->num_stages());
+  for (int i = 0; i < timing_stats_->num_stages(); i++) {
+    output->stage_names[i] = timing_stats_->stage_name(i);
+    output->last_us[i] = timing_stats_->Last(i);
+    output->p50_us[i] = timing_stats_->Percentile(i, 50);
+    output->p99_us[i] = timing_stats_->Percentile(i, 99);
+    output->max_us[i] = timing_stats_->Max(i);
+  }
+}
+
+void OperationalSpaceControl::UpdateStates(
+    const Eigen::Ref<const VectorXd>& x_w_spr) const {
+  auto& ws = *workspace_;
+  ws.x_w_spr = x_w_spr;
+  auto q_wo_spr = ws.x_wo_spr.head(n_q_);
+  auto v_wo_spr = ws.x_wo_spr.tail(n_v_);
+  map_position_from_spring_to_no_spring_.Gather(
+      ws.x_w_spr.head(plant_w_spr_.num_positions()), &q_wo_spr);
+  map_velocity_from_spring_to_no_spring_.Gather(
+      ws.x_w_spr.tail(plant_w_spr_.num_velocities()), &v_wo_spr);
+}
+
+const VectorXd& OperationalSpaceControl::SolveRecordedSample(
+    const Context<double>& context, const Eigen::Ref<const VectorXd>& x_w_spr,
+    double t, int fsm_state, double time_since_last_state_switch) const {
+  DRAKE_DEMAND(workspace_ != nullptr);
+  auto t_start = OscTimingStats::Clock::now();
+  UpdateStates(x_w_spr);
+  timing_stats_->Toc(kSpringMappingStage, t_start);
+
+  const VectorXd& u_sol =
+      SolveQp(workspace_->x_w_spr, workspace_->x_wo_spr, context, t,
+              fsm_state, time_since_last_state_switch);
+
+  timing_stats_->Toc(kTotalStage, t_start);
+  timing_stats_->EndTick();
+  return u_sol;
+}
+
 void OperationalSpaceControl::CalcOptimalInput(
     const drake::systems::Context<double>& context,
     systems::TimestampedVector<double>* control) const {
+  auto t_start = OscTimingStats::Clock::now();
   // Read in current state and time
+  auto& ws = *workspace_;
   const OutputVector<double>* robot_output =
       (OutputVector<double>*)this->EvalVectorInput(context, state_port_);
-  VectorXd q_w_spr = robot_output->GetPositions();
-  VectorXd v_w_spr = robot_output->GetVelocities();
-  VectorXd x_w_spr(plant_w_spr_.num_positions() +
-                   plant_w_spr_.num_velocities());
-  x_w_spr << q_w_spr, v_w_spr;
 
   double timestamp = robot_output->get_timestamp();
   auto current_time = static_cast<double>(timestamp);
@@ -768,30 +1021,33 @@ void OperationalSpaceControl::CalcOptimalInput(
     cout << "\n\ncurrent_time = " << current_time << endl;
   }
 
-  VectorXd x_wo_spr(n_q_ + n_v_);
-  x_wo_spr << map_position_from_spring_to_no_spring_ * q_w_spr,
-      map_velocity_from_spring_to_no_spring_ * v_w_spr;
+  UpdateStates(robot_output->GetStateRef());
+  timing_stats_->Toc(kSpringMappingStage, t_start);
 
-  VectorXd u_sol(n_u_);
+  const VectorXd* u_sol;
   if (used_with_finite_state_machine_) {
     // Read in finite state machine
     const BasicVector<double>* fsm_output =
         (BasicVector<double>*)this->EvalVectorInput(context, fsm_port_);
-    VectorXd fsm_state = fsm_output->get_value();
+    int fsm_state = fsm_output->get_value()(0);
 
     // Get discrete states
     const auto prev_event_time =
         context.get_discrete_state(prev_event_time_idx_).get_value();
 
-    u_sol = SolveQp(x_w_spr, x_wo_spr, context, current_time, fsm_state(0),
-                    current_time - prev_event_time(0));
+    u_sol = &SolveQp(ws.x_w_spr, ws.x_wo_spr, context, current_time, fsm_state,
+                     current_time - prev_event_time(0));
   } else {
-    u_sol = SolveQp(x_w_spr, x_wo_spr, context, current_time, -1, current_time);
+    u_sol = &SolveQp(ws.x_w_spr, ws.x_wo_spr, context, current_time, -1,
+                     current_time);
   }
 
   // Assign the control input
-  control->SetDataVector(u_sol);
+  control->SetDataVector(*u_sol);
   control->set_timestamp(robot_output->get_timestamp());
+
+  timing_stats_->Toc(kTotalStage, t_start);
+  timing_stats_->EndTick();
 }
 
 }  // namespace dairlib::systems::controllers
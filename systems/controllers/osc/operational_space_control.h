@@ -7,6 +7,7 @@
 #include <set>
 #include <drake/multibody/plant/multibody_plant.h>
 #include "dairlib/lcmt_osc_output.hpp"
+#include "dairlib/lcmt_osc_timing.hpp"
 #include "drake/common/trajectories/exponential_plus_piecewise_polynomial.h"
 #include "drake/common/trajectories/piecewise_polynomial.h"
 #include "drake/systems/framework/diagram.h"
@@ -14,16 +15,28 @@
 #include "drake/systems/framework/leaf_system.h"
 
 #include "drake/solvers/mathematical_program.h"
-#include "drake/solvers/solve.h"
+#include "drake/solvers/solver_options.h"
 
+#include "multibody/index_map.h"
 #include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "multibody/kinematic/kinematics_cache.h"
 #include "multibody/kinematic/world_point_evaluator.h"
+#include "solvers/fast_osqp_solver.h"
 #include "systems/controllers/control_utils.h"
+#include "systems/controllers/osc/osc_timing_stats.h"
 #include "systems/controllers/osc/osc_tracking_data.h"
 #include "systems/framework/output_vector.h"
 
 namespace dairlib::systems::controllers {
 
+/// What OperationalSpaceControl outputs in a tick where the QP solver does not
+/// converge, e.g. because it reached its time budget (see SetQpTimeBudget())
+enum class QpFallback {
+  kNone,           // use the solution returned by the solver anyway
+  kPreviousInput,  // hold the input of the previous tick
+  kLeastSquares,   // solve the costs and equality constraints by least squares
+};
+
 /// `OperationalSpaceControl` takes in desired trajectory in world frame and
 /// outputs torque command of the motors.
 
@@ -104,6 +117,10 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
   const drake::systems::OutputPort<double>& get_osc_debug_port() const {
     return this->get_output_port(osc_debug_port_);
   }
+  /// Rolling p50/p99/max latencies of the stages of each control tick
+  const drake::systems::OutputPort<double>& get_osc_timing_port() const {
+    return this->get_output_port(osc_timing_port_);
+  }
 
   // Input/output ports
   const drake::systems::InputPort<double>& get_robot_output_input_port() const {
@@ -117,6 +134,14 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
     return this->get_input_port(traj_name_to_port_index_map_.at(name));
   }
 
+  /// Solution of the last QP: the accelerations dv, the contact forces
+  /// lambda_c (3 per contact point, only meaningful for the active contacts)
+  /// and the holonomic constraint forces lambda_h. Must be called after
+  /// Build().
+  const Eigen::VectorXd& dv_solution() const { return *dv_sol_; }
+  const Eigen::VectorXd& lambda_c_solution() const { return *lambda_c_sol_; }
+  const Eigen::VectorXd& lambda_h_solution() const { return *lambda_h_sol_; }
+
   // Cost methods
   void SetInputCost(const Eigen::MatrixXd& W) { W_input_ = W; }
   void SetAccelerationCostForAllJoints(const Eigen::MatrixXd& W) {
@@ -126,6 +151,14 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
 
   // Constraint methods
   void DisableAcutationConstraint() { with_input_constraints_ = false; }
+  /// Removes the inputs u from the decision variables of the QP. The actuated
+  /// rows of the manipulator equation are solved for u,
+  ///   u = B_a^{-1} * (M_a*dv + bias_a - J_c_a^T*lambda_c - J_h_a^T*lambda_h),
+  /// so only the unactuated rows stay as equality constraints, and the input
+  /// cost and the input limits become functions of (dv, lambda_c, lambda_h).
+  /// Requires each actuator to drive a different joint (B_a invertible).
+  /// Must be called before Build().
+  void EliminateInputsFromQp() { eliminate_inputs_ = true; }
   void SetContactFriction(double mu) { mu_ = mu; }
   void SetWeightOfSoftContactConstraint(double w_soft_constraint) {
     w_soft_constraint_ = w_soft_constraint;
@@ -151,20 +184,66 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
     return tracking_data_vec_->at(index);
   }
 
+  // Solver methods
+  /// The QP is solved by OSQP, warm-started from the previous solution. The
+  /// OSQP workspace is created in the first solve and reused afterwards.
+  /// `options` are OSQP settings set under drake::solvers::OsqpSolver::id().
+  /// Must be called before Build().
+  void SetOsqpSolverOptions(const drake::solvers::SolverOptions& options) {
+    solver_options_ = options;
+  }
+
+  /// Limits the time spent in the QP solver to `time_budget` seconds (OSQP
+  /// stops early when the limit is reached), and sets what the OSC outputs
+  /// when the solver does not converge. A solution which converged but took
+  /// longer than the budget is still used. The numbers of failed and
+  /// over-budget ticks are published in the debug output. OSQP only enforces
+  /// the limit when it is built with PROFILING; otherwise Build() throws.
+  /// Must be called before Build().
+  void SetQpTimeBudget(double time_budget,
+                       QpFallback fallback = QpFallback::kPreviousInput) {
+    qp_time_budget_ = time_budget;
+    qp_fallback_ = fallback;
+  }
+  /// Sets the fallback used when the solver fails, without a time budget
+  void SetQpFallback(QpFallback fallback) { qp_fallback_ = fallback; }
+
   // OSC LeafSystem builder
   void Build();
 
+  /// Solves the QP for one recorded sample without going through the Drake
+  /// diagram, e.g. to replay a log (see OscBatchEvaluator).
+  /// @param context a Context of this system. Only its input ports of the
+  ///   non-constant desired trajectories are read.
+  /// @param x_w_spr state of plant_w_spr
+  /// @param t time of the sample
+  /// @param fsm_state finite state machine state (-1 if the OSC is not used
+  ///   with a finite state machine)
+  /// @param time_since_last_state_switch time since the finite state machine
+  ///   switched to `fsm_state` (`t` if the OSC is not used with a finite
+  ///   state machine)
+  /// @return the input u. The reference stays valid until the next solve.
+  /// The QP is warm-started from the previous solve, so samples should be
+  /// solved in time order. Must be called after Build().
+  const Eigen::VectorXd& SolveRecordedSample(
+      const drake::systems::Context<double>& context,
+      const Eigen::Ref<const Eigen::VectorXd>& x_w_spr, double t,
+      int fsm_state, double time_since_last_state_switch) const;
+
  private:
   // Osc checkers and constructor-related methods
   void CheckCostSettings();
   void CheckConstraintSettings();
 
-  // Get solution of OSC
-  Eigen::VectorXd SolveQp(const Eigen::VectorXd& x_w_spr,
-                          const Eigen::VectorXd& x_wo_spr,
-                          const drake::systems::Context<double>& context,
-                          double t, int fsm_state,
-                          double time_since_last_state_switch) const;
+  // Copies x_w_spr to the workspace and maps it to the plant without springs
+  void UpdateStates(const Eigen::Ref<const Eigen::VectorXd>& x_w_spr) const;
+
+  // Get solution of OSC (the input u)
+  const Eigen::VectorXd& SolveQp(const Eigen::VectorXd& x_w_spr,
+                                 const Eigen::VectorXd& x_wo_spr,
+                                 const drake::systems::Context<double>& context,
+                                 double t, int fsm_state,
+                                 double time_since_last_state_switch) const;
 
   // Discrete update that stores the previous state transition time
   drake::systems::EventStatus DiscreteVariableUpdate(
@@ -174,12 +253,16 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
   void AssignOscLcmOutput(const drake::systems::Context<double>& context,
                           dairlib::lcmt_osc_output* output) const;
 
+  void AssignOscTimingLcmOutput(const drake::systems::Context<double>& context,
+                                dairlib::lcmt_osc_timing* output) const;
+
   // Output function
   void CalcOptimalInput(const drake::systems::Context<double>& context,
                         systems::TimestampedVector<double>* control) const;
 
   // Input/Output ports
   int osc_debug_port_;
+  int osc_timing_port_;
   int osc_output_port_;
   int state_port_;
   int fsm_port_;
@@ -189,8 +272,8 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
   int prev_event_time_idx_;
 
   // Map position/velocity from model with spring to without spring
-  Eigen::MatrixXd map_position_from_spring_to_no_spring_;
-  Eigen::MatrixXd map_velocity_from_spring_to_no_spring_;
+  multibody::IndexMap map_position_from_spring_to_no_spring_;
+  multibody::IndexMap map_velocity_from_spring_to_no_spring_;
 
   // Map from (non-const) trajectory names to input port indices
   std::map<std::string, int> traj_name_to_port_index_map_;
@@ -207,6 +290,12 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
   drake::systems::Context<double>* context_w_spr_;
   drake::systems::Context<double>* context_wo_spr_;
 
+  // Kinematics caches of the two contexts, shared by the tracking data, the
+  // contact constraints and the holonomic constraints. Cleared at the start
+  // of every QP update.
+  std::unique_ptr<multibody::KinematicsCache<double>> kinematics_cache_w_spr_;
+  std::unique_ptr<multibody::KinematicsCache<double>> kinematics_cache_wo_spr_;
+
   // Size of position, velocity and input of the MBP without spring
   int n_q_;
   int n_v_;
@@ -235,6 +324,12 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
 
   // MathematicalProgram
   std::unique_ptr<drake::solvers::MathematicalProgram> prog_;
+  // Solver (keeps the OSQP workspace alive between ticks)
+  std::unique_ptr<solvers::FastOsqpSolver> solver_;
+  drake::solvers::SolverOptions solver_options_;
+  // Time budget of the solver in seconds (no budget if not positive)
+  double qp_time_budget_ = -1;
+  QpFallback qp_fallback_ = QpFallback::kNone;
   // Decision variables
   drake::solvers::VectorXDecisionVariable dv_;
   drake::solvers::VectorXDecisionVariable u_;
@@ -246,7 +341,80 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
   drake::solvers::LinearEqualityConstraint* holonomic_constraint_;
   drake::solvers::LinearEqualityConstraint* contact_constraints_;
   std::vector<drake::solvers::LinearConstraint*> friction_constraints_;
-  std::vector<drake::solvers::QuadraticCost*> tracking_cost_;
+  // Input cost and input limits (only stored when the inputs are eliminated
+  // from the QP, since their coefficients then change at every tick)
+  drake::solvers::QuadraticCost* input_cost_ = nullptr;
+  drake::solvers::LinearConstraint* input_constraint_ = nullptr;
+  // The tracking costs of all active tracking data are summed into one cost,
+  // so the solver sees a single term however many tracking data are active
+  drake::solvers::QuadraticCost* tracking_cost_;
+
+  // Preallocated buffers of the control loop. They are sized in Build() and
+  // reused at every tick, so that CalcOptimalInput() does not allocate memory
+  // itself (Drake's MultibodyPlant computations and the evaluation of
+  // non-constant desired trajectories still do).
+  struct OscWorkspace {
+    // States of the plants with and without springs
+    Eigen::VectorXd x_w_spr;
+    Eigen::VectorXd x_wo_spr;
+    // Manipulator equation M*dv + bias == J_c^T*lambda_c + J_h^T*lambda_h + B*u
+    Eigen::MatrixXd B;
+    Eigen::MatrixXd M;
+    Eigen::VectorXd bias;
+    Eigen::VectorXd grav;
+    // Holonomic and contact constraint Jacobians
+    Eigen::MatrixXd J_h;
+    Eigen::VectorXd JdotV_h;
+    Eigen::MatrixXd J_c;
+    Eigen::VectorXd JdotV_c_i;
+    Eigen::MatrixXd J_c_active;
+    Eigen::VectorXd JdotV_c_active;
+    // When the inputs are eliminated, D = [M, -J_c^T, -J_h^T] and the
+    // inputs are u = A_u * [dv; lambda_c; lambda_h] + b_u
+    Eigen::MatrixXd D;
+    Eigen::MatrixXd D_a;
+    Eigen::VectorXd bias_a;
+    Eigen::MatrixXd A_u;
+    Eigen::VectorXd b_u;
+    Eigen::MatrixXd WA_u;
+    Eigen::MatrixXd Q_u;
+    Eigen::VectorXd b_Q_u;
+    Eigen::VectorXd u_lb;
+    Eigen::VectorXd u_ub;
+    // Coefficients of the linear constraints
+    Eigen::MatrixXd A_dyn;
+    Eigen::VectorXd b_dyn;
+    Eigen::VectorXd b_h;
+    Eigen::MatrixXd A_c;
+    Eigen::VectorXd b_c;
+    // Lower bounds of the friction cone constraints
+    Eigen::VectorXd zero_bound;
+    Eigen::VectorXd neg_inf_bound;
+    // Tracking costs. WJ and tracking_error are W*J and JdotV - yddot_command
+    // of each tracking data, and Q_tracking and b_tracking the sum of the
+    // costs of the active tracking data. tracking_active[i] is whether the
+    // i-th tracking data is active in the current tick (fsm state and time
+    // window).
+    std::vector<bool> tracking_active;
+    std::vector<Eigen::MatrixXd> WJ;
+    std::vector<Eigen::VectorXd> tracking_error;
+    std::vector<Eigen::VectorXd> weighted_tracking_error;
+    Eigen::VectorXd weighted_u;
+    Eigen::VectorXd weighted_dv;
+    Eigen::MatrixXd Q_tracking;
+    Eigen::VectorXd b_tracking;
+    // Warm start of the QP
+    Eigen::VectorXd initial_guess;
+    // Whether the QP did not converge in the last tick, and the number of such
+    // ticks since Build()
+    bool qp_failed = false;
+    int num_qp_failures = 0;
+    // Whether the QP converged but took longer than the time budget in the
+    // last tick, and the number of such ticks since Build()
+    bool qp_budget_overrun = false;
+    int num_qp_budget_overruns = 0;
+  };
+  std::unique_ptr<OscWorkspace> workspace_;
 
   // OSC solution
   std::unique_ptr<Eigen::VectorXd> dv_sol_;
@@ -264,12 +432,21 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
   // OSC constraint members
   bool with_input_constraints_ = true;
 
+  // Structured QP without the inputs (see EliminateInputsFromQp()).
+  // actuated_rows_[i] is the row of B driven by the i-th actuator.
+  bool eliminate_inputs_ = false;
+  std::vector<int> actuated_rows_;
+  std::vector<int> unactuated_rows_;
+  Eigen::MatrixXd B_a_inv_;
+
   // Soft contact penalty coefficient and friction cone coefficient
   double mu_ = -1;  // Friction coefficients
   double w_soft_constraint_ = -1;
 
   // Map finite state machine state to its active contact indices
   std::map<int, std::set<int>> contact_indices_map_ = {};
+  // Active contact set of the fsm states which are not in the map
+  const std::set<int> no_active_contact_ = {};
   // All contacts (used in contact constraints)
   std::vector<const multibody::WorldPointEvaluator<double>*> all_contacts_ = {};
   // single_contact_mode_ is true if there is only 1 contact mode in OSC
@@ -282,6 +459,20 @@ class OperationalSpaceControl : public drake::systems::LeafSystem<double> {
   // Fixed position of constant trajectories
   std::vector<Eigen::VectorXd> fixed_position_vec_;
 
+  // Latency statistics of each control tick. The i-th tracking data is timed
+  // as stage kNumFixedTimingStages + i.
+  enum TimingStage {
+    kSpringMappingStage = 0,
+    kDynamicsStage,
+    kConstraintJacobianStage,
+    kCostAssemblyStage,
+    kSolveStage,
+    kSolutionExtractionStage,
+    kTotalStage,
+    kNumFixedTimingStages
+  };
+  std::unique_ptr<OscTimingStats> timing_stats_;
+
   // Set a period during which we apply control (Unit: seconds)
   // Let t be the elapsed time since fsm switched to a new state.
   // We only apply the control when t_s <= t <= t_e
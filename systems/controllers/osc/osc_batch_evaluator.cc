@@ -0,0 +1,122 @@
+#include "systems/controllers/osc/osc_batch_evaluator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <thread>
+
+#include "drake/common/drake_assert.h"
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+using Eigen::VectorXi;
+using std::unique_ptr;
+
+namespace dairlib::systems::controllers {
+
+OscBatchEvaluator::OscBatchEvaluator(
+    std::function<unique_ptr<Worker>()> worker_factory, int num_threads) {
+  DRAKE_DEMAND(num_threads >= 1);
+  for (int i = 0; i < num_threads; i++) {
+    workers_.push_back(worker_factory());
+    DRAKE_DEMAND(workers_.back() != nullptr);
+    DRAKE_DEMAND(workers_.back()->osc != nullptr);
+    DRAKE_DEMAND(workers_.back()->context != nullptr);
+  }
+}
+
+VectorXd OscBatchEvaluator::CalcTimeSinceLastStateSwitch(
+    const VectorXi& fsm_states, const VectorXd& timestamps) {
+  DRAKE_DEMAND(fsm_states.size() == timestamps.size());
+  VectorXd time_since_switch(timestamps.size());
+  // Same initial values as the discrete states of OperationalSpaceControl
+  double prev_fsm_state = -0.1;
+  double prev_event_time = 0;
+  for (int i = 0; i < timestamps.size(); i++) {
+    if (fsm_states(i) != prev_fsm_state) {
+      prev_fsm_state = fsm_states(i);
+      prev_event_time = timestamps(i);
+    }
+    time_since_switch(i) = timestamps(i) - prev_event_time;
+  }
+  return time_since_switch;
+}
+
+void OscBatchEvaluator::EvaluateChunk(int worker_index, int begin, int end,
+                                      const MatrixXd& states,
+                                      const VectorXi& fsm_states,
+                                      const VectorXd& timestamps,
+                                      const VectorXd& time_since_switch,
+                                      MatrixXd* inputs) const {
+  const Worker& worker = *workers_[worker_index];
+  for (int i = begin; i < end; i++) {
+    const VectorXd& u =
+        fsm_states.size() > 0
+            ? worker.osc->SolveRecordedSample(*worker.context, states.col(i),
+                                              timestamps(i), fsm_states(i),
+                                              time_since_switch(i))
+            : worker.osc->SolveRecordedSample(*worker.context, states.col(i),
+                                              timestamps(i), -1, timestamps(i));
+    if (inputs->rows() != u.size()) {
+      inputs->resize(u.size(), end - begin);
+    }
+    inputs->col(i - begin) = u;
+  }
+}
+
+MatrixXd OscBatchEvaluator::Evaluate(const MatrixXd& states,
+                                     const VectorXi& fsm_states,
+                                     const VectorXd& timestamps) const {
+  const int n_samples = timestamps.size();
+  DRAKE_DEMAND(states.cols() == n_samples);
+  DRAKE_DEMAND(fsm_states.size() == 0 || fsm_states.size() == n_samples);
+  if (n_samples == 0) return MatrixXd(0, 0);
+
+  VectorXd time_since_switch;
+  if (fsm_states.size() > 0) {
+    time_since_switch = CalcTimeSinceLastStateSwitch(fsm_states, timestamps);
+  }
+
+  // Each worker writes its chunk of inputs to its own matrix, so that the
+  // input dimension does not have to be known in advance
+  const int n_chunks = std::min<int>(workers_.size(), n_samples);
+  std::vector<MatrixXd> chunk_inputs(n_chunks);
+  std::vector<int> chunk_begin(n_chunks + 1);
+  for (int k = 0; k <= n_chunks; k++) {
+    chunk_begin[k] = static_cast<int64_t>(n_samples) * k / n_chunks;
+  }
+
+  if (n_chunks == 1) {
+    EvaluateChunk(0, chunk_begin[0], chunk_begin[1], states, fsm_states,
+                  timestamps, time_since_switch, &chunk_inputs[0]);
+  } else {
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(n_chunks);
+    for (int k = 0; k < n_chunks; k++) {
+      threads.emplace_back([&, k]() {
+        try {
+          EvaluateChunk(k, chunk_begin[k], chunk_begin[k + 1], states,
+                        fsm_states, timestamps, time_since_switch,
+                        &chunk_inputs[k]);
+        } catch (...) {
+          errors[k] = std::current_exception();
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (const auto& error : errors) {
+      if (error) std::rethrow_exception(error);
+    }
+  }
+
+  MatrixXd inputs(chunk_inputs[0].rows(), n_samples);
+  for (int k = 0; k < n_chunks; k++) {
+    inputs.middleCols(chunk_begin[k], chunk_begin[k + 1] - chunk_begin[k]) =
+        chunk_inputs[k];
+  }
+  return inputs;
+}
+
+}  // namespace dairlib::systems::controllers
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "common/owned_objects.h"
+#include "systems/controllers/osc/operational_space_control.h"
+#include "drake/systems/framework/context.h"
+
+namespace dairlib::systems::controllers {
+
+/// OscBatchEvaluator solves the OSC QP for a batch of recorded samples (robot
+/// states, finite state machine states and timestamps), e.g. to tune gains on
+/// a hardware log without running the Drake diagram message by message.
+///
+/// The batch is split into contiguous chunks which are solved in parallel,
+/// one thread per worker. OperationalSpaceControl, its tracking data and its
+/// plant contexts are not thread-safe, so each worker owns a separate OSC,
+/// created by the user-provided factory. The plants themselves can be shared.
+///
+/// The time since the last finite state machine switch is computed from the
+/// whole batch before solving, so it does not depend on the chunking. The QP
+/// is warm-started from the previous sample of the same chunk, so the inputs
+/// only differ from a serial evaluation up to the solver tolerance.
+class OscBatchEvaluator {
+ public:
+  /// A worker of the batch. The plant contexts or tracking data referred to
+  /// by `osc` are kept alive with Own().
+  struct Worker : public OwnedObjects {
+    /// A built OSC
+    std::unique_ptr<OperationalSpaceControl> osc;
+    /// A context of `osc`. Only the input ports of the non-constant desired
+    /// trajectories are read, so they must be fixed by the factory if used.
+    std::unique_ptr<drake::systems::Context<double>> context;
+  };
+
+  /// @param worker_factory creates one independent Worker. Called
+  ///   `num_threads` times in the constructor, from the calling thread.
+  /// @param num_threads number of worker threads (>= 1)
+  OscBatchEvaluator(std::function<std::unique_ptr<Worker>()> worker_factory,
+                    int num_threads = 1);
+
+  /// Solves the OSC for every sample (column) of the batch.
+  /// @param states (n_x_w_spr x N) states of the plant with springs
+  /// @param fsm_states (N) finite state machine states. Must be empty if the
+  ///   OSC is not used with a finite state machine.
+  /// @param timestamps (N) increasing timestamps
+  /// @return (n_u x N) inputs
+  Eigen::MatrixXd Evaluate(const Eigen::MatrixXd& states,
+                           const Eigen::VectorXi& fsm_states,
+                           const Eigen::VectorXd& timestamps) const;
+
+  /// Time since the last finite state machine switch of every sample, as
+  /// computed by the discrete update of OperationalSpaceControl
+  static Eigen::VectorXd CalcTimeSinceLastStateSwitch(
+      const Eigen::VectorXi& fsm_states, const Eigen::VectorXd& timestamps);
+
+  int num_threads() const { return workers_.size(); }
+
+ private:
+  // Solves the samples [begin, end) with workers_[worker_index]
+  void EvaluateChunk(int worker_index, int begin, int end,
+                     const Eigen::MatrixXd& states,
+                     const Eigen::VectorXi& fsm_states,
+                     const Eigen::VectorXd& timestamps,
+                     const Eigen::VectorXd& time_since_switch,
+                     Eigen::MatrixXd* inputs) const;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+}  // namespace dairlib::systems::controllers
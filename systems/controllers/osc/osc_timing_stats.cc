@@ -0,0 +1,68 @@
+#include "systems/controllers/osc/osc_timing_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "drake/common/drake_assert.h"
+
+using std::string;
+using std::vector;
+
+namespace dairlib::systems::controllers {
+
+OscTimingStats::OscTimingStats(const vector<string>& stage_names,
+                               int window_size)
+    : stage_names_(stage_names),
+      window_size_(window_size),
+      current_(Eigen::VectorXd::Zero(stage_names.size())),
+      samples_(Eigen::MatrixXd::Zero(window_size, stage_names.size())),
+      scratch_(window_size) {
+  DRAKE_DEMAND(window_size > 0);
+}
+
+OscTimingStats::Clock::time_point OscTimingStats::Toc(
+    int stage, Clock::time_point start) {
+  auto now = Clock::now();
+  Record(stage,
+         std::chrono::duration<double, std::micro>(now - start).count());
+  return now;
+}
+
+void OscTimingStats::Record(int stage, double duration_us) {
+  current_(stage) += duration_us;
+}
+
+void OscTimingStats::EndTick() {
+  samples_.row(next_row_) = current_.transpose();
+  current_.setZero();
+  next_row_ = (next_row_ + 1) % window_size_;
+  num_samples_ = std::min(num_samples_ + 1, window_size_);
+}
+
+double OscTimingStats::Last(int stage) const {
+  if (num_samples_ == 0) return 0;
+  int last_row = (next_row_ + window_size_ - 1) % window_size_;
+  return samples_(last_row, stage);
+}
+
+double OscTimingStats::Percentile(int stage, double p) const {
+  DRAKE_DEMAND(0 <= p && p <= 100);
+  if (num_samples_ == 0) return 0;
+  auto begin = scratch_.begin();
+  auto end = begin + num_samples_;
+  for (int i = 0; i < num_samples_; i++) {
+    scratch_[i] = samples_(i, stage);
+  }
+  int k = std::min(static_cast<int>(std::ceil(p / 100 * num_samples_)) - 1,
+                   num_samples_ - 1);
+  k = std::max(k, 0);
+  std::nth_element(begin, begin + k, end);
+  return scratch_[k];
+}
+
+double OscTimingStats::Max(int stage) const {
+  if (num_samples_ == 0) return 0;
+  return samples_.col(stage).head(num_samples_).maxCoeff();
+}
+
+}  // namespace dairlib::systems::controllers
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace dairlib {
+namespace systems {
+namespace controllers {
+
+/// OscTimingStats keeps the latencies of the stages of a control tick over a
+/// rolling window of the most recent ticks.
+///
+/// Recording a sample only reads a monotonic clock and writes into a
+/// preallocated ring buffer, so it is cheap enough to be called from the
+/// real-time control loop. The percentiles are computed when they are
+/// queried (e.g. when the timing lcm message is assigned), which costs a
+/// partial sort of the window, so they should be queried at a low rate (the
+/// OSC_TIMING publishers are periodic, not per tick).
+///
+/// Usage:
+///   auto t = OscTimingStats::Clock::now();
+///   ... stage 0 ...
+///   t = stats.Toc(0, t);
+///   ... stage 1 ...
+///   t = stats.Toc(1, t);
+class OscTimingStats {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// @param stage_names names of the stages
+  /// @param window_size number of ticks kept for the statistics
+  explicit OscTimingStats(const std::vector<std::string>& stage_names,
+                          int window_size = 2000);
+
+  /// Records the time elapsed since `start` for stage `stage` and returns the
+  /// current time, so that calls can be chained from one stage to the next.
+  Clock::time_point Toc(int stage, Clock::time_point start);
+
+  /// Records a duration (in microseconds) for stage `stage`
+  void Record(int stage, double duration_us);
+
+  /// Marks the end of a tick. Stages which are not recorded in a tick get a
+  /// zero sample.
+  void EndTick();
+
+  int num_stages() const { return stage_names_.size(); }
+  const std::string& stage_name(int stage) const {
+    return stage_names_.at(stage);
+  }
+  /// Number of ticks currently in the window
+  int num_samples() const { return num_samples_; }
+
+  /// Duration of the stage in the last completed tick (in microseconds)
+  double Last(int stage) const;
+  /// p-th percentile (0 <= p <= 100) of the stage duration over the window
+  double Percentile(int stage, double p) const;
+  /// Maximum of the stage duration over the window
+  double Max(int stage) const;
+
+ private:
+  std::vector<std::string> stage_names_;
+  int window_size_;
+  // Samples of the current tick
+  Eigen::VectorXd current_;
+  // Ring buffer of completed ticks (window_size x num_stages)
+  Eigen::MatrixXd samples_;
+  int next_row_ = 0;
+  int num_samples_ = 0;
+  // Scratch space for Percentile() so that querying does not allocate
+  mutable std::vector<double> scratch_;
+};
+
+}  // namespace controllers
+}  // namespace systems
+}  // namespace dairlib
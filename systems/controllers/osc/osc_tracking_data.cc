@@ -55,33 +55,61 @@ bool OscTrackingData::Update(
     // Careful: must update y_des_ before calling UpdateYAndError()
     // Update desired output
     y_des_ = traj.value(t);
-    ydot_des_ = traj.MakeDerivative(1)->value(t);
-    yddot_des_ = traj.MakeDerivative(2)->value(t);
-
-    // Update feedback output (Calling virtual methods)
-    UpdateYAndError(x_w_spr, context_w_spr);
-    UpdateYdotAndError(x_w_spr, context_w_spr);
-    UpdateYddotDes();
-    UpdateJ(x_wo_spr, context_wo_spr);
-    UpdateJdotV(x_wo_spr, context_wo_spr);
-
-    // Update command output (desired output with pd control)
-    yddot_command_ =
-        yddot_des_converted_ + K_p_ * (error_y_) + K_d_ * (error_ydot_);
+    ydot_des_ = traj.EvalDerivative(t, 1);
+    yddot_des_ = traj.EvalDerivative(t, 2);
+
+    UpdateFeedbackAndCommand(x_w_spr, context_w_spr, x_wo_spr, context_wo_spr);
+  }
+  return track_at_current_state_;
+}
+
+bool OscTrackingData::Update(const VectorXd& x_w_spr,
+                             const Context<double>& context_w_spr,
+                             const VectorXd& x_wo_spr,
+                             const Context<double>& context_wo_spr,
+                             const VectorXd& y_des,
+                             int finite_state_machine_state) {
+  UpdateTrackingFlag(finite_state_machine_state);
+
+  if (track_at_current_state_) {
+    // setZero(n) only reallocates if the size changes
+    y_des_ = y_des;
+    ydot_des_.setZero(y_des.size());
+    yddot_des_.setZero(y_des.size());
+
+    UpdateFeedbackAndCommand(x_w_spr, context_w_spr, x_wo_spr, context_wo_spr);
   }
   return track_at_current_state_;
 }
 
-void OscTrackingData::UpdateTrackingFlag(int finite_state_machine_state) {
+void OscTrackingData::UpdateFeedbackAndCommand(
+    const VectorXd& x_w_spr, const Context<double>& context_w_spr,
+    const VectorXd& x_wo_spr, const Context<double>& context_wo_spr) {
+  // Update feedback output (Calling virtual methods)
+  UpdateYAndError(x_w_spr, context_w_spr);
+  UpdateYdotAndError(x_w_spr, context_w_spr);
+  UpdateYddotDes();
+  UpdateJ(x_wo_spr, context_wo_spr);
+  UpdateJdotV(x_wo_spr, context_wo_spr);
+
+  // Update command output (desired output with pd control)
+  // The products are accumulated in place to avoid temporaries
+  yddot_command_ = yddot_des_converted_;
+  yddot_command_.noalias() += K_p_ * error_y_;
+  yddot_command_.noalias() += K_d_ * error_ydot_;
+}
+
+bool OscTrackingData::UpdateTrackingFlag(int finite_state_machine_state) {
   if (state_.empty()) {
     track_at_current_state_ = true;
     state_idx_ = 0;
-    return;
+    return track_at_current_state_;
   }
 
   auto it = find(state_.begin(), state_.end(), finite_state_machine_state);
   state_idx_ = std::distance(state_.begin(), it);
   track_at_current_state_ = it != state_.end();
+  return track_at_current_state_;
 }
 
 void OscTrackingData::PrintFeedbackAndDesiredValues(const VectorXd& dv) {
@@ -101,7 +129,8 @@ void OscTrackingData::PrintFeedbackAndDesiredValues(const VectorXd& dv) {
 
 void OscTrackingData::SaveYddotCommandSol(const VectorXd& dv) {
   DRAKE_ASSERT(track_at_current_state_);
-  yddot_command_sol_ = J_ * dv + JdotV_;
+  yddot_command_sol_ = JdotV_;
+  yddot_command_sol_.noalias() += J_ * dv;
 }
 
 void OscTrackingData::AddState(int state) {
@@ -112,12 +141,24 @@ void OscTrackingData::AddState(int state) {
   state_.push_back(state);
 }
 
+void OscTrackingData::SetKinematicsCaches(
+    multibody::KinematicsCache<double>* cache_w_spr,
+    multibody::KinematicsCache<double>* cache_wo_spr) {
+  DRAKE_DEMAND(&cache_w_spr->plant() == &plant_w_spr_);
+  DRAKE_DEMAND(&cache_wo_spr->plant() == &plant_wo_spr_);
+  cache_w_spr_ = cache_w_spr;
+  cache_wo_spr_ = cache_wo_spr;
+}
+
 // Run this function in OSC constructor to make sure that users constructed
 // OscTrackingData correctly.
 void OscTrackingData::CheckOscTrackingData() {
   cout << "Checking " << name_ << endl;
   CheckDerivedOscTrackingData();
 
+  DRAKE_DEMAND(cache_w_spr_ != nullptr);
+  DRAKE_DEMAND(cache_wo_spr_ != nullptr);
+
   DRAKE_DEMAND((K_p_.rows() == n_ydot_) && (K_p_.cols() == n_ydot_));
   DRAKE_DEMAND((K_d_.rows() == n_ydot_) && (K_d_.cols() == n_ydot_));
   DRAKE_DEMAND((W_.rows() == n_ydot_) && (W_.cols() == n_ydot_));
@@ -140,17 +181,16 @@ void ComTrackingData::AddStateToTrack(int state) { AddState(state); }
 
 void ComTrackingData::UpdateYAndError(const VectorXd& x_w_spr,
                                       const Context<double>& context_w_spr) {
-  y_ = plant_w_spr_.CalcCenterOfMassPosition(context_w_spr);
+  y_ = cache_w_spr_->EvalCenterOfMassPosition(context_w_spr);
   error_y_ = y_des_ - y_;
 }
 
 void ComTrackingData::UpdateYdotAndError(const VectorXd& x_w_spr,
                                          const Context<double>& context_w_spr) {
-  MatrixXd J_w_spr(kSpaceDim, plant_w_spr_.num_velocities());
-  plant_w_spr_.CalcJacobianCenterOfMassTranslationalVelocity(
-      context_w_spr, JacobianWrtVariable::kV, world_w_spr_, world_w_spr_,
-      &J_w_spr);
-  ydot_ = J_w_spr * x_w_spr.tail(plant_w_spr_.num_velocities());
+  ydot_.noalias() =
+      cache_w_spr_->EvalJacobianCenterOfMassTranslationalVelocity(
+          context_w_spr) *
+      x_w_spr.tail(plant_w_spr_.num_velocities());
   error_ydot_ = ydot_des_ - ydot_;
 }
 
@@ -158,15 +198,15 @@ void ComTrackingData::UpdateYddotDes() { yddot_des_converted_ = yddot_des_; }
 
 void ComTrackingData::UpdateJ(const VectorXd& x_wo_spr,
                               const Context<double>& context_wo_spr) {
-  J_ = MatrixXd::Zero(kSpaceDim, plant_wo_spr_.num_velocities());
-  plant_wo_spr_.CalcJacobianCenterOfMassTranslationalVelocity(
-      context_wo_spr, JacobianWrtVariable::kV, world_w_spr_, world_w_spr_, &J_);
+  J_ = cache_wo_spr_->EvalJacobianCenterOfMassTranslationalVelocity(
+      context_wo_spr);
 }
 
 void ComTrackingData::UpdateJdotV(const VectorXd& x_wo_spr,
                                   const Context<double>& context_wo_spr) {
-  JdotV_ = plant_wo_spr_.CalcBiasCenterOfMassTranslationalAcceleration(
-      context_wo_spr, JacobianWrtVariable::kV, world_wo_spr_, world_wo_spr_);
+  JdotV_ =
+      cache_wo_spr_->EvalBiasCenterOfMassTranslationalAcceleration(
+          context_wo_spr);
 }
 
 void ComTrackingData::CheckDerivedOscTrackingData() {}
@@ -208,21 +248,18 @@ void TransTaskSpaceTrackingData::AddStateAndPointToTrack(
 
 void TransTaskSpaceTrackingData::UpdateYAndError(
     const VectorXd& x_w_spr, const Context<double>& context_w_spr) {
-  y_ = Vector3d::Zero();
-  plant_w_spr_.CalcPointsPositions(
-      context_w_spr, *body_frames_wo_spr_[GetStateIdx()],
-      pts_on_body_[GetStateIdx()], world_w_spr_, &y_);
+  y_ = cache_w_spr_->EvalPointPosition(context_w_spr,
+                                       *body_frames_w_spr_.at(GetStateIdx()),
+                                       pts_on_body_.at(GetStateIdx()));
   error_y_ = y_des_ - y_;
 }
 
 void TransTaskSpaceTrackingData::UpdateYdotAndError(
     const VectorXd& x_w_spr, const Context<double>& context_w_spr) {
-  MatrixXd J(kSpaceDim, plant_w_spr_.num_velocities());
-  plant_w_spr_.CalcJacobianTranslationalVelocity(
-      context_w_spr, JacobianWrtVariable::kV,
-      *body_frames_w_spr_.at(GetStateIdx()), pts_on_body_.at(GetStateIdx()),
-      world_w_spr_, world_w_spr_, &J);
-  ydot_ = J * x_w_spr.tail(plant_w_spr_.num_velocities());
+  ydot_.noalias() = cache_w_spr_->EvalJacobianTranslationalVelocity(
+                        context_w_spr, *body_frames_w_spr_.at(GetStateIdx()),
+                        pts_on_body_.at(GetStateIdx())) *
+                    x_w_spr.tail(plant_w_spr_.num_velocities());
   error_ydot_ = ydot_des_ - ydot_;
 }
 
@@ -232,19 +269,16 @@ void TransTaskSpaceTrackingData::UpdateYddotDes() {
 
 void TransTaskSpaceTrackingData::UpdateJ(
     const VectorXd& x_wo_spr, const Context<double>& context_wo_spr) {
-  J_ = MatrixXd::Zero(kSpaceDim, plant_wo_spr_.num_velocities());
-  plant_wo_spr_.CalcJacobianTranslationalVelocity(
-      context_wo_spr, JacobianWrtVariable::kV,
-      *body_frames_wo_spr_.at(GetStateIdx()), pts_on_body_.at(GetStateIdx()),
-      world_wo_spr_, world_wo_spr_, &J_);
+  J_ = cache_wo_spr_->EvalJacobianTranslationalVelocity(
+      context_wo_spr, *body_frames_wo_spr_.at(GetStateIdx()),
+      pts_on_body_.at(GetStateIdx()));
 }
 
 void TransTaskSpaceTrackingData::UpdateJdotV(
     const VectorXd& x_wo_spr, const Context<double>& context_wo_spr) {
-  JdotV_ = plant_wo_spr_.CalcBiasTranslationalAcceleration(
-      context_wo_spr, drake::multibody::JacobianWrtVariable::kV,
-      *body_frames_wo_spr_.at(GetStateIdx()), pts_on_body_.at(GetStateIdx()),
-      world_wo_spr_, world_wo_spr_);
+  JdotV_ = cache_wo_spr_->EvalBiasTranslationalAcceleration(
+      context_wo_spr, *body_frames_wo_spr_.at(GetStateIdx()),
+      pts_on_body_.at(GetStateIdx()));
 }
 
 void TransTaskSpaceTrackingData::CheckDerivedOscTrackingData() {
@@ -312,14 +346,11 @@ void RotTaskSpaceTrackingData::UpdateYAndError(
 
 void RotTaskSpaceTrackingData::UpdateYdotAndError(
     const VectorXd& x_w_spr, const Context<double>& context_w_spr) {
-  MatrixXd J_spatial(6, plant_w_spr_.num_velocities());
-  plant_w_spr_.CalcJacobianSpatialVelocity(
-      context_w_spr, JacobianWrtVariable::kV,
-      *body_frames_w_spr_.at(GetStateIdx()),
-      frame_pose_.at(GetStateIdx()).translation(), world_w_spr_, world_w_spr_,
-      &J_spatial);
-  ydot_ = J_spatial.block(0, 0, kSpaceDim, J_spatial.cols()) *
-          x_w_spr.tail(plant_w_spr_.num_velocities());
+  const MatrixXd& J_spatial = cache_w_spr_->EvalJacobianSpatialVelocity(
+      context_w_spr, *body_frames_w_spr_.at(GetStateIdx()),
+      frame_pose_.at(GetStateIdx()).translation());
+  ydot_.noalias() = J_spatial.block(0, 0, kSpaceDim, J_spatial.cols()) *
+                    x_w_spr.tail(plant_w_spr_.num_velocities());
   // Transform qdot to w
   Quaterniond y_quat_des(y_des_(0), y_des_(1), y_des_(2), y_des_(3));
   Quaterniond dy_quat_des(ydot_des_(0), ydot_des_(1), ydot_des_(2),
@@ -339,24 +370,20 @@ void RotTaskSpaceTrackingData::UpdateYddotDes() {
 
 void RotTaskSpaceTrackingData::UpdateJ(const VectorXd& x_wo_spr,
                                        const Context<double>& context_wo_spr) {
-  MatrixXd J_spatial(6, plant_wo_spr_.num_velocities());
-  plant_wo_spr_.CalcJacobianSpatialVelocity(
-      context_wo_spr, JacobianWrtVariable::kV,
-      *body_frames_wo_spr_.at(GetStateIdx()),
-      frame_pose_.at(GetStateIdx()).translation(), world_wo_spr_, world_wo_spr_,
-      &J_spatial);
+  const MatrixXd& J_spatial = cache_wo_spr_->EvalJacobianSpatialVelocity(
+      context_wo_spr, *body_frames_wo_spr_.at(GetStateIdx()),
+      frame_pose_.at(GetStateIdx()).translation());
   J_ = J_spatial.block(0, 0, kSpaceDim, J_spatial.cols());
 }
 
 void RotTaskSpaceTrackingData::UpdateJdotV(
     const VectorXd& x_wo_spr, const Context<double>& context_wo_spr) {
-  JdotV_ = plant_wo_spr_
-               .CalcBiasSpatialAcceleration(
-                   context_wo_spr, JacobianWrtVariable::kV,
-                   *body_frames_wo_spr_.at(GetStateIdx()),
-                   frame_pose_.at(GetStateIdx()).translation(), world_wo_spr_,
-                   world_wo_spr_)
-               .rotational();
+  // The rotational part comes first in the spatial acceleration
+  JdotV_ = cache_wo_spr_
+               ->EvalBiasSpatialAcceleration(
+                   context_wo_spr, *body_frames_wo_spr_.at(GetStateIdx()),
+                   frame_pose_.at(GetStateIdx()).translation())
+               .head(kSpaceDim);
 }
 
 void RotTaskSpaceTrackingData::CheckDerivedOscTrackingData() {
@@ -407,9 +434,8 @@ void JointSpaceTrackingData::UpdateYAndError(
 
 void JointSpaceTrackingData::UpdateYdotAndError(
     const VectorXd& x_w_spr, const Context<double>& context_w_spr) {
-  MatrixXd J = MatrixXd::Zero(1, plant_w_spr_.num_velocities());
-  J(0, joint_vel_idx_w_spr_.at(GetStateIdx())) = 1;
-  ydot_ = J * x_w_spr.tail(plant_w_spr_.num_velocities());
+  ydot_ = x_w_spr.tail(plant_w_spr_.num_velocities())
+              .segment(joint_vel_idx_w_spr_.at(GetStateIdx()), 1);
   error_ydot_ = ydot_des_ - ydot_;
 }
 
@@ -6,6 +6,7 @@
 #include <drake/common/trajectories/trajectory.h>
 #include <drake/multibody/plant/multibody_plant.h>
 
+#include "multibody/kinematic/kinematics_cache.h"
 #include "systems/framework/output_vector.h"
 
 namespace dairlib {
@@ -90,6 +91,14 @@ class OscTrackingData {
               const drake::systems::Context<double>& context_wo_spr,
               const drake::trajectories::Trajectory<double>& traj, double t,
               int finite_state_machine_state);
+  // Same as above, but tracks the constant desired output `y_des` (with zero
+  // velocity and acceleration). Unlike evaluating a constant trajectory, this
+  // does not allocate memory.
+  bool Update(const Eigen::VectorXd& x_w_spr,
+              const drake::systems::Context<double>& context_w_spr,
+              const Eigen::VectorXd& x_wo_spr,
+              const drake::systems::Context<double>& context_wo_spr,
+              const Eigen::VectorXd& y_des, int finite_state_machine_state);
 
   // Getters for debugging
   const Eigen::VectorXd& GetY() const { return y_; }
@@ -117,6 +126,10 @@ class OscTrackingData {
   int GetYDim() const { return n_y_; };
   int GetYdotDim() const { return n_ydot_; };
   bool IsActive() const { return track_at_current_state_; }
+  // Updates whether the tracking data is active in the finite state machine
+  // state `finite_state_machine_state`, without evaluating the kinematics.
+  // Also called by Update().
+  bool UpdateTrackingFlag(int finite_state_machine_state);
 
   void SaveYddotCommandSol(const Eigen::VectorXd& dv);
 
@@ -127,6 +140,14 @@ class OscTrackingData {
   // correctly.
   void CheckOscTrackingData();
 
+  // Set the kinematics caches of the plant with and without springs. The
+  // caches are shared by all tracking data and the contact/holonomic
+  // constraints of one OSC, so that the kinematics of a frame are computed
+  // once per control tick. Called by OperationalSpaceControl::Build().
+  void SetKinematicsCaches(
+      multibody::KinematicsCache<double>* cache_w_spr,
+      multibody::KinematicsCache<double>* cache_wo_spr);
+
  protected:
   int GetStateIdx() const { return state_idx_; };
   void AddState(int state);
@@ -165,9 +186,17 @@ class OscTrackingData {
   const drake::multibody::BodyFrame<double>& world_w_spr_;
   const drake::multibody::BodyFrame<double>& world_wo_spr_;
 
+  // Kinematics caches (valid for the contexts passed to Update())
+  multibody::KinematicsCache<double>* cache_w_spr_ = nullptr;
+  multibody::KinematicsCache<double>* cache_wo_spr_ = nullptr;
+
  private:
-  // Check if we should do tracking in the current state
-  void UpdateTrackingFlag(int finite_state_machine_state);
+  // Update feedback output and command output, once the desired output is set
+  void UpdateFeedbackAndCommand(
+      const Eigen::VectorXd& x_w_spr,
+      const drake::systems::Context<double>& context_w_spr,
+      const Eigen::VectorXd& x_wo_spr,
+      const drake::systems::Context<double>& context_wo_spr);
 
   // Updaters of feedback output, jacobian and dJ/dt * v
   virtual void UpdateYAndError(
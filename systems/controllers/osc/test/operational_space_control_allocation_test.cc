@@ -0,0 +1,305 @@
+#include <map>
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "drake/multibody/parsing/parser.h"
+#include "drake/multibody/plant/multibody_plant.h"
+#include "drake/solvers/osqp_solver.h"
+
+#include "common/allocation_counter.h"
+#include "common/find_resource.h"
+#include "examples/Cassie/cassie_utils.h"
+#include "multibody/kinematic/kinematics_cache.h"
+#include "systems/controllers/osc/operational_space_control.h"
+#include "systems/framework/output_vector.h"
+
+namespace dairlib {
+namespace systems {
+namespace controllers {
+namespace {
+
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using drake::systems::BasicVector;
+using drake::systems::Context;
+using Eigen::Matrix3d;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+
+/// Checks that, after the first tick, CalcOptimalInput does not allocate
+/// beyond what MultibodyPlant itself allocates to compute the dynamics.
+class OscAllocationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    plant_ = std::make_unique<MultibodyPlant<double>>(0.0);
+    Parser parser(plant_.get());
+    parser.AddModelFromFile(
+        FindResourceOrThrow("examples/PlanarWalker/PlanarWalker.urdf"));
+    plant_->WeldFrames(plant_->world_frame(), plant_->GetFrameByName("base"),
+                       drake::math::RigidTransform<double>());
+    plant_->Finalize();
+    plant_context_ = plant_->CreateDefaultContext();
+  }
+
+  std::unique_ptr<MultibodyPlant<double>> plant_;
+  std::unique_ptr<Context<double>> plant_context_;
+};
+
+TEST_F(OscAllocationTest, SteadyStateTick) {
+  const int n_q = plant_->num_positions();
+  const int n_v = plant_->num_velocities();
+  const int n_u = plant_->num_actuators();
+
+  // The two plants are the same, so that the baseline below evaluates the
+  // dynamics exactly as the OSC does
+  auto context_wo_spr = plant_->CreateDefaultContext();
+  OperationalSpaceControl osc(*plant_, *plant_, plant_context_.get(),
+                              context_wo_spr.get(), true);
+  osc.SetInputCost(MatrixXd::Identity(n_u, n_u));
+  osc.SetAccelerationCostForAllJoints(0.01 * MatrixXd::Identity(n_v, n_v));
+
+  JointSpaceTrackingData hip_traj("hip_traj", 100 * MatrixXd::Ones(1, 1),
+                                  10 * MatrixXd::Ones(1, 1),
+                                  MatrixXd::Ones(1, 1), *plant_, *plant_);
+  hip_traj.AddJointToTrack("hip_pin", "hip_pindot");
+  osc.AddConstTrackingData(&hip_traj, 0.3 * VectorXd::Ones(1));
+
+  // Polishing allocates inside OSQP
+  drake::solvers::SolverOptions solver_options;
+  solver_options.SetOption(drake::solvers::OsqpSolver::id(), "polish", 0);
+  osc.SetOsqpSolverOptions(solver_options);
+  osc.Build();
+
+  auto context = osc.CreateDefaultContext();
+  OutputVector<double> robot_output(n_q, n_v, n_u);
+  robot_output.SetPositions(0.1 * VectorXd::Ones(n_q));
+  robot_output.SetVelocities(0.2 * VectorXd::Ones(n_v));
+  robot_output.SetEfforts(VectorXd::Zero(n_u));
+  robot_output.set_timestamp(1);
+  osc.get_robot_output_input_port().FixValue(context.get(), robot_output);
+  osc.get_fsm_input_port().FixValue(context.get(),
+                                    BasicVector<double>(VectorXd::Zero(1)));
+
+  const auto& output_port = osc.get_osc_output_port();
+  auto output = output_port.Allocate();
+
+  // The first ticks size the buffers and the OSQP workspace
+  for (int i = 0; i < 3; i++) {
+    output_port.Calc(*context, output.get());
+  }
+
+  // Baseline: the MultibodyPlant calls of a tick
+  MatrixXd M(n_v, n_v);
+  VectorXd bias(n_v);
+  VectorXd grav(n_v);
+  AllocationCounter baseline_counter;
+  plant_->CalcMassMatrixViaInverseDynamics(*context_wo_spr, &M);
+  plant_->CalcBiasTerm(*context_wo_spr, &bias);
+  grav = plant_->CalcGravityGeneralizedForces(*context_wo_spr);
+  const int64_t num_baseline_allocations = baseline_counter.num_allocations();
+
+  AllocationCounter counter;
+  output_port.Calc(*context, output.get());
+  EXPECT_LE(counter.num_allocations(), num_baseline_allocations);
+}
+
+/// Same check for a floating-base Cassie with contacts switched by the finite
+/// state machine, loop-closure constraints, and task-space tracking data. The
+/// baseline are the MultibodyPlant calls the OSC makes through its
+/// KinematicsCache, replayed through a separate cache.
+TEST(OscFloatingBaseAllocationTest, SteadyStateTicksWithFsmSwitches) {
+  MultibodyPlant<double> plant(0.0);
+  addCassieMultibody(&plant, nullptr, true,
+                     "examples/Cassie/urdf/cassie_fixed_springs.urdf", false,
+                     false);
+  plant.Finalize();
+  const int n_q = plant.num_positions();
+  const int n_v = plant.num_velocities();
+  const int n_u = plant.num_actuators();
+  auto context_w_spr = plant.CreateDefaultContext();
+  auto context_wo_spr = plant.CreateDefaultContext();
+
+  OperationalSpaceControl osc(plant, plant, context_w_spr.get(),
+                              context_wo_spr.get(), true);
+  osc.SetInputCost(0.001 * MatrixXd::Identity(n_u, n_u));
+  osc.SetAccelerationCostForAllJoints(MatrixXd::Identity(n_v, n_v));
+
+  // Loop closures
+  multibody::KinematicEvaluatorSet<double> evaluators(plant);
+  auto left_loop = LeftLoopClosureEvaluator(plant);
+  auto right_loop = RightLoopClosureEvaluator(plant);
+  evaluators.add_evaluator(&left_loop);
+  evaluators.add_evaluator(&right_loop);
+  osc.AddKinematicConstraint(&evaluators);
+
+  // Contacts: left stance, right stance and double support
+  const int left_stance = 0;
+  const int right_stance = 1;
+  const int double_support = 2;
+  osc.SetWeightOfSoftContactConstraint(2000);
+  osc.SetContactFriction(0.4);
+  auto left_toe = LeftToeFront(plant);
+  auto left_heel = LeftToeRear(plant);
+  auto right_toe = RightToeFront(plant);
+  auto right_heel = RightToeRear(plant);
+  multibody::WorldPointEvaluator<double> left_toe_evaluator(
+      plant, left_toe.first, left_toe.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {1, 2});
+  multibody::WorldPointEvaluator<double> left_heel_evaluator(
+      plant, left_heel.first, left_heel.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {0, 1, 2});
+  multibody::WorldPointEvaluator<double> right_toe_evaluator(
+      plant, right_toe.first, right_toe.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {1, 2});
+  multibody::WorldPointEvaluator<double> right_heel_evaluator(
+      plant, right_heel.first, right_heel.second, Matrix3d::Identity(),
+      Vector3d::Zero(), {0, 1, 2});
+  for (int state : {left_stance, double_support}) {
+    osc.AddStateAndContactPoint(state, &left_toe_evaluator);
+    osc.AddStateAndContactPoint(state, &left_heel_evaluator);
+  }
+  for (int state : {right_stance, double_support}) {
+    osc.AddStateAndContactPoint(state, &right_toe_evaluator);
+    osc.AddStateAndContactPoint(state, &right_heel_evaluator);
+  }
+
+  // Swing foot (translational, only in single support) and pelvis
+  // (rotational) tracking
+  TransTaskSpaceTrackingData swing_foot_traj(
+      "swing_foot_traj", 100 * Matrix3d::Identity(), 10 * Matrix3d::Identity(),
+      400 * Matrix3d::Identity(), plant, plant);
+  swing_foot_traj.AddStateAndPointToTrack(left_stance, "toe_right");
+  swing_foot_traj.AddStateAndPointToTrack(right_stance, "toe_left");
+  osc.AddConstTrackingData(&swing_foot_traj, Vector3d(0.1, -0.1, 0.1));
+  RotTaskSpaceTrackingData pelvis_rot_traj(
+      "pelvis_rot_traj", 200 * Matrix3d::Identity(), 80 * Matrix3d::Identity(),
+      200 * Matrix3d::Identity(), plant, plant);
+  pelvis_rot_traj.AddFrameToTrack("pelvis");
+  osc.AddConstTrackingData(&pelvis_rot_traj, Eigen::Vector4d(1, 0, 0, 0));
+
+  // Polishing allocates inside OSQP
+  drake::solvers::SolverOptions solver_options;
+  solver_options.SetOption(drake::solvers::OsqpSolver::id(), "polish", 0);
+  osc.SetOsqpSolverOptions(solver_options);
+  osc.Build();
+
+  auto context = osc.CreateDefaultContext();
+  const auto& output_port = osc.get_osc_output_port();
+  auto output = output_port.Allocate();
+  OutputVector<double> robot_output(n_q, n_v, n_u);
+  robot_output.SetEfforts(VectorXd::Zero(n_u));
+  robot_output.set_timestamp(1);
+  // Standing pelvis with the joints perturbed by `s`
+  auto state = [n_q, n_v](double s) {
+    VectorXd x = VectorXd::Zero(n_q + n_v);
+    x(0) = 1;
+    x(6) = 1;
+    x.segment(7, n_q - 7).setConstant(s);
+    x.tail(n_v).setConstant(0.1 * s);
+    return x;
+  };
+  auto set_inputs = [&](int fsm_state, double s) {
+    robot_output.SetState(state(s));
+    osc.get_robot_output_input_port().FixValue(context.get(), robot_output);
+    osc.get_fsm_input_port().FixValue(
+        context.get(), BasicVector<double>(fsm_state * VectorXd::Ones(1)));
+  };
+
+  // Baseline: the MultibodyPlant calls of a tick in `fsm_state`, through a
+  // separate cache on separate contexts
+  auto baseline_context_w_spr = plant.CreateDefaultContext();
+  auto baseline_context_wo_spr = plant.CreateDefaultContext();
+  multibody::KinematicsCache<double> baseline_cache_w_spr(plant);
+  multibody::KinematicsCache<double> baseline_cache_wo_spr(plant);
+  MatrixXd M(n_v, n_v);
+  VectorXd bias(n_v);
+  VectorXd grav(n_v);
+  MatrixXd J_h(evaluators.count_full(), n_v);
+  VectorXd JdotV_h(evaluators.count_full());
+  MatrixXd J_c(3, n_v);
+  VectorXd JdotV_c(3);
+  using ContactList =
+      std::vector<const multibody::WorldPointEvaluator<double>*>;
+  const std::map<int, ContactList> contacts = {
+      {left_stance, {&left_toe_evaluator, &left_heel_evaluator}},
+      {right_stance, {&right_toe_evaluator, &right_heel_evaluator}},
+      {double_support,
+       {&left_toe_evaluator, &left_heel_evaluator, &right_toe_evaluator,
+        &right_heel_evaluator}}};
+  const auto& toe_left_frame = plant.GetBodyByName("toe_left").body_frame();
+  const auto& toe_right_frame = plant.GetBodyByName("toe_right").body_frame();
+  const auto& pelvis = plant.GetBodyByName("pelvis");
+  auto count_baseline_allocations = [&](int fsm_state, double s) {
+    plant.SetPositionsAndVelocities(baseline_context_w_spr.get(), state(s));
+    plant.SetPositionsAndVelocities(baseline_context_wo_spr.get(), state(s));
+    baseline_cache_w_spr.Clear();
+    baseline_cache_wo_spr.Clear();
+    const auto& cw = *baseline_context_w_spr;
+    const auto& cwo = *baseline_context_wo_spr;
+
+    AllocationCounter counter;
+    plant.CalcMassMatrixViaInverseDynamics(cwo, &M);
+    plant.CalcBiasTerm(cwo, &bias);
+    grav = plant.CalcGravityGeneralizedForces(cwo);
+    evaluators.EvalFullJacobian(cwo, &baseline_cache_wo_spr, &J_h);
+    evaluators.EvalFullJacobianDotTimesV(cwo, &baseline_cache_wo_spr,
+                                         &JdotV_h);
+    for (const auto* contact : contacts.at(fsm_state)) {
+      contact->EvalFullJacobian(cwo, &baseline_cache_wo_spr, &J_c);
+      contact->EvalFullJacobianDotTimesV(cwo, &baseline_cache_wo_spr,
+                                         &JdotV_c);
+    }
+    if (fsm_state != double_support) {
+      const auto& foot =
+          (fsm_state == left_stance) ? toe_right_frame : toe_left_frame;
+      baseline_cache_w_spr.EvalPointPosition(cw, foot, Vector3d::Zero());
+      baseline_cache_w_spr.EvalJacobianTranslationalVelocity(cw, foot,
+                                                             Vector3d::Zero());
+      baseline_cache_wo_spr.EvalJacobianTranslationalVelocity(
+          cwo, foot, Vector3d::Zero());
+      baseline_cache_wo_spr.EvalBiasTranslationalAcceleration(
+          cwo, foot, Vector3d::Zero());
+    }
+    plant.EvalBodyPoseInWorld(cw, pelvis);
+    baseline_cache_w_spr.EvalJacobianSpatialVelocity(cw, pelvis.body_frame(),
+                                                     Vector3d::Zero());
+    baseline_cache_wo_spr.EvalJacobianSpatialVelocity(
+        cwo, pelvis.body_frame(), Vector3d::Zero());
+    baseline_cache_wo_spr.EvalBiasSpatialAcceleration(
+        cwo, pelvis.body_frame(), Vector3d::Zero());
+    return counter.num_allocations();
+  };
+
+  // The first ticks of each fsm state size the buffers, the caches and the
+  // OSQP workspace
+  const std::vector<int> fsm_sequence = {left_stance, double_support,
+                                         right_stance, double_support};
+  double s = 0.01;
+  for (int i = 0; i < 2; i++) {
+    for (int fsm_state : fsm_sequence) {
+      set_inputs(fsm_state, s);
+      output_port.Calc(*context, output.get());
+      count_baseline_allocations(fsm_state, s);
+      s += 0.01;
+    }
+  }
+
+  // Steady state, including the ticks where the fsm state switches
+  for (int fsm_state : fsm_sequence) {
+    set_inputs(fsm_state, s);
+    const int64_t num_baseline_allocations =
+        count_baseline_allocations(fsm_state, s);
+    AllocationCounter counter;
+    output_port.Calc(*context, output.get());
+    EXPECT_LE(counter.num_allocations(), num_baseline_allocations)
+        << "fsm state " << fsm_state;
+    s += 0.01;
+  }
+}
+
+}  // namespace
+}  // namespace controllers
+}  // namespace systems
+}  // namespace dairlib
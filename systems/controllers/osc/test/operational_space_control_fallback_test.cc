@@ -0,0 +1,145 @@
+#include <memory>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/multibody/parsing/parser.h"
+#include "drake/multibody/plant/multibody_plant.h"
+#include "drake/solvers/osqp_solver.h"
+
+#include "common/find_resource.h"
+#include "dairlib/lcmt_osc_output.hpp"
+#include "systems/controllers/osc/operational_space_control.h"
+#include "systems/framework/output_vector.h"
+
+namespace dairlib {
+namespace systems {
+namespace controllers {
+namespace {
+
+using drake::CompareMatrices;
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using drake::systems::BasicVector;
+using drake::systems::Context;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+/// Forces the OSC QP to fail (OSQP stops after one iteration with
+/// unreachable tolerances) and checks the fallback policies.
+class OscFallbackTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    plant_ = std::make_unique<MultibodyPlant<double>>(0.0);
+    Parser parser(plant_.get());
+    parser.AddModelFromFile(
+        FindResourceOrThrow("examples/PlanarWalker/PlanarWalker.urdf"));
+    plant_->WeldFrames(plant_->world_frame(), plant_->GetFrameByName("base"),
+                       drake::math::RigidTransform<double>());
+    plant_->Finalize();
+    context_w_spr_ = plant_->CreateDefaultContext();
+    context_wo_spr_ = plant_->CreateDefaultContext();
+
+    const int n_v = plant_->num_velocities();
+    const int n_u = plant_->num_actuators();
+    osc_ = std::make_unique<OperationalSpaceControl>(
+        *plant_, *plant_, context_w_spr_.get(), context_wo_spr_.get(), true);
+    osc_->SetInputCost(MatrixXd::Identity(n_u, n_u));
+    osc_->SetAccelerationCostForAllJoints(0.01 * MatrixXd::Identity(n_v, n_v));
+    hip_traj_ = std::make_unique<JointSpaceTrackingData>(
+        "hip_traj", 100 * MatrixXd::Ones(1, 1), 10 * MatrixXd::Ones(1, 1),
+        MatrixXd::Ones(1, 1), *plant_, *plant_);
+    hip_traj_->AddJointToTrack("hip_pin", "hip_pindot");
+    osc_->AddConstTrackingData(hip_traj_.get(), 0.3 * VectorXd::Ones(1));
+  }
+
+  void Build(QpFallback fallback) {
+    drake::solvers::SolverOptions solver_options;
+    solver_options.SetOption(drake::solvers::OsqpSolver::id(), "max_iter", 1);
+    solver_options.SetOption(drake::solvers::OsqpSolver::id(), "eps_abs",
+                             1e-12);
+    solver_options.SetOption(drake::solvers::OsqpSolver::id(), "eps_rel",
+                             1e-12);
+    osc_->SetOsqpSolverOptions(solver_options);
+    osc_->SetQpFallback(fallback);
+    osc_->Build();
+
+    context_ = osc_->CreateDefaultContext();
+    osc_->get_fsm_input_port().FixValue(context_.get(),
+                                        BasicVector<double>(VectorXd::Zero(1)));
+    output_ = osc_->get_osc_output_port().Allocate();
+    debug_output_ = osc_->get_osc_debug_port().Allocate();
+  }
+
+  // Runs one tick at the given joint positions and returns the input
+  VectorXd Tick(double q) {
+    const int n_q = plant_->num_positions();
+    const int n_v = plant_->num_velocities();
+    const int n_u = plant_->num_actuators();
+    OutputVector<double> robot_output(n_q, n_v, n_u);
+    robot_output.SetPositions(q * VectorXd::Ones(n_q));
+    robot_output.SetVelocities(0.2 * VectorXd::Ones(n_v));
+    robot_output.SetEfforts(VectorXd::Zero(n_u));
+    robot_output.set_timestamp(1);
+    osc_->get_robot_output_input_port().FixValue(context_.get(), robot_output);
+    osc_->get_osc_output_port().Calc(*context_, output_.get());
+    osc_->get_osc_debug_port().Calc(*context_, debug_output_.get());
+    return static_cast<const TimestampedVector<double>&>(
+               output_->get_value<BasicVector<double>>())
+        .get_data();
+  }
+
+  const lcmt_osc_output& debug() const {
+    return debug_output_->get_value<lcmt_osc_output>();
+  }
+
+  std::unique_ptr<MultibodyPlant<double>> plant_;
+  std::unique_ptr<Context<double>> context_w_spr_;
+  std::unique_ptr<Context<double>> context_wo_spr_;
+  std::unique_ptr<JointSpaceTrackingData> hip_traj_;
+  std::unique_ptr<OperationalSpaceControl> osc_;
+  std::unique_ptr<Context<double>> context_;
+  std::unique_ptr<drake::AbstractValue> output_;
+  std::unique_ptr<drake::AbstractValue> debug_output_;
+};
+
+TEST_F(OscFallbackTest, FailuresAreCounted) {
+  Build(QpFallback::kNone);
+  for (int i = 1; i <= 3; i++) {
+    Tick(0.1 * i);
+    EXPECT_TRUE(debug().qp_failed);
+    EXPECT_EQ(debug().num_qp_failures, i);
+    EXPECT_FALSE(debug().qp_budget_overrun);
+    EXPECT_EQ(debug().num_qp_budget_overruns, 0);
+  }
+}
+
+TEST_F(OscFallbackTest, PreviousInputIsHeld) {
+  Build(QpFallback::kNone);
+  const VectorXd u_prev = Tick(0.1);
+  ASSERT_TRUE(debug().qp_failed);
+  EXPECT_FALSE(u_prev.isZero());
+
+  // The state changes, but the input of the previous tick is held
+  osc_->SetQpFallback(QpFallback::kPreviousInput);
+  EXPECT_TRUE(CompareMatrices(Tick(0.5), u_prev));
+  EXPECT_TRUE(CompareMatrices(Tick(-0.3), u_prev));
+  EXPECT_EQ(debug().num_qp_failures, 3);
+}
+
+TEST_F(OscFallbackTest, LeastSquares) {
+  // Effort limits of the PlanarWalker actuators
+  const double u_max = 100;
+  Build(QpFallback::kLeastSquares);
+  for (double q : {0.1, 0.5, -0.3}) {
+    const VectorXd u = Tick(q);
+    EXPECT_TRUE(debug().qp_failed);
+    EXPECT_TRUE(u.allFinite());
+    // The least-squares solution is clamped to the input limits
+    EXPECT_LE(u.lpNorm<Eigen::Infinity>(), u_max);
+  }
+}
+
+}  // namespace
+}  // namespace controllers
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,112 @@
+#include <cmath>
+#include <memory>
+#include <gtest/gtest.h>
+
+#include "drake/multibody/parsing/parser.h"
+#include "drake/multibody/plant/multibody_plant.h"
+
+#include "common/find_resource.h"
+#include "systems/controllers/osc/osc_batch_evaluator.h"
+
+namespace dairlib {
+namespace systems {
+namespace controllers {
+namespace {
+
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+using Eigen::VectorXi;
+
+class OscBatchEvaluatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    plant_ = std::make_unique<MultibodyPlant<double>>(0.0);
+    Parser parser(plant_.get());
+    parser.AddModelFromFile(
+        FindResourceOrThrow("examples/PlanarWalker/PlanarWalker.urdf"));
+    plant_->WeldFrames(plant_->world_frame(), plant_->GetFrameByName("base"),
+                       drake::math::RigidTransform<double>());
+    plant_->Finalize();
+  }
+
+  // Creates an OSC tracking a constant hip angle, with its own contexts and
+  // tracking data
+  std::unique_ptr<OscBatchEvaluator::Worker> CreateWorker() const {
+    const int n_v = plant_->num_velocities();
+    const int n_u = plant_->num_actuators();
+    auto worker = std::make_unique<OscBatchEvaluator::Worker>();
+    auto context_w_spr = worker->Own(plant_->CreateDefaultContext());
+    auto context_wo_spr = worker->Own(plant_->CreateDefaultContext());
+    worker->osc = std::make_unique<OperationalSpaceControl>(
+        *plant_, *plant_, context_w_spr, context_wo_spr, true);
+    worker->osc->SetInputCost(MatrixXd::Identity(n_u, n_u));
+    worker->osc->SetAccelerationCostForAllJoints(
+        0.01 * MatrixXd::Identity(n_v, n_v));
+
+    auto hip_traj = worker->Own(std::make_unique<JointSpaceTrackingData>(
+        "hip_traj", 100 * MatrixXd::Ones(1, 1), 10 * MatrixXd::Ones(1, 1),
+        MatrixXd::Ones(1, 1), *plant_, *plant_));
+    hip_traj->AddJointToTrack("hip_pin", "hip_pindot");
+    worker->osc->AddConstTrackingData(hip_traj, 0.3 * VectorXd::Ones(1));
+    worker->osc->Build();
+    worker->context = worker->osc->CreateDefaultContext();
+    return worker;
+  }
+
+  std::unique_ptr<MultibodyPlant<double>> plant_;
+};
+
+TEST_F(OscBatchEvaluatorTest, TimeSinceLastStateSwitch) {
+  VectorXi fsm_states(5);
+  fsm_states << 0, 0, 1, 1, 0;
+  VectorXd timestamps(5);
+  timestamps << 1, 2, 3, 4, 5;
+  VectorXd expected(5);
+  expected << 0, 1, 0, 1, 0;
+  EXPECT_TRUE(OscBatchEvaluator::CalcTimeSinceLastStateSwitch(fsm_states,
+                                                              timestamps)
+                  .isApprox(expected));
+}
+
+TEST_F(OscBatchEvaluatorTest, ParallelMatchesSerial) {
+  const int n_x = plant_->num_positions() + plant_->num_velocities();
+  const int n_samples = 20;
+  MatrixXd states(n_x, n_samples);
+  VectorXi fsm_states(n_samples);
+  VectorXd timestamps(n_samples);
+  for (int i = 0; i < n_samples; i++) {
+    states.col(i) = 0.1 * std::sin(0.3 * i) * VectorXd::Ones(n_x);
+    fsm_states(i) = (i / 5) % 2;
+    timestamps(i) = 0.01 * i;
+  }
+
+  auto factory = [this]() { return CreateWorker(); };
+  OscBatchEvaluator serial(factory, 1);
+  OscBatchEvaluator parallel(factory, 3);
+  MatrixXd u_serial = serial.Evaluate(states, fsm_states, timestamps);
+  MatrixXd u_parallel = parallel.Evaluate(states, fsm_states, timestamps);
+
+  EXPECT_EQ(u_serial.rows(), plant_->num_actuators());
+  EXPECT_EQ(u_serial.cols(), n_samples);
+  // Chunks are warm-started differently, so the inputs only match up to the
+  // QP tolerance
+  EXPECT_TRUE(u_parallel.isApprox(u_serial, 1e-3));
+
+  // Each sample is also solved independently of the batch
+  auto worker = CreateWorker();
+  VectorXd time_since_switch =
+      OscBatchEvaluator::CalcTimeSinceLastStateSwitch(fsm_states, timestamps);
+  for (int i = 0; i < n_samples; i++) {
+    const VectorXd& u = worker->osc->SolveRecordedSample(
+        *worker->context, states.col(i), timestamps(i), fsm_states(i),
+        time_since_switch(i));
+    EXPECT_TRUE(u.isApprox(u_serial.col(i), 1e-6));
+  }
+}
+
+}  // namespace
+}  // namespace controllers
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "systems/controllers/osc/osc_timing_stats.h"
+
+namespace dairlib {
+namespace systems {
+namespace controllers {
+namespace {
+
+TEST(OscTimingStatsTest, EmptyWindow) {
+  OscTimingStats stats({"a", "b"}, 4);
+  EXPECT_EQ(stats.num_stages(), 2);
+  EXPECT_EQ(stats.stage_name(1), "b");
+  EXPECT_EQ(stats.num_samples(), 0);
+  EXPECT_EQ(stats.Last(0), 0);
+  EXPECT_EQ(stats.Percentile(0, 50), 0);
+  EXPECT_EQ(stats.Max(0), 0);
+}
+
+TEST(OscTimingStatsTest, TocAccumulatesWithinATick) {
+  OscTimingStats stats({"a", "b"}, 4);
+  auto start = OscTimingStats::Clock::now();
+  auto t = stats.Toc(0, start);
+  EXPECT_GE(t, start);
+  // Recording the same stage twice in a tick sums the durations
+  stats.Record(1, 2.0);
+  stats.Record(1, 3.0);
+  stats.EndTick();
+  EXPECT_EQ(stats.num_samples(), 1);
+  EXPECT_GE(stats.Last(0), 0);
+  EXPECT_EQ(stats.Last(1), 5.0);
+
+  // Stages which are not recorded in a tick get a zero sample
+  stats.Record(0, 1.0);
+  stats.EndTick();
+  EXPECT_EQ(stats.Last(0), 1.0);
+  EXPECT_EQ(stats.Last(1), 0.0);
+}
+
+TEST(OscTimingStatsTest, RingWrapAround) {
+  OscTimingStats stats({"a"}, 4);
+  for (int i = 1; i <= 6; i++) {
+    stats.Record(0, i);
+    stats.EndTick();
+  }
+  // Only the last four ticks (3, 4, 5, 6) are kept
+  EXPECT_EQ(stats.num_samples(), 4);
+  EXPECT_EQ(stats.Last(0), 6);
+  EXPECT_EQ(stats.Max(0), 6);
+  EXPECT_EQ(stats.Percentile(0, 0), 3);
+  EXPECT_EQ(stats.Percentile(0, 100), 6);
+
+  // Overwriting the maximum drops it from the statistics
+  OscTimingStats peak({"a"}, 3);
+  for (double sample : {10.0, 1.0, 2.0, 3.0}) {
+    peak.Record(0, sample);
+    peak.EndTick();
+  }
+  EXPECT_EQ(peak.Max(0), 3);
+}
+
+TEST(OscTimingStatsTest, Percentile) {
+  OscTimingStats stats({"a", "b"}, 200);
+  // Stage a gets 1, ..., 100 in shuffled order, stage b is constant
+  for (int i = 0; i < 100; i++) {
+    stats.Record(0, (i * 37) % 100 + 1);
+    stats.Record(1, 7);
+    stats.EndTick();
+  }
+  EXPECT_EQ(stats.num_samples(), 100);
+  EXPECT_EQ(stats.Percentile(0, 0), 1);
+  EXPECT_EQ(stats.Percentile(0, 1), 1);
+  EXPECT_EQ(stats.Percentile(0, 50), 50);
+  EXPECT_EQ(stats.Percentile(0, 99), 99);
+  EXPECT_EQ(stats.Percentile(0, 100), 100);
+  EXPECT_EQ(stats.Max(0), 100);
+  EXPECT_EQ(stats.Percentile(1, 50), 7);
+  // Querying does not modify the recorded samples
+  EXPECT_EQ(stats.Percentile(0, 50), 50);
+  EXPECT_EQ(stats.Last(0), (99 * 37) % 100 + 1);
+}
+
+}  // namespace
+}  // namespace controllers
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,109 @@
+#include <memory>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/multibody/parsing/parser.h"
+#include "drake/multibody/plant/multibody_plant.h"
+
+#include "common/find_resource.h"
+#include "multibody/kinematic/kinematics_cache.h"
+#include "systems/controllers/osc/osc_tracking_data.h"
+
+namespace dairlib {
+namespace systems {
+namespace controllers {
+namespace {
+
+using drake::CompareMatrices;
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using drake::multibody::SpatialInertia;
+using drake::multibody::UnitInertia;
+using drake::systems::Context;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+using multibody::KinematicsCache;
+
+void AddPlanarWalker(MultibodyPlant<double>* plant) {
+  Parser parser(plant);
+  parser.AddModelFromFile(
+      FindResourceOrThrow("examples/PlanarWalker/PlanarWalker.urdf"));
+  plant->WeldFrames(plant->world_frame(), plant->GetFrameByName("base"),
+                    drake::math::RigidTransform<double>());
+}
+
+/// The "plant with springs" of this test has an extra (welded) body, so that
+/// the frames of the two plants have different indices, as they do for Cassie
+/// with and without springs. Each plant must then be evaluated with its own
+/// frames.
+class OscTrackingDataTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const auto& dummy = plant_w_spr_.AddRigidBody(
+        "dummy", SpatialInertia<double>(1, Vector3d::Zero(),
+                                        UnitInertia<double>(1, 1, 1)));
+    plant_w_spr_.WeldFrames(plant_w_spr_.world_frame(), dummy.body_frame(),
+                            drake::math::RigidTransform<double>());
+    AddPlanarWalker(&plant_w_spr_);
+    plant_w_spr_.Finalize();
+    AddPlanarWalker(&plant_wo_spr_);
+    plant_wo_spr_.Finalize();
+    ASSERT_NE(plant_w_spr_.GetFrameByName("left_lower_leg").index(),
+              plant_wo_spr_.GetFrameByName("left_lower_leg").index());
+
+    context_w_spr_ = plant_w_spr_.CreateDefaultContext();
+    context_wo_spr_ = plant_wo_spr_.CreateDefaultContext();
+    const int n_x =
+        plant_w_spr_.num_positions() + plant_w_spr_.num_velocities();
+    x_ = VectorXd::LinSpaced(n_x, -0.8, 0.9);
+    plant_w_spr_.SetPositionsAndVelocities(context_w_spr_.get(), x_);
+    plant_wo_spr_.SetPositionsAndVelocities(context_wo_spr_.get(), x_);
+  }
+
+  MultibodyPlant<double> plant_w_spr_{0.0};
+  MultibodyPlant<double> plant_wo_spr_{0.0};
+  std::unique_ptr<Context<double>> context_w_spr_;
+  std::unique_ptr<Context<double>> context_wo_spr_;
+  VectorXd x_;
+};
+
+TEST_F(OscTrackingDataTest, TransTaskSpaceUsesTheFramesOfEachPlant) {
+  const Vector3d pt(0, 0, -0.5);
+  TransTaskSpaceTrackingData foot_traj(
+      "foot_traj", MatrixXd::Identity(3, 3), MatrixXd::Identity(3, 3),
+      MatrixXd::Identity(3, 3), plant_w_spr_, plant_wo_spr_);
+  foot_traj.AddPointToTrack("left_lower_leg", pt);
+  KinematicsCache<double> cache_w_spr(plant_w_spr_);
+  KinematicsCache<double> cache_wo_spr(plant_wo_spr_);
+  foot_traj.SetKinematicsCaches(&cache_w_spr, &cache_wo_spr);
+  ASSERT_TRUE(foot_traj.Update(x_, *context_w_spr_, x_, *context_wo_spr_,
+                               VectorXd::Zero(3), 0));
+
+  // y and ydot come from the plant with springs
+  const auto& frame_w_spr = plant_w_spr_.GetFrameByName("left_lower_leg");
+  Vector3d y;
+  plant_w_spr_.CalcPointsPositions(*context_w_spr_, frame_w_spr, pt,
+                                   plant_w_spr_.world_frame(), &y);
+  EXPECT_TRUE(CompareMatrices(foot_traj.GetY(), y, 1e-12));
+  MatrixXd J_w_spr(3, plant_w_spr_.num_velocities());
+  plant_w_spr_.CalcJacobianTranslationalVelocity(
+      *context_w_spr_, drake::multibody::JacobianWrtVariable::kV, frame_w_spr,
+      pt, plant_w_spr_.world_frame(), plant_w_spr_.world_frame(), &J_w_spr);
+  EXPECT_TRUE(CompareMatrices(
+      foot_traj.GetYdot(),
+      J_w_spr * x_.tail(plant_w_spr_.num_velocities()), 1e-12));
+
+  // J comes from the plant without springs
+  MatrixXd J_wo_spr(3, plant_wo_spr_.num_velocities());
+  plant_wo_spr_.CalcJacobianTranslationalVelocity(
+      *context_wo_spr_, drake::multibody::JacobianWrtVariable::kV,
+      plant_wo_spr_.GetFrameByName("left_lower_leg"), pt,
+      plant_wo_spr_.world_frame(), plant_wo_spr_.world_frame(), &J_wo_spr);
+  EXPECT_TRUE(CompareMatrices(foot_traj.GetJ(), J_wo_spr, 1e-12));
+}
+
+}  // namespace
+}  // namespace controllers
+}  // namespace systems
+}  // namespace dairlib
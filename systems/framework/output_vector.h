@@ -94,6 +94,13 @@ public:
       num_positions_ + num_velocities_);
   }
 
+  /// Returns a const reference to the state, without the copy made by
+  /// GetState(). The reference is invalidated if this vector is destroyed.
+  Eigen::Ref<const VectorX<T>> GetStateRef() const {
+    return this->get_value().segment(position_start_,
+                                     num_positions_ + num_velocities_);
+  }
+
   /// Returns a const positions vector
   const VectorX<T> GetPositions() const {
     return this->get_data().segment(position_start_, num_positions_);
@@ -1,7 +1,10 @@
 #include "systems/trajectory_optimization/dircon/dircon.h"
 
+#include <algorithm>
+
 #include "multibody/kinematic/kinematic_constraints.h"
 #include "multibody/multibody_utils.h"
+#include "solvers/batched_constraint.h"
 #include "systems/trajectory_optimization/dircon/dircon_opt_constraints.h"
 
 namespace dairlib {
@@ -10,6 +13,8 @@ namespace trajectory_optimization {
 
 using drake::VectorX;
 using drake::multibody::MultibodyPlant;
+using drake::solvers::Binding;
+using drake::solvers::Constraint;
 using drake::solvers::MathematicalProgramResult;
 using drake::solvers::VectorXDecisionVariable;
 using drake::symbolic::Expression;
@@ -23,22 +28,50 @@ using multibody::KinematicAccelerationConstraint;
 using multibody::KinematicPositionConstraint;
 using multibody::KinematicVelocityConstraint;
 
+namespace {
+
+// The dynamics of a mode at (x, u, lambda), evaluated in T
 template <typename T>
-Dircon<T>::Dircon(const DirconModeSequence<T>& mode_sequence)
+VectorXd CalcTimeDerivatives(const DirconMode<T>& mode, const VectorXd& x,
+                             const VectorXd& u, const VectorXd& lambda) {
+  const VectorX<T> x_t = x.cast<T>();
+  const VectorX<T> u_t = u.cast<T>();
+  auto context = multibody::createContext<T>(mode.plant(), x_t, u_t);
+  return drake::math::DiscardGradient(
+      mode.evaluators().CalcTimeDerivativesWithForce(context.get(),
+                                                     lambda.cast<T>()));
+}
+
+// A trajectory through the columns of samples at the given times: a first
+// order hold, or a constant if there is a single sample
+PiecewisePolynomial<double> Resample(const VectorXd& times,
+                                     const MatrixXd& samples) {
+  if (samples.cols() == 1) {
+    return PiecewisePolynomial<double>(samples);
+  }
+  return PiecewisePolynomial<double>::FirstOrderHold(times, samples);
+}
+
+}  // namespace
+
+template <typename T>
+Dircon<T>::Dircon(const DirconModeSequence<T>& mode_sequence,
+                  const DirconEvaluationOptions& options)
     : Dircon<T>({}, &mode_sequence, mode_sequence.plant(),
-                mode_sequence.count_knotpoints()) {}
+                mode_sequence.count_knotpoints(), options) {}
 
 template <typename T>
-Dircon<T>::Dircon(DirconMode<T>* mode)
+Dircon<T>::Dircon(DirconMode<T>* mode, const DirconEvaluationOptions& options)
     : Dircon<T>(std::make_unique<DirconModeSequence<T>>(mode), nullptr,
-                mode->plant(), mode->num_knotpoints()) {}
+                mode->plant(), mode->num_knotpoints(), options) {}
 
 /// Private constructor. Determines which DirconModeSequence was provided,
 /// a locally owned unique_ptr or an externally owned const reference
 template <typename T>
 Dircon<T>::Dircon(std::unique_ptr<DirconModeSequence<T>> my_sequence,
                   const DirconModeSequence<T>* ext_sequence,
-                  const MultibodyPlant<T>& plant, int num_knotpoints)
+                  const MultibodyPlant<T>& plant, int num_knotpoints,
+                  const DirconEvaluationOptions& options)
     : drake::systems::trajectory_optimization::MultipleShooting(
           plant.num_actuators(), plant.num_positions() + plant.num_velocities(),
           num_knotpoints, 1e-8, 1e8),
@@ -47,6 +80,7 @@ Dircon<T>::Dircon(std::unique_ptr<DirconModeSequence<T>> my_sequence,
       mode_sequence_(ext_sequence ? *ext_sequence : *my_sequence_),
       contexts_(num_modes()),
       mode_start_(num_modes()) {
+  DRAKE_DEMAND(options.num_threads >= 1);
   // Loop over all modes
   for (int i_mode = 0; i_mode < num_modes(); i_mode++) {
     const auto& mode = get_mode(i_mode);
@@ -134,27 +168,16 @@ Dircon<T>::Dircon(std::unique_ptr<DirconModeSequence<T>> my_sequence,
     // Create and add collocation constraints
     //
 
-    // Want to set cache_size > number of decision variables. While we have not
-    // declared every decision variable yet (see impulse variables below), the
-    // impulse variables do not enter into any dynamics evaluations, so we are
-    // safe. Add a small factor (10%) just for safety margin.
-    int cache_size = 1.1 * num_vars();
-    cache_.push_back(
-        std::make_unique<DynamicsCache<T>>(mode.evaluators(), cache_size));
-    for (int j = 0; j < mode.num_knotpoints() - 1; j++) {
-      auto constraint = std::make_shared<DirconCollocationConstraint<T>>(
-          plant_, mode.evaluators(), contexts_[i_mode].at(j).get(),
-          contexts_[i_mode].at(j + 1).get(), i_mode, j, cache_[i_mode].get());
-      constraint->SetConstraintScaling(mode.GetDynamicsScale());
-      AddConstraint(
-          constraint,
-          {timestep(mode_start_[i_mode] + j), state_vars(i_mode, j),
-           state_vars(i_mode, j + 1), input_vars(i_mode, j),
-           input_vars(i_mode, j + 1), force_vars(i_mode, j),
-           force_vars(i_mode, j + 1), collocation_force_vars(i_mode, j),
-           collocation_slack_vars(i_mode, j),
-           quaternion_slack_vars(i_mode, j)});
+    // The cache is bounded by memory rather than by a number of entries, see
+    // DirconEvaluationOptions::dynamics_cache_bytes
+    cache_.push_back(std::make_unique<DynamicsCache<T>>(
+        mode.evaluators(), options.dynamics_cache_bytes));
+    knot_dynamics_.emplace_back();
+    if (options.share_knot_dynamics) {
+      knot_dynamics_.back() = std::make_unique<KnotDynamics<T>>(
+          mode.evaluators(), mode.num_knotpoints());
     }
+    AddCollocationConstraints(i_mode, options);
 
     //
     // Create and add kinematic constraints
@@ -216,6 +239,12 @@ Dircon<T>::Dircon(std::unique_ptr<DirconModeSequence<T>> my_sequence,
               std::to_string(j) + "]",
           cache_[i_mode].get());
       accel_constraint->SetConstraintScaling(mode.GetKinAccelerationScale());
+      if (options.analytic_gradients) {
+        accel_constraint->EnableAnalyticGradients();
+      }
+      if (knot_dynamics_[i_mode]) {
+        accel_constraint->ShareKnotDynamics(knot_dynamics_[i_mode].get(), j);
+      }
       AddConstraint(accel_constraint,
                     {state_vars(i_mode, j), input_vars(i_mode, j),
                      force_vars(i_mode, j)});
@@ -328,6 +357,73 @@ Dircon<T>::Dircon(std::unique_ptr<DirconModeSequence<T>> my_sequence,
   }
 }
 
+template <typename T>
+void Dircon<T>::AddCollocationConstraints(
+    int i_mode, const DirconEvaluationOptions& options) {
+  const auto& mode = get_mode(i_mode);
+  const int num_collocation = mode.num_knotpoints() - 1;
+  batch_caches_.emplace_back();
+
+  auto make_constraint = [&](int j, Context<T>* context_0,
+                             Context<T>* context_1, DynamicsCache<T>* cache) {
+    auto constraint = std::make_shared<DirconCollocationConstraint<T>>(
+        plant_, mode.evaluators(), context_0, context_1, i_mode, j, cache);
+    constraint->SetConstraintScaling(mode.GetDynamicsScale());
+    if (options.analytic_gradients) {
+      constraint->EnableAnalyticGradients();
+    }
+    if (knot_dynamics_[i_mode]) {
+      constraint->ShareKnotDynamics(knot_dynamics_[i_mode].get(), j);
+    }
+    return constraint;
+  };
+  auto collocation_vars = [&](int j) {
+    return drake::solvers::ConcatenateVariableRefList(
+        {timestep(mode_start_[i_mode] + j), state_vars(i_mode, j),
+         state_vars(i_mode, j + 1), input_vars(i_mode, j),
+         input_vars(i_mode, j + 1), force_vars(i_mode, j),
+         force_vars(i_mode, j + 1), collocation_force_vars(i_mode, j),
+         collocation_slack_vars(i_mode, j), quaternion_slack_vars(i_mode, j)});
+  };
+
+  if (options.num_threads == 1 || num_collocation < 2) {
+    for (int j = 0; j < num_collocation; j++) {
+      AddConstraint(make_constraint(j, contexts_[i_mode].at(j).get(),
+                                    contexts_[i_mode].at(j + 1).get(),
+                                    cache_[i_mode].get()),
+                    collocation_vars(j));
+    }
+    return;
+  }
+
+  // Split the knots in contiguous chunks, one per thread. The knot contexts
+  // and the DynamicsCache are shared within a chunk (as in the serial case,
+  // consecutive collocation constraints share a knot), but not across chunks.
+  const int num_chunks = std::min(options.num_threads, num_collocation);
+  std::vector<std::vector<Binding<Constraint>>> chunks(num_chunks);
+  for (int k = 0; k < num_chunks; k++) {
+    const int begin = num_collocation * k / num_chunks;
+    const int end = num_collocation * (k + 1) / num_chunks;
+    batch_caches_.back().push_back(std::make_unique<DynamicsCache<T>>(
+        mode.evaluators(), options.dynamics_cache_bytes));
+    const int context_start = batch_contexts_.size();
+    for (int j = begin; j <= end; j++) {
+      batch_contexts_.push_back(plant_.CreateDefaultContext());
+    }
+    for (int j = begin; j < end; j++) {
+      chunks[k].emplace_back(
+          make_constraint(
+              j, batch_contexts_.at(context_start + j - begin).get(),
+              batch_contexts_.at(context_start + j - begin + 1).get(),
+              batch_caches_.back().back().get()),
+          collocation_vars(j));
+    }
+  }
+  auto batch = std::make_shared<solvers::BatchedConstraint>(
+      chunks, "collocation[" + std::to_string(i_mode) + "]");
+  AddConstraint(batch, batch->variables());
+}
+
 ///
 /// Getters for decision variables
 ///
@@ -714,6 +810,19 @@ int Dircon<T>::mode_length(int mode_index) const {
   return get_mode(mode_index).num_knotpoints();
 }
 
+template <typename T>
+DynamicsCacheStats Dircon<T>::GetDynamicsCacheStats(int mode) const {
+  DynamicsCacheStats stats = cache_.at(mode)->stats();
+  for (const auto& cache : batch_caches_.at(mode)) {
+    stats.hits += cache->stats().hits;
+    stats.misses += cache->stats().misses;
+    stats.evictions += cache->stats().evictions;
+    stats.num_entries += cache->stats().num_entries;
+    stats.num_bytes += cache->stats().num_bytes;
+  }
+  return stats;
+}
+
 template <typename T>
 void Dircon<T>::ScaleTimeVariables(double scale) {
   for (int i = 0; i < h_vars().size(); i++) {
@@ -877,6 +986,122 @@ Eigen::MatrixXd Dircon<T>::GetForceSamplesByMode(
   return forces;
 }
 
+template <typename T>
+VectorXd Dircon<T>::GetMeshErrorByMode(const MathematicalProgramResult& result,
+                                       int mode_index) const {
+  const auto& mode = get_mode(mode_index);
+  const VectorXd times = GetSampleTimes(result);
+  const int n = mode_length(mode_index);
+  const MatrixXd x = GetStateSamplesByMode(result, mode_index);
+  const MatrixXd u = GetInputSamplesByMode(result, mode_index);
+  const MatrixXd l = GetForceSamplesByMode(result, mode_index);
+  MatrixXd xdot(num_states(), n);
+  for (int j = 0; j < n; j++) {
+    xdot.col(j) = CalcTimeDerivatives(mode, x.col(j), u.col(j), l.col(j));
+  }
+
+  VectorXd error(n - 1);
+  for (int j = 0; j < n - 1; j++) {
+    const double h = times(mode_start_[mode_index] + j + 1) -
+                     times(mode_start_[mode_index] + j);
+    const VectorXd lc =
+        result.GetSolution(collocation_force_vars(mode_index, j));
+    error(j) = 0;
+    for (double s : {0.25, 0.75}) {
+      // Cubic Hermite state and its derivative
+      const VectorXd x_s =
+          (2 * s * s * s - 3 * s * s + 1) * x.col(j) +
+          (s * s * s - 2 * s * s + s) * h * xdot.col(j) +
+          (-2 * s * s * s + 3 * s * s) * x.col(j + 1) +
+          (s * s * s - s * s) * h * xdot.col(j + 1);
+      const VectorXd xdot_s =
+          ((6 * s * s - 6 * s) * x.col(j) +
+           (3 * s * s - 4 * s + 1) * h * xdot.col(j) +
+           (-6 * s * s + 6 * s) * x.col(j + 1) +
+           (3 * s * s - 2 * s) * h * xdot.col(j + 1)) / h;
+      const VectorXd u_s = (1 - s) * u.col(j) + s * u.col(j + 1);
+      // Quadratic through the forces at s = 0, 1/2 and 1
+      const VectorXd l_s = 2 * (s - 0.5) * (s - 1) * l.col(j) -
+                           4 * s * (s - 1) * lc +
+                           2 * s * (s - 0.5) * l.col(j + 1);
+      const VectorXd residual =
+          xdot_s - CalcTimeDerivatives(mode, x_s, u_s, l_s);
+      error(j) = std::max(error(j), h * residual.lpNorm<Eigen::Infinity>());
+    }
+  }
+  return error;
+}
+
+template <typename T>
+void Dircon<T>::SetInitialGuessFromSolution(
+    const Dircon<T>& other, const MathematicalProgramResult& result) {
+  DRAKE_DEMAND(other.num_modes() == num_modes());
+  const VectorXd other_times = other.GetSampleTimes(result);
+  for (int i = 0; i < num_modes(); i++) {
+    const auto& mode = get_mode(i);
+    const int n_other = other.mode_length(i);
+    const int n = mode_length(i);
+
+    // Times of the knot and collocation points of the solution, relative to
+    // the start of the mode
+    const VectorXd knot_times =
+        other_times.segment(other.mode_start_[i], n_other).array() -
+        other_times(other.mode_start_[i]);
+    const double duration = knot_times(n_other - 1);
+    const VectorXd collocation_times =
+        (knot_times.head(n_other - 1) + knot_times.tail(n_other - 1)) / 2;
+
+    // State trajectory, as in ReconstructStateTrajectory
+    const MatrixXd x = other.GetStateSamplesByMode(result, i);
+    const MatrixXd u = other.GetInputSamplesByMode(result, i);
+    const MatrixXd l = other.GetForceSamplesByMode(result, i);
+    PiecewisePolynomial<double> x_traj(MatrixXd(x.col(0)));
+    if (n_other > 1) {
+      MatrixXd xdot(num_states(), n_other);
+      for (int j = 0; j < n_other; j++) {
+        xdot.col(j) = CalcTimeDerivatives(mode, x.col(j), u.col(j), l.col(j));
+      }
+      x_traj = PiecewisePolynomial<double>::CubicHermite(knot_times, x, xdot);
+    }
+    const auto u_traj = Resample(knot_times, u);
+    const auto l_traj = Resample(knot_times, l);
+
+    // Forces and slacks at the collocation points, if any
+    const int n_l = mode.evaluators().count_full();
+    MatrixXd lc = MatrixXd::Zero(n_l, std::max(n_other - 1, 1));
+    MatrixXd gamma = MatrixXd::Zero(n_l, std::max(n_other - 1, 1));
+    for (int j = 0; j < n_other - 1; j++) {
+      lc.col(j) = result.GetSolution(other.collocation_force_vars(i, j));
+      gamma.col(j) = result.GetSolution(other.collocation_slack_vars(i, j));
+    }
+    const auto lc_traj = Resample(collocation_times, lc);
+    const auto gamma_traj = Resample(collocation_times, gamma);
+
+    const double h = n > 1 ? duration / (n - 1) : 0;
+    for (int j = 0; j < n; j++) {
+      SetInitialGuess(state_vars(i, j), x_traj.value(j * h));
+      SetInitialGuess(input_vars(i, j), u_traj.value(j * h));
+      SetInitialGuess(force_vars(i, j), l_traj.value(j * h));
+    }
+    for (int j = 0; j < n - 1; j++) {
+      if (timesteps_are_decision_variables()) {
+        SetInitialGuess(timestep(mode_start_[i] + j), VectorXd::Constant(1, h));
+      }
+      SetInitialGuess(collocation_force_vars(i, j),
+                      lc_traj.value((j + 0.5) * h));
+      SetInitialGuess(collocation_slack_vars(i, j),
+                      gamma_traj.value((j + 0.5) * h));
+    }
+    SetInitialGuess(quaternion_slack_vars_[i],
+                    VectorXd::Zero(quaternion_slack_vars_[i].size()));
+    SetInitialGuess(offset_vars(i), result.GetSolution(other.offset_vars(i)));
+    if (i > 0) {
+      SetInitialGuess(impulse_vars(i - 1),
+                      result.GetSolution(other.impulse_vars(i - 1)));
+    }
+  }
+}
+
 }  // namespace trajectory_optimization
 }  // namespace systems
 }  // namespace dairlib
@@ -11,12 +11,38 @@
 
 #include "systems/trajectory_optimization/dircon/dircon_mode.h"
 #include "systems/trajectory_optimization/dircon/dynamics_cache.h"
+#include "systems/trajectory_optimization/dircon/knot_dynamics.h"
 #include "multibody/multipose_visualizer.h"
 
 namespace dairlib {
 namespace systems {
 namespace trajectory_optimization {
 
+/// Options for how Dircon evaluates its constraints
+struct DirconEvaluationOptions {
+  /// If greater than one, the collocation constraints of each mode are grouped
+  /// into one solvers::BatchedConstraint, evaluated in parallel across (up to)
+  /// num_threads threads. Each thread uses its own plant contexts and
+  /// DynamicsCache.
+  int num_threads = 1;
+
+  /// If true, the collocation and acceleration constraints compute their
+  /// gradients from analytic derivatives of the dynamics (see
+  /// DynamicsDerivatives) rather than finite differences. Only supported for
+  /// Dircon<double>.
+  bool analytic_gradients = false;
+
+  /// Memory cap, in bytes, of each DynamicsCache (one per mode, and one per
+  /// thread and mode when num_threads > 1)
+  std::size_t dynamics_cache_bytes = 64 << 20;
+
+  /// If true, the collocation and acceleration constraints of a mode share
+  /// the dynamics (and their analytic Jacobians) at each knot through a
+  /// KnotDynamics, so that they are evaluated once per knot for a given
+  /// vector of decision variables.
+  bool share_knot_dynamics = true;
+};
+
 /// DIRCON implements the approach to trajectory optimization as
 /// described in
 ///   Michael Posa, Scott Kuindersma, Russ Tedrake. "Optimization and
@@ -35,10 +61,12 @@ class Dircon
   DRAKE_NO_COPY_NO_MOVE_NO_ASSIGN(Dircon)
 
   /// The default, hybrid constructor. Takes a mode sequence.
-  Dircon(const DirconModeSequence<T>& mode_sequence);
+  Dircon(const DirconModeSequence<T>& mode_sequence,
+         const DirconEvaluationOptions& options = DirconEvaluationOptions());
 
   /// For simplicity, a constructor that takes only a single mode as a pointer.
-  Dircon(DirconMode<T>* mode);
+  Dircon(DirconMode<T>* mode,
+         const DirconEvaluationOptions& options = DirconEvaluationOptions());
 
   /// Get the input trajectory at the solution as a
   /// %drake::trajectories::PiecewisePolynomialTrajectory%.
@@ -65,6 +93,27 @@ class Dircon
   Eigen::MatrixXd GetForceSamplesByMode(
     const drake::solvers::MathematicalProgramResult& result, int mode) const;
 
+  /// Estimate the discretization error of each interval of a mode, at a
+  /// solution. The dynamics are only enforced at the knot and collocation
+  /// points, so they are evaluated at the quarter points of each interval,
+  /// along the cubic state trajectory, with linearly interpolated inputs and
+  /// quadratically interpolated forces (through the knot and collocation
+  /// forces). The error of an interval is the largest absolute residual of
+  /// the dynamics, times the timestep. The velocity and quaternion slack
+  /// variables, which vanish at exact solutions, are neglected.
+  /// @return a vector of length mode_length(mode) - 1
+  Eigen::VectorXd GetMeshErrorByMode(
+    const drake::solvers::MathematicalProgramResult& result, int mode) const;
+
+  /// Set the initial guess of the variables from the solution of another
+  /// Dircon problem with the same modes, but possibly different numbers of
+  /// knot points (see DirconMeshRefinement). The state, input and force
+  /// trajectories of each mode are resampled at the knot and collocation
+  /// points of this problem, keeping the duration of the mode. Quaternion
+  /// slack variables are set to zero.
+  void SetInitialGuessFromSolution(const Dircon<T>& other,
+      const drake::solvers::MathematicalProgramResult& result);
+
   /// Adds a visualization callback that will visualize knot points
   /// without transparency. Cannot be called twice
   /// @param model_name The path of a URDF/SDF model name for visualization
@@ -187,6 +236,10 @@ class Dircon
     return mode_sequence_.mode(mode);
   }
 
+  /// Hit/miss statistics of the dynamics caches of a mode, summed over the
+  /// caches of all threads
+  DynamicsCacheStats GetDynamicsCacheStats(int mode) const;
+
   const drake::systems::Context<T>& get_context(int mode, int knotpoint_index) {
     return *contexts_.at(mode).at(knotpoint_index);
   }
@@ -211,7 +264,12 @@ class Dircon
   Dircon(std::unique_ptr<DirconModeSequence<T>> my_sequence,
       const DirconModeSequence<T>* ext_sequence,
       const drake::multibody::MultibodyPlant<T>& plant,
-      int num_knotpoints);
+      int num_knotpoints, const DirconEvaluationOptions& options);
+
+  // Adds the collocation constraints of mode i_mode, either one constraint
+  // per knot or, if options.num_threads > 1, batched constraints
+  void AddCollocationConstraints(int i_mode,
+                                 const DirconEvaluationOptions& options);
 
   std::unique_ptr<DirconModeSequence<T>> my_sequence_;
   const drake::multibody::MultibodyPlant<T>& plant_;
@@ -229,6 +287,13 @@ class Dircon
   std::vector<drake::solvers::VectorXDecisionVariable> quaternion_slack_vars_;
   std::unique_ptr<multibody::MultiposeVisualizer> callback_visualizer_;
   std::vector<std::unique_ptr<DynamicsCache<T>>> cache_;
+  // Dynamics shared across the constraints of each mode, null if
+  // DirconEvaluationOptions::share_knot_dynamics is false
+  std::vector<std::unique_ptr<KnotDynamics<T>>> knot_dynamics_;
+  // Contexts and caches (per mode) used by the batched collocation
+  // constraints
+  std::vector<std::unique_ptr<drake::systems::Context<T>>> batch_contexts_;
+  std::vector<std::vector<std::unique_ptr<DynamicsCache<T>>>> batch_caches_;
 };
 
 }  // namespace trajectory_optimization
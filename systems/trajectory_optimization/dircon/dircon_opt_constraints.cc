@@ -1,6 +1,10 @@
 #include "systems/trajectory_optimization/dircon/dircon_opt_constraints.h"
 
+#include <utility>
+#include <vector>
+
 #include "multibody/multibody_utils.h"
+#include "drake/math/autodiff_gradient.h"
 
 namespace dairlib {
 namespace systems {
@@ -9,7 +13,9 @@ namespace trajectory_optimization {
 using multibody::KinematicEvaluatorSet;
 using solvers::NonlinearConstraint;
 
+using drake::AutoDiffXd;
 using drake::VectorX;
+using drake::math::DiscardGradient;
 using drake::multibody::MultibodyPlant;
 using drake::systems::Context;
 
@@ -19,7 +25,10 @@ using Eigen::VectorXd;
 template <typename T>
 QuaternionConstraint<T>::QuaternionConstraint()
     : NonlinearConstraint<T>(1, 4, VectorXd::Zero(1), VectorXd::Zero(1),
-                             "quaternion_norm_constraint") {}
+                             "quaternion_norm_constraint") {
+  this->SetGradientSparsity({{0, 0}, {0, 1}, {0, 2}, {0, 3}});
+}
+
 template <typename T>
 void QuaternionConstraint<T>::EvaluateConstraint(
     const Eigen::Ref<const VectorX<T>>& x, VectorX<T>* y) const {
@@ -55,7 +64,34 @@ DirconCollocationConstraint<T>::DirconCollocationConstraint(
       n_x_(plant.num_positions() + plant.num_velocities()),
       n_u_(plant.num_actuators()),
       n_l_(evaluators.count_full()),
-      cache_(cache) {}
+      cache_(cache) {
+  // Gradient sparsity, with the variables ordered as in EvaluateConstraint.
+  // The position rows, xdotcol - (N(q) v + N(q) J^T gamma + quat * slack) at
+  // the collocation point, do not depend on lc, while the velocity rows, the
+  // collocated accelerations, depend on neither gamma nor the quaternion
+  // slacks. Each quaternion slack only enters the rows of its quaternion.
+  const int n_q = plant_.num_positions();
+  const int i_lc = 1 + 2 * (n_x_ + n_u_) + 2 * n_l_;
+  const int i_gamma = i_lc + n_l_;
+  const int i_quat_slack = i_gamma + n_l_;
+  std::vector<std::pair<int, int>> nonzeros;
+  for (int col = 0; col < i_quat_slack; col++) {
+    const bool is_lc = (col >= i_lc && col < i_gamma);
+    const bool is_gamma = (col >= i_gamma);
+    for (int row = 0; row < n_x_; row++) {
+      if ((row < n_q && !is_lc) || (row >= n_q && !is_gamma)) {
+        nonzeros.emplace_back(row, col);
+      }
+    }
+  }
+  for (uint i = 0; i < quat_start_indices_.size(); i++) {
+    for (int row = quat_start_indices_[i]; row < quat_start_indices_[i] + 4;
+         row++) {
+      nonzeros.emplace_back(row, i_quat_slack + i);
+    }
+  }
+  this->SetGradientSparsity(nonzeros);
+}
 
 /// The format of the input to the eval() function is in the order
 ///   - timestep h
@@ -87,21 +123,20 @@ void DirconCollocationConstraint<T>::EvaluateConstraint(
   // Evaluate dynamics at k and k+1
   multibody::setContext<T>(plant_, x0, u0, context_0_);
   multibody::setContext<T>(plant_, x1, u1, context_1_);
-  const auto& xdot0 = CalcTimeDerivativesWithForce(context_0_, l0);
-  const auto& xdot1 = CalcTimeDerivativesWithForce(context_1_, l1);
+  const auto& xdot0 = CalcKnotTimeDerivatives(0, context_0_, l0);
+  const auto& xdot1 = CalcKnotTimeDerivatives(1, context_1_, l1);
 
   // Cubic interpolation to get xcol and xdotcol.
   const auto& xcol = 0.5 * (x0 + x1) + h / 8 * (xdot0 - xdot1);
   const auto& xdotcol = -1.5 * (x0 - x1) / h - .25 * (xdot0 + xdot1);
   const auto& ucol = 0.5 * (u0 + u1);
 
-  static drake::MatrixX<T> J(evaluators_.count_full(), plant_.num_velocities());
-
   // Evaluate dynamics at colocation point
   multibody::setContext<T>(plant_, xcol, ucol, context_col_.get());
   auto g = CalcTimeDerivativesWithForce(context_col_.get(), lc);
 
   // Add velocity slack contribution, J^T * gamma
+  drake::MatrixX<T> J(n_l_, plant_.num_velocities());
   evaluators_.EvalFullJacobian(*context_col_, &J);
   VectorX<T> gamma_in_qdot_space(plant_.num_positions());
   plant_.MapVelocityToQDot(*context_col_, J.transpose() * gamma,
@@ -128,6 +163,154 @@ drake::VectorX<T> DirconCollocationConstraint<T>::CalcTimeDerivativesWithForce(
   }
 }
 
+template <typename T>
+drake::VectorX<T> DirconCollocationConstraint<T>::CalcKnotTimeDerivatives(
+    int i, drake::systems::Context<T>* context,
+    const drake::VectorX<T>& forces) const {
+  if (knot_dynamics_) {
+    return knot_dynamics_->CalcTimeDerivativesWithForce(
+        knot_index_ + i, context, forces, cache_);
+  } else {
+    return CalcTimeDerivativesWithForce(context, forces);
+  }
+}
+
+template <typename T>
+void DirconCollocationConstraint<T>::ShareKnotDynamics(
+    KnotDynamics<T>* knot_dynamics, int knot_index) {
+  DRAKE_DEMAND(knot_index + 1 < knot_dynamics->num_knots());
+  knot_dynamics_ = knot_dynamics;
+  knot_index_ = knot_index;
+}
+
+template <>
+void DirconCollocationConstraint<double>::EnableAnalyticGradients() {
+  derivatives_ = std::make_unique<DynamicsDerivatives>(plant_, evaluators_);
+}
+
+template <>
+void DirconCollocationConstraint<AutoDiffXd>::EnableAnalyticGradients() {
+  throw std::logic_error(
+      "Analytic gradients are only supported for DirconCollocationConstraint"
+      "<double>.");
+}
+
+template <>
+void DirconCollocationConstraint<AutoDiffXd>::EvaluateConstraintAndGradient(
+    const Eigen::Ref<const VectorXd>& x, VectorXd* y, MatrixXd* dy) const {
+  NonlinearConstraint<AutoDiffXd>::EvaluateConstraintAndGradient(x, y, dy);
+}
+
+/// Chain rule through the cubic interpolation of EvaluateConstraint, with the
+/// Jacobians of the dynamics at x0, x1 and the collocation point given by
+/// DynamicsDerivatives
+template <>
+void DirconCollocationConstraint<double>::EvaluateConstraintAndGradient(
+    const Eigen::Ref<const VectorXd>& x, VectorXd* y, MatrixXd* dy) const {
+  if (!derivatives_) {
+    NonlinearConstraint<double>::EvaluateConstraintAndGradient(x, y, dy);
+    return;
+  }
+  const int n_q = plant_.num_positions();
+  const int n_quat = quat_start_indices_.size();
+
+  // Offsets of the decision variables, see EvaluateConstraint
+  const int i_x0 = 1;
+  const int i_x1 = 1 + n_x_;
+  const int i_u0 = 1 + 2 * n_x_;
+  const int i_u1 = i_u0 + n_u_;
+  const int i_l0 = 1 + 2 * (n_x_ + n_u_);
+  const int i_l1 = i_l0 + n_l_;
+  const int i_lc = i_l0 + 2 * n_l_;
+  const int i_gamma = i_l0 + 3 * n_l_;
+  const int i_quat_slack = i_l0 + 4 * n_l_;
+  const int n_z = num_vars();
+
+  const double h = x(0);
+  const VectorXd x0 = x.segment(i_x0, n_x_);
+  const VectorXd x1 = x.segment(i_x1, n_x_);
+  const VectorXd u0 = x.segment(i_u0, n_u_);
+  const VectorXd u1 = x.segment(i_u1, n_u_);
+  const VectorXd l0 = x.segment(i_l0, n_l_);
+  const VectorXd l1 = x.segment(i_l1, n_l_);
+  const VectorXd lc = x.segment(i_lc, n_l_);
+  const VectorXd gamma = x.segment(i_gamma, n_l_);
+  const VectorXd quat_slack = x.segment(i_quat_slack, n_quat);
+
+  // Dynamics at k and k+1, and their Jacobians w.r.t. all variables
+  VectorXd xdot0, xdot1;
+  MatrixXd A, B, L;
+  auto calc_knot = [&](int i, Context<double>* context, const VectorXd& l,
+                       VectorXd* xdot) {
+    if (knot_dynamics_) {
+      knot_dynamics_->CalcTimeDerivativesAndGradient(
+          knot_index_ + i, context, l, *derivatives_, xdot, &A, &B, &L);
+    } else {
+      derivatives_->Calc(context, l, xdot, &A, &B, &L);
+    }
+  };
+  MatrixXd dxdot0 = MatrixXd::Zero(n_x_, n_z);
+  MatrixXd dxdot1 = MatrixXd::Zero(n_x_, n_z);
+  multibody::setContext<double>(plant_, x0, u0, context_0_);
+  calc_knot(0, context_0_, l0, &xdot0);
+  dxdot0.middleCols(i_x0, n_x_) = A;
+  dxdot0.middleCols(i_u0, n_u_) = B;
+  dxdot0.middleCols(i_l0, n_l_) = L;
+  multibody::setContext<double>(plant_, x1, u1, context_1_);
+  calc_knot(1, context_1_, l1, &xdot1);
+  dxdot1.middleCols(i_x1, n_x_) = A;
+  dxdot1.middleCols(i_u1, n_u_) = B;
+  dxdot1.middleCols(i_l1, n_l_) = L;
+
+  // Cubic interpolation
+  const VectorXd xcol = 0.5 * (x0 + x1) + h / 8 * (xdot0 - xdot1);
+  const VectorXd xdotcol = -1.5 * (x0 - x1) / h - .25 * (xdot0 + xdot1);
+  const VectorXd ucol = 0.5 * (u0 + u1);
+
+  MatrixXd dxcol = h / 8 * (dxdot0 - dxdot1);
+  dxcol.middleCols(i_x0, n_x_).diagonal().array() += 0.5;
+  dxcol.middleCols(i_x1, n_x_).diagonal().array() += 0.5;
+  dxcol.col(0) += (xdot0 - xdot1) / 8;
+
+  MatrixXd dxdotcol = -.25 * (dxdot0 + dxdot1);
+  dxdotcol.middleCols(i_x0, n_x_).diagonal().array() -= 1.5 / h;
+  dxdotcol.middleCols(i_x1, n_x_).diagonal().array() += 1.5 / h;
+  dxdotcol.col(0) += 1.5 * (x0 - x1) / (h * h);
+
+  // Dynamics at the collocation point
+  VectorXd g;
+  multibody::setContext<double>(plant_, xcol, ucol, context_col_.get());
+  derivatives_->Calc(context_col_.get(), lc, &g, &A, &B, &L);
+  MatrixXd dg = A * dxcol;
+  dg.middleCols(i_u0, n_u_) += 0.5 * B;
+  dg.middleCols(i_u1, n_u_) += 0.5 * B;
+  dg.middleCols(i_lc, n_l_) += L;
+
+  // Velocity slack contribution, N(q) * J^T * gamma
+  const MatrixXd J = evaluators_.EvalFullJacobian(*context_col_);
+  VectorXd gamma_in_qdot_space;
+  MatrixXd N, dN_dq;
+  derivatives_->CalcMapVelocityToQDot(xcol.head(n_q), J.transpose() * gamma,
+                                      &gamma_in_qdot_space, &N, &dN_dq);
+  const MatrixXd dJt_gamma_dq =
+      derivatives_->CalcJacobianTransposeTimesVectorDerivative(xcol.head(n_q),
+                                                               gamma);
+  g.head(n_q) += gamma_in_qdot_space;
+  dg.topRows(n_q) += (dN_dq + N * dJt_gamma_dq) * dxcol.topRows(n_q);
+  dg.block(0, i_gamma, n_q, n_l_) += N * J.transpose();
+
+  // Quaternion slack contribution, quat * slack
+  for (int i = 0; i < n_quat; i++) {
+    const int start = quat_start_indices_.at(i);
+    g.segment(start, 4) += xcol.segment(start, 4) * quat_slack(i);
+    dg.middleRows(start, 4) += quat_slack(i) * dxcol.middleRows(start, 4);
+    dg.block(start, i_quat_slack + i, 4, 1) += xcol.segment(start, 4);
+  }
+
+  *y = xdotcol - g;
+  *dy = dxdotcol - dg;
+}
+
 template <typename T>
 ImpactConstraint<T>::ImpactConstraint(
     const MultibodyPlant<T>& plant, const KinematicEvaluatorSet<T>& evaluators,
@@ -142,7 +325,47 @@ ImpactConstraint<T>::ImpactConstraint(
       evaluators_(evaluators),
       context_(context),
       n_x_(plant.num_positions() + plant.num_velocities()),
-      n_l_(evaluators.count_full()) {}
+      n_l_(evaluators.count_full()) {
+  // Gradient sparsity. The q columns are dense, while the v0 and v1 columns
+  // follow the nonzeros of M(q), and the impulse columns those of J(q)^T.
+  // M and J are probed at two (fixed seed) random configurations: entries
+  // that couple joints on different branches of the kinematic tree, or joints
+  // off the kinematic path of an evaluator, are exactly zero. See
+  // sparsity_pattern_test for a check against the AutoDiff gradient.
+  const int n_q = plant_.num_positions();
+  const int n_v = plant_.num_velocities();
+  Eigen::MatrixXd M_pattern = Eigen::MatrixXd::Zero(n_v, n_v);
+  Eigen::MatrixXd J_pattern = Eigen::MatrixXd::Zero(n_l_, n_v);
+  auto probe_context = plant_.CreateDefaultContext();
+  drake::MatrixX<T> M(n_v, n_v);
+  for (int sample = 0; sample < 2; sample++) {
+    plant_.SetPositions(probe_context.get(),
+                        multibody::RandomPositions(plant_, sample).cast<T>());
+    plant_.CalcMassMatrix(*probe_context, &M);
+    const auto J = evaluators_.EvalFullJacobian(*probe_context);
+    M_pattern += DiscardGradient(M).cwiseAbs();
+    J_pattern += DiscardGradient(J).cwiseAbs();
+  }
+
+  std::vector<std::pair<int, int>> nonzeros;
+  for (int row = 0; row < n_v; row++) {
+    for (int col = 0; col < n_q; col++) {
+      nonzeros.emplace_back(row, col);
+    }
+    for (int col = 0; col < n_v; col++) {
+      if (M_pattern(row, col) != 0) {
+        nonzeros.emplace_back(row, n_q + col);
+        nonzeros.emplace_back(row, n_x_ + n_l_ + col);
+      }
+    }
+    for (int col = 0; col < n_l_; col++) {
+      if (J_pattern(col, row) != 0) {
+        nonzeros.emplace_back(row, n_x_ + col);
+      }
+    }
+  }
+  this->SetGradientSparsity(nonzeros);
+}
 
 /// The format of the input to the eval() function is in the order
 ///   - x0, pre-impact state (q,v)
@@ -196,8 +419,12 @@ void CachedAccelerationConstraint<T>::EvaluateConstraint(
   const auto& lambda = vars.tail(evaluators_.count_full());
   multibody::setContext<T>(plant_, x, u, context_);
 
-  if (cache_) {
-    const auto& xdot = cache_->CalcTimeDerivativesWithForce(context_, lambda);
+  if (knot_dynamics_ || cache_) {
+    const auto& xdot =
+        knot_dynamics_
+            ? knot_dynamics_->CalcTimeDerivativesWithForce(
+                  knot_index_, context_, lambda, cache_)
+            : cache_->CalcTimeDerivativesWithForce(context_, lambda);
     const auto& J = evaluators_.EvalActiveJacobian(*context_);
     const auto& Jdotv = evaluators_.EvalActiveJacobianDotTimesV(*context_);
     *y = J * xdot.tail(plant_.num_velocities()) + Jdotv;
@@ -206,6 +433,68 @@ void CachedAccelerationConstraint<T>::EvaluateConstraint(
   }
 }
 
+template <typename T>
+void CachedAccelerationConstraint<T>::ShareKnotDynamics(
+    KnotDynamics<T>* knot_dynamics, int knot_index) {
+  DRAKE_DEMAND(knot_index < knot_dynamics->num_knots());
+  knot_dynamics_ = knot_dynamics;
+  knot_index_ = knot_index;
+}
+
+template <>
+void CachedAccelerationConstraint<double>::EnableAnalyticGradients() {
+  derivatives_ = std::make_unique<DynamicsDerivatives>(plant_, evaluators_);
+}
+
+template <>
+void CachedAccelerationConstraint<AutoDiffXd>::EnableAnalyticGradients() {
+  throw std::logic_error(
+      "Analytic gradients are only supported for CachedAccelerationConstraint"
+      "<double>.");
+}
+
+template <>
+void CachedAccelerationConstraint<AutoDiffXd>::EvaluateConstraintAndGradient(
+    const Eigen::Ref<const VectorXd>& vars, VectorXd* y, MatrixXd* dy) const {
+  NonlinearConstraint<AutoDiffXd>::EvaluateConstraintAndGradient(vars, y, dy);
+}
+
+/// y = J(q) vdot + Jdot(q, v) v, where only vdot depends on u and lambda
+template <>
+void CachedAccelerationConstraint<double>::EvaluateConstraintAndGradient(
+    const Eigen::Ref<const VectorXd>& vars, VectorXd* y, MatrixXd* dy) const {
+  if (!derivatives_) {
+    NonlinearConstraint<double>::EvaluateConstraintAndGradient(vars, y, dy);
+    return;
+  }
+  const int n_x = plant_.num_positions() + plant_.num_velocities();
+  const int n_v = plant_.num_velocities();
+  const int n_u = plant_.num_actuators();
+  const int n_l = evaluators_.count_full();
+  const VectorXd x = vars.head(n_x);
+  const VectorXd u = vars.segment(n_x, n_u);
+  const VectorXd lambda = vars.tail(n_l);
+  multibody::setContext<double>(plant_, x, u, context_);
+
+  VectorXd xdot;
+  MatrixXd A, B, L;
+  if (knot_dynamics_) {
+    knot_dynamics_->CalcTimeDerivativesAndGradient(
+        knot_index_, context_, lambda, *derivatives_, &xdot, &A, &B, &L);
+  } else {
+    derivatives_->Calc(context_, lambda, &xdot, &A, &B, &L);
+  }
+  const VectorXd vdot = xdot.tail(n_v);
+  const MatrixXd J = evaluators_.EvalActiveJacobian(*context_);
+  *y = J * vdot + evaluators_.EvalActiveJacobianDotTimesV(*context_);
+
+  dy->resize(J.rows(), n_x + n_u + n_l);
+  dy->leftCols(n_x) = J * A.bottomRows(n_v) +
+                      derivatives_->CalcActiveAccelerationDerivative(x, vdot);
+  dy->middleCols(n_x, n_u) = J * B.bottomRows(n_v);
+  dy->rightCols(n_l) = J * L.bottomRows(n_v);
+}
+
 DRAKE_DEFINE_CLASS_TEMPLATE_INSTANTIATIONS_ON_DEFAULT_NONSYMBOLIC_SCALARS(
     class ::dairlib::systems::trajectory_optimization::QuaternionConstraint)
 DRAKE_DEFINE_CLASS_TEMPLATE_INSTANTIATIONS_ON_DEFAULT_NONSYMBOLIC_SCALARS(
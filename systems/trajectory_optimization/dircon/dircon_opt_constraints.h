@@ -6,6 +6,8 @@
 #include "solvers/nonlinear_constraint.h"
 #include "systems/trajectory_optimization/dircon/dircon_mode.h"
 #include "systems/trajectory_optimization/dircon/dynamics_cache.h"
+#include "systems/trajectory_optimization/dircon/dynamics_derivatives.h"
+#include "systems/trajectory_optimization/dircon/knot_dynamics.h"
 #include "drake/common/drake_copyable.h"
 #include "drake/common/symbolic.h"
 #include "drake/solvers/constraint.h"
@@ -49,11 +51,31 @@ class DirconCollocationConstraint : public solvers::NonlinearConstraint<T> {
   void EvaluateConstraint(const Eigen::Ref<const drake::VectorX<T>>& x,
                           drake::VectorX<T>* y) const override;
 
+  /// Computes the gradient from analytic derivatives of the dynamics (see
+  /// DynamicsDerivatives) rather than finite differences. Only supported for
+  /// T = double.
+  void EnableAnalyticGradients();
+
+  /// Reads the dynamics at the knots k and k+1 from knot_dynamics, where k =
+  /// knot_index, rather than evaluating them independently of the other
+  /// constraints. See KnotDynamics.
+  void ShareKnotDynamics(KnotDynamics<T>* knot_dynamics, int knot_index);
+
+ protected:
+  void EvaluateConstraintAndGradient(const Eigen::Ref<const Eigen::VectorXd>& x,
+                                     Eigen::VectorXd* y,
+                                     Eigen::MatrixXd* dy) const override;
+
  private:
   drake::VectorX<T> CalcTimeDerivativesWithForce(
     drake::systems::Context<T>* context,
     const drake::VectorX<T>& forces) const;
 
+  // xdot at the knot k + i, i = 0 or 1, shared through knot_dynamics_ if set
+  drake::VectorX<T> CalcKnotTimeDerivatives(
+      int i, drake::systems::Context<T>* context,
+      const drake::VectorX<T>& forces) const;
+
   const drake::multibody::MultibodyPlant<T>& plant_;
   const multibody::KinematicEvaluatorSet<T>& evaluators_;
   drake::systems::Context<T>* context_0_;
@@ -64,6 +86,9 @@ class DirconCollocationConstraint : public solvers::NonlinearConstraint<T> {
   int n_u_;
   int n_l_;
   DynamicsCache<T>* cache_;
+  std::unique_ptr<DynamicsDerivatives> derivatives_;
+  KnotDynamics<T>* knot_dynamics_ = nullptr;
+  int knot_index_ = 0;
 };
 
 /// Implements the impact constraint used by Dircon on mode transitions
@@ -118,12 +143,27 @@ class CachedAccelerationConstraint : public solvers::NonlinearConstraint<T> {
   void EvaluateConstraint(const Eigen::Ref<const drake::VectorX<T>>& x,
                                   drake::VectorX<T>* y) const;
 
+  /// See DirconCollocationConstraint::EnableAnalyticGradients()
+  void EnableAnalyticGradients();
+
+  /// Reads the dynamics at the constrained knot, knot_index, from
+  /// knot_dynamics. See KnotDynamics.
+  void ShareKnotDynamics(KnotDynamics<T>* knot_dynamics, int knot_index);
+
+ protected:
+  void EvaluateConstraintAndGradient(const Eigen::Ref<const Eigen::VectorXd>& x,
+                                     Eigen::VectorXd* y,
+                                     Eigen::MatrixXd* dy) const override;
+
  private:
   const drake::multibody::MultibodyPlant<T>& plant_;
   const multibody::KinematicEvaluatorSet<T>& evaluators_;
   drake::systems::Context<T>* context_;
   std::unique_ptr<drake::systems::Context<T>> owned_context_;
   DynamicsCache<T>* cache_;
+  std::unique_ptr<DynamicsDerivatives> derivatives_;
+  KnotDynamics<T>* knot_dynamics_ = nullptr;
+  int knot_index_ = 0;
 };
 
 
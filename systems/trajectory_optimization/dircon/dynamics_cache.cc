@@ -6,91 +6,128 @@ namespace dairlib {
 namespace systems {
 namespace trajectory_optimization {
 
-using drake::AutoDiffXd;
 using drake::AutoDiffVecXd;
+using drake::AutoDiffXd;
+using drake::VectorX;
+using Eigen::VectorXd;
+
+namespace {
 
 inline void hash_combine(std::size_t& seed, const double& v) {
-    seed ^= std::hash<double>{}(v) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+  seed ^= std::hash<double>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 }
 
 inline void hash_combine(std::size_t& seed,
-    const Eigen::Ref<const Eigen::VectorXd>& v) {
+                         const Eigen::Ref<const VectorXd>& v) {
   for (int i = 0; i < v.size(); i++) {
-    hash_combine(seed, v(i)); 
+    hash_combine(seed, v(i));
   }
 }
 
-inline void hash_combine(std::size_t& seed,
-    const Eigen::Ref<const AutoDiffVecXd>& v) {
+// Fingerprint of the derivatives of v, zero for double
+inline void hash_seeds(std::size_t&, const VectorXd&) {}
+
+inline void hash_seeds(std::size_t& seed, const AutoDiffVecXd& v) {
   for (int i = 0; i < v.size(); i++) {
-    hash_combine(seed, v(i).value());
+    seed ^= v(i).derivatives().size() + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     hash_combine(seed, v(i).derivatives());
   }
 }
 
+inline std::size_t ScalarBytes(double) { return sizeof(double); }
+
+inline std::size_t ScalarBytes(const AutoDiffXd& v) {
+  return sizeof(AutoDiffXd) + v.derivatives().size() * sizeof(double);
+}
+
+}  // namespace
+
 template <typename T>
 DynamicsCache<T>::DynamicsCache(
-    const multibody::KinematicEvaluatorSet<T>& evaluators, int max_size)
-  : evaluators_(evaluators),
-    max_size_(max_size) {}
+    const multibody::KinematicEvaluatorSet<T>& evaluators,
+    std::size_t max_bytes)
+    : evaluators_(evaluators), max_bytes_(max_bytes) {}
 
 template <typename T>
-drake::VectorX<T> DynamicsCache<T>::CalcTimeDerivativesWithForce(
-    drake::systems::Context<T>* context,
-    const drake::VectorX<T>& forces) {
-  CacheKey<T> key{evaluators_.plant().GetPositionsAndVelocities(*context), 
-                  evaluators_.plant().get_actuation_input_port().Eval(*context),
-                  forces};
+VectorX<T> DynamicsCache<T>::CalcTimeDerivativesWithForce(
+    drake::systems::Context<T>* context, const VectorX<T>& forces) {
+  const auto& plant = evaluators_.plant();
+  const VectorX<T> x = plant.GetPositionsAndVelocities(*context);
+  const VectorX<T> u = plant.get_actuation_input_port().Eval(*context);
+
+  CacheKey key;
+  key.values.resize(x.size() + u.size() + forces.size());
+  key.values << drake::math::DiscardGradient(x),
+      drake::math::DiscardGradient(u), drake::math::DiscardGradient(forces);
+  key.seed_fingerprint = 0;
+  hash_seeds(key.seed_fingerprint, x);
+  hash_seeds(key.seed_fingerprint, u);
+  hash_seeds(key.seed_fingerprint, forces);
+
   auto it = map_.find(key);
-  if (it == map_.end()) {
-    auto xdot = evaluators_.CalcTimeDerivativesWithForce(context, forces);
-    map_[key] = xdot;
-
-    // Add to the queue_
-    if (map_.size() >= max_size_) {
-      map_.erase(queue_.front());
-      queue_.pop_front();
-    }
-    queue_.push_back(key);
-    return xdot;
-  } else {
-    return it->second;
+  if (it != map_.end()) {
+    // Move the entry to the front of the recency list
+    entries_.splice(entries_.begin(), entries_, it->second);
+    stats_.hits++;
+    return it->second->second;
   }
-}
 
-bool AreVectorsEqual(const Eigen::Ref<const AutoDiffVecXd>& a,
-                     const Eigen::Ref<const AutoDiffVecXd>& b) {
-  if (a.value() != b.value()) {
-    return false;
+  stats_.misses++;
+  entries_.emplace_front(
+      key, evaluators_.CalcTimeDerivativesWithForce(context, forces));
+  map_.emplace(std::move(key), entries_.begin());
+  stats_.num_entries++;
+  stats_.num_bytes += EntryBytes(entries_.front());
+
+  // Evict the least recently used entries, always keeping the new one
+  while (stats_.num_bytes > max_bytes_ && stats_.num_entries > 1) {
+    const Entry& lru = entries_.back();
+    stats_.num_bytes -= EntryBytes(lru);
+    stats_.num_entries--;
+    stats_.evictions++;
+    map_.erase(lru.first);
+    entries_.pop_back();
   }
-  const Eigen::MatrixXd& a_gradient = drake::math::autoDiffToGradientMatrix(a);
-  const Eigen::MatrixXd& b_gradient = drake::math::autoDiffToGradientMatrix(b);
+  return entries_.front().second;
+}
 
-  return a_gradient == b_gradient;
+template <typename T>
+void DynamicsCache<T>::ResetStats() {
+  stats_.hits = 0;
+  stats_.misses = 0;
+  stats_.evictions = 0;
 }
 
 template <typename T>
-std::size_t CacheHasher<T>::operator()(const CacheKey<T>& key) const {
-  std::size_t seed = 0;
-  hash_combine(seed, key.state);
-  hash_combine(seed, key.input);
-  hash_combine(seed, key.forces);
-  return seed;
+void DynamicsCache<T>::Clear() {
+  map_.clear();
+  entries_.clear();
+  stats_.num_entries = 0;
+  stats_.num_bytes = 0;
 }
 
-template <>
-bool CacheComparer<double>::operator()(const CacheKey<double>& a,
-    const CacheKey<double>& b) const {
-  return (a.state == b.state) && (a.forces == b.forces) &&
-      (a.input == b.input);
+template <typename T>
+std::size_t DynamicsCache<T>::EntryBytes(const Entry& entry) {
+  // The key is stored both in the list and in the map, along with the list
+  // and hash table nodes
+  std::size_t bytes = 2 * (sizeof(CacheKey) + entry.first.values.size() *
+                                                  sizeof(double)) +
+                      sizeof(Entry) + 4 * sizeof(void*);
+  for (int i = 0; i < entry.second.size(); i++) {
+    bytes += ScalarBytes(entry.second(i));
+  }
+  return bytes;
+}
+
+std::size_t CacheHasher::operator()(const CacheKey& key) const {
+  std::size_t seed = key.seed_fingerprint;
+  hash_combine(seed, key.values);
+  return seed;
 }
 
-template <>
-bool CacheComparer<AutoDiffXd>::operator()(const CacheKey<AutoDiffXd>& a,
-    const CacheKey<AutoDiffXd>& b) const {
-  return AreVectorsEqual(a.state, b.state) &&
-         AreVectorsEqual(a.input, b.input) &&
-        AreVectorsEqual(a.forces, b.forces);
+bool CacheComparer::operator()(const CacheKey& a, const CacheKey& b) const {
+  return a.seed_fingerprint == b.seed_fingerprint &&
+         a.values.size() == b.values.size() && a.values == b.values;
 }
 
 }  // namespace trajectory_optimization
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <list>
 #include <unordered_map>
+#include <utility>
 
 #include "multibody/kinematic/kinematic_evaluator_set.h"
 
@@ -8,44 +11,93 @@ namespace dairlib {
 namespace systems {
 namespace trajectory_optimization {
 
-template <typename T>
+/// Key of a DynamicsCache entry: the values of the state, input and forces,
+/// stacked, along with a fingerprint of their derivatives (the gradient seeds)
+/// when T = AutoDiffXd. Keys with equal values and fingerprints are considered
+/// equal, so the derivatives themselves are neither stored nor compared.
 struct CacheKey {
-  const drake::VectorX<T> state;
-  const drake::VectorX<T> input;
-  const drake::VectorX<T> forces;
+  Eigen::VectorXd values;
+  std::size_t seed_fingerprint;
 };
 
 // == operation for two CacheKeys
-template <typename T>
 class CacheComparer {
  public:
-  bool operator()(const CacheKey<T>& a, const CacheKey<T>& b) const;
+  bool operator()(const CacheKey& a, const CacheKey& b) const;
 };
 
 // Hashes a CacheKey by bit shifting and combining hashes of the double
 // elements
-template <typename T>
 class CacheHasher {
  public:
-  std::size_t operator()(const CacheKey<T>& key) const;
+  std::size_t operator()(const CacheKey& key) const;
+};
+
+/// Hit/miss statistics and current footprint of a DynamicsCache
+struct DynamicsCacheStats {
+  int64_t hits = 0;
+  int64_t misses = 0;
+  int64_t evictions = 0;
+  int num_entries = 0;
+  /// Estimated memory used by the entries, in bytes
+  std::size_t num_bytes = 0;
+
+  double hit_rate() const {
+    return (hits + misses) > 0 ? static_cast<double>(hits) / (hits + misses)
+                               : 0;
+  }
 };
 
+/// Memoizes KinematicEvaluatorSet::CalcTimeDerivativesWithForce, which
+/// constraints sharing a knot point (or finite differences perturbing
+/// variables that do not enter the dynamics) evaluate repeatedly with the
+/// same arguments.
+///
+/// The cache holds at most max_bytes (estimated) of entries, evicting the
+/// least recently used entries first. Lookups, insertions and evictions are
+/// O(1), besides hashing the key.
+///
+/// For T = AutoDiffXd, the derivatives of the arguments are only hashed into
+/// the key (see CacheKey). Two arguments with equal values but different
+/// derivatives therefore only collide if their fingerprints do, which for a
+/// 64 bit hash is negligible.
 template <typename T>
 class DynamicsCache {
  public:
-  DynamicsCache(const multibody::KinematicEvaluatorSet<T>& constraints,
-      int max_size);
+  /// @param evaluators the kinematic constraints
+  /// @param max_bytes memory cap of the entries. The most recent entry is
+  ///   always kept, even if it alone exceeds the cap.
+  DynamicsCache(const multibody::KinematicEvaluatorSet<T>& evaluators,
+                std::size_t max_bytes);
 
   drake::VectorX<T> CalcTimeDerivativesWithForce(
       drake::systems::Context<T>* context,
       const drake::VectorX<T>& forces);
 
+  const DynamicsCacheStats& stats() const { return stats_; }
+
+  /// Resets the hit/miss/eviction counts, keeping the entries
+  void ResetStats();
+
+  /// Removes all entries
+  void Clear();
+
+  std::size_t max_bytes() const { return max_bytes_; }
+
  private:
+  typedef std::pair<CacheKey, drake::VectorX<T>> Entry;
+
+  // Estimated memory footprint of an entry, including container overhead
+  static std::size_t EntryBytes(const Entry& entry);
+
   const multibody::KinematicEvaluatorSet<T>& evaluators_;
-  size_t max_size_;
-  std::unordered_map<CacheKey<T>, drake::VectorX<T>, CacheHasher<T>,
-      CacheComparer<T>> map_;
-  std::list<CacheKey<T>> queue_;
+  std::size_t max_bytes_;
+  // Entries, most recently used first
+  std::list<Entry> entries_;
+  std::unordered_map<CacheKey, typename std::list<Entry>::iterator,
+                     CacheHasher, CacheComparer>
+      map_;
+  DynamicsCacheStats stats_;
 };
 
 }  // namespace trajectory_optimization
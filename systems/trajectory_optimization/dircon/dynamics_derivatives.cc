@@ -0,0 +1,146 @@
+#include "systems/trajectory_optimization/dircon/dynamics_derivatives.h"
+
+#include "drake/math/autodiff.h"
+#include "drake/math/autodiff_gradient.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+
+using drake::AutoDiffXd;
+using drake::VectorX;
+using drake::math::autoDiffToGradientMatrix;
+using drake::math::autoDiffToValueMatrix;
+using drake::math::initializeAutoDiff;
+using drake::multibody::MultibodyForces;
+using drake::multibody::MultibodyPlant;
+using drake::systems::Context;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+DynamicsDerivatives::DynamicsDerivatives(
+    const MultibodyPlant<double>& plant,
+    const multibody::KinematicEvaluatorSet<double>& evaluators, double eps)
+    : plant_(plant),
+      evaluators_(evaluators),
+      plant_ad_(drake::systems::System<double>::ToAutoDiffXd(plant)),
+      context_ad_(plant_ad_->CreateDefaultContext()),
+      context_fd_(plant.CreateDefaultContext()),
+      B_(plant.MakeActuationMatrix()),
+      eps_(eps) {}
+
+void DynamicsDerivatives::Calc(Context<double>* context, const VectorXd& lambda,
+                               VectorXd* xdot, MatrixXd* dxdot_dx,
+                               MatrixXd* dxdot_du,
+                               MatrixXd* dxdot_dlambda) const {
+  const int n_q = plant_.num_positions();
+  const int n_v = plant_.num_velocities();
+  const int n_x = n_q + n_v;
+
+  *xdot = evaluators_.CalcTimeDerivativesWithForce(context, lambda);
+  const VectorXd x = plant_.GetPositionsAndVelocities(*context);
+  const VectorXd vdot = xdot->tail(n_v);
+
+  MatrixXd M(n_v, n_v);
+  plant_.CalcMassMatrix(*context, &M);
+  const Eigen::LLT<MatrixXd> M_llt(M);
+  const MatrixXd J = evaluators_.EvalFullJacobian(*context);
+
+  // Inverse dynamics at the fixed vdot, differentiated w.r.t. x. The force
+  // elements contribution includes the joint damping, so dID/dv already
+  // contains the damping matrix.
+  plant_ad_->SetPositionsAndVelocities(context_ad_.get(),
+                                       initializeAutoDiff(x));
+  MultibodyForces<AutoDiffXd> forces(*plant_ad_);
+  plant_ad_->CalcForceElementsContribution(*context_ad_, &forces);
+  const VectorX<AutoDiffXd> inverse_dynamics = plant_ad_->CalcInverseDynamics(
+      *context_ad_, vdot.cast<AutoDiffXd>(), forces);
+  MatrixXd rhs = -autoDiffToGradientMatrix(inverse_dynamics, n_x);
+  rhs.leftCols(n_q) +=
+      CalcJacobianTransposeTimesVectorDerivative(x.head(n_q), lambda);
+
+  VectorXd qdot;
+  MatrixXd N, dqdot_dq;
+  CalcMapVelocityToQDot(x.head(n_q), x.tail(n_v), &qdot, &N, &dqdot_dq);
+
+  dxdot_dx->resize(n_x, n_x);
+  dxdot_dx->topLeftCorner(n_q, n_q) = dqdot_dq;
+  dxdot_dx->topRightCorner(n_q, n_v) = N;
+  dxdot_dx->bottomRows(n_v) = M_llt.solve(rhs);
+
+  dxdot_du->setZero(n_x, B_.cols());
+  dxdot_du->bottomRows(n_v) = M_llt.solve(B_);
+
+  dxdot_dlambda->setZero(n_x, J.rows());
+  dxdot_dlambda->bottomRows(n_v) = M_llt.solve(J.transpose());
+}
+
+void DynamicsDerivatives::CalcMapVelocityToQDot(const VectorXd& q,
+                                                const VectorXd& w,
+                                                VectorXd* qdot, MatrixXd* N,
+                                                MatrixXd* dqdot_dq) const {
+  const int n_q = plant_.num_positions();
+  const int n_v = plant_.num_velocities();
+
+  plant_ad_->SetPositions(context_ad_.get(), initializeAutoDiff(q));
+  VectorX<AutoDiffXd> qdot_ad(n_q);
+  plant_ad_->MapVelocityToQDot(*context_ad_, w.cast<AutoDiffXd>(), &qdot_ad);
+  *qdot = autoDiffToValueMatrix(qdot_ad);
+  *dqdot_dq = autoDiffToGradientMatrix(qdot_ad, n_q);
+
+  // N(q) is linear in w, so its columns are the images of the unit vectors
+  plant_.SetPositions(context_fd_.get(), q);
+  N->resize(n_q, n_v);
+  VectorXd e_i = VectorXd::Zero(n_v);
+  VectorXd N_i(n_q);
+  for (int i = 0; i < n_v; i++) {
+    e_i(i) = 1;
+    plant_.MapVelocityToQDot(*context_fd_, e_i, &N_i);
+    N->col(i) = N_i;
+    e_i(i) = 0;
+  }
+}
+
+MatrixXd DynamicsDerivatives::CalcJacobianTransposeTimesVectorDerivative(
+    const VectorXd& q, const VectorXd& w) const {
+  VectorXd q_fd = q;
+  plant_.SetPositions(context_fd_.get(), q_fd);
+  const VectorXd f0 =
+      evaluators_.EvalFullJacobian(*context_fd_).transpose() * w;
+
+  MatrixXd df_dq(f0.size(), q.size());
+  for (int i = 0; i < q.size(); i++) {
+    q_fd(i) += eps_;
+    plant_.SetPositions(context_fd_.get(), q_fd);
+    df_dq.col(i) =
+        (evaluators_.EvalFullJacobian(*context_fd_).transpose() * w - f0) /
+        eps_;
+    q_fd(i) -= eps_;
+  }
+  return df_dq;
+}
+
+MatrixXd DynamicsDerivatives::CalcActiveAccelerationDerivative(
+    const VectorXd& x, const VectorXd& vdot) const {
+  auto calc_acceleration = [&]() -> VectorXd {
+    return evaluators_.EvalActiveJacobian(*context_fd_) * vdot +
+           evaluators_.EvalActiveJacobianDotTimesV(*context_fd_);
+  };
+
+  VectorXd x_fd = x;
+  plant_.SetPositionsAndVelocities(context_fd_.get(), x_fd);
+  const VectorXd f0 = calc_acceleration();
+
+  MatrixXd df_dx(f0.size(), x.size());
+  for (int i = 0; i < x.size(); i++) {
+    x_fd(i) += eps_;
+    plant_.SetPositionsAndVelocities(context_fd_.get(), x_fd);
+    df_dx.col(i) = (calc_acceleration() - f0) / eps_;
+    x_fd(i) -= eps_;
+  }
+  return df_dx;
+}
+
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
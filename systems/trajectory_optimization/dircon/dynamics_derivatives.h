@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+
+#include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "drake/multibody/plant/multibody_plant.h"
+#include "drake/systems/framework/context.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+
+/// DynamicsDerivatives evaluates the constrained forward dynamics of
+/// KinematicEvaluatorSet::CalcTimeDerivativesWithForce,
+///   xdot = f(x, u, lambda) = [N(q) v; M(q)^-1 (B u + J(q)^T lambda - c(q, v))]
+/// along with its Jacobians, without differentiating through the forward
+/// dynamics. With ID(q, v, vdot) = M(q) vdot + c(q, v) the inverse dynamics
+/// (c includes the bias, gravity and force element terms, the latter
+/// including joint damping, as in CalcTimeDerivativesWithForce),
+///   df/du = [0; M^-1 B],  df/dlambda = [0; M^-1 J^T],
+///   d(vdot)/d(q, v) = M^-1 (d(J^T lambda)/d(q, v) - dID/d(q, v)),
+/// where dID/d(q, v) is taken at the fixed vdot = f(x, u, lambda).
+///
+/// dID/d(q, v) and d(N(q) v)/dq are computed by AutoDiffXd on a copy of the
+/// plant, which only differentiates the inverse dynamics rather than the
+/// factorization of the mass matrix. The kinematic terms, such as
+/// d(J^T lambda)/dq, are finite differenced, which only costs Jacobian
+/// evaluations.
+///
+/// Not thread-safe: the scratch contexts are owned by the object.
+class DynamicsDerivatives {
+ public:
+  /// @param plant a finalized plant
+  /// @param evaluators the kinematic constraints
+  /// @param eps step size of the finite differences of kinematic terms
+  DynamicsDerivatives(
+      const drake::multibody::MultibodyPlant<double>& plant,
+      const multibody::KinematicEvaluatorSet<double>& evaluators,
+      double eps = 1e-7);
+
+  /// Evaluates xdot = f(x, u, lambda) and its Jacobians. The state x and the
+  /// input u are read from the context.
+  /// @param dxdot_dx (nx x nx) Jacobian w.r.t. x
+  /// @param dxdot_du (nx x nu) Jacobian w.r.t. u
+  /// @param dxdot_dlambda (nx x n_lambda) Jacobian w.r.t. the full lambda
+  void Calc(drake::systems::Context<double>* context,
+            const Eigen::VectorXd& lambda, Eigen::VectorXd* xdot,
+            Eigen::MatrixXd* dxdot_dx, Eigen::MatrixXd* dxdot_du,
+            Eigen::MatrixXd* dxdot_dlambda) const;
+
+  /// Evaluates qdot = N(q) w, N(q) (nq x nv) and d(N(q) w)/dq (nq x nq)
+  void CalcMapVelocityToQDot(const Eigen::VectorXd& q, const Eigen::VectorXd& w,
+                             Eigen::VectorXd* qdot, Eigen::MatrixXd* N,
+                             Eigen::MatrixXd* dqdot_dq) const;
+
+  /// d(J(q)^T w)/dq (nv x nq) of the full Jacobian J, by finite differences
+  Eigen::MatrixXd CalcJacobianTransposeTimesVectorDerivative(
+      const Eigen::VectorXd& q, const Eigen::VectorXd& w) const;
+
+  /// d(J_a(q) vdot + Jdot_a(q, v) v)/dx (n_active x nx) at a fixed vdot, where
+  /// J_a is the active Jacobian, by finite differences
+  Eigen::MatrixXd CalcActiveAccelerationDerivative(
+      const Eigen::VectorXd& x, const Eigen::VectorXd& vdot) const;
+
+ private:
+  const drake::multibody::MultibodyPlant<double>& plant_;
+  const multibody::KinematicEvaluatorSet<double>& evaluators_;
+  std::unique_ptr<drake::multibody::MultibodyPlant<drake::AutoDiffXd>>
+      plant_ad_;
+  std::unique_ptr<drake::systems::Context<drake::AutoDiffXd>> context_ad_;
+  std::unique_ptr<drake::systems::Context<double>> context_fd_;
+  Eigen::MatrixXd B_;
+  double eps_;
+};
+
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
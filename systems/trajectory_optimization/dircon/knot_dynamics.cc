@@ -0,0 +1,118 @@
+#include "systems/trajectory_optimization/dircon/knot_dynamics.h"
+
+#include "drake/common/default_scalars.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+
+using drake::AutoDiffVecXd;
+using drake::AutoDiffXd;
+using drake::VectorX;
+using drake::systems::Context;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+namespace {
+
+bool AreEqual(const VectorXd& a, const VectorXd& b) {
+  return a.size() == b.size() && a == b;
+}
+
+bool AreEqual(const AutoDiffVecXd& a, const AutoDiffVecXd& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (int i = 0; i < a.size(); i++) {
+    if (a(i).value() != b(i).value() ||
+        a(i).derivatives().size() != b(i).derivatives().size() ||
+        a(i).derivatives() != b(i).derivatives()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+template <typename T>
+KnotDynamics<T>::KnotDynamics(
+    const multibody::KinematicEvaluatorSet<T>& evaluators, int num_knots)
+    : evaluators_(evaluators), knots_(num_knots) {}
+
+template <typename T>
+bool KnotDynamics<T>::Lookup(Knot* knot, const VectorX<T>& x,
+                             const VectorX<T>& u, const VectorX<T>& lambda) {
+  if (knot->valid && AreEqual(knot->x, x) && AreEqual(knot->u, u) &&
+      AreEqual(knot->lambda, lambda)) {
+    return true;
+  }
+  knot->valid = false;
+  knot->has_gradient = false;
+  knot->x = x;
+  knot->u = u;
+  knot->lambda = lambda;
+  return false;
+}
+
+template <typename T>
+VectorX<T> KnotDynamics<T>::CalcTimeDerivativesWithForce(
+    int knot_index, Context<T>* context, const VectorX<T>& lambda,
+    DynamicsCache<T>* cache) {
+  const auto& plant = evaluators_.plant();
+  Knot& knot = knots_.at(knot_index);
+  std::lock_guard<std::mutex> lock(knot.mutex);
+
+  if (Lookup(&knot, plant.GetPositionsAndVelocities(*context),
+             plant.get_actuation_input_port().Eval(*context), lambda)) {
+    num_reuses_++;
+    return knot.xdot;
+  }
+  num_evaluations_++;
+  knot.xdot = cache ? cache->CalcTimeDerivativesWithForce(context, lambda)
+                    : evaluators_.CalcTimeDerivativesWithForce(context, lambda);
+  knot.valid = true;
+  return knot.xdot;
+}
+
+template <>
+void KnotDynamics<double>::CalcTimeDerivativesAndGradient(
+    int knot_index, Context<double>* context, const VectorXd& lambda,
+    const DynamicsDerivatives& derivatives, VectorXd* xdot, MatrixXd* dxdot_dx,
+    MatrixXd* dxdot_du, MatrixXd* dxdot_dlambda) {
+  const auto& plant = evaluators_.plant();
+  Knot& knot = knots_.at(knot_index);
+  std::lock_guard<std::mutex> lock(knot.mutex);
+
+  if (Lookup(&knot, plant.GetPositionsAndVelocities(*context),
+             plant.get_actuation_input_port().Eval(*context), lambda) &&
+      knot.has_gradient) {
+    num_reuses_++;
+  } else {
+    num_evaluations_++;
+    derivatives.Calc(context, lambda, &knot.xdot, &knot.dxdot_dx,
+                     &knot.dxdot_du, &knot.dxdot_dlambda);
+    knot.valid = true;
+    knot.has_gradient = true;
+  }
+  *xdot = knot.xdot;
+  *dxdot_dx = knot.dxdot_dx;
+  *dxdot_du = knot.dxdot_du;
+  *dxdot_dlambda = knot.dxdot_dlambda;
+}
+
+template <>
+void KnotDynamics<AutoDiffXd>::CalcTimeDerivativesAndGradient(
+    int knot_index, Context<double>* context, const VectorXd& lambda,
+    const DynamicsDerivatives& derivatives, VectorXd* xdot, MatrixXd* dxdot_dx,
+    MatrixXd* dxdot_du, MatrixXd* dxdot_dlambda) {
+  throw std::logic_error(
+      "KnotDynamics<AutoDiffXd> does not support analytic gradients.");
+}
+
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
+
+DRAKE_DEFINE_CLASS_TEMPLATE_INSTANTIATIONS_ON_DEFAULT_NONSYMBOLIC_SCALARS(
+    class ::dairlib::systems::trajectory_optimization::KnotDynamics)
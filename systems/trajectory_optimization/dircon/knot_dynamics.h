@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "systems/trajectory_optimization/dircon/dynamics_cache.h"
+#include "systems/trajectory_optimization/dircon/dynamics_derivatives.h"
+#include "drake/systems/framework/context.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+
+/// Shares the dynamics xdot = f(x, u, lambda) at the knot points of a mode
+/// between the constraints that need them. Each collocation constraint uses
+/// the knots k and k+1 and each acceleration constraint the knot k, so,
+/// without sharing, the dynamics of every knot are evaluated three times for
+/// the same decision variables.
+///
+/// Each knot holds the arguments and result of its last evaluation. A
+/// constraint asking for the dynamics of a knot at the same arguments (the
+/// values of x, u and lambda, compared exactly) reads the stored result,
+/// otherwise the dynamics are evaluated, through the DynamicsCache of the
+/// constraint if it has one, and replace the stored result. For a given
+/// vector of decision variables, the dynamics of each knot are therefore
+/// evaluated once. The Jacobians computed by DynamicsDerivatives are shared
+/// the same way, which is where most of the savings are when the constraints
+/// use analytic gradients.
+///
+/// Knots are locked individually, so constraints of different threads may
+/// share a knot (as the batched collocation constraints do at the boundaries
+/// of their chunks).
+template <typename T>
+class KnotDynamics {
+ public:
+  KnotDynamics(const multibody::KinematicEvaluatorSet<T>& evaluators,
+               int num_knots);
+
+  /// Evaluates xdot at knot `knot`, with x and u read from the context
+  /// @param cache used to evaluate the dynamics if they are not stored, can
+  ///   be nullptr
+  drake::VectorX<T> CalcTimeDerivativesWithForce(
+      int knot, drake::systems::Context<T>* context,
+      const drake::VectorX<T>& lambda, DynamicsCache<T>* cache = nullptr);
+
+  /// Evaluates xdot at knot `knot` and its Jacobians (see
+  /// DynamicsDerivatives::Calc). Only supported for T = double.
+  void CalcTimeDerivativesAndGradient(
+      int knot, drake::systems::Context<double>* context,
+      const Eigen::VectorXd& lambda, const DynamicsDerivatives& derivatives,
+      Eigen::VectorXd* xdot, Eigen::MatrixXd* dxdot_dx,
+      Eigen::MatrixXd* dxdot_du, Eigen::MatrixXd* dxdot_dlambda);
+
+  int num_knots() const { return knots_.size(); }
+
+  /// Number of evaluations of the dynamics (or of the dynamics and their
+  /// Jacobians), and number of requests answered from a stored result
+  int64_t num_evaluations() const { return num_evaluations_; }
+  int64_t num_reuses() const { return num_reuses_; }
+
+ private:
+  struct Knot {
+    std::mutex mutex;
+    bool valid = false;
+    bool has_gradient = false;
+    drake::VectorX<T> x;
+    drake::VectorX<T> u;
+    drake::VectorX<T> lambda;
+    drake::VectorX<T> xdot;
+    Eigen::MatrixXd dxdot_dx;
+    Eigen::MatrixXd dxdot_du;
+    Eigen::MatrixXd dxdot_dlambda;
+  };
+
+  // Returns true if knot holds an evaluation at (x, u, lambda). Otherwise,
+  // stores these arguments and invalidates the stored result. knot.mutex must
+  // be held.
+  bool Lookup(Knot* knot, const drake::VectorX<T>& x,
+              const drake::VectorX<T>& u, const drake::VectorX<T>& lambda);
+
+  const multibody::KinematicEvaluatorSet<T>& evaluators_;
+  std::vector<Knot> knots_;
+  std::atomic<int64_t> num_evaluations_{0};
+  std::atomic<int64_t> num_reuses_{0};
+};
+
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,78 @@
+#include "systems/trajectory_optimization/dircon/mesh_refinement.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "drake/common/drake_assert.h"
+#include "drake/solvers/solve.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+
+using drake::solvers::MathematicalProgramResult;
+using std::vector;
+
+DirconMeshRefinement::DirconMeshRefinement(ProblemFactory factory,
+                                           const Options& options)
+    : factory_(std::move(factory)), options_(options) {
+  DRAKE_DEMAND(options_.max_solves >= 1);
+  DRAKE_DEMAND(options_.refinement_factor >= 2);
+}
+
+std::unique_ptr<DirconMeshRefinement::Problem> DirconMeshRefinement::Solve(
+    const vector<int>& num_knotpoints, MathematicalProgramResult* result) {
+  DRAKE_DEMAND(result != nullptr);
+  iterations_.clear();
+  vector<int> knots = num_knotpoints;
+  std::unique_ptr<Problem> previous;
+
+  while (true) {
+    std::unique_ptr<Problem> problem = factory_(knots);
+    DRAKE_DEMAND(problem != nullptr && problem->trajopt != nullptr);
+    Dircon<double>& trajopt = *problem->trajopt;
+    DRAKE_DEMAND(trajopt.num_modes() == static_cast<int>(knots.size()));
+    if (previous) {
+      trajopt.SetInitialGuessFromSolution(*previous->trajopt, *result);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    *result = drake::solvers::Solve(trajopt, trajopt.initial_guess());
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    Iteration iteration;
+    iteration.num_knotpoints = knots;
+    iteration.success = result->is_success();
+    iteration.cost = result->get_optimal_cost();
+    iteration.solve_time = elapsed.count();
+    for (int i = 0; i < trajopt.num_modes(); i++) {
+      const Eigen::VectorXd error = trajopt.GetMeshErrorByMode(*result, i);
+      iteration.mesh_error.push_back(error.size() > 0 ? error.maxCoeff() : 0);
+    }
+    iterations_.push_back(iteration);
+
+    // Refine the modes which are not accurate enough
+    bool refined = false;
+    for (int i = 0; i < trajopt.num_modes(); i++) {
+      const bool accurate = iteration.success &&
+                            iteration.mesh_error[i] <= options_.tolerance;
+      const int refined_knots = std::min(
+          (knots[i] - 1) * options_.refinement_factor + 1,
+          options_.max_knotpoints);
+      if (!accurate && knots[i] > 1 && refined_knots > knots[i]) {
+        knots[i] = refined_knots;
+        refined = true;
+      }
+    }
+    if (!refined ||
+        static_cast<int>(iterations_.size()) == options_.max_solves) {
+      return problem;
+    }
+    previous = std::move(problem);
+  }
+}
+
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
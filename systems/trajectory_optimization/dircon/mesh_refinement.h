@@ -0,0 +1,90 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "drake/solvers/mathematical_program_result.h"
+
+#include "common/owned_objects.h"
+#include "systems/trajectory_optimization/dircon/dircon.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+
+/// DirconMeshRefinement solves a Dircon problem by continuation from a coarse
+/// to a fine grid of knot points. The problem is first solved with few knot
+/// points per mode. Modes whose discretization error (see
+/// Dircon::GetMeshErrorByMode) is above a tolerance are then given more knot
+/// points, and the refined problem is solved again, warm started from the
+/// previous solution (see Dircon::SetInitialGuessFromSolution), until every
+/// mode is accurate enough.
+///
+/// Since knot points are evenly spaced within a Dircon mode, refinement is
+/// per mode: the number of intervals of a refined mode is multiplied by
+/// Options::refinement_factor.
+///
+/// The knot points of the modes are fixed when the modes are created, so
+/// problems are created by a user-provided factory, which receives the number
+/// of knot points of each mode and adds the costs and constraints of the
+/// problem.
+class DirconMeshRefinement {
+ public:
+  /// A problem, along with the objects it depends on. The evaluators, modes
+  /// and mode sequence referred to by `trajopt` are kept alive with Own().
+  struct Problem : public OwnedObjects {
+    std::unique_ptr<Dircon<double>> trajopt;
+  };
+
+  typedef std::function<std::unique_ptr<Problem>(
+      const std::vector<int>& num_knotpoints)>
+      ProblemFactory;
+
+  struct Options {
+    /// Maximum number of solves, including the first (coarsest) one
+    int max_solves = 4;
+    /// Modes with a larger mesh error are refined
+    double tolerance = 1e-3;
+    /// Ratio of the number of intervals of a refined mode to the current one
+    int refinement_factor = 2;
+    /// Upper bound on the number of knot points of each mode
+    int max_knotpoints = 100;
+  };
+
+  /// Outcome of one solve
+  struct Iteration {
+    std::vector<int> num_knotpoints;
+    bool success = false;
+    double cost = 0;
+    double solve_time = 0;
+    /// Largest interval error of each mode
+    std::vector<double> mesh_error;
+  };
+
+  explicit DirconMeshRefinement(ProblemFactory factory,
+                                const Options& options = Options());
+
+  /// Solves the problem, starting with num_knotpoints knot points per mode,
+  /// and refining until all modes are within tolerance (and the solve
+  /// succeeded), no mode can be refined further, or max_solves is reached.
+  /// Failed solves refine every mode, as the grid may be too coarse for the
+  /// problem to be feasible.
+  /// @param result the solution of the last solve
+  /// @return the last problem, which result refers to
+  std::unique_ptr<Problem> Solve(
+      const std::vector<int>& num_knotpoints,
+      drake::solvers::MathematicalProgramResult* result);
+
+  /// The solves of the last call to Solve()
+  const std::vector<Iteration>& iterations() const { return iterations_; }
+
+ private:
+  ProblemFactory factory_;
+  Options options_;
+  std::vector<Iteration> iterations_;
+};
+
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,143 @@
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/multibody/parsing/parser.h"
+#include "drake/multibody/plant/multibody_plant.h"
+
+#include "common/find_resource.h"
+#include "multibody/kinematic/distance_evaluator.h"
+#include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "multibody/kinematic/world_point_evaluator.h"
+#include "systems/trajectory_optimization/dircon/dircon_opt_constraints.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+namespace {
+
+using drake::CompareMatrices;
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using drake::systems::Context;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+using multibody::DistanceEvaluator;
+using multibody::KinematicEvaluatorSet;
+using multibody::WorldPointEvaluator;
+
+/// Evaluates DirconCollocationConstraints concurrently from several threads,
+/// each constraint with its own contexts, and checks that the results match
+/// a serial evaluation. The two evaluator sets have different sizes, so that
+/// state shared across calls (e.g. function-local statics) would also be
+/// caught by a single thread.
+class DirconConstraintThreadTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    plant_ = std::make_unique<MultibodyPlant<double>>(0.0);
+    Parser parser(plant_.get());
+    parser.AddModelFromFile(
+        FindResourceOrThrow("examples/PlanarWalker/PlanarWalker.urdf"));
+    plant_->WeldFrames(plant_->world_frame(), plant_->GetFrameByName("base"),
+                       drake::math::RigidTransform<double>());
+    plant_->Finalize();
+
+    const auto& left_foot = plant_->GetFrameByName("left_lower_leg");
+    const auto& right_foot = plant_->GetFrameByName("right_lower_leg");
+    Vector3d pt_foot(0, 0, -.5);
+    foot_evaluator_ = std::make_unique<WorldPointEvaluator<double>>(
+        *plant_, pt_foot, left_foot);
+    distance_evaluator_ = std::make_unique<DistanceEvaluator<double>>(
+        *plant_, pt_foot, left_foot, pt_foot, right_foot, 0.5);
+
+    foot_set_ = std::make_unique<KinematicEvaluatorSet<double>>(*plant_);
+    foot_set_->add_evaluator(foot_evaluator_.get());
+    full_set_ = std::make_unique<KinematicEvaluatorSet<double>>(*plant_);
+    full_set_->add_evaluator(foot_evaluator_.get());
+    full_set_->add_evaluator(distance_evaluator_.get());
+  }
+
+  // A collocation constraint with its own knot contexts
+  struct ConstraintWithContexts {
+    std::unique_ptr<Context<double>> context_0;
+    std::unique_ptr<Context<double>> context_1;
+    std::unique_ptr<DirconCollocationConstraint<double>> constraint;
+  };
+
+  ConstraintWithContexts MakeConstraint(
+      const KinematicEvaluatorSet<double>& evaluators, int index) const {
+    ConstraintWithContexts c;
+    c.context_0 = plant_->CreateDefaultContext();
+    c.context_1 = plant_->CreateDefaultContext();
+    c.constraint = std::make_unique<DirconCollocationConstraint<double>>(
+        *plant_, evaluators, c.context_0.get(), c.context_1.get(), 0, index);
+    return c;
+  }
+
+  std::unique_ptr<MultibodyPlant<double>> plant_;
+  std::unique_ptr<WorldPointEvaluator<double>> foot_evaluator_;
+  std::unique_ptr<DistanceEvaluator<double>> distance_evaluator_;
+  std::unique_ptr<KinematicEvaluatorSet<double>> foot_set_;
+  std::unique_ptr<KinematicEvaluatorSet<double>> full_set_;
+};
+
+TEST_F(DirconConstraintThreadTest, ConcurrentCollocation) {
+  const int n_threads = 8;
+  const int n_inputs = 20;
+  const int n_repeats = 50;
+
+  std::vector<ConstraintWithContexts> constraints;
+  std::vector<MatrixXd> inputs;
+  for (int i = 0; i < n_threads; i++) {
+    constraints.push_back(
+        MakeConstraint(i % 2 == 0 ? *foot_set_ : *full_set_, i));
+    const int n = constraints.back().constraint->num_vars();
+    MatrixXd x = 0.5 * MatrixXd::Random(n, n_inputs);
+    // Strictly positive timestep
+    x.row(0).array() = 0.1 + 0.05 * x.row(0).array().abs();
+    inputs.push_back(x);
+  }
+
+  // Serial reference
+  std::vector<MatrixXd> expected(n_threads);
+  for (int i = 0; i < n_threads; i++) {
+    const auto& constraint = *constraints[i].constraint;
+    expected[i].resize(constraint.num_constraints(), n_inputs);
+    for (int j = 0; j < n_inputs; j++) {
+      VectorXd y;
+      constraint.EvaluateConstraint(inputs[i].col(j), &y);
+      expected[i].col(j) = y;
+    }
+  }
+
+  std::vector<MatrixXd> results(n_threads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < n_threads; i++) {
+    threads.emplace_back([&, i]() {
+      const auto& constraint = *constraints[i].constraint;
+      results[i].resize(constraint.num_constraints(), n_inputs);
+      for (int k = 0; k < n_repeats; k++) {
+        for (int j = 0; j < n_inputs; j++) {
+          VectorXd y;
+          constraint.EvaluateConstraint(inputs[i].col(j), &y);
+          results[i].col(j) = y;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < n_threads; i++) {
+    EXPECT_TRUE(CompareMatrices(results[i], expected[i], 1e-12));
+  }
+}
+
+}  // namespace
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
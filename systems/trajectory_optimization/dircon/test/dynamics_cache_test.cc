@@ -0,0 +1,142 @@
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/math/autodiff.h"
+#include "drake/multibody/parsing/parser.h"
+#include "drake/multibody/plant/multibody_plant.h"
+
+#include "common/find_resource.h"
+#include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "multibody/kinematic/world_point_evaluator.h"
+#include "multibody/multibody_utils.h"
+#include "systems/trajectory_optimization/dircon/dynamics_cache.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+namespace {
+
+using drake::AutoDiffVecXd;
+using drake::AutoDiffXd;
+using drake::CompareMatrices;
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+using multibody::KinematicEvaluatorSet;
+using multibody::WorldPointEvaluator;
+
+class DynamicsCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    plant_ = std::make_unique<MultibodyPlant<double>>(0.0);
+    Parser parser(plant_.get());
+    parser.AddModelFromFile(FindResourceOrThrow(
+        "systems/trajectory_optimization/dircon/test/acrobot_floating.urdf"));
+    plant_->Finalize();
+
+    contact_ = std::make_unique<WorldPointEvaluator<double>>(
+        *plant_, Vector3d(0, 0, -1), plant_->GetFrameByName("lower_link"));
+    evaluators_ = std::make_unique<KinematicEvaluatorSet<double>>(*plant_);
+    evaluators_->add_evaluator(contact_.get());
+  }
+
+  // Context with a random state and input
+  std::unique_ptr<drake::systems::Context<double>> RandomContext() const {
+    VectorXd x =
+        VectorXd::Random(plant_->num_positions() + plant_->num_velocities());
+    x.head(4).normalize();
+    return multibody::createContext<double>(
+        *plant_, x, VectorXd::Random(plant_->num_actuators()));
+  }
+
+  std::unique_ptr<MultibodyPlant<double>> plant_;
+  std::unique_ptr<WorldPointEvaluator<double>> contact_;
+  std::unique_ptr<KinematicEvaluatorSet<double>> evaluators_;
+};
+
+TEST_F(DynamicsCacheTest, HitsMissesAndLruEviction) {
+  DynamicsCache<double> unbounded(*evaluators_, 1 << 30);
+  const VectorXd lambda = VectorXd::Random(evaluators_->count_full());
+
+  // Three different states
+  std::vector<std::unique_ptr<drake::systems::Context<double>>> contexts;
+  for (int i = 0; i < 3; i++) {
+    contexts.push_back(RandomContext());
+    const VectorXd xdot =
+        unbounded.CalcTimeDerivativesWithForce(contexts[i].get(), lambda);
+    EXPECT_TRUE(CompareMatrices(
+        xdot, evaluators_->CalcTimeDerivativesWithForce(contexts[i].get(),
+                                                        lambda)));
+  }
+  EXPECT_EQ(unbounded.stats().misses, 3);
+  EXPECT_EQ(unbounded.stats().hits, 0);
+  EXPECT_EQ(unbounded.stats().num_entries, 3);
+
+  unbounded.CalcTimeDerivativesWithForce(contexts[1].get(), lambda);
+  EXPECT_EQ(unbounded.stats().hits, 1);
+  EXPECT_EQ(unbounded.stats().misses, 3);
+
+  // Room for two entries: reading entry 0 makes entry 1 the least recently
+  // used one, which the third entry then evicts
+  const std::size_t entry_bytes = unbounded.stats().num_bytes / 3;
+  DynamicsCache<double> bounded(*evaluators_, 2 * entry_bytes);
+  bounded.CalcTimeDerivativesWithForce(contexts[0].get(), lambda);
+  bounded.CalcTimeDerivativesWithForce(contexts[1].get(), lambda);
+  bounded.CalcTimeDerivativesWithForce(contexts[0].get(), lambda);
+  bounded.CalcTimeDerivativesWithForce(contexts[2].get(), lambda);
+  EXPECT_EQ(bounded.stats().evictions, 1);
+  EXPECT_EQ(bounded.stats().num_entries, 2);
+  EXPECT_LE(bounded.stats().num_bytes, bounded.max_bytes());
+
+  bounded.ResetStats();
+  bounded.CalcTimeDerivativesWithForce(contexts[0].get(), lambda);
+  bounded.CalcTimeDerivativesWithForce(contexts[2].get(), lambda);
+  EXPECT_EQ(bounded.stats().hits, 2);
+  bounded.CalcTimeDerivativesWithForce(contexts[1].get(), lambda);
+  EXPECT_EQ(bounded.stats().misses, 1);
+}
+
+// Equal values with different gradient seeds must not share an entry
+TEST(DynamicsCacheSeedTest, DifferentSeedsMiss) {
+  MultibodyPlant<double> plant_double(0.0);
+  Parser parser(&plant_double);
+  parser.AddModelFromFile(FindResourceOrThrow(
+      "systems/trajectory_optimization/dircon/test/acrobot_floating.urdf"));
+  plant_double.Finalize();
+  auto plant = drake::systems::System<double>::ToAutoDiffXd(plant_double);
+  KinematicEvaluatorSet<AutoDiffXd> evaluators(*plant);
+  auto context = plant->CreateDefaultContext();
+  DynamicsCache<AutoDiffXd> cache(evaluators, 1 << 30);
+
+  const int n_x = plant->num_positions() + plant->num_velocities();
+  VectorXd x = VectorXd::Random(n_x);
+  x.head(4).normalize();
+  const AutoDiffVecXd u =
+      VectorXd::Zero(plant->num_actuators()).cast<AutoDiffXd>();
+  const AutoDiffVecXd lambda(0);
+
+  multibody::setContext<AutoDiffXd>(
+      *plant, drake::math::initializeAutoDiff(x), u, context.get());
+  const AutoDiffVecXd xdot_1 =
+      cache.CalcTimeDerivativesWithForce(context.get(), lambda);
+  multibody::setContext<AutoDiffXd>(
+      *plant, drake::math::initializeAutoDiff(2 * x) / 2, u, context.get());
+  const AutoDiffVecXd xdot_2 =
+      cache.CalcTimeDerivativesWithForce(context.get(), lambda);
+
+  EXPECT_EQ(cache.stats().misses, 2);
+  EXPECT_TRUE(CompareMatrices(drake::math::autoDiffToValueMatrix(xdot_1),
+                              drake::math::autoDiffToValueMatrix(xdot_2),
+                              1e-12));
+  EXPECT_TRUE(CompareMatrices(
+      drake::math::autoDiffToGradientMatrix(xdot_1) / 2,
+      drake::math::autoDiffToGradientMatrix(xdot_2), 1e-10));
+}
+
+}  // namespace
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
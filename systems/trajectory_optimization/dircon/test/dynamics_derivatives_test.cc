@@ -0,0 +1,239 @@
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/math/autodiff.h"
+#include "drake/math/autodiff_gradient.h"
+#include "drake/multibody/parsing/parser.h"
+#include "drake/multibody/plant/multibody_plant.h"
+
+#include "common/find_resource.h"
+#include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "multibody/kinematic/world_point_evaluator.h"
+#include "multibody/multibody_utils.h"
+#include "systems/trajectory_optimization/dircon/dircon_opt_constraints.h"
+#include "systems/trajectory_optimization/dircon/dynamics_derivatives.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+namespace {
+
+using drake::AutoDiffVecXd;
+using drake::CompareMatrices;
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+using multibody::KinematicEvaluatorSet;
+using multibody::WorldPointEvaluator;
+using solvers::FiniteDifferenceMethod;
+
+/// Compares the analytic gradients of the collocation and acceleration
+/// constraints with finite differences, on a floating base acrobot (so that
+/// the quaternion terms are exercised) with a point contact on the lower link
+/// and a damped elbow
+class DynamicsDerivativesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    plant_ = std::make_unique<MultibodyPlant<double>>(0.0);
+    Parser parser(plant_.get());
+    parser.AddModelFromFile(FindResourceOrThrow(
+        "systems/trajectory_optimization/dircon/test/acrobot_floating.urdf"));
+    plant_->Finalize();
+
+    contact_ = std::make_unique<WorldPointEvaluator<double>>(
+        *plant_, Vector3d(0, 0, -1), plant_->GetFrameByName("lower_link"));
+    evaluators_ = std::make_unique<KinematicEvaluatorSet<double>>(*plant_);
+    evaluators_->add_evaluator(contact_.get());
+  }
+
+  // Random state with a unit quaternion
+  VectorXd RandomState() const {
+    VectorXd x =
+        VectorXd::Random(plant_->num_positions() + plant_->num_velocities());
+    x.head(4).normalize();
+    return x;
+  }
+
+  // Gradient of the constraint at x, as seen by the solvers
+  static MatrixXd EvalGradient(const drake::solvers::Constraint& constraint,
+                               const VectorXd& x) {
+    AutoDiffVecXd y;
+    constraint.Eval(drake::math::initializeAutoDiff(x), &y);
+    return drake::math::autoDiffToGradientMatrix(y);
+  }
+
+  // Entrywise, with a tolerance close to the error of the finite
+  // differences (central for the numerical constraints, forward for the
+  // kinematic terms of the analytic ones)
+  static void ExpectGradientsMatch(const MatrixXd& analytic,
+                                   const MatrixXd& numerical) {
+    ASSERT_EQ(analytic.rows(), numerical.rows());
+    ASSERT_EQ(analytic.cols(), numerical.cols());
+    EXPECT_TRUE(CompareMatrices(analytic, numerical, kTolerance));
+  }
+
+  static constexpr double kTolerance = 1e-5;
+
+  std::unique_ptr<MultibodyPlant<double>> plant_;
+  std::unique_ptr<WorldPointEvaluator<double>> contact_;
+  std::unique_ptr<KinematicEvaluatorSet<double>> evaluators_;
+};
+
+TEST_F(DynamicsDerivativesTest, CollocationConstraint) {
+  auto context_0 = plant_->CreateDefaultContext();
+  auto context_1 = plant_->CreateDefaultContext();
+  DirconCollocationConstraint<double> numerical(
+      *plant_, *evaluators_, context_0.get(), context_1.get(), 0, 0);
+  DirconCollocationConstraint<double> analytic(
+      *plant_, *evaluators_, context_0.get(), context_1.get(), 0, 0);
+  numerical.SetFiniteDifferenceMethod(FiniteDifferenceMethod::kCentral);
+  analytic.EnableAnalyticGradients();
+
+  const int n_x = plant_->num_positions() + plant_->num_velocities();
+  for (int trial = 0; trial < 5; trial++) {
+    VectorXd vars = VectorXd::Random(numerical.num_vars());
+    vars(0) = 0.05;
+    vars.segment(1, n_x) = RandomState();
+    vars.segment(1 + n_x, n_x) = RandomState();
+
+    VectorXd y_numerical, y_analytic;
+    numerical.Eval(vars, &y_numerical);
+    analytic.Eval(vars, &y_analytic);
+    EXPECT_TRUE(y_analytic.isApprox(y_numerical));
+
+    ExpectGradientsMatch(EvalGradient(analytic, vars),
+                         EvalGradient(numerical, vars));
+
+    // The analytic gradient is not masked, so it must vanish outside of the
+    // declared sparsity pattern
+    MatrixXd outside = EvalGradient(analytic, vars).cwiseAbs();
+    for (const auto& [i, j] : analytic.gradient_sparsity_pattern().value()) {
+      outside(i, j) = 0;
+    }
+    EXPECT_LE(outside.maxCoeff(), 1e-12);
+  }
+}
+
+TEST_F(DynamicsDerivativesTest, AccelerationConstraint) {
+  CachedAccelerationConstraint<double> numerical(*plant_, *evaluators_,
+                                                 nullptr, "numerical");
+  CachedAccelerationConstraint<double> analytic(*plant_, *evaluators_,
+                                                nullptr, "analytic");
+  numerical.SetFiniteDifferenceMethod(FiniteDifferenceMethod::kCentral);
+  analytic.EnableAnalyticGradients();
+
+  const int n_x = plant_->num_positions() + plant_->num_velocities();
+  for (int trial = 0; trial < 5; trial++) {
+    VectorXd vars = VectorXd::Random(numerical.num_vars());
+    vars.head(n_x) = RandomState();
+    ExpectGradientsMatch(EvalGradient(analytic, vars),
+                         EvalGradient(numerical, vars));
+  }
+}
+
+// d(vdot)/dv of the damped elbow, against central differences of the forward
+// dynamics, which include the joint damping once
+TEST_F(DynamicsDerivativesTest, DampedJointVelocity) {
+  const int n_q = plant_->num_positions();
+  const int n_v = plant_->num_velocities();
+  const int i_elbow = plant_->GetJointByName("elbow").velocity_start();
+  DynamicsDerivatives derivatives(*plant_, *evaluators_);
+  auto context = plant_->CreateDefaultContext();
+  const VectorXd lambda = VectorXd::Random(evaluators_->count_full());
+  const VectorXd u = VectorXd::Random(plant_->num_actuators());
+
+  for (int trial = 0; trial < 5; trial++) {
+    VectorXd x = RandomState();
+    multibody::setContext<double>(*plant_, x, u, context.get());
+    VectorXd xdot;
+    MatrixXd dxdot_dx, dxdot_du, dxdot_dlambda;
+    derivatives.Calc(context.get(), lambda, &xdot, &dxdot_dx, &dxdot_du,
+                     &dxdot_dlambda);
+
+    const double eps = 1e-6;
+    x(n_q + i_elbow) += eps;
+    multibody::setContext<double>(*plant_, x, u, context.get());
+    const VectorXd vdot_plus =
+        evaluators_->CalcTimeDerivativesWithForce(context.get(), lambda)
+            .tail(n_v);
+    x(n_q + i_elbow) -= 2 * eps;
+    multibody::setContext<double>(*plant_, x, u, context.get());
+    const VectorXd vdot_minus =
+        evaluators_->CalcTimeDerivativesWithForce(context.get(), lambda)
+            .tail(n_v);
+
+    EXPECT_TRUE(CompareMatrices(dxdot_dx.bottomRows(n_v).col(n_q + i_elbow),
+                                (vdot_plus - vdot_minus) / (2 * eps), 1e-6));
+  }
+}
+
+// Two consecutive collocation constraints and the acceleration constraint of
+// their common knot share the dynamics of the three knots
+TEST_F(DynamicsDerivativesTest, SharedKnotDynamics) {
+  const int n_x = plant_->num_positions() + plant_->num_velocities();
+  const int n_u = plant_->num_actuators();
+  const int n_l = evaluators_->count_full();
+  std::vector<VectorXd> x, u, l;
+  for (int k = 0; k < 3; k++) {
+    x.push_back(RandomState());
+    u.push_back(VectorXd::Random(n_u));
+    l.push_back(VectorXd::Random(n_l));
+  }
+
+  KnotDynamics<double> knot_dynamics(*evaluators_, 3);
+  std::vector<std::unique_ptr<drake::systems::Context<double>>> contexts;
+  for (int k = 0; k < 3; k++) {
+    contexts.push_back(plant_->CreateDefaultContext());
+  }
+
+  std::vector<std::unique_ptr<DirconCollocationConstraint<double>>> shared,
+      independent;
+  std::vector<VectorXd> vars;
+  for (int j = 0; j < 2; j++) {
+    for (auto* constraints : {&shared, &independent}) {
+      constraints->push_back(
+          std::make_unique<DirconCollocationConstraint<double>>(
+              *plant_, *evaluators_, contexts[j].get(), contexts[j + 1].get(),
+              0, j));
+      constraints->back()->EnableAnalyticGradients();
+    }
+    shared.back()->ShareKnotDynamics(&knot_dynamics, j);
+
+    VectorXd vars_j = VectorXd::Random(shared.back()->num_vars());
+    vars_j(0) = 0.05;
+    vars_j.segment(1, 2 * n_x) << x[j], x[j + 1];
+    vars_j.segment(1 + 2 * n_x, 2 * n_u) << u[j], u[j + 1];
+    vars_j.segment(1 + 2 * (n_x + n_u), 2 * n_l) << l[j], l[j + 1];
+    vars.push_back(vars_j);
+  }
+
+  CachedAccelerationConstraint<double> shared_accel(
+      *plant_, *evaluators_, contexts[1].get(), "shared");
+  CachedAccelerationConstraint<double> independent_accel(
+      *plant_, *evaluators_, contexts[1].get(), "independent");
+  shared_accel.EnableAnalyticGradients();
+  independent_accel.EnableAnalyticGradients();
+  shared_accel.ShareKnotDynamics(&knot_dynamics, 1);
+  VectorXd accel_vars(n_x + n_u + n_l);
+  accel_vars << x[1], u[1], l[1];
+
+  for (int j = 0; j < 2; j++) {
+    EXPECT_TRUE(CompareMatrices(EvalGradient(*shared[j], vars[j]),
+                                EvalGradient(*independent[j], vars[j])));
+  }
+  EXPECT_TRUE(CompareMatrices(EvalGradient(shared_accel, accel_vars),
+                              EvalGradient(independent_accel, accel_vars)));
+
+  // Knots 0, 1 and 2 are evaluated once, knot 1 is then reused twice
+  EXPECT_EQ(knot_dynamics.num_evaluations(), 3);
+  EXPECT_EQ(knot_dynamics.num_reuses(), 2);
+}
+
+}  // namespace
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,101 @@
+#include <memory>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/multibody/parsing/parser.h"
+#include "drake/multibody/plant/multibody_plant.h"
+
+#include "common/find_resource.h"
+#include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "multibody/kinematic/world_point_evaluator.h"
+#include "systems/trajectory_optimization/dircon/dircon.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+namespace {
+
+using drake::CompareMatrices;
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using drake::solvers::MathematicalProgramResult;
+using Eigen::Matrix3d;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+using multibody::KinematicEvaluatorSet;
+using multibody::WorldPointEvaluator;
+
+/// Resamples a random "solution" of a coarse single stance problem onto a
+/// finer grid, and checks that the knot points common to both grids match.
+class MeshRefinementTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    plant_ = std::make_unique<MultibodyPlant<double>>(0.0);
+    Parser parser(plant_.get());
+    parser.AddModelFromFile(
+        FindResourceOrThrow("examples/PlanarWalker/PlanarWalker.urdf"));
+    plant_->WeldFrames(plant_->world_frame(), plant_->GetFrameByName("base"),
+                       drake::math::RigidTransform<double>());
+    plant_->Finalize();
+
+    foot_ = std::make_unique<WorldPointEvaluator<double>>(
+        *plant_, Vector3d(0, 0, -.5), plant_->GetFrameByName("left_lower_leg"),
+        Matrix3d::Identity(), Vector3d::Zero(), std::vector<int>{0, 2});
+    evaluators_ = std::make_unique<KinematicEvaluatorSet<double>>(*plant_);
+    evaluators_->add_evaluator(foot_.get());
+  }
+
+  std::unique_ptr<MultibodyPlant<double>> plant_;
+  std::unique_ptr<WorldPointEvaluator<double>> foot_;
+  std::unique_ptr<KinematicEvaluatorSet<double>> evaluators_;
+};
+
+TEST_F(MeshRefinementTest, SetInitialGuessFromSolution) {
+  const double h = 0.1;
+  DirconMode<double> coarse_mode(*evaluators_, 4);
+  DirconMode<double> fine_mode(*evaluators_, 7);
+  Dircon<double> coarse(&coarse_mode);
+  Dircon<double> fine(&fine_mode);
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> uniform(-1, 1);
+  VectorXd z(coarse.num_vars());
+  for (int i = 0; i < z.size(); i++) z(i) = uniform(generator);
+  for (int j = 0; j < coarse.N() - 1; j++) {
+    z(coarse.FindDecisionVariableIndex(coarse.timestep(j)(0))) = h;
+  }
+  MathematicalProgramResult result;
+  result.set_decision_variable_index(coarse.decision_variable_index());
+  result.set_x_val(z);
+
+  fine.SetInitialGuessFromSolution(coarse, result);
+
+  double duration = 0;
+  for (int j = 0; j < fine.N() - 1; j++) {
+    duration += fine.GetInitialGuess(fine.timestep(j))(0);
+  }
+  EXPECT_NEAR(duration, 3 * h, 1e-12);
+  // Every other knot of the fine grid is a knot of the coarse one
+  for (int j = 0; j < coarse.N(); j++) {
+    EXPECT_TRUE(CompareMatrices(
+        fine.GetInitialGuess(fine.state_vars(0, 2 * j)),
+        result.GetSolution(coarse.state_vars(0, j)), 1e-10));
+    EXPECT_TRUE(CompareMatrices(
+        fine.GetInitialGuess(fine.input_vars(0, 2 * j)),
+        result.GetSolution(coarse.input_vars(0, j)), 1e-10));
+    EXPECT_TRUE(CompareMatrices(
+        fine.GetInitialGuess(fine.force_vars(0, 2 * j)),
+        result.GetSolution(coarse.force_vars(0, j)), 1e-10));
+  }
+
+  const VectorXd error = coarse.GetMeshErrorByMode(result, 0);
+  EXPECT_EQ(error.size(), coarse.N() - 1);
+  EXPECT_TRUE((error.array() >= 0).all());
+}
+
+}  // namespace
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
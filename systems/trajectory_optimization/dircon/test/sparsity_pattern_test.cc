@@ -0,0 +1,144 @@
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "drake/math/autodiff.h"
+#include "drake/math/autodiff_gradient.h"
+#include "drake/multibody/parsing/parser.h"
+#include "drake/multibody/plant/multibody_plant.h"
+
+#include "common/find_resource.h"
+#include "examples/Cassie/cassie_utils.h"
+#include "multibody/kinematic/kinematic_constraints.h"
+#include "multibody/kinematic/kinematic_evaluator_set.h"
+#include "multibody/kinematic/world_point_evaluator.h"
+#include "multibody/multibody_utils.h"
+#include "systems/trajectory_optimization/dircon/dircon_opt_constraints.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+namespace {
+
+using drake::AutoDiffVecXd;
+using drake::AutoDiffXd;
+using drake::multibody::MultibodyPlant;
+using drake::multibody::Parser;
+using Eigen::MatrixXd;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+using multibody::KinematicEvaluatorSet;
+using multibody::KinematicPositionConstraint;
+using multibody::WorldPointEvaluator;
+
+/// Checks that the gradient sparsity patterns which KinematicPositionConstraint
+/// and ImpactConstraint infer by probing the plant cover every nonzero of the
+/// dense AutoDiff gradient, at configurations other than the probed ones.
+class SparsityPatternTest : public ::testing::Test {
+ protected:
+  // The AutoDiff gradient of EvaluateConstraint, which is not masked by the
+  // declared pattern, must vanish outside of it. The pattern must also be
+  // sparser than dense for the test to be meaningful.
+  static void ExpectPatternCovers(
+      const solvers::NonlinearConstraint<AutoDiffXd>& constraint,
+      const VectorXd& x) {
+    ASSERT_TRUE(constraint.gradient_sparsity_pattern().has_value());
+    const auto& pattern = constraint.gradient_sparsity_pattern().value();
+    EXPECT_LT(static_cast<int>(pattern.size()),
+              constraint.num_constraints() * constraint.num_vars());
+
+    AutoDiffVecXd y;
+    constraint.EvaluateConstraint(drake::math::initializeAutoDiff(x), &y);
+    MatrixXd outside = drake::math::autoDiffToGradientMatrix(y).cwiseAbs();
+    ASSERT_EQ(outside.rows(), constraint.num_constraints());
+    ASSERT_EQ(outside.cols(), constraint.num_vars());
+    for (const auto& [i, j] : pattern) {
+      outside(i, j) = 0;
+    }
+    EXPECT_EQ(outside.maxCoeff(), 0) << constraint.get_description();
+  }
+
+  // Checks both constraints on `plant`, with the contact evaluators
+  // `evaluators`, at kNumSamples configurations
+  void CheckConstraints(const MultibodyPlant<AutoDiffXd>& plant,
+                        const KinematicEvaluatorSet<AutoDiffXd>& evaluators) {
+    const int n_q = plant.num_positions();
+    const int n_v = plant.num_velocities();
+    const int n_l = evaluators.count_full();
+    auto context = plant.CreateDefaultContext();
+
+    KinematicPositionConstraint<AutoDiffXd> position_constraint(
+        plant, evaluators, VectorXd::Zero(evaluators.count_active()),
+        VectorXd::Zero(evaluators.count_active()), {0}, context.get());
+    ImpactConstraint<AutoDiffXd> impact_constraint(plant, evaluators,
+                                                   context.get(), "impact");
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    auto random_vector = [&](int size) {
+      VectorXd v(size);
+      for (int i = 0; i < size; i++) v(i) = distribution(generator);
+      return v;
+    };
+    for (int sample = 0; sample < kNumSamples; sample++) {
+      // Seeds 0 and 1 are the probed configurations
+      const VectorXd q = multibody::RandomPositions(plant, 100 + sample);
+      VectorXd position_vars(n_q + 1);
+      position_vars << q, random_vector(1);
+      ExpectPatternCovers(position_constraint, position_vars);
+
+      // x0, impulse and v1
+      VectorXd impact_vars(n_q + n_v + n_l + n_v);
+      impact_vars << q, random_vector(n_v + n_l + n_v);
+      ExpectPatternCovers(impact_constraint, impact_vars);
+    }
+  }
+
+  static constexpr int kNumSamples = 5;
+};
+
+TEST_F(SparsityPatternTest, PlanarWalker) {
+  MultibodyPlant<double> plant(0.0);
+  Parser parser(&plant);
+  parser.AddModelFromFile(
+      FindResourceOrThrow("examples/PlanarWalker/PlanarWalker.urdf"));
+  plant.WeldFrames(plant.world_frame(), plant.GetFrameByName("base"),
+                   drake::math::RigidTransform<double>());
+  plant.Finalize();
+  auto plant_ad = drake::systems::System<double>::ToAutoDiffXd(plant);
+
+  // Contact on the left leg only: the right leg positions do not enter phi
+  WorldPointEvaluator<AutoDiffXd> left_foot(
+      *plant_ad, Vector3d(0, 0, -0.5),
+      plant_ad->GetFrameByName("left_lower_leg"));
+  KinematicEvaluatorSet<AutoDiffXd> evaluators(*plant_ad);
+  evaluators.add_evaluator(&left_foot);
+  CheckConstraints(*plant_ad, evaluators);
+}
+
+TEST_F(SparsityPatternTest, Cassie) {
+  MultibodyPlant<double> plant(0.0);
+  addCassieMultibody(&plant, nullptr, true,
+                     "examples/Cassie/urdf/cassie_v2.urdf", true, false);
+  plant.Finalize();
+  auto plant_ad = drake::systems::System<double>::ToAutoDiffXd(plant);
+
+  // Floating base, left toe contact and both loop closures
+  const auto left_toe = LeftToeFront(*plant_ad);
+  WorldPointEvaluator<AutoDiffXd> left_toe_evaluator(
+      *plant_ad, left_toe.first, left_toe.second);
+  auto left_loop = LeftLoopClosureEvaluator(*plant_ad);
+  auto right_loop = RightLoopClosureEvaluator(*plant_ad);
+  KinematicEvaluatorSet<AutoDiffXd> evaluators(*plant_ad);
+  evaluators.add_evaluator(&left_toe_evaluator);
+  evaluators.add_evaluator(&left_loop);
+  evaluators.add_evaluator(&right_loop);
+  CheckConstraints(*plant_ad, evaluators);
+}
+
+}  // namespace
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,334 @@
+#include "systems/trajectory_optimization/multi_start.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "drake/common/drake_assert.h"
+#include "drake/solvers/snopt_solver.h"
+#include "drake/solvers/solve.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+
+using drake::solvers::MathematicalProgramResult;
+using drake::solvers::SnoptSolver;
+using drake::solvers::SolutionResult;
+using drake::systems::trajectory_optimization::MultipleShooting;
+using Eigen::VectorXd;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Result of a problem solved by a child process, sent through a pipe. Much
+// smaller than PIPE_BUF, so it is written atomically and without blocking.
+struct ResultMessage {
+  int success;
+  int solution_result;
+  int solver_status;
+  int saved;
+  double cost;
+  double solve_time;
+};
+
+vector<string> NamesOrDefault(const vector<string>& names, int size,
+                              const string& prefix) {
+  if (static_cast<int>(names.size()) == size) {
+    return names;
+  }
+  vector<string> default_names;
+  for (int i = 0; i < size; i++) {
+    default_names.push_back(prefix + "[" + std::to_string(i) + "]");
+  }
+  return default_names;
+}
+
+LcmTrajectory::Trajectory MakeStateInputTrajectory(
+    const MultipleShooting& trajopt, const MathematicalProgramResult& solution,
+    const MultiStartDriver::Problem& problem) {
+  const auto state_traj = trajopt.ReconstructStateTrajectory(solution);
+  const auto input_traj = trajopt.ReconstructInputTrajectory(solution);
+  const vector<double>& breaks = state_traj.get_segment_times();
+  const int n_x = state_traj.rows();
+  const int n_u = input_traj.rows();
+
+  LcmTrajectory::Trajectory traj;
+  traj.traj_name = "state_input";
+  traj.time_vector = Eigen::Map<const VectorXd>(breaks.data(), breaks.size());
+  traj.datapoints.resize(n_x + n_u, breaks.size());
+  for (int i = 0; i < traj.time_vector.size(); i++) {
+    traj.datapoints.col(i) << state_traj.value(breaks[i]),
+        input_traj.value(breaks[i]);
+  }
+  traj.datatypes = NamesOrDefault(problem.state_names, n_x, "x");
+  const vector<string> input_names =
+      NamesOrDefault(problem.input_names, n_u, "u");
+  traj.datatypes.insert(traj.datatypes.end(), input_names.begin(),
+                        input_names.end());
+  return traj;
+}
+
+LcmTrajectory::Trajectory MakeDecisionVariableTrajectory(
+    const MultipleShooting& trajopt,
+    const MathematicalProgramResult& solution) {
+  LcmTrajectory::Trajectory traj;
+  traj.traj_name = "decision_vars";
+  traj.datapoints = solution.GetSolution();
+  traj.time_vector = VectorXd::Zero(1);
+  for (int i = 0; i < trajopt.num_vars(); i++) {
+    traj.datatypes.push_back(trajopt.decision_variable(i).get_name());
+  }
+  return traj;
+}
+
+LcmTrajectory::Trajectory MakeStatsTrajectory(
+    const MultiStartDriver::Result& result) {
+  LcmTrajectory::Trajectory traj;
+  traj.traj_name = "solver_stats";
+  traj.datapoints.resize(4, 1);
+  traj.datapoints << result.solve_time, result.cost,
+      static_cast<int>(result.solution_result), result.solver_status;
+  traj.time_vector = VectorXd::Zero(1);
+  traj.datatypes = {"solve_time", "cost", "solution_result", "solver_status"};
+  return traj;
+}
+
+LcmTrajectory::Trajectory MakeTaskParameterTrajectory(
+    const VectorXd& task_parameters) {
+  LcmTrajectory::Trajectory traj;
+  traj.traj_name = "task_parameters";
+  traj.datapoints = task_parameters;
+  traj.time_vector = VectorXd::Zero(1);
+  traj.datatypes = NamesOrDefault({}, task_parameters.size(), "p");
+  return traj;
+}
+
+}  // namespace
+
+MultiStartDriver::MultiStartDriver(ProblemFactory factory,
+                                   const Options& options)
+    : factory_(std::move(factory)), options_(options) {
+  DRAKE_DEMAND(options_.num_workers >= 1);
+}
+
+string MultiStartDriver::Filename(int index) const {
+  return options_.output_directory + "/" + options_.name + "_" +
+         std::to_string(index);
+}
+
+vector<VectorXd> MultiStartDriver::PerturbedInitialGuesses(
+    const VectorXd& guess, double stddev, int num_guesses, unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::normal_distribution<double> noise(0, stddev);
+  vector<VectorXd> guesses;
+  for (int i = 0; i < num_guesses; i++) {
+    guesses.push_back(guess);
+    if (i > 0) {
+      for (int j = 0; j < guess.size(); j++) {
+        guesses.back()(j) += noise(generator);
+      }
+    }
+  }
+  return guesses;
+}
+
+MultiStartDriver::Result MultiStartDriver::Solve(int index) const {
+  std::unique_ptr<Problem> problem = factory_(index);
+  DRAKE_DEMAND(problem != nullptr);
+  DRAKE_DEMAND(problem->trajopt != nullptr);
+  const MultipleShooting& trajopt = *problem->trajopt;
+  const VectorXd initial_guess = problem->initial_guess.size() > 0
+                                     ? problem->initial_guess
+                                     : trajopt.initial_guess();
+
+  const auto start = std::chrono::steady_clock::now();
+  const MathematicalProgramResult solution =
+      drake::solvers::Solve(trajopt, initial_guess);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  Result result;
+  result.index = index;
+  result.success = solution.is_success();
+  result.solution_result = solution.get_solution_result();
+  result.cost = solution.get_optimal_cost();
+  result.solve_time = elapsed.count();
+  result.decision_variables = solution.GetSolution();
+  if (solution.get_solver_id() == SnoptSolver::id()) {
+    result.solver_status = solution.get_solver_details<SnoptSolver>().info;
+  }
+
+  if (result.success && !options_.output_directory.empty()) {
+    result.filename = Filename(index);
+    vector<LcmTrajectory::Trajectory> trajectories = {
+        MakeStateInputTrajectory(trajopt, solution, *problem),
+        MakeDecisionVariableTrajectory(trajopt, solution),
+        MakeStatsTrajectory(result)};
+    if (problem->task_parameters.size() > 0) {
+      trajectories.push_back(
+          MakeTaskParameterTrajectory(problem->task_parameters));
+    }
+    vector<string> trajectory_names;
+    for (const auto& traj : trajectories) {
+      trajectory_names.push_back(traj.traj_name);
+    }
+    LcmTrajectory saved_traj(trajectories, trajectory_names, options_.name,
+                             "Solution " + std::to_string(index) +
+                                 " of a multi-start trajectory optimization");
+    saved_traj.writeToFile(result.filename);
+  }
+  return result;
+}
+
+vector<MultiStartDriver::Result> MultiStartDriver::Run(
+    int num_problems) const {
+  if (options_.parallelism == Parallelism::kProcesses) {
+    return RunProcesses(num_problems);
+  }
+  return RunThreads(num_problems);
+}
+
+vector<MultiStartDriver::Result> MultiStartDriver::RunThreads(
+    int num_problems) const {
+  vector<Result> results(num_problems);
+  std::atomic<int> next_index(0);
+  const int num_workers = std::min(options_.num_workers, num_problems);
+  vector<std::exception_ptr> errors(num_workers);
+
+  // Workers take the problems in order of index, one at a time
+  auto work = [&](int worker) {
+    try {
+      for (int i = next_index++; i < num_problems; i = next_index++) {
+        results[i] = Solve(i);
+      }
+    } catch (...) {
+      errors[worker] = std::current_exception();
+    }
+  };
+  vector<std::thread> threads;
+  for (int worker = 1; worker < num_workers; worker++) {
+    threads.emplace_back(work, worker);
+  }
+  if (num_workers > 0) {
+    work(0);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+  return results;
+}
+
+vector<MultiStartDriver::Result> MultiStartDriver::RunProcesses(
+    int num_problems) const {
+  vector<Result> results(num_problems);
+  // Index of the problem and read end of the pipe of each running child
+  std::map<pid_t, std::pair<int, int>> children;
+
+  // Buffered output would otherwise be flushed by the children as well
+  std::cout.flush();
+  std::fflush(stdout);
+
+  int next_index = 0;
+  while (next_index < num_problems || !children.empty()) {
+    while (next_index < num_problems &&
+           static_cast<int>(children.size()) < options_.num_workers) {
+      int fds[2];
+      if (pipe(fds) != 0) {
+        throw std::runtime_error("MultiStartDriver: pipe() failed.");
+      }
+      const pid_t pid = fork();
+      if (pid < 0) {
+        throw std::runtime_error("MultiStartDriver: fork() failed.");
+      }
+      if (pid == 0) {
+        close(fds[0]);
+        ResultMessage message{
+            0, static_cast<int>(SolutionResult::kUnknownError), -1, 0, 0, 0};
+        try {
+          const Result result = Solve(next_index);
+          message.success = result.success;
+          message.solution_result = static_cast<int>(result.solution_result);
+          message.solver_status = result.solver_status;
+          message.saved = !result.filename.empty();
+          message.cost = result.cost;
+          message.solve_time = result.solve_time;
+        } catch (const std::exception& e) {
+          std::cerr << "MultiStartDriver: problem " << next_index
+                    << " threw: " << e.what() << std::endl;
+        }
+        const ssize_t written = write(fds[1], &message, sizeof(message));
+        close(fds[1]);
+        _exit(written == sizeof(message) ? 0 : 1);
+      }
+      close(fds[1]);
+      children[pid] = {next_index++, fds[0]};
+    }
+
+    int status;
+    const pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      const int error = errno;
+      if (error == EINTR) continue;
+      // The children can't be waited for (e.g. ECHILD): report the running
+      // and the remaining problems as failed
+      std::cerr << "MultiStartDriver: waitpid() failed: "
+                << std::strerror(error) << std::endl;
+      for (const auto& child : children) {
+        const auto [index, fd] = child.second;
+        results[index].index = index;
+        close(fd);
+      }
+      children.clear();
+      for (; next_index < num_problems; next_index++) {
+        results[next_index].index = next_index;
+      }
+      break;
+    }
+    auto child = children.find(pid);
+    if (child == children.end()) continue;
+    const auto [index, fd] = child->second;
+    children.erase(child);
+
+    Result& result = results[index];
+    result.index = index;
+    if (WIFSIGNALED(status)) {
+      result.signal = WTERMSIG(status);
+      std::cerr << "MultiStartDriver: problem " << index
+                << " was killed by signal " << result.signal << std::endl;
+    }
+    ResultMessage message;
+    if (read(fd, &message, sizeof(message)) == sizeof(message)) {
+      result.success = message.success;
+      result.solution_result =
+          static_cast<SolutionResult>(message.solution_result);
+      result.solver_status = message.solver_status;
+      result.cost = message.cost;
+      result.solve_time = message.solve_time;
+      if (message.saved) result.filename = Filename(index);
+    }
+    close(fd);
+  }
+  return results;
+}
+
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/owned_objects.h"
+#include "lcm/lcm_trajectory.h"
+#include "drake/solvers/mathematical_program_result.h"
+#include "drake/systems/trajectory_optimization/multiple_shooting.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+
+/// MultiStartDriver solves a set of trajectory optimization problems
+/// concurrently, e.g. one problem per perturbed initial guess, or one problem
+/// per value of a swept parameter (stride length, jump height...) when
+/// building a gait library. Problems are created by a user-provided factory,
+/// which receives the index of the problem, and can be any MultipleShooting
+/// (Dircon, HybridDircon...).
+///
+/// Every converged solution is written to
+///   <output_directory>/<name>_<index>
+/// as an LcmTrajectory holding
+///   - "state_input": the state and input at the breaks of the reconstructed
+///     state trajectory,
+///   - "decision_vars": the decision variables,
+///   - "solver_stats": the solve time, cost, solution result and (for SNOPT)
+///     the solver exit code,
+///   - "task_parameters": the parameters of the task, if the problem has any.
+///
+/// Problems are run either on threads or, for solvers or problem factories
+/// which are not thread-safe, in forked processes. Either way, each problem
+/// is created by the worker that solves it, so the factory must not share
+/// mutable objects (plants can be shared, contexts cannot) between problems.
+class MultiStartDriver {
+ public:
+  /// A problem, along with the objects it depends on. The plant, evaluators
+  /// or modes referred to by `trajopt` are kept alive with Own().
+  struct Problem : public OwnedObjects {
+    std::unique_ptr<drake::systems::trajectory_optimization::MultipleShooting>
+        trajopt;
+    /// Initial guess of the decision variables. Defaults to
+    /// trajopt->initial_guess() if empty.
+    Eigen::VectorXd initial_guess;
+    /// Names of the states and inputs, saved as the datatypes of the
+    /// "state_input" trajectory. Generic names are used if empty.
+    std::vector<std::string> state_names;
+    std::vector<std::string> input_names;
+    /// Parameters of the task (stride length, jump height...), saved as the
+    /// "task_parameters" trajectory for TrajectoryLibrary. Not saved if
+    /// empty.
+    Eigen::VectorXd task_parameters;
+  };
+
+  typedef std::function<std::unique_ptr<Problem>(int index)> ProblemFactory;
+
+  enum class Parallelism { kThreads, kProcesses };
+
+  struct Options {
+    /// Number of problems solved at a time
+    int num_workers = 1;
+    Parallelism parallelism = Parallelism::kThreads;
+    /// Directory of the saved solutions. Nothing is saved if empty.
+    std::string output_directory;
+    /// Prefix of the file names, and name of the saved LcmTrajectory objects
+    std::string name = "multi_start";
+  };
+
+  /// Outcome of one problem
+  struct Result {
+    int index = -1;
+    bool success = false;
+    drake::solvers::SolutionResult solution_result =
+        drake::solvers::SolutionResult::kUnknownError;
+    /// Solver exit code (SNOPT info), -1 if not available
+    int solver_status = -1;
+    double cost = 0;
+    /// Wall time of the solve, excluding the creation of the problem
+    double solve_time = 0;
+    /// Saved file, empty if the problem did not converge or nothing is saved
+    std::string filename;
+    /// Solution. Left empty by Parallelism::kProcesses (see the saved file).
+    Eigen::VectorXd decision_variables;
+    /// Signal which killed the process of the problem (e.g. SIGSEGV), 0 if
+    /// it was not killed. Only set by Parallelism::kProcesses.
+    int signal = 0;
+  };
+
+  MultiStartDriver(ProblemFactory factory, const Options& options);
+
+  /// Solves the problems 0, ..., num_problems - 1, and returns their results
+  /// in order of index. Exceptions thrown by the factory or the solvers are
+  /// rethrown (for threads) or reported as kUnknownError (for processes). A
+  /// crashed process is reported as kUnknownError with Result::signal set. If
+  /// the processes can't be waited for, the problems which have not finished
+  /// are reported as kUnknownError.
+  std::vector<Result> Run(int num_problems) const;
+
+  /// Initial guesses randomly perturbed around `guess`, with normally
+  /// distributed noise of standard deviation `stddev`. The first one is
+  /// `guess` itself. Deterministic for a given seed.
+  static std::vector<Eigen::VectorXd> PerturbedInitialGuesses(
+      const Eigen::VectorXd& guess, double stddev, int num_guesses,
+      unsigned int seed = 0);
+
+  /// Path of the file of problem `index`
+  std::string Filename(int index) const;
+
+ private:
+  // Creates, solves and (if converged) saves problem `index`
+  Result Solve(int index) const;
+
+  std::vector<Result> RunThreads(int num_problems) const;
+  std::vector<Result> RunProcesses(int num_problems) const;
+
+  ProblemFactory factory_;
+  Options options_;
+};
+
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
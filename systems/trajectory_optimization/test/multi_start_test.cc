@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "drake/common/temp_directory.h"
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+#include "drake/systems/primitives/linear_system.h"
+#include "drake/systems/trajectory_optimization/direct_transcription.h"
+
+#include "lcm/lcm_trajectory.h"
+#include "systems/trajectory_optimization/multi_start.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+namespace {
+
+using drake::CompareMatrices;
+using drake::solvers::SolutionResult;
+using drake::systems::LinearSystem;
+using drake::systems::trajectory_optimization::DirectTranscription;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+constexpr int kNumTimeSamples = 5;
+constexpr double kTimeStep = 0.1;
+
+/// Drives the discrete-time integrator x[n+1] = x[n] + kTimeStep*u[n] from 0
+/// to `target` with the least input effort. The optimal input is constant.
+std::unique_ptr<MultiStartDriver::Problem> MakeProblem(
+    double target, const VectorXd& initial_guess) {
+  auto problem = std::make_unique<MultiStartDriver::Problem>();
+  auto system = problem->Own(std::make_unique<LinearSystem<double>>(
+      MatrixXd::Ones(1, 1), kTimeStep * MatrixXd::Ones(1, 1),
+      MatrixXd::Ones(1, 1), MatrixXd::Zero(1, 1), kTimeStep));
+  auto context = problem->Own(system->CreateDefaultContext());
+  auto trajopt =
+      std::make_unique<DirectTranscription>(system, *context, kNumTimeSamples);
+  trajopt->AddBoundingBoxConstraint(0, 0, trajopt->state(0));
+  trajopt->AddBoundingBoxConstraint(target, target,
+                                    trajopt->state(kNumTimeSamples - 1));
+  trajopt->AddRunningCost(trajopt->input()(0) * trajopt->input()(0));
+  problem->trajopt = std::move(trajopt);
+  problem->initial_guess = initial_guess;
+  problem->state_names = {"x"};
+  problem->input_names = {"u"};
+  problem->task_parameters = VectorXd::Constant(1, target);
+  return problem;
+}
+
+double Target(int index) { return 1 + index; }
+
+class MultiStartDriverTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Decision variables of DirectTranscription: inputs, then states
+    const int num_vars = 2 * kNumTimeSamples - 1;
+    guesses_ = MultiStartDriver::PerturbedInitialGuesses(
+        VectorXd::Zero(num_vars), 0.1, kNumProblems, 1);
+  }
+
+  MultiStartDriver::Options MakeOptions(
+      MultiStartDriver::Parallelism parallelism,
+      const std::string& name) const {
+    MultiStartDriver::Options options;
+    options.num_workers = 2;
+    options.parallelism = parallelism;
+    options.output_directory = drake::temp_directory();
+    options.name = name;
+    return options;
+  }
+
+  // Checks the result and the saved file of problem `index`
+  void CheckSolution(const MultiStartDriver& driver,
+                     const MultiStartDriver::Result& result, int index) const {
+    EXPECT_EQ(result.index, index);
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(result.signal, 0);
+    ASSERT_EQ(result.filename, driver.Filename(index));
+
+    const double target = Target(index);
+    const double u_optimal = target / (kTimeStep * (kNumTimeSamples - 1));
+    EXPECT_NEAR(result.cost,
+                kTimeStep * (kNumTimeSamples - 1) * u_optimal * u_optimal,
+                1e-3 * (1 + result.cost));
+
+    const LcmTrajectory saved(result.filename);
+    auto names = saved.getTrajectoryNames();
+    std::sort(names.begin(), names.end());
+    EXPECT_EQ(names, std::vector<std::string>({"decision_vars", "solver_stats",
+                                               "state_input",
+                                               "task_parameters"}));
+    const auto state_input = saved.getTrajectory("state_input");
+    EXPECT_EQ(state_input.datatypes, std::vector<std::string>({"x", "u"}));
+    ASSERT_EQ(state_input.datapoints.rows(), 2);
+    ASSERT_EQ(state_input.time_vector.size(), kNumTimeSamples);
+    EXPECT_NEAR(state_input.time_vector.tail(1)(0),
+                kTimeStep * (kNumTimeSamples - 1), 1e-12);
+    EXPECT_NEAR(state_input.datapoints(0, 0), 0, 1e-3);
+    EXPECT_NEAR(state_input.datapoints(0, kNumTimeSamples - 1), target, 1e-3);
+    EXPECT_NEAR(state_input.datapoints(1, 0), u_optimal, 1e-2);
+    EXPECT_EQ(saved.getTrajectory("decision_vars").datapoints.size(),
+              2 * kNumTimeSamples - 1);
+    const auto stats = saved.getTrajectory("solver_stats");
+    EXPECT_EQ(stats.datapoints(1, 0), result.cost);
+    EXPECT_EQ(stats.datapoints(2, 0),
+              static_cast<int>(SolutionResult::kSolutionFound));
+    EXPECT_TRUE(CompareMatrices(
+        saved.getTrajectory("task_parameters").datapoints,
+        VectorXd::Constant(1, target)));
+  }
+
+  static constexpr int kNumProblems = 4;
+  std::vector<VectorXd> guesses_;
+};
+
+TEST_F(MultiStartDriverTest, PerturbedInitialGuesses) {
+  ASSERT_EQ(guesses_.size(), static_cast<size_t>(kNumProblems));
+  // The first guess is unperturbed, the others are distinct
+  EXPECT_TRUE(guesses_[0].isZero());
+  for (int i = 1; i < kNumProblems; i++) {
+    EXPECT_FALSE(guesses_[i].isZero());
+    EXPECT_FALSE(guesses_[i].isApprox(guesses_[i - 1]));
+  }
+  // Deterministic for a given seed
+  const auto same_seed = MultiStartDriver::PerturbedInitialGuesses(
+      VectorXd::Zero(guesses_[0].size()), 0.1, kNumProblems, 1);
+  const auto other_seed = MultiStartDriver::PerturbedInitialGuesses(
+      VectorXd::Zero(guesses_[0].size()), 0.1, kNumProblems, 2);
+  for (int i = 0; i < kNumProblems; i++) {
+    EXPECT_TRUE(CompareMatrices(same_seed[i], guesses_[i]));
+  }
+  EXPECT_FALSE(other_seed[1].isApprox(guesses_[1]));
+}
+
+TEST_F(MultiStartDriverTest, Threads) {
+  MultiStartDriver driver(
+      [this](int index) { return MakeProblem(Target(index), guesses_[index]); },
+      MakeOptions(MultiStartDriver::Parallelism::kThreads, "threads"));
+  const auto results = driver.Run(kNumProblems);
+  ASSERT_EQ(results.size(), static_cast<size_t>(kNumProblems));
+  for (int i = 0; i < kNumProblems; i++) {
+    CheckSolution(driver, results[i], i);
+    EXPECT_EQ(results[i].decision_variables.size(), 2 * kNumTimeSamples - 1);
+  }
+}
+
+TEST_F(MultiStartDriverTest, ThreadsRethrow) {
+  MultiStartDriver driver(
+      [](int) -> std::unique_ptr<MultiStartDriver::Problem> {
+        throw std::runtime_error("factory failed");
+      },
+      MakeOptions(MultiStartDriver::Parallelism::kThreads, "throws"));
+  EXPECT_THROW(driver.Run(kNumProblems), std::runtime_error);
+}
+
+TEST_F(MultiStartDriverTest, Processes) {
+  // Problem 1 throws and problem 2 crashes; the others are unaffected
+  MultiStartDriver driver(
+      [this](int index) {
+        if (index == 1) throw std::runtime_error("factory failed");
+        if (index == 2) std::abort();
+        return MakeProblem(Target(index), guesses_[index]);
+      },
+      MakeOptions(MultiStartDriver::Parallelism::kProcesses, "processes"));
+  const auto results = driver.Run(kNumProblems);
+  ASSERT_EQ(results.size(), static_cast<size_t>(kNumProblems));
+  for (int i : {0, 3}) {
+    CheckSolution(driver, results[i], i);
+  }
+
+  EXPECT_EQ(results[1].index, 1);
+  EXPECT_FALSE(results[1].success);
+  EXPECT_EQ(results[1].solution_result, SolutionResult::kUnknownError);
+  EXPECT_EQ(results[1].signal, 0);
+  EXPECT_TRUE(results[1].filename.empty());
+
+  EXPECT_EQ(results[2].index, 2);
+  EXPECT_FALSE(results[2].success);
+  EXPECT_EQ(results[2].solution_result, SolutionResult::kUnknownError);
+  EXPECT_EQ(results[2].signal, SIGABRT);
+  EXPECT_TRUE(results[2].filename.empty());
+}
+
+}  // namespace
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,64 @@
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "drake/common/test_utilities/eigen_matrix_compare.h"
+
+#include "systems/trajectory_optimization/trajectory_library.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+namespace {
+
+using drake::CompareMatrices;
+using Eigen::Vector2d;
+using Eigen::VectorXd;
+
+VectorXd Scalar(double value) { return VectorXd::Constant(1, value); }
+
+class TrajectoryLibraryTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Solutions linear in the stride length
+    for (double stride : {0.1, 0.2, 0.3, 0.4}) {
+      library_.Add(Scalar(stride), Vector2d(stride, 1 - 2 * stride));
+    }
+  }
+
+  TrajectoryLibrary library_;
+};
+
+TEST_F(TrajectoryLibraryTest, NearestNeighbors) {
+  EXPECT_EQ(library_.NearestNeighbors(Scalar(0.22), 2),
+            std::vector<int>({1, 2}));
+  EXPECT_EQ(library_.NearestNeighbors(Scalar(0.5), 3),
+            std::vector<int>({3, 2, 1}));
+  EXPECT_EQ(library_.NearestNeighbors(Scalar(0), 10).size(), 4u);
+}
+
+TEST_F(TrajectoryLibraryTest, Interpolation) {
+  // Exact match
+  EXPECT_TRUE(CompareMatrices(
+      library_.InterpolateDecisionVariables(Scalar(0.3)), Vector2d(0.3, 0.4),
+      1e-12));
+  // Linear interpolation between the two neighbors
+  EXPECT_TRUE(CompareMatrices(
+      library_.InterpolateDecisionVariables(Scalar(0.22)),
+      Vector2d(0.22, 0.56), 1e-12));
+  // No extrapolation
+  EXPECT_TRUE(CompareMatrices(
+      library_.InterpolateDecisionVariables(Scalar(1), 1), Vector2d(0.4, 0.2),
+      1e-12));
+}
+
+TEST_F(TrajectoryLibraryTest, SizeMismatch) {
+  EXPECT_THROW(library_.Add(Scalar(0.5), VectorXd::Zero(3)),
+               std::runtime_error);
+  EXPECT_THROW(TrajectoryLibrary().InterpolateDecisionVariables(Scalar(0)),
+               std::runtime_error);
+}
+
+}  // namespace
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,180 @@
+#include "systems/trajectory_optimization/trajectory_library.h"
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "lcm/lcm_trajectory.h"
+#include "drake/common/drake_assert.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+
+using drake::systems::trajectory_optimization::MultipleShooting;
+using Eigen::VectorXd;
+using std::string;
+using std::vector;
+
+namespace {
+
+bool HasTrajectory(const LcmTrajectory& lcm_traj, const string& name) {
+  const auto& names = lcm_traj.getTrajectoryNames();
+  return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+// Saved blocks hold a single column, or a single row (as saved by
+// run_dircon_jumping)
+VectorXd ReadVector(const LcmTrajectory& lcm_traj, const string& name) {
+  const Eigen::MatrixXd datapoints = lcm_traj.getTrajectory(name).datapoints;
+  return Eigen::Map<const VectorXd>(datapoints.data(), datapoints.size());
+}
+
+}  // namespace
+
+TrajectoryLibrary::TrajectoryLibrary(const Options& options)
+    : options_(options) {}
+
+int TrajectoryLibrary::num_parameters() const {
+  return entries_.empty() ? 0 : entries_[0].task_parameters.size();
+}
+
+int TrajectoryLibrary::num_decision_variables() const {
+  return entries_.empty() ? 0 : entries_[0].decision_variables.size();
+}
+
+void TrajectoryLibrary::Add(const VectorXd& task_parameters,
+                            const VectorXd& decision_variables) {
+  if (!entries_.empty() &&
+      (task_parameters.size() != num_parameters() ||
+       decision_variables.size() != num_decision_variables())) {
+    throw std::runtime_error(
+        "TrajectoryLibrary: the solution does not have the number of task "
+        "parameters or decision variables of the library.");
+  }
+  DRAKE_DEMAND(options_.parameter_scale.size() == 0 ||
+               options_.parameter_scale.size() == task_parameters.size());
+  entries_.push_back({task_parameters, decision_variables});
+}
+
+void TrajectoryLibrary::AddFile(const string& filename,
+                                const VectorXd& task_parameters) {
+  const LcmTrajectory lcm_traj(filename);
+  if (!HasTrajectory(lcm_traj, options_.decision_vars_name)) {
+    throw std::runtime_error("TrajectoryLibrary: " + filename + " has no " +
+                             options_.decision_vars_name + " trajectory.");
+  }
+  if (task_parameters.size() > 0) {
+    Add(task_parameters, ReadVector(lcm_traj, options_.decision_vars_name));
+    return;
+  }
+  if (!HasTrajectory(lcm_traj, options_.task_parameters_name)) {
+    throw std::runtime_error("TrajectoryLibrary: " + filename + " has no " +
+                             options_.task_parameters_name + " trajectory.");
+  }
+  Add(ReadVector(lcm_traj, options_.task_parameters_name),
+      ReadVector(lcm_traj, options_.decision_vars_name));
+}
+
+int TrajectoryLibrary::AddDirectory(const string& directory,
+                                    const string& prefix) {
+  DIR* dir = opendir(directory.c_str());
+  if (dir == nullptr) {
+    throw std::runtime_error("TrajectoryLibrary: cannot open " + directory);
+  }
+  vector<string> filenames;
+  while (const dirent* file = readdir(dir)) {
+    const string name = file->d_name;
+    if (name != "." && name != ".." &&
+        name.compare(0, prefix.size(), prefix) == 0) {
+      filenames.push_back(directory + "/" + name);
+    }
+  }
+  closedir(dir);
+  // Sorted, so that the library does not depend on the order of the entries
+  // of the directory
+  std::sort(filenames.begin(), filenames.end());
+
+  int num_added = 0;
+  for (const auto& filename : filenames) {
+    LcmTrajectory lcm_traj;
+    try {
+      lcm_traj.loadFromFile(filename);
+    } catch (const std::exception&) {
+      continue;  // Not an LcmTrajectory
+    }
+    if (HasTrajectory(lcm_traj, options_.decision_vars_name) &&
+        HasTrajectory(lcm_traj, options_.task_parameters_name)) {
+      Add(ReadVector(lcm_traj, options_.task_parameters_name),
+          ReadVector(lcm_traj, options_.decision_vars_name));
+      num_added++;
+    }
+  }
+  return num_added;
+}
+
+double TrajectoryLibrary::Distance(const VectorXd& a,
+                                   const VectorXd& b) const {
+  if (options_.parameter_scale.size() == 0) {
+    return (a - b).norm();
+  }
+  return (a - b).cwiseQuotient(options_.parameter_scale).norm();
+}
+
+vector<int> TrajectoryLibrary::NearestNeighbors(const VectorXd& task_parameters,
+                                                int k) const {
+  DRAKE_DEMAND(entries_.empty() || task_parameters.size() == num_parameters());
+  vector<double> distances;
+  for (const auto& entry : entries_) {
+    distances.push_back(Distance(entry.task_parameters, task_parameters));
+  }
+  vector<int> indices(entries_.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  const int num_neighbors = std::min<int>(k, indices.size());
+  std::partial_sort(indices.begin(), indices.begin() + num_neighbors,
+                    indices.end(), [&distances](int i, int j) {
+                      return distances[i] < distances[j];
+                    });
+  indices.resize(num_neighbors);
+  return indices;
+}
+
+VectorXd TrajectoryLibrary::InterpolateDecisionVariables(
+    const VectorXd& task_parameters, int k) const {
+  if (entries_.empty()) {
+    throw std::runtime_error("TrajectoryLibrary: the library is empty.");
+  }
+  const vector<int> neighbors = NearestNeighbors(task_parameters, k);
+  VectorXd decision_variables = VectorXd::Zero(num_decision_variables());
+  double total_weight = 0;
+  for (int i : neighbors) {
+    const double distance =
+        Distance(entries_[i].task_parameters, task_parameters);
+    if (distance == 0) {
+      return entries_[i].decision_variables;
+    }
+    decision_variables += entries_[i].decision_variables / distance;
+    total_weight += 1 / distance;
+  }
+  return decision_variables / total_weight;
+}
+
+void TrajectoryLibrary::SetInitialGuess(const VectorXd& task_parameters,
+                                        MultipleShooting* trajopt,
+                                        int k) const {
+  if (trajopt->num_vars() != num_decision_variables()) {
+    throw std::runtime_error(
+        "TrajectoryLibrary: the problem has " +
+        std::to_string(trajopt->num_vars()) +
+        " decision variables, the solutions of the library " +
+        std::to_string(num_decision_variables()) + ".");
+  }
+  trajopt->SetInitialGuessForAllVariables(
+      InterpolateDecisionVariables(task_parameters, k));
+}
+
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "drake/systems/trajectory_optimization/multiple_shooting.h"
+
+namespace dairlib {
+namespace systems {
+namespace trajectory_optimization {
+
+/// TrajectoryLibrary indexes solved trajectory optimization problems by the
+/// parameters of their task (stride length, speed, jump height...), in order
+/// to warm start a new problem from the solutions of its nearest neighbors.
+///
+/// Solutions are the decision variables of the problems, which, for Dircon
+/// and HybridDircon, include the states, inputs, contact forces, slack
+/// variables and time steps. Interpolating them therefore gives a guess for
+/// all the variables at once, including those (forces, slacks) which are
+/// hardest to guess by hand. All solutions of a library must come from
+/// problems with the same decision variables, i.e. the same mode sequence
+/// and number of knot points; only the task parameters differ.
+///
+/// Solutions are interpolated with inverse distance weights over the k
+/// nearest neighbors. For a single, evenly sampled parameter and k = 2, this
+/// is linear interpolation between the neighbors on each side of the query.
+/// Queries outside of the library are not extrapolated: the result is a
+/// weighted average of the closest solutions.
+class TrajectoryLibrary {
+ public:
+  struct Options {
+    /// Names of the LcmTrajectory blocks of the decision variables and task
+    /// parameters, as saved by MultiStartDriver
+    std::string decision_vars_name = "decision_vars";
+    std::string task_parameters_name = "task_parameters";
+    /// Scale of each task parameter in the distance between tasks, e.g. to
+    /// compare a speed in m/s with a height in m. Defaults to ones if empty.
+    Eigen::VectorXd parameter_scale;
+  };
+
+  TrajectoryLibrary() : TrajectoryLibrary(Options()) {}
+  explicit TrajectoryLibrary(const Options& options);
+
+  /// Adds a solution
+  void Add(const Eigen::VectorXd& task_parameters,
+           const Eigen::VectorXd& decision_variables);
+
+  /// Adds the solution saved in an LcmTrajectory file. If task_parameters is
+  /// empty, they are read from the task parameter block of the file.
+  /// @throws std::exception if the file has no decision variable block, or no
+  ///   task parameters are given and it has no task parameter block
+  void AddFile(const std::string& filename,
+               const Eigen::VectorXd& task_parameters = Eigen::VectorXd());
+
+  /// Adds every file of `directory` whose name starts with `prefix` and which
+  /// holds both a decision variable and a task parameter block. Other files
+  /// are skipped.
+  /// @return the number of solutions added
+  int AddDirectory(const std::string& directory,
+                   const std::string& prefix = "");
+
+  int size() const { return entries_.size(); }
+  int num_parameters() const;
+  int num_decision_variables() const;
+
+  const Eigen::VectorXd& task_parameters(int i) const {
+    return entries_.at(i).task_parameters;
+  }
+  const Eigen::VectorXd& decision_variables(int i) const {
+    return entries_.at(i).decision_variables;
+  }
+
+  /// Indices of the (at most) k solutions closest to task_parameters, from
+  /// the closest to the farthest
+  std::vector<int> NearestNeighbors(const Eigen::VectorXd& task_parameters,
+                                    int k) const;
+
+  /// Interpolation of the decision variables of the k nearest neighbors of
+  /// task_parameters. Returns the stored solution for an exact match.
+  /// @throws std::exception if the library is empty
+  Eigen::VectorXd InterpolateDecisionVariables(
+      const Eigen::VectorXd& task_parameters, int k = 2) const;
+
+  /// Sets the initial guess of all the decision variables of trajopt from
+  /// InterpolateDecisionVariables().
+  /// @throws std::exception if trajopt does not have the number of decision
+  ///   variables of the library
+  void SetInitialGuess(
+      const Eigen::VectorXd& task_parameters,
+      drake::systems::trajectory_optimization::MultipleShooting* trajopt,
+      int k = 2) const;
+
+ private:
+  struct Entry {
+    Eigen::VectorXd task_parameters;
+    Eigen::VectorXd decision_variables;
+  };
+
+  double Distance(const Eigen::VectorXd& a, const Eigen::VectorXd& b) const;
+
+  Options options_;
+  std::vector<Entry> entries_;
+};
+
+}  // namespace trajectory_optimization
+}  // namespace systems
+}  // namespace dairlib
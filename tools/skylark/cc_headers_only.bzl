@@ -0,0 +1,17 @@
+# -*- mode: python -*-
+# vi: set ft=python :
+
+def _cc_headers_only_impl(ctx):
+    return [CcInfo(
+        compilation_context = ctx.attr.dep[CcInfo].compilation_context,
+    )]
+
+# Exposes the headers (and defines) of a C++ library without linking it. Used
+# for libraries which are already linked into libdrake.so, since linking them
+# again next to drake_shared_library would give two copies of their symbols.
+cc_headers_only = rule(
+    implementation = _cc_headers_only_impl,
+    attrs = {
+        "dep": attr.label(mandatory = True, providers = [CcInfo]),
+    },
+)